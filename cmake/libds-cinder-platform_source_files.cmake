@@ -29,12 +29,15 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/network/udp_connection.cpp
 	${ROOT_PATH}/src/ds/network/single_udp_receiver.cpp
 	${ROOT_PATH}/src/ds/network/network_info.cpp		# Uses winsock2 apis
+	${ROOT_PATH}/src/ds/network/net_codec.cpp
+	${ROOT_PATH}/src/ds/network/replication_stats.cpp
 	${ROOT_PATH}/src/ds/time/timer.cpp
 	${ROOT_PATH}/src/ds/thread/work_request.cpp
 	${ROOT_PATH}/src/ds/thread/work_manager.cpp
 	${ROOT_PATH}/src/ds/thread/gl_thread.cpp			# Uses win32 and WGL APIs
 	${ROOT_PATH}/src/ds/thread/runnable_client.cpp		# error: invalid initialization of non-const reference of type ‘std::unique_ptr<ds::WorkRequest>&’ from an rvalue of type ‘std::unique_ptr<ds::WorkRequest>’
 	${ROOT_PATH}/src/ds/thread/work_client.cpp
+	${ROOT_PATH}/src/ds/thread/runnable_executor.cpp
 	#${ROOT_PATH}/src/ds/storage/directory_watcher_win32.cpp	# Uses win32 apis
 	${ROOT_PATH}/src/ds/storage/persistent_cache.cpp
 	${ROOT_PATH}/src/ds/storage/directory_watcher.cpp
@@ -44,6 +47,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/query/sql_database.cpp
 	${ROOT_PATH}/src/ds/query/query_client.cpp			# error: invalid initialization of non-const reference of type ‘std::unique_ptr<ds::WorkRequest>&’ from an rvalue of type ‘std::unique_ptr<ds::WorkRequest>’
 	${ROOT_PATH}/src/ds/query/query_result_editor.cpp
+	${ROOT_PATH}/src/ds/query/sql_connection_pool.cpp
 	${ROOT_PATH}/src/ds/app/event_client.cpp
 	${ROOT_PATH}/src/ds/app/event_registry.cpp
 	${ROOT_PATH}/src/ds/app/engine/engine_io.cpp
@@ -60,6 +64,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/app/engine/engine_io_defs.cpp
 	${ROOT_PATH}/src/ds/app/engine/engine_standalone.cpp
 	${ROOT_PATH}/src/ds/app/engine/engine_clientserver.cpp
+	${ROOT_PATH}/src/ds/app/engine/engine_touch_input.cpp
 	${ROOT_PATH}/src/ds/app/error.cpp
 	${ROOT_PATH}/src/ds/app/blob_reader.cpp
 	${ROOT_PATH}/src/ds/app/camera_utils.cpp
@@ -105,6 +110,10 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/ui/sprite/image_with_thumbnail.cpp
 	${ROOT_PATH}/src/ds/ui/sprite/circle_border.cpp
 	${ROOT_PATH}/src/ds/ui/sprite/text_defs.cpp
+	${ROOT_PATH}/src/ds/ui/sprite/dirty_sprite_list.cpp
+	${ROOT_PATH}/src/ds/ui/sprite/sprite_id_map.cpp
+	${ROOT_PATH}/src/ds/ui/sprite/parallel_sprite_update.cpp
+	${ROOT_PATH}/src/ds/ui/sprite/sprite_pool.cpp
 	${ROOT_PATH}/src/ds/ui/ip/functions/ip_circle_mask.cpp
 	${ROOT_PATH}/src/ds/ui/ip/ip_function.cpp
 	${ROOT_PATH}/src/ds/ui/ip/ip_defs.cpp
@@ -131,6 +140,8 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/debug/computer_info.cpp
 	${ROOT_PATH}/src/ds/debug/debug_defines.cpp
 	${ROOT_PATH}/src/ds/debug/logger.cpp
+	${ROOT_PATH}/src/ds/debug/profiler.cpp
+	${ROOT_PATH}/src/ds/debug/memory_accounting.cpp
 	${ROOT_PATH}/src/ds/math/math_func.cpp
 	${ROOT_PATH}/src/ds/cfg/cfg_nine_patch.cpp
 	${ROOT_PATH}/src/ds/cfg/settings.cpp
@@ -144,6 +155,7 @@ list( APPEND DS_CINDER_SRC_FILES
 	${ROOT_PATH}/src/ds/data/color_list.cpp
 	${ROOT_PATH}/src/ds/data/user_data.cpp
 	${ROOT_PATH}/src/ds/data/resource.cpp
+	${ROOT_PATH}/src/ds/data/compact_encoding.cpp
 
 	${ROOT_PATH}/src/tuio/TuioClient.cpp
 	${ROOT_PATH}/src/osc/OscBundle.cpp
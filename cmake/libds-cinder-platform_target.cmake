@@ -32,6 +32,9 @@ target_include_directories( ds-cinder-platform SYSTEM BEFORE PRIVATE ${DS_CINDER
 
 target_link_libraries( ds-cinder-platform PUBLIC ${DS_CINDER_LIBS_DEPENDS}  )
 
+if( DS_CINDER_DISABLE_PROFILER )
+	list( APPEND DS_CINDER_DEFINES "-DDS_DISABLE_PROFILER" )
+endif()
 target_compile_definitions( ds-cinder-platform PUBLIC ${DS_CINDER_DEFINES} )
 
 # Enable C++14
@@ -35,11 +35,11 @@ const char			NUM_INST_ATT = 84;
 
 // Part of the registration mechanism
 void CustomSprite::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "CustomSprite");
 }
 
 void CustomSprite::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<CustomSprite>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<CustomSprite>(r); }, "CustomSprite");
 }
 
 CustomSprite::CustomSprite(SpriteEngine& engine)
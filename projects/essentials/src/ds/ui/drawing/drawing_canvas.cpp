@@ -134,11 +134,11 @@ const int			MAX_SERIALIZED_POINTS	= 100;
 } // anonymous namespace
 
 void DrawingCanvas::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "DrawingCanvas");
 }
 
 void DrawingCanvas::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<DrawingCanvas>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<DrawingCanvas>(r); }, "DrawingCanvas");
 }
 // -- Client/Server Stuff ----------------------------
 
@@ -156,11 +156,11 @@ const std::string lineGeom =
 }
 
 void LineSprite::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromClient(r); }, "LineSprite");
 }
 
 void LineSprite::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromServer<LineSprite>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromServer<LineSprite>(r); }, "LineSprite");
 }
 
 LineSprite::LineSprite(ds::ui::SpriteEngine& eng, const std::vector<ci::vec2>& points)
@@ -49,11 +49,11 @@ const char			PDF_CURPAGE_ATT		= 81;
  * Pdf static
  */
 void Pdf::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);}, "Pdf");
 }
 
 void Pdf::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Pdf>(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Pdf>(r);}, "Pdf");
 }
 
 /**
@@ -156,11 +156,11 @@ GstVideo& GstVideo::makeVideo(SpriteEngine& e, Sprite* parent) {
 }
 
 void GstVideo::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromClient(r); }, "GstVideo");
 }
 
 void GstVideo::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromServer<GstVideo>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) { Sprite::handleBlobFromServer<GstVideo>(r); }, "GstVideo");
 }
 
 /**
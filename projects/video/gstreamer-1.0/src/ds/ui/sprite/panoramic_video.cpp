@@ -34,7 +34,7 @@ void PanoramicVideo::installAsServer(ds::BlobRegistry& registry)
 	_BLOB = registry.add([](ds::BlobReader& r)
 	{
 		Sprite::handleBlobFromClient(r);
-	});
+	}, "PanoramicVideo");
 }
 
 void PanoramicVideo::installAsClient(ds::BlobRegistry& registry)
@@ -42,7 +42,7 @@ void PanoramicVideo::installAsClient(ds::BlobRegistry& registry)
 	_BLOB = registry.add([](ds::BlobReader& r)
 	{
 		Sprite::handleBlobFromServer<PanoramicVideo>(r);
-	});
+	}, "PanoramicVideo");
 }
 
 void PanoramicVideo::installSprite(ds::Engine& engine)
@@ -14,6 +14,7 @@
 #include "ds/app/environment.h"
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/profiler.h"
 #include "ds/content/content_events.h"
 #include "ds/network/https_client.h"
 
@@ -281,6 +282,10 @@ void App::update() {
 	}
 #endif
 
+	// A frame runs from one update to the next, draw included
+	DS_PROFILE_END_FRAME();
+	DS_PROFILE_ZONE("App update");
+
 	mEngine.setAverageFps(getAverageFps());
 
 	DS_LOG_VERBOSE(9, "App::Update fps=" << getAverageFps());
@@ -307,6 +312,7 @@ void App::update() {
 }
 
 void App::draw() {
+	DS_PROFILE_ZONE("App draw");
 	mEngine.draw();
 }
 void App::mouseDown(ci::app::MouseEvent e) {
@@ -381,6 +387,32 @@ void App::writeSpriteHierarchy() {
 	std::cout << buf.str() << std::endl;
 }
 
+void App::writeReplicationStats() {
+	const std::string	path = ds::Environment::expand("%LOCAL%/replication_stats.csv");
+	if(!mEngine.getReplicationStats().isEnabled()) {
+		DS_LOG_WARNING("No replication stats to save, this engine doesn't replicate or server:replication_stats is 0");
+		return;
+	}
+	if(mEngine.getReplicationStats().writeTo(path)) {
+		DS_LOG_INFO("Wrote replication stats to " << path);
+	} else {
+		DS_LOG_WARNING("Couldn't write replication stats to " << path);
+	}
+}
+
+void App::writeProfilerTrace() {
+	const std::string	path = ds::Environment::expand("%LOCAL%/profiler_trace.json");
+	if(!ds::Profiler::get().isEnabled()) {
+		DS_LOG_WARNING("No profiler zones to save, profiler:frames is 0");
+		return;
+	}
+	if(ds::Profiler::get().writeChromeTrace(path)) {
+		DS_LOG_INFO("Wrote profiler trace to " << path);
+	} else {
+		DS_LOG_WARNING("Couldn't write profiler trace to " << path);
+	}
+}
+
 void App::debugEnabledSprites() {
 	DS_LOG_VERBOSE(1, "App::debugEnabledSprites()");
 	const size_t numRoots = mEngine.getRootCount();
@@ -420,6 +452,8 @@ void App::setupKeyPresses() {
 	mKeyManager.registerKey("Quit app", [this] { quit(); }, KeyEvent::KEY_F4);
 	mKeyManager.registerKey("Print available keys", [this] { mKeyManager.printCurrentKeys(); mEngine.getNotifier().notify(EngineStatsView::ToggleHelpRequest()); }, KeyEvent::KEY_h);
 	mKeyManager.registerKey("Toggle stats", [this] {mEngine.getNotifier().notify(EngineStatsView::ToggleStatsRequest()); }, KeyEvent::KEY_s);
+	mKeyManager.registerKey("Save replication stats", [this] { writeReplicationStats(); }, KeyEvent::KEY_s, true);
+	mKeyManager.registerKey("Save profiler trace", [this] { writeProfilerTrace(); }, KeyEvent::KEY_s, false, true);
 	mKeyManager.registerKey("Toggle fullscreen", [this] {setFullScreen(!isFullScreen()); }, KeyEvent::KEY_f);
 	mKeyManager.registerKey("Toggle always on top", [this] {ci::app::getWindow()->setAlwaysOnTop(!ci::app::getWindow()->isAlwaysOnTop()); }, KeyEvent::KEY_a);
 	mKeyManager.registerKey("Toggle idling", [this] {mEngine.isIdling() ? mEngine.resetIdleTimeout() : mEngine.startIdling(); }, KeyEvent::KEY_i);
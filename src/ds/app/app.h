@@ -125,6 +125,10 @@ public:
 
 	/// Logs all sprites to disk for deep debuggin
 	void						writeSpriteHierarchy();
+	/// Dump the frames in the engine's ReplicationStats as CSV.
+	void						writeReplicationStats();
+	/// Dump the frames in the profiler as a Chrome trace.
+	void						writeProfilerTrace();
 
 	/// Show sprites that are enabled
 	void						debugEnabledSprites();
@@ -3,8 +3,10 @@
 #include "ds/app/auto_update_list.h"
 
 #include <algorithm>
+#include <typeinfo>
 #include <Poco/Timestamp.h>
 #include "ds/app/auto_update.h"
+#include "ds/debug/profiler.h"
 #include "ds/params/update_params.h"
 
 namespace ds {
@@ -27,6 +29,7 @@ void AutoUpdateList::update(const ds::UpdateParams &p) {
 	if (mRunning.empty()) return;
 
 	for (auto it : mRunning) {
+		DS_PROFILE_ZONE(typeid(*it));
 		it->update(p);
 	}
 }
@@ -11,17 +11,28 @@ namespace ds {
 BlobRegistry::BlobRegistry()
 {
   mReader.reserve(32);
+  mNames.reserve(32);
   // Install an empty handler at index 0, because we don't want anyone
   // assigned byte '0' for transport.
   mReader.push_back(nullptr);
+  mNames.push_back(std::string());
 }
 
-char BlobRegistry::add(const std::function<void(BlobReader&)>& reader)
+char BlobRegistry::add(const std::function<void(BlobReader&)>& reader, const std::string& name)
 {
   assert(mReader.size() < 120);
   const char        index = static_cast<char>(mReader.size());
   mReader.push_back(reader);
+  mNames.push_back(name);
   return index;
 }
 
+const std::string& BlobRegistry::getName(const char key) const
+{
+  static const std::string  EMPTY;
+  const size_t      index = static_cast<size_t>(static_cast<unsigned char>(key));
+  if (index >= mNames.size()) return EMPTY;
+  return mNames[index];
+}
+
 } // namespace ds
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define DS_APP_BLOBREGISTRY_H_
 
 #include <functional>
+#include <string>
 #include <vector>
 
 namespace ds {
@@ -19,7 +20,13 @@ class BlobRegistry {
     BlobRegistry();
 
     /// Add a new blob handler.  I answer with the unique key assigned the handler.
-    char              add(const std::function<void(BlobReader&)>& reader);
+    /// The name labels the blob in the replication stats, so use the same one on server and client.
+    char              add(const std::function<void(BlobReader&)>& reader, const std::string& name = std::string());
+
+    /// One past the last key handed out.
+    size_t            size() const { return mReader.size(); }
+    /// The name the handler for key was added with, or empty.
+    const std::string& getName(const char key) const;
 
   private:
     friend class EngineClient;
@@ -27,6 +34,8 @@ class BlobRegistry {
     friend class EngineReceiver;
     std::vector<std::function<void(BlobReader&)>>
                       mReader;
+    std::vector<std::string>
+                      mNames;
 };
 
 } // namespace ds
@@ -16,6 +16,8 @@
 #endif
 #include "ds/debug/debug_defines.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/memory_accounting.h"
+#include "ds/debug/profiler.h"
 #include "ds/math/math_defs.h"
 #include "ds/metrics/metrics_service.h"
 #include "ds/ui/touch/draw_touch_view.h"
@@ -31,6 +33,10 @@
 //! function Poco::Path::expand. This slowly needs
 //! to get removed. Poco is not part of the Cinder.
 #include <Poco/Path.h>
+#include <algorithm>
+#include <sstream>
+#include <typeindex>
+#include <typeinfo>
 
 //#include <boost/algorithm/string/predicate.hpp>
 
@@ -65,9 +71,9 @@ Engine::Engine(ds::App& app, ds::EngineSettings &settings,
 	, mPangoFontService(*this)
 	, mSettings(settings)
 	, mSettingsEditor(nullptr)
-	, mTouchBeginEvents(mTouchMutex,	mLastTouchTime,  [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesBegan(e); this->mTouchManager.touchesBegin(e);}, "touchbegin")
-	, mTouchMovedEvents(mTouchMutex,	mLastTouchTime,  [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesMoved(e); this->mTouchManager.touchesMoved(e);}, "touchmoved")
-	, mTouchEndedEvents(mTouchMutex,	mLastTouchTime,  [&app, this](const ds::ui::TouchEvent& e) {app.onTouchesEnded(e); this->mTouchManager.touchesEnded(e);}, "touchend")
+	, mTouchInput(mLastTouchTime,	[&app, this](const ds::ui::TouchEvent& e) {app.onTouchesBegan(e); this->mTouchManager.touchesBegin(e);},
+									[&app, this](const ds::ui::TouchEvent& e) {app.onTouchesMoved(e); this->mTouchManager.touchesMoved(e);},
+									[&app, this](const ds::ui::TouchEvent& e) {app.onTouchesEnded(e); this->mTouchManager.touchesEnded(e);})
 	, mMouseBeginEvents(mTouchMutex,	mLastTouchTime,  [this](const MousePair& e)  {handleMouseTouchBegin(e.first, e.second);}, "mousebegin")
 	, mMouseMovedEvents(mTouchMutex,	mLastTouchTime,  [this](const MousePair& e)  {handleMouseTouchMoved(e.first, e.second);}, "mousemoved")
 	, mMouseEndedEvents(mTouchMutex,	mLastTouchTime,  [this](const MousePair& e)  {handleMouseTouchEnded(e.first, e.second);}, "mouseend")
@@ -90,7 +96,10 @@ Engine::Engine(ds::App& app, ds::EngineSettings &settings,
 	, mFonts(*this)
 	, mEventClient(ed.mNotifier, [this](const ds::Event *m){ if(m) onAppEvent(*m); })
 	, mAutoRefresh(*this)
+	, mMemoryLogInterval(0.0f)
+	, mLastMemoryLog(0.0f)
 {
+	mTouchInput.setHistoryFn([this](const ds::ui::TouchEvent& e) {this->mTouchManager.touchesMovedHistory(e);});
 
 
 	ds::event::Registry::get().addEventCreator(ds::app::RequestAppExitEvent::NAME(), [this]()->ds::Event* {return new ds::app::RequestAppExitEvent(); });
@@ -131,6 +140,10 @@ void Engine::setupEngine() {
 	setupIdleTimeout();
 	setupMetrics();
 	setupAutoRefresh();
+	setupWorkManager();
+	setupParallelUpdate();
+	setupProfiler();
+	setupMemoryLog();
 }
 
 void Engine::setupLogger() {
@@ -373,6 +386,62 @@ void Engine::setupAutoRefresh() {
 	mAutoRefresh.initialize();
 }
 
+void Engine::setupWorkManager() {
+	mWorkManager.setUpdateBudget(mSettings.getInt("work:update_budget"), mSettings.getInt("work:update_max_results"));
+}
+
+void Engine::setupParallelUpdate() {
+	mParallelUpdate.setThreadCount(mSettings.getInt("update:parallel_threads"));
+}
+
+void Engine::setupProfiler() {
+	const int		frames = mSettings.getInt("profiler:frames");
+	ds::Profiler::get().setCapacity(frames > 0 ? static_cast<size_t>(frames) : 0);
+	ds::Profiler::get().setSpriteZones(mSettings.getBool("profiler:sprite_zones"));
+}
+
+void Engine::setupMemoryLog() {
+	mMemoryLogInterval = static_cast<float>(mSettings.getInt("memory:log_interval"));
+}
+
+void Engine::updateMemoryLog(const float curr) {
+	if(mMemoryLogInterval <= 0.0f || curr - mLastMemoryLog < mMemoryLogInterval) return;
+	mLastMemoryLog = curr;
+
+	std::vector<std::pair<std::string, std::string>>	stats;
+	getMemoryStats(stats);
+	std::stringstream				ss;
+	for(auto& it : stats) {
+		if(ss.tellp() > 0) ss << "; ";
+		ss << it.first << ": " << it.second;
+	}
+	DS_LOG_INFO("Memory: " << ss.str());
+}
+
+void Engine::getMemoryStats(std::vector<std::pair<std::string, std::string>>& out) {
+	// Sprites are counted by walking the registered ones, since only the whole sprite knows its class
+	// Keyed by type, so the names are only looked up once per class
+	std::unordered_map<std::type_index, std::pair<const std::type_info*, size_t>>	classes;
+	for(auto s : mSprites.getAll()) {
+		if(!s) continue;
+		const std::type_info&		type = typeid(*s);
+		auto&						count = classes[std::type_index(type)];
+		count.first = &type;
+		++count.second;
+	}
+	std::vector<std::pair<size_t, std::string>>	sorted;
+	for(auto& it : classes) sorted.push_back(std::make_pair(it.second.second, std::string(ds::Profiler::getClassName(*it.second.first))));
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b) { return a.first > b.first; });
+
+	std::stringstream				ss;
+	ss << mSprites.size();
+	for(size_t k = 0; k < sorted.size() && k < 5; ++k) ss << (k == 0 ? " (" : ", ") << sorted[k].second << " " << sorted[k].first;
+	if(!sorted.empty()) ss << (sorted.size() > 5 ? ", ...)" : ")");
+	out.push_back(std::make_pair("Sprites", ss.str()));
+
+	ds::MemoryAccounting::get().getSummary(out);
+}
+
 void Engine::toggleConsole() {
 	if(mShowConsole) hideConsole();
 	else showConsole();
@@ -456,6 +525,14 @@ void Engine::onAppEvent(const ds::Event& in_e){
 				setupIdleTimeout();
 			} else if(e.mSettingName == "platform:mute"){
 				setupMute();
+			} else if(e.mSettingName.find("work:") == 0){
+				setupWorkManager();
+			} else if(e.mSettingName == "update:parallel_threads"){
+				setupParallelUpdate();
+			} else if(e.mSettingName.find("profiler:") == 0){
+				setupProfiler();
+			} else if(e.mSettingName == "memory:log_interval"){
+				setupMemoryLog();
 			} else if(e.mSettingName.find("touch") != std::string::npos){
 				setupTouch(mDsApp);
 			} else if(e.mSettingName == "animation:duration") {
@@ -551,6 +628,7 @@ void Engine::setupTouch(ds::App& app) {
 	
 	setTouchSmoothing(mSettings.getBool("touch:smoothing"));
 	setTouchSmoothFrames(mSettings.getInt("touch:smooth_frames"));
+	mTouchInput.setCoalesce(mSettings.getBool("touch:coalesce_moves"));
 
 
 	mData.mMinTapDistance = mSettings.getFloat("touch:tap_threshold");
@@ -828,11 +906,18 @@ void Engine::updateClient() {
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
-	mAutoUpdateClient.update(mUpdateParams);
+	{
+		DS_PROFILE_ZONE("Engine auto update");
+		mAutoUpdateClient.update(mUpdateParams);
+	}
+	updateMemoryLog(curr);
 
+	DS_PROFILE_ZONE("Engine sprite update");
+	updateParallel(false);
 	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
 		(*it)->updateClient(mUpdateParams);
 	}
+	mParallelUpdate.finish();
 }
 
 void Engine::updateServer() {
@@ -856,36 +941,54 @@ void Engine::updateServer() {
 		mMouseMovedEvents.lockedUpdate();
 		mMouseEndedEvents.lockedUpdate();
 
-		mTouchBeginEvents.lockedUpdate();
-		mTouchMovedEvents.lockedUpdate();
-		mTouchEndedEvents.lockedUpdate();
-
 		mTuioObjectsBegin.lockedUpdate();
 		mTuioObjectsMoved.lockedUpdate();
 		mTuioObjectsEnded.lockedUpdate();
 	} // unlock touch mutex
 	//////////////////////////////////////////////////////////////////////////
 
-	mMouseBeginEvents.update(curr);
-	mMouseMovedEvents.update(curr);
-	mMouseEndedEvents.update(curr);
+	{
+		DS_PROFILE_ZONE("Engine input");
+		mMouseBeginEvents.update(curr);
+		mMouseMovedEvents.update(curr);
+		mMouseEndedEvents.update(curr);
 
-	mTouchBeginEvents.update(curr);
-	mTouchMovedEvents.update(curr);
-	mTouchEndedEvents.update(curr);
+		mTouchInput.update(curr);
 
-	mTuioObjectsBegin.update(curr);
-	mTuioObjectsMoved.update(curr);
-	mTuioObjectsEnded.update(curr);
+		mTuioObjectsBegin.update(curr);
+		mTuioObjectsMoved.update(curr);
+		mTuioObjectsEnded.update(curr);
+	}
 
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
-	mAutoUpdateServer.update(mUpdateParams);
+	{
+		DS_PROFILE_ZONE("Engine auto update");
+		mAutoUpdateServer.update(mUpdateParams);
+	}
+	updateMemoryLog(curr);
 
+	DS_PROFILE_ZONE("Engine sprite update");
+	updateParallel(true);
 	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
 		(*it)->updateServer(mUpdateParams);
 	}
+	mParallelUpdate.finish();
+}
+
+void Engine::updateParallel(const bool server) {
+	if(!mParallelUpdate.isEnabled()) return;
+	DS_PROFILE_ZONE("Engine parallel update");
+
+	mParallelRoots.clear();
+	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
+		ui::Sprite*		s = (*it)->getSprite();
+		if(s) mParallelRoots.push_back(s);
+	}
+	mDirtySprites.setConcurrent(true);
+	mParallelUpdate.update(mParallelRoots, mUpdateParams, server);
+	mDirtySprites.setConcurrent(false);
 }
 
 void Engine::markCameraDirty() {
@@ -986,6 +1089,7 @@ void Engine::drawClient() {
 
 	ci::gl::clear(ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f));
 
+	DS_PROFILE_ZONE("Engine draw");
 	for(auto it = getRoots().begin(), end = getRoots().end(); it != end; ++it){
 		(*it)->drawClient(getDrawParams(), getAutoDrawService());
 	}
@@ -996,11 +1100,19 @@ void Engine::drawServer() {
 
 	ci::gl::clear(ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f));
 
+	DS_PROFILE_ZONE("Engine draw");
 	for(auto it = getRoots().cbegin(), end = getRoots().cend(); it != end; ++it){
 		(*it)->drawServer(getDrawParams());
 	}
 }
 
+void Engine::nameReplicatedBlobs() {
+	for(size_t i = 1; i < mBlobRegistry.size(); ++i) {
+		const char			blob = static_cast<char>(i);
+		if(!mBlobRegistry.getName(blob).empty()) mReplicationStats.nameBlob(blob, mBlobRegistry.getName(blob));
+	}
+}
+
 ds::sprite_id_t Engine::nextSpriteId() {
 	static ds::sprite_id_t              ID = 0;
 	++ID;
@@ -1015,7 +1127,7 @@ void Engine::registerSprite(ds::ui::Sprite& s) {
 		assert(false);
 		return;
 	}
-	mSprites[s.getId()] = &s;
+	mSprites.set(s.getId(), &s);
 }
 
 void Engine::unregisterSprite(ds::ui::Sprite& s) {
@@ -1025,15 +1137,11 @@ void Engine::unregisterSprite(ds::ui::Sprite& s) {
 		assert(false);
 		return;
 	}
-	auto it = mSprites.find(s.getId());
-	if (it != mSprites.end()) mSprites.erase(it);
+	mSprites.erase(s.getId());
 }
 
 ds::ui::Sprite* Engine::findSprite(const ds::sprite_id_t id) {
-	if (mSprites.empty()) return nullptr;
-	auto it = mSprites.find(id);
-	if (it == mSprites.end()) return nullptr;
-	return it->second;
+	return mSprites.find(id);
 }
 
 void Engine::spriteDeleted(const ds::sprite_id_t&) {
@@ -1051,15 +1159,15 @@ ci::Color8u Engine::getUniqueColor() {
 }
 
 void Engine::touchesBegin(const ds::ui::TouchEvent &e) {
-	mTouchBeginEvents.incoming(mTouchTranslator.toWorldSpace(e));
+	mTouchInput.incoming(ds::EngineTouchInput::PHASE_BEGIN, mTouchTranslator.toWorldSpace(e));
 }
 
 void Engine::touchesMoved(const ds::ui::TouchEvent &e) {
-	mTouchMovedEvents.incoming(mTouchTranslator.toWorldSpace(e));
+	mTouchInput.incoming(ds::EngineTouchInput::PHASE_MOVED, mTouchTranslator.toWorldSpace(e));
 }
 
 void Engine::touchesEnded(const ds::ui::TouchEvent &e) {
-	mTouchEndedEvents.incoming(mTouchTranslator.toWorldSpace(e));
+	mTouchInput.incoming(ds::EngineTouchInput::PHASE_ENDED, mTouchTranslator.toWorldSpace(e));
 }
 
 ci::tuio::Client &Engine::getTuioClient() {
@@ -1191,6 +1299,8 @@ void Engine::nextTouchMode() {
 
 void Engine::setTouchSmoothing(const bool doSmoothing){
 	mTouchManager.setTouchSmoothing(doSmoothing);
+	// Smoothing averages over samples, so it wants the moves that got folded together too
+	mTouchInput.setKeepHistory(doSmoothing);
 }
 
 void Engine::setTouchSmoothFrames(const int smoothFrames){
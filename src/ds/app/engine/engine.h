@@ -22,6 +22,7 @@
 
 #include "TuioClient.h"
 
+#include "ds/app/engine/engine_touch_input.h"
 #include "ds/app/engine/engine_touch_queue.h"
 #include <ds/app/event_client.h>
 #include "ds/data/color_list.h"
@@ -33,6 +34,7 @@
 #include "ds/ui/service/pango_font_service.h"
 #include "ds/ui/service/load_image_service.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/sprite/sprite_id_map.h"
 #include "ds/ui/touch/touch_manager.h"
 #include "ds/ui/touch/touch_translator.h"
 #include "ds/ui/touch/tuio_input.h"
@@ -197,6 +199,11 @@ public:
 	/// to make sure everything is stopped before they go away.
 	virtual void						stopServices();
 
+	/// Extra name/value lines for the stats view about how replication is keeping up. Nothing if this engine doesn't replicate.
+	virtual void						getNetworkStats(std::vector<std::pair<std::string, std::string>>&) {}
+	/// Name/value lines for the stats view and memory log about what each subsystem is holding on to, sprites by class included.
+	void								getMemoryStats(std::vector<std::pair<std::string, std::string>>&);
+
 	void								setHideMouse(const bool doMouseHide);
 	bool								getHideMouse() const;
 	bool								getAutoHideMouse() const { return mAutoHideMouse; }
@@ -258,8 +265,12 @@ protected:
 	/// Conveniences for the subclases
 	void								updateClient();
 	void								updateServer();
+	/// Update the subtrees that opted in to it across the worker threads, before the regular walk.
+	void								updateParallel(const bool server);
 	void								drawClient();
 	void								drawServer();
+	/// Label the blobs in the replication stats with the names they were registered under. Call after registering any.
+	void								nameReplicatedBlobs();
 
 	/** When mouse events are ready to be handled by the touch manager. 
 		These are enforced virtual functions to be sure the engine handles mouse events.
@@ -274,8 +285,7 @@ protected:
 	static const int					NumberOfNetworkThreads;
 
 	ds::BlobRegistry					mBlobRegistry;
-	std::unordered_map<ds::sprite_id_t, ds::ui::Sprite*>
-										mSprites;
+	ds::ui::SpriteIdMap					mSprites;
 	int									mTuioPort;
 
 	ds::ui::TouchMode::Enum				mTouchMode;
@@ -301,6 +311,12 @@ private:
 	void								setupRoots();
 	void								setupMetrics();
 	void								setupAutoRefresh();
+	void								setupWorkManager();
+	void								setupParallelUpdate();
+	void								setupProfiler();
+	void								setupMemoryLog();
+	/// Log the memory stats if it's been memory:log_interval seconds
+	void								updateMemoryLog(const float curr);
 
 	friend class EngineStatsView;
 	std::vector<std::unique_ptr<EngineRoot> >
@@ -318,6 +334,8 @@ private:
 	RootList							mRequestedRootList;
 	UpdateParams						mUpdateParams;
 	DrawParams							mDrawParams;
+	/// Scratch for updateParallel()
+	std::vector<ui::Sprite*>			mParallelRoots;
 	float								mLastTime;
 	bool								mIdling;
 	float								mLastTouchTime;
@@ -343,12 +361,8 @@ private:
 
 	ds::ui::TouchTranslator				mTouchTranslator;
 	std::mutex							mTouchMutex;
-	ds::EngineTouchQueue<ds::ui::TouchEvent>
-										mTouchBeginEvents;
-	ds::EngineTouchQueue<ds::ui::TouchEvent>
-										mTouchMovedEvents;
-	ds::EngineTouchQueue<ds::ui::TouchEvent>
-										mTouchEndedEvents;
+	/// Touches go through a lock-free ring that folds each finger's moves into one per frame
+	ds::EngineTouchInput				mTouchInput;
 	typedef std::pair<ci::app::MouseEvent, int> MousePair;
 	ds::EngineTouchQueue<MousePair>		mMouseBeginEvents;
 	ds::EngineTouchQueue<MousePair>		mMouseMovedEvents;
@@ -379,6 +393,8 @@ private:
 										mChannels;
 
 	float								mAverageFps;
+	float								mMemoryLogInterval;
+	float								mLastMemoryLog;
 
 	/// For listening to settings changes and applying them
 	void								onAppEvent(const ds::Event&);
@@ -6,12 +6,15 @@
 #include "ds/app/engine/engine_data.h"
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/profiler.h"
 #include "ds/ui/sprite/image.h"
 #include "ds/util/string_util.h"
 #include <cinder/Rand.h>
 #include "snappy.h"
+#include <sstream>
 
 #include "ds/debug/computer_info.h"
+#include "ds/network/network_info.h"
 
 namespace ds {
 
@@ -42,6 +45,11 @@ EngineClient::EngineClient(	ds::App& app, ds::EngineSettings& settings,
 		, mBlobReader(mReceiver.getData(), *this)
 		, mSessionId(0)
 		, mConnectionRenewed(false)
+		, mAwaitingKeyframe(false)
+		, mResumeWait(0)
+		, mResumeRequests(0)
+		, mUseReceiveThread(false)
+		, mMaxFrameBacklog(0)
 		, mServerFrame(-1)
 		, mState(nullptr)
 		, mIoInfo(*this)
@@ -49,17 +57,26 @@ EngineClient::EngineClient(	ds::App& app, ds::EngineSettings& settings,
 
 	// NOTE:  Must be EXACTLY the same items as in EngineServer, in same order,
 	// so that the BLOB ids match.
-	HEADER_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveHeader(r.mDataBuffer);});
-	COMMAND_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveCommand(r.mDataBuffer);});
-	DELETE_SPRITE_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveDeleteSprite(r.mDataBuffer);});
-	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer); });
-	CLIENT_INPUT_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientInput(r.mDataBuffer); });
+	HEADER_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveHeader(r.mDataBuffer);}, "header");
+	COMMAND_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveCommand(r.mDataBuffer);}, "command");
+	DELETE_SPRITE_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveDeleteSprite(r.mDataBuffer);}, "delete sprite");
+	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer); }, "client status");
+	CLIENT_INPUT_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientInput(r.mDataBuffer); }, "client input");
 	mReceiver.setHeaderAndCommandIds(HEADER_BLOB, COMMAND_BLOB);
-	
+	mSender.setCodec(ds::net::codecFromString(settings.getString("server:compression", 0, "snappy")));
+	setAttributeEncoding(ds::CompactEncoding::fromSettings(settings));
+	mLocalAddress = ds::network::networkInfo().getAddress();
+	mUseReceiveThread = settings.getBool("client:receive_thread", 0, true);
+	mMaxFrameBacklog = static_cast<size_t>(std::max(0, settings.getInt("client:max_frame_backlog", 0, 120)));
+	mReplicationStats.setCapacity(static_cast<size_t>(std::max(0, settings.getInt("server:replication_stats", 0, 600))));
+	nameReplicatedBlobs();
+	mReceiver.setReplicationStats(&mReplicationStats);
+
 	try {
 		if (settings.getBool("server:connect", 0, true)) {
 			mSendConnection.initialize(true, settings.getString("server:ip"), ds::value_to_string(settings.getInt("server:listen_port")));
 			mReceiveConnection.initialize(false, settings.getString("server:ip"), ds::value_to_string(settings.getInt("server:send_port")));
+			if (mUseReceiveThread) mReceiver.startReceiveThread();
 		}
 	} catch(std::exception &e) {
 		DS_LOG_ERROR_M("EngineClient::EngineClient() initializing UDP: " << e.what(), ds::ENGINE_LOG);
@@ -69,6 +86,7 @@ EngineClient::EngineClient(	ds::App& app, ds::EngineSettings& settings,
 }
 
 EngineClient::~EngineClient() {
+	mReceiver.stopReceiveThread();
 	// It's important to clean up the sprites before the services go away
 	clearRoots();
 }
@@ -76,6 +94,7 @@ EngineClient::~EngineClient() {
 void EngineClient::installSprite( const std::function<void(ds::BlobRegistry&)>& asServer,
 								  const std::function<void(ds::BlobRegistry&)>& asClient) {
 	if (asClient) asClient(mBlobRegistry);
+	nameReplicatedBlobs();
 }
 
 ds::sprite_id_t EngineClient::nextSpriteId() {
@@ -93,7 +112,9 @@ void EngineClient::update() {
 		){
 		// This can happen because the network connection drops, so
 		// refresh it, and let the world now I'm ready again.
+		mReceiver.stopReceiveThread();
 		mReceiveConnection.renew();
+		if (mUseReceiveThread) mReceiver.startReceiveThread();
 		mSendConnection.renew();
 		mReceiver.clearLostConnection();
 
@@ -107,11 +128,19 @@ void EngineClient::update() {
 
 
 	// Every update, receive data
+	DS_PROFILE_ZONE("Engine replication");
 	mReceiver.setHeaderAndCommandOnly(mState->getHeaderAndCommandOnly());
 
 	// Don't change state or take any action if there's no data waiting
 	if(!mReceiver.receiveBlob()) return;
 
+	// Don't replay a backlog that a keyframe would replace
+	if(skipBacklog()) return;
+
+	// Recover lost chunks before they hold up too many frames
+	sendChunkRequests();
+	mReceiver.setHeaderAndCommandOnly(mState->getHeaderAndCommandOnly());
+
 	// Run through all the blobs we just 
 	while(true) {
 		bool moreData = false;
@@ -135,6 +164,7 @@ void EngineClient::draw() {
 }
 
 void EngineClient::stopServices() {
+	mReceiver.stopReceiveThread();
 	Engine::stopServices();
 	mWorkManager.stopManager();
 }
@@ -147,9 +177,35 @@ int EngineClient::getBytesSent(){
 	return mSendConnection.getSentBytes();
 }
 
+int EngineClient::getBytesPerFrame(){
+	return static_cast<int>(mReceiver.getLastFrameSize());
+}
+
+void EngineClient::getNetworkStats(std::vector<std::pair<std::string, std::string>>& stats){
+	if(mReceiver.isReceiveThreadRunning() || mReceiver.getSkippedFrames() > 0) {
+		std::stringstream	ss;
+		ss << mReceiver.getQueuedFrames() << " queued, " << mReceiver.getSkippedFrames() << " skipped";
+		stats.push_back(std::make_pair("Receive Thread", ss.str()));
+	}
+
+	mReplicationStats.getSummary(stats);
+}
+
 void EngineClient::receiveHeader(ds::DataBuffer& data) {
 	if (data.canRead<int32_t>()) {
-		mServerFrame = data.read<int32_t>();
+		// Anything that isn't part of the frame sequence (world, replies, keyframes) sends -1
+		const int32_t	frame = data.read<int32_t>();
+		if (frame >= 0) mServerFrame = frame;
+
+		if (data.canRead<int64_t>()) {
+			const int64_t	sentAt = data.read<int64_t>();
+			if (mReplicationStats.isEnabled()) {
+				ds::net::ReplicationStats::Frame&	f = mReplicationStats.getPending();
+				f.mFrame = frame;
+				// Anything below zero is just the clocks disagreeing
+				f.mLatencySeconds = std::max(0.0, static_cast<double>(ds::net::ReplicationStats::getEpochMicroseconds() - sentAt) / 1000000.0);
+			}
+		}
 	} else {
 		DS_LOG_WARNING_M("EngineClient::receiveHeader() invalid server frame. This is likely a net communication issue, packets lost, etc.", ds::IO_LOG);
 	}
@@ -167,6 +223,8 @@ void EngineClient::receiveCommand(ds::DataBuffer& data) {
 		if (cmd == CMD_SERVER_SEND_WORLD) {
 			DS_LOG_INFO_M("Receive world, sessionid=" << mSessionId, ds::IO_LOG);
 			clearAllSprites(false);
+			mReceiver.holdStream(false);
+			mAwaitingKeyframe = false;
 
 			if (mSessionId < 1) {
 				setState(mClientStartedState);
@@ -178,6 +236,8 @@ void EngineClient::receiveCommand(ds::DataBuffer& data) {
 		} else if(cmd == CMD_CLIENT_STARTED_REPLY) {
 			DS_LOG_INFO_M("Receive ClientStartedReply", ds::IO_LOG);
 			onClientStartedReplyCommand(data);
+		} else if(cmd == CMD_SERVER_SEND_KEYFRAME) {
+			onServerSendKeyframeCommand(data);
 		}
 	}
 }
@@ -191,14 +251,10 @@ void EngineClient::receiveDeleteSprite(ds::DataBuffer& data) {
 		if (data.canRead<sprite_id_t>()) {
 			const sprite_id_t	id = data.read<sprite_id_t>();
 
-			if (!mSprites.empty()) {
-				auto f = mSprites.find(id);
-				if (f != mSprites.end()) {
-					// Once I delete this item, mSprites will have been updated,
-					// with f->second and all children removed, so do not reference f again.
-					if (f->second) f->second->release();
-				}
-			}
+			// Once I delete this item, mSprites will have been updated,
+			// with it and all children removed, so do not reference it again.
+			ds::ui::Sprite*		s = mSprites.find(id);
+			if (s) s->release();
 		} else {
 			break;
 		}
@@ -239,11 +295,17 @@ void EngineClient::onClientStartedReplyCommand(ds::DataBuffer& data) {
 			std::string		guid;
 			int32_t			sessionid(0);
 			unsigned int	chunkerId(0);
+			char			codec(mSender.getCodec());
+			ds::CompactEncoding	encoding(getAttributeEncoding());
 			while (data.canRead<char>() && (att=data.read<char>()) != ds::TERMINATOR_CHAR) {
 				if (att == ATT_GLOBAL_ID) {
 					guid = data.read<std::string>();
 				} else if (att == ATT_SESSION_ID) {
 					sessionid = data.read<int32_t>();
+				} else if(att == ATT_CODEC) {
+					codec = data.read<char>();
+				} else if(att == ATT_ENCODING) {
+					encoding.readFrom(data);
 				} else if(att == ATT_ROOTS){
 					std::vector<RootList::Root> roots;
 					int numRoots = data.read<int32_t>();
@@ -271,12 +333,134 @@ void EngineClient::onClientStartedReplyCommand(ds::DataBuffer& data) {
 			if (guid == mIoInfo.mGlobalId) {
 				mSessionId = sessionid;
 				mSender.setPacketNumber(chunkerId);
+				mSender.setCodec(static_cast<ds::net::Codec>(codec));
+				setAttributeEncoding(encoding);
 				setState(mBlankState);
 			}
 		} 
 	}
 }
 
+void EngineClient::onServerSendKeyframeCommand(ds::DataBuffer& data) {
+	if (!data.canRead<char>() || data.read<char>() != ATT_SESSION_ID || !data.canRead<int32_t>()) return;
+	const int32_t		sessionId = data.read<int32_t>();
+	if (!data.canRead<char>() || data.read<char>() != ATT_FRAME || !data.canRead<int32_t>()) return;
+	const int32_t		frame = data.read<int32_t>();
+	if (!data.canRead<char>() || data.read<char>() != ATT_GROUP || !data.canRead<unsigned>()) return;
+	const unsigned		groupId = data.read<unsigned>();
+
+	// Not mine, not wanted, or the stream already caught up past it
+	if (mSessionId < 1 || !mAwaitingKeyframe
+		|| (sessionId != 0 && sessionId != mSessionId)
+		|| (mState == &mRunningState && mServerFrame >= frame)) {
+		mReceiver.skipRemainingData();
+		return;
+	}
+
+	DS_LOG_INFO_M("Receive keyframe, frame=" << frame << " sessionid=" << mSessionId, ds::IO_LOG);
+	clearAllSprites(false);
+
+	// Make sure the rest of the blobs are handled
+	mReceiver.setHeaderAndCommandOnly(false);
+	setState(mRunningState);
+	mServerFrame = frame;
+
+	// The keyframe covers everything before groupId, so the main stream picks up from there
+	mReceiver.resumeAt(groupId);
+	mReceiver.holdStream(false);
+	mAwaitingKeyframe = false;
+	mResumeRequests = 0;
+}
+
+void EngineClient::sendChunkRequests() {
+	if(mResumeWait > 0) --mResumeWait;
+
+	if(mReceiver.hasUnrecoverableLoss()) {
+		if(mSessionId < 1) {
+			mReceiver.resetChunks();
+			return;
+		}
+
+		// Keep everything I have, and ask to pick up where I left off. The blank state asks on its own.
+		if(mState == &mRunningState && mResumeWait <= 0) {
+			DS_LOG_WARNING_M("EngineClient: lost chunks couldn't be recovered. Asking the server to resume from frame " << mServerFrame, ds::IO_LOG);
+			sendResumeRequest();
+			mResumeWait = ci::randInt(30, 240);
+		}
+		return;
+	}
+
+	// Caught up again without needing a keyframe
+	if(mAwaitingKeyframe && mState == &mRunningState && mReceiver.getPendingGroups() <= 1) {
+		mAwaitingKeyframe = false;
+		mResumeRequests = 0;
+	}
+
+	mReceiver.getMissingChunks(mMissingChunks);
+	if(mMissingChunks.empty()) return;
+
+	EngineSender::AutoSend  send(mSender);
+	ds::DataBuffer&   buf = send.mData;
+	buf.add(COMMAND_BLOB);
+	buf.add(CMD_CLIENT_REQUEST_CHUNKS);
+	buf.add(ATT_SESSION_ID);
+	buf.add(mSessionId);
+	buf.add(ATT_CHUNKS);
+	buf.add(static_cast<int32_t>(mMissingChunks.size()));
+	for(auto& group : mMissingChunks) {
+		buf.add(group.mGroupId);
+		// Past a certain point it's cheaper to just ask for the whole group
+		if(group.mIds.size() > 256) {
+			buf.add(static_cast<int32_t>(0));
+		} else {
+			buf.add(static_cast<int32_t>(group.mIds.size()));
+			for(auto id : group.mIds) {
+				buf.add(id);
+			}
+		}
+	}
+	buf.add(ds::TERMINATOR_CHAR);
+}
+
+void EngineClient::sendResumeRequest() {
+	mAwaitingKeyframe = true;
+
+	EngineSender::AutoSend  send(mSender);
+	ds::DataBuffer&   buf = send.mData;
+	buf.add(COMMAND_BLOB);
+	buf.add(CMD_CLIENT_REQUEST_RESUME);
+	buf.add(ATT_SESSION_ID);
+	buf.add(mSessionId);
+	buf.add(ATT_FRAME);
+	buf.add(mState == &mRunningState ? mServerFrame : static_cast<int32_t>(-1));
+	buf.add(ATT_GROUP);
+	buf.add(mReceiver.getNextGroupId());
+	// Every other try goes without an address, so the keyframe comes over multicast
+	// in case something between here and the server is eating it.
+	if(!mLocalAddress.empty() && mResumeRequests % 2 == 0) {
+		buf.add(ATT_ADDRESS);
+		buf.add(mLocalAddress);
+	}
+	buf.add(ds::TERMINATOR_CHAR);
+
+	++mResumeRequests;
+}
+
+bool EngineClient::skipBacklog() {
+	if(mMaxFrameBacklog < 1 || mState != &mRunningState || mSessionId < 1) return false;
+
+	const size_t		backlog = mReceiver.getQueuedFrames();
+	if(backlog <= mMaxFrameBacklog) return false;
+
+	DS_LOG_WARNING_M("EngineClient: " << backlog << " frames behind the server, skipping ahead with a keyframe", ds::IO_LOG);
+	mReceiver.dropQueuedFrames();
+	// The blank state holds the stream and keeps asking until the keyframe shows up.
+	// Everything on screen stays put until then.
+	setState(mBlankState);
+	mState->update(*this);
+	return true;
+}
+
 void EngineClient::setState(State& s) {
 	if (&s == mState) return;
   
@@ -357,9 +541,12 @@ EngineClient::ClientStartedState::ClientStartedState()
 		: mSendFrame(0) {
 }
 
-void EngineClient::ClientStartedState::begin(EngineClient&) {
+void EngineClient::ClientStartedState::begin(EngineClient& engine) {
 	DS_LOG_INFO_M("ClientStartedState", ds::IO_LOG);
 	mSendFrame = 0;
+	// The started reply comes on the main stream
+	engine.mReceiver.holdStream(false);
+	engine.mAwaitingKeyframe = false;
 }
 
 void EngineClient::ClientStartedState::update(EngineClient& engine) {
@@ -398,11 +585,11 @@ void EngineClient::BlankState::begin(EngineClient&) {
 
 void EngineClient::BlankState::update(EngineClient& engine) {
 	if (mSendFrame <= 0) {
-		EngineSender::AutoSend  send(engine.mSender);
-		ds::DataBuffer&   buf = send.mData;
-		buf.add(COMMAND_BLOB);
-		buf.add(CMD_CLIENT_REQUEST_WORLD);
-		buf.add(ds::TERMINATOR_CHAR);
+		// Start the main stream over and hold it, so nothing between the keyframe
+		// and whenever it shows up gets thrown away while I'm blank.
+		engine.mReceiver.resetChunks();
+		engine.mReceiver.holdStream(true);
+		engine.sendResumeRequest();
 
 		// Randomize the amount of time to wait for a retry. 
 		// If there are multiple clients that started at the same time, we could be flooding the server with new world requests
@@ -33,6 +33,8 @@ public:
 
 	virtual int						getBytesRecieved();
 	virtual int						getBytesSent();
+	virtual int						getBytesPerFrame();
+	virtual void					getNetworkStats(std::vector<std::pair<std::string, std::string>>&);
 
 	/// The most recent frame received from the server.
 	int32_t							mServerFrame;
@@ -44,6 +46,13 @@ private:
 	void							receiveClientStatus(ds::DataBuffer&);
 	void							receiveClientInput(ds::DataBuffer&);
 	void							onClientStartedReplyCommand(ds::DataBuffer&);
+	void							onServerSendKeyframeCommand(ds::DataBuffer&);
+	/// Ask the server for any chunks that went missing, or to resume if they can't be recovered.
+	void							sendChunkRequests();
+	/// Ask the server for everything since my last frame, or a keyframe if I don't have one.
+	void							sendResumeRequest();
+	/// If too many frames are waiting to be handled, drop them and wait for a keyframe instead. Answer true if I did.
+	bool							skipBacklog();
 
 	virtual void					handleMouseTouchBegin(const ci::app::MouseEvent&, int id);
 	virtual void					handleMouseTouchMoved(const ci::app::MouseEvent&, int id);
@@ -56,10 +65,22 @@ private:
 	EngineSender					mSender;
 	EngineReceiver					mReceiver;
 	ds::BlobReader					mBlobReader;
+	std::vector<ds::net::DeChunker::MissingGroup>
+									mMissingChunks;
 	int32_t							mSessionId;
 	/// True if I lost the connection, renewed it, and am
 	/// waiting to hear back.
 	bool							mConnectionRenewed;
+	/// True if I've asked to resume and will take the next keyframe meant for me.
+	bool							mAwaitingKeyframe;
+	/// Frames until I can ask to resume again, and how many times I've asked.
+	int								mResumeWait;
+	int								mResumeRequests;
+	/// Where the server can send a keyframe just to me. Empty if unknown.
+	std::string						mLocalAddress;
+	bool							mUseReceiveThread;
+	/// More frames than this waiting, and I skip ahead with a keyframe. 0 never skips.
+	size_t							mMaxFrameBacklog;
 
 	/// STATES
 	class State {
@@ -2,31 +2,322 @@
 
 #include "ds/app/engine/engine_io.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "ds/app/blob_reader.h"
 #include "ds/app/blob_registry.h"
+#include "ds/app/engine/engine_io_defs.h"
 #include "ds/debug/logger.h"
 #include "ds/util/string_util.h"
-#include "snappy.h"
 #include <cinder/Rand.h>
 
 #include "ds/network/packet_chunker.h"
+#include <Poco/Timestamp.h>
 
 namespace ds {
 
+namespace {
+// How many frames can be waiting on the send thread, counting the one going out
+const size_t		MAX_PENDING_FRAMES = 2;
+// How many decoded frames can be waiting for the main thread
+const size_t		MAX_READY_FRAMES = 256;
+// How long the receive thread waits on an idle connection before checking whether it should stop
+const int			RECEIVE_WAIT_MS = 5;
+}
+
 /**
  * \class EngineSender
  */
-EngineSender::EngineSender(ds::NetConnection& con, const bool useChunker)
+EngineSender::EngineSender(ds::NetConnection& con, const bool useChunker, const ds::net::Codec codec)
 		: mConnection(con) 
 		, mPacketId(0)
+		, mChannel(0)
+		, mLastFrameSize(0)
 		, mUseChunker(useChunker)
+		, mCodec(codec)
+		, mRetransmitWindow(0)
+		, mReplicationStats(nullptr)
+		, mWorker(*this)
 {
 }
 
+EngineSender::~EngineSender() {
+	stopSendThread();
+}
+
 void EngineSender::setPacketNumber(unsigned int packetId){
 	mPacketId = packetId;
 }
 
+void EngineSender::setCodec(const ds::net::Codec codec){
+	if(!ds::net::isValidCodec(codec)) return;
+	mCodec = codec;
+}
+
+void EngineSender::setReplicationStats(ds::net::ReplicationStats* stats){
+	mReplicationStats = stats;
+}
+
+void EngineSender::setRetransmitWindow(const size_t numGroups){
+	Poco::FastMutex::ScopedLock		l(mSentMutex);
+	mRetransmitWindow = numGroups;
+	while(mSentGroups.size() > mRetransmitWindow){
+		mSentGroups.pop_front();
+	}
+}
+
+bool EngineSender::resendChunks(const unsigned groupId, const std::vector<unsigned>& chunkIds){
+	if(!mConnection.initialized()) return false;
+
+	if(mReplicationStats && mReplicationStats->isEnabled()){
+		mReplicationStats->getPending().mChunksRequested += std::max(static_cast<unsigned>(chunkIds.size()), 1u);
+	}
+
+	if(mThread.isRunning()){
+		// Resends go through the send thread too, so they can't cut in front of
+		// (or ask for) a frame that hasn't gone out yet
+		if(!canResendFrom(groupId)) return false;
+		mWorker.queueResend(groupId, chunkIds);
+		return true;
+	}
+
+	return sendChunks(groupId, chunkIds);
+}
+
+bool EngineSender::sendChunks(const unsigned groupId, const std::vector<unsigned>& chunkIds){
+	Poco::FastMutex::ScopedLock		l(mSentMutex);
+	for(auto& it : mSentGroups){
+		if(it.first != groupId) continue;
+
+		const std::vector<std::string>& chunks = it.second;
+		if(chunkIds.empty()){
+			for(auto& chunk : chunks){
+				mConnection.sendMessage(chunk);
+			}
+		} else {
+			for(auto id : chunkIds){
+				if(id < chunks.size()){
+					mConnection.sendMessage(chunks[id]);
+				}
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+bool EngineSender::canResendFrom(const unsigned groupId) const {
+	// Everything up to the last packet number is either kept or still waiting for the send thread
+	Poco::FastMutex::ScopedLock		l(mSentMutex);
+	if(mSentGroups.empty()) return false;
+	return mSentGroups.front().first <= groupId && groupId <= mPacketId;
+}
+
+void EngineSender::startSendThread(){
+	if(mThread.isRunning()) return;
+	try {
+		mWorker.reset();
+		mThread.start(mWorker);
+	} catch(std::exception const& ex) {
+		DS_LOG_WARNING_M("EngineSender couldn't start the send thread, sending on the main thread: " << ex.what(), ds::IO_LOG);
+	}
+}
+
+void EngineSender::stopSendThread(){
+	if(!mThread.isRunning()) return;
+
+	// Anything already queued still goes out
+	mWorker.abort();
+	try {
+		mThread.join();
+	} catch(std::exception const&) {
+	}
+}
+
+void EngineSender::waitUntilSent(){
+	if(mThread.isRunning()) mWorker.waitUntilIdle();
+}
+
+EngineSender::Stats EngineSender::getStats() const {
+	return mWorker.getStats();
+}
+
+void EngineSender::sendFrame(const ds::DataBuffer& data, const unsigned packetId, const ds::net::Codec codec, const unsigned channel){
+	const int size = static_cast<int>(data.size());
+	const Poco::Timestamp start;
+
+	std::vector<std::string> chunks;
+
+	// Encode exactly once, straight out of the send buffer. Chunked sends record the codec
+	// in every ChunkHeader, unchunked sends lead with a single codec byte.
+	if(mUseChunker){
+		ds::net::encode(codec, data.data(), size, mCompressionBuffer);
+
+		ds::net::Chunker chunker;
+		chunker.Chunkify(mCompressionBuffer, packetId, chunks, codec, channel);
+	} else {
+		mCompressionBuffer.assign(1, static_cast<char>(codec));
+		ds::net::encode(codec, data.data(), size, mCompressionBuffer, 1);
+		chunks.push_back(mCompressionBuffer);
+	}
+
+	if(mReplicationStats && mReplicationStats->isEnabled()){
+		mReplicationStats->addEncodeResult(channel, packetId, static_cast<unsigned>(mCompressionBuffer.size()),
+										   static_cast<unsigned>(chunks.size()), static_cast<double>(start.elapsed()) / 1000000.0);
+	}
+
+	for (auto& it : chunks){
+		mConnection.sendMessage(it);
+	}
+
+	// Hang on to recent groups in case a receiver lost some of it
+	Poco::FastMutex::ScopedLock		l(mSentMutex);
+	if(mUseChunker && mRetransmitWindow > 0){
+		if(mSentGroups.size() >= mRetransmitWindow){
+			mSentGroups.pop_front();
+		}
+		mSentGroups.push_back(SentGroup(packetId, std::move(chunks)));
+	}
+}
+
+/**
+ * \class EngineSender::Stats
+ */
+EngineSender::Stats::Stats()
+		: mFramesSent(0)
+		, mFramesQueued(0)
+		, mStalls(0)
+		, mStallSeconds(0.0)
+		, mLastSendSeconds(0.0) {
+}
+
+/**
+ * \class EngineSender::Worker
+ */
+EngineSender::Worker::Worker(EngineSender& sender)
+		: mSender(sender)
+		, mAbort(false)
+		, mBusy(false)
+		, mPendingFrames(0) {
+}
+
+void EngineSender::Worker::reset(){
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mAbort = false;
+}
+
+void EngineSender::Worker::queueFrame(ds::DataBuffer& data, const unsigned packetId, const ds::net::Codec codec, const unsigned channel){
+	Poco::Mutex::ScopedLock		l(mMutex);
+
+	// Double buffered: one frame going out while the next is built. If the network can't
+	// keep up, the caller waits here rather than the queue (and the latency) growing.
+	if(mPendingFrames >= MAX_PENDING_FRAMES && !mAbort){
+		const Poco::Timestamp	start;
+		while(mPendingFrames >= MAX_PENDING_FRAMES && !mAbort){
+			mCondition.wait(mMutex);
+		}
+		++mStats.mStalls;
+		mStats.mStallSeconds += static_cast<double>(start.elapsed()) / 1000000.0;
+	}
+
+	Job		job;
+	if(!mSpareBuffers.empty()){
+		job.mData.swap(mSpareBuffers.back());
+		mSpareBuffers.pop_back();
+	}
+	// The caller gets the job's old (cleared) buffer to build the next frame in
+	job.mData.swap(data);
+	data.clear();
+	job.mPacketId = packetId;
+	job.mCodec = codec;
+	job.mChannel = channel;
+	mFrames.push_back(std::move(job));
+	++mPendingFrames;
+	mCondition.broadcast();
+}
+
+void EngineSender::Worker::queueResend(const unsigned groupId, const std::vector<unsigned>& chunkIds){
+	Poco::Mutex::ScopedLock		l(mMutex);
+	Job		job;
+	job.mResend = true;
+	job.mPacketId = groupId;
+	job.mChunkIds = chunkIds;
+	mFrames.push_back(std::move(job));
+	mCondition.broadcast();
+}
+
+void EngineSender::Worker::waitUntilIdle(){
+	Poco::Mutex::ScopedLock		l(mMutex);
+	while((!mFrames.empty() || mBusy) && !mAbort){
+		mCondition.wait(mMutex);
+	}
+}
+
+void EngineSender::Worker::abort(){
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mAbort = true;
+	mCondition.broadcast();
+}
+
+EngineSender::Stats EngineSender::Worker::getStats() const {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	Stats		ans = mStats;
+	ans.mFramesQueued = mPendingFrames;
+	return ans;
+}
+
+void EngineSender::Worker::run(){
+	Job		job;
+	while(true){
+		{
+			Poco::Mutex::ScopedLock		l(mMutex);
+			while(mFrames.empty() && !mAbort){
+				mCondition.wait(mMutex);
+			}
+			// Drain what's queued before quitting, receivers are counting on every frame
+			if(mFrames.empty()) break;
+
+			job = std::move(mFrames.front());
+			mFrames.pop_front();
+			mBusy = true;
+		}
+
+		const Poco::Timestamp	start;
+		if(job.mResend){
+			if(!mSender.sendChunks(job.mPacketId, job.mChunkIds)){
+				DS_LOG_WARNING_M("Chunk group " << job.mPacketId << " fell out of the retransmit window before it could be resent", ds::IO_LOG);
+			}
+		} else {
+			mSender.sendFrame(job.mData, job.mPacketId, job.mCodec, job.mChannel);
+		}
+
+		{
+			Poco::Mutex::ScopedLock		l(mMutex);
+			if(!job.mResend){
+				--mPendingFrames;
+				++mStats.mFramesSent;
+				mStats.mLastSendSeconds = static_cast<double>(start.elapsed()) / 1000000.0;
+				job.mData.clear();
+				mSpareBuffers.push_back(ds::DataBuffer());
+				mSpareBuffers.back().swap(job.mData);
+			}
+			job.mChunkIds.clear();
+			job.mResend = false;
+			mBusy = false;
+			mCondition.broadcast();
+		}
+	}
+}
+
+EngineSender::Worker::Job::Job()
+		: mPacketId(0)
+		, mCodec(ds::net::CODEC_NONE)
+		, mChannel(0)
+		, mResend(false) {
+}
+
 /**
  * \class AutoSend
  */
@@ -41,24 +332,25 @@ EngineSender::AutoSend::~AutoSend() {
 	if (!mSender.mConnection.initialized()) return;
 	if (mData.size() < 1) return;
 
-	const int size = static_cast<int>(mData.size());
-	mSender.mRawDataBuffer.setSize(size);
-	mData.readRaw(mSender.mRawDataBuffer.data(), size);
-	snappy::Compress(mSender.mRawDataBuffer.data(), size, &mSender.mCompressionBuffer);
-
-	std::vector<std::string> chunks;
-
+	mSender.mLastFrameSize = mData.size();
+	// Packet numbers are handed out here, in order, so they're known as soon as the frame is built
 	if(mSender.mUseChunker){
-
 		mSender.mPacketId++;
-		ds::net::Chunker chunker;
-		chunker.Chunkify(mSender.mCompressionBuffer, mSender.mPacketId, chunks);
-	} else {
-		chunks.push_back(mSender.mCompressionBuffer);
 	}
 
-	for (auto it : chunks){
-		mSender.mConnection.sendMessage(it);
+	// Filed before it goes out, so the send thread can fill in the encoding
+	ds::net::ReplicationStats*	stats = mSender.mReplicationStats;
+	if(stats && stats->isEnabled()){
+		stats->getPending().mPacketId = mSender.mPacketId;
+		stats->getPending().mChannel = mSender.mChannel;
+		stats->getPending().mRawBytes = mData.size();
+		stats->commitFrame();
+	}
+
+	if(mSender.mThread.isRunning()){
+		mSender.mWorker.queueFrame(mData, mSender.mPacketId, mSender.mCodec, mSender.mChannel);
+	} else {
+		mSender.sendFrame(mData, mSender.mPacketId, mSender.mCodec, mSender.mChannel);
 	}
 
 	mData.clear();
@@ -72,11 +364,26 @@ EngineReceiver::EngineReceiver(ds::NetConnection& con, const bool useChunker)
 		, mHeaderId(0)
 		, mCommandId(0)
 		, mHeaderAndCommandOnly(false)
+		, mSkipRemaining(false)
+		, mHoldStream(false)
+		, mNoDataCount(0)
+		, mLastFrameSize(0)
+		, mSideDechunker(false)
 		, mUseChunker(useChunker)
-		, mNoDataCount(0) {
+		, mSkippedFrames(0)
+		, mReplicationStats(nullptr)
+		, mReadyFrames(MAX_READY_FRAMES)
+		, mReturnedBuffers(MAX_READY_FRAMES)
+		, mReceivedData(false)
+		, mDecodeFailed(false)
+		, mWorker(*this) {
 	setHeaderAndCommandOnly();
 }
 
+EngineReceiver::~EngineReceiver() {
+	stopReceiveThread();
+}
+
 void EngineReceiver::setHeaderAndCommandIds(const char header, const char command) {
 	mHeaderId = header;
 	mCommandId = command;
@@ -90,38 +397,131 @@ ds::DataBuffer& EngineReceiver::getData() {
 	return mCurrentDataBuffer;
 }
 
+void EngineReceiver::setReplicationStats(ds::net::ReplicationStats* stats) {
+	mReplicationStats = stats;
+}
+
+void EngineReceiver::startReceiveThread() {
+	if(mThread.isRunning()) return;
+	try {
+		mWorker.reset();
+		mThread.start(mWorker);
+	} catch(std::exception const& ex) {
+		DS_LOG_WARNING_M("EngineReceiver couldn't start the receive thread, receiving on the main thread: " << ex.what(), ds::IO_LOG);
+	}
+}
+
+void EngineReceiver::stopReceiveThread() {
+	if(!mThread.isRunning()) return;
+
+	mWorker.abort();
+	try {
+		mThread.join();
+	} catch(std::exception const&) {
+	}
+
+	// Anything the thread finished stays in order, ahead of whatever gets received next
+	std::string		frame;
+	while(mReadyFrames.pop(frame)) {
+		mReceiveBuffers.push_back(std::move(frame));
+	}
+	while(mReturnedBuffers.pop(frame)) {
+		mSpareBuffers.push_back(std::move(frame));
+	}
+}
+
 bool EngineReceiver::receiveBlob() {
+	bool received = false;
+
+	if(mThread.isRunning()) {
+		std::string		frame;
+		while(mReadyFrames.pop(frame)) {
+			mReceiveBuffers.push_back(std::move(frame));
+		}
+		received = mReceivedData.exchange(false);
+
+		if(mDecodeFailed.exchange(false)) {
+			DS_LOG_WARNING_M("EngineReceiver: Invalid chunk received. Expect a new world frame shortly.", ds::IO_LOG);
+			return false;
+		}
+	} else if(!receiveInto(mReceiveBuffers, mSpareBuffers, received)) {
+		DS_LOG_WARNING_M("EngineReceiver: Invalid chunk received. Expect a new world frame shortly.", ds::IO_LOG);
+		return false;
+	}
+
+	// A held stream is still a live connection, it's just not being handed back yet
+	if(received && isStreamHeld()) {
+		mNoDataCount = 0;
+	}
+
+	collapseSupersededFrames();
+
+	if(mReceiveBuffers.empty()) {
+		++mNoDataCount;
+		//return false;
+	}
+
+	return true;
+}
+
+bool EngineReceiver::receiveInto(std::deque<std::string>& out, std::vector<std::string>& spares, bool& received) {
 	std::string recvBuffer;
+	const bool recordStats = mReplicationStats && mReplicationStats->isEnabled();
 
-	if(mUseChunker){
+	if(!mUseChunker) {
 		while(mConnection.recvMessage(recvBuffer)) {
+			received = true;
+			if(recvBuffer.empty()) continue;
+
+			const int codec = static_cast<int>(recvBuffer[0]);
+			if(!decodeInto(static_cast<unsigned>(codec), recvBuffer.c_str() + 1, recvBuffer.size() - 1, out, spares)) {
+				DS_LOG_WARNING_M("EngineReceiver: Couldn't decode message with codec " << codec, ds::IO_LOG);
+				continue;
+			}
+		}
+		return true;
+	}
+
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	unsigned numChunks = 0;
+	while(mConnection.recvMessage(recvBuffer)) {
+		received = true;
+		++numChunks;
+		unsigned channel = 0;
+		if(ds::net::Chunker::getChannel(recvBuffer.c_str(), static_cast<unsigned>(recvBuffer.size()), channel) && channel != 0) {
+			mSideDechunker.addChunk(recvBuffer);
+		} else {
 			mDechunker.addChunk(recvBuffer);
 		}
+	}
+
+	// The main stream goes first, so a keyframe can tell whether it's already out of date
+	const Poco::Timestamp start;
+	unsigned encodedBytes = 0;
+	ds::net::DeChunker* dechunkers[] = { &mDechunker, &mSideDechunker };
+	for(auto dechunker : dechunkers) {
+		if(dechunker == &mDechunker && mHoldStream) continue;
 
-		while(mDechunker.getAvailable() > 0) {
+		while(dechunker->getAvailable() > 0) {
 			std::string outBuf;
-			bool validy = mDechunker.getNextGroup(outBuf);
+			unsigned codec = 0;
+			bool validy = dechunker->getNextGroup(outBuf, codec);
 
 			if(!validy) {
-				DS_LOG_WARNING_M("EngineReceiver: Invalid chunk received. Expect a new world frame shortly.", ds::IO_LOG);
 				return false;
 			}
 
-			snappy::Uncompress(outBuf.c_str(), outBuf.size(), &mCompressionBufferRead);
-			mReceiveBuffers.push_back(mCompressionBufferRead);
-		}
-	} else {
-		while(mConnection.recvMessage(recvBuffer)) {
-			snappy::Uncompress(recvBuffer.c_str(), recvBuffer.size(), &mCompressionBufferRead);
-			mReceiveBuffers.push_back(mCompressionBufferRead);
+			if(!decodeInto(codec, outBuf.c_str(), outBuf.size(), out, spares)) {
+				DS_LOG_WARNING_M("EngineReceiver: Couldn't decode chunk group with codec " << codec << ".", ds::IO_LOG);
+				return false;
+			}
+			encodedBytes += static_cast<unsigned>(outBuf.size());
 		}
 	}
 
-	if(mReceiveBuffers.empty()) {
-		++mNoDataCount;
-		//return false;
+	if(recordStats && numChunks > 0) {
+		mReplicationStats->addDecodeResult(encodedBytes, numChunks, static_cast<double>(start.elapsed()) / 1000000.0);
 	}
-
 	return true;
 }
 
@@ -134,33 +534,150 @@ bool EngineReceiver::handleBlob(ds::BlobRegistry& registry, ds::BlobReader& read
 
 	mNoDataCount = 0;
 
-	mCurrentDataBuffer.clear(); 
-	mCurrentDataBuffer.addRaw(mReceiveBuffers.front().c_str(), static_cast<unsigned int>(mReceiveBuffers.front().size()));
-	mReceiveBuffers.erase(mReceiveBuffers.begin());
+	// Swap rather than copy: the handled frame's storage goes back to the spares for the next decode
+	mCurrentFrame.swap(mReceiveBuffers.front());
+	recycle(mReceiveBuffers.front());
+	mReceiveBuffers.pop_front();
+	mCurrentDataBuffer.wrap(mCurrentFrame.data(), static_cast<unsigned int>(mCurrentFrame.size()));
 
 	morePacketsAvailable = !mReceiveBuffers.empty();
 
 	const size_t				receiveSize = mCurrentDataBuffer.size();
+	mLastFrameSize = static_cast<unsigned>(receiveSize);
 	const char					size = static_cast<char>(registry.mReader.size());
+	const bool					recordStats = mReplicationStats && mReplicationStats->isEnabled();
+	const Poco::Timestamp		start;
+	mSkipRemaining = false;
 	while (mCurrentDataBuffer.canRead<char>()) {
+		if (mSkipRemaining) {
+			mSkipRemaining = false;
+			break;
+		}
+
+		const unsigned			blobStart = mCurrentDataBuffer.getReadPosition();
 		const char				token = mCurrentDataBuffer.read<char>();
 		if (token > 0 && token < size) {
 			// If we're doing header and command only, as soon as we hit a
 			// non-header, non-command, we need to bail
-			if (mHeaderAndCommandOnly) {
-				if (token == mHeaderId || token == mCommandId) {
-					registry.mReader[token](reader);
-				} else {
-					return true;
-				}
-			} else {
-				registry.mReader[token](reader);
+			if (mHeaderAndCommandOnly && token != mHeaderId && token != mCommandId) {
+				break;
+			}
+			registry.mReader[token](reader);
+			if (recordStats) {
+				mReplicationStats->addBlobBytes(token, mCurrentDataBuffer.getReadPosition() - blobStart);
 			}
 		}
 	}
+
+	if (recordStats) {
+		ds::net::ReplicationStats::Frame&	frame = mReplicationStats->getPending();
+		frame.mRawBytes = static_cast<unsigned>(receiveSize);
+		frame.mApplySeconds = static_cast<double>(start.elapsed()) / 1000000.0;
+		if (mUseChunker) {
+			Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+			const ds::net::DeChunker::LossCounts&	loss = mDechunker.getLossCounts();
+			frame.mChunksRequested = loss.mChunksRequested - mLastLossCounts.mChunksRequested;
+			frame.mGroupsLost = loss.mGroupsLost - mLastLossCounts.mGroupsLost;
+			frame.mGroupsRecovered = loss.mGroupsRecovered - mLastLossCounts.mGroupsRecovered;
+			mLastLossCounts = loss;
+		}
+		mReplicationStats->commitFrame();
+	}
+	return true;
+}
+
+bool EngineReceiver::decodeInto(const unsigned codec, const char* src, const size_t size,
+								std::deque<std::string>& out, std::vector<std::string>& spares) {
+	if(!ds::net::isValidCodec(codec)) return false;
+
+	if(spares.empty()) {
+		out.emplace_back();
+	} else {
+		out.push_back(std::move(spares.back()));
+		spares.pop_back();
+	}
+
+	if(!ds::net::decode(static_cast<ds::net::Codec>(codec), src, size, out.back())) {
+		spares.push_back(std::move(out.back()));
+		out.pop_back();
+		return false;
+	}
 	return true;
 }
 
+bool EngineReceiver::isWorldFrame(const std::string& frame) const {
+	// HEADER_BLOB, frame, timestamp, TERMINATOR_CHAR, COMMAND_BLOB, CMD_SERVER_SEND_WORLD, see EngineServer::SendWorldState
+	const size_t		cmd = 1 + sizeof(int32_t) + sizeof(int64_t) + 1;
+	if(frame.size() < cmd + 2) return false;
+	return frame[0] == mHeaderId && frame[cmd - 1] == ds::TERMINATOR_CHAR
+		&& frame[cmd] == mCommandId && frame[cmd + 1] == CMD_SERVER_SEND_WORLD;
+}
+
+bool EngineReceiver::isSequencedFrame(const std::string& frame) const {
+	if(frame.size() < 1 + sizeof(int32_t) || frame[0] != mHeaderId) return false;
+	int32_t				id = -1;
+	memcpy(&id, frame.data() + 1, sizeof(id));
+	return id >= 0;
+}
+
+void EngineReceiver::collapseSupersededFrames() {
+	if(mReceiveBuffers.size() < 2 || mHeaderId == mCommandId) return;
+
+	size_t				world = 0;
+	for(size_t k = mReceiveBuffers.size() - 1; k > 0; --k) {
+		if(isWorldFrame(mReceiveBuffers[k])) {
+			world = k;
+			break;
+		}
+	}
+	if(world < 1) return;
+
+	// Replies and keyframes aren't part of the sequence, and still have to be handled
+	size_t				skipped = 0;
+	std::deque<std::string>	kept;
+	for(size_t k = 0; k < world; ++k) {
+		if(isSequencedFrame(mReceiveBuffers[k])) {
+			recycle(mReceiveBuffers[k]);
+			++skipped;
+		} else {
+			kept.push_back(std::move(mReceiveBuffers[k]));
+		}
+	}
+	mReceiveBuffers.erase(mReceiveBuffers.begin(), mReceiveBuffers.begin() + world);
+	mReceiveBuffers.insert(mReceiveBuffers.begin(), std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()));
+
+	if(skipped > 0) {
+		mSkippedFrames += skipped;
+		DS_LOG_INFO_M("EngineReceiver: skipped " << skipped << " frames superseded by a world", ds::IO_LOG);
+	}
+}
+
+void EngineReceiver::recycle(std::string& frame) {
+	frame.clear();
+	if(mThread.isRunning()) {
+		// If the thread's got plenty, let this one go
+		mReturnedBuffers.push(std::move(frame));
+	} else {
+		mSpareBuffers.push_back(std::move(frame));
+	}
+}
+
+size_t EngineReceiver::getQueuedFrames() const {
+	return mReceiveBuffers.size() + mReadyFrames.size();
+}
+
+void EngineReceiver::dropQueuedFrames() {
+	std::string		frame;
+	while(mReadyFrames.pop(frame)) {
+		mReceiveBuffers.push_back(std::move(frame));
+	}
+	mSkippedFrames += mReceiveBuffers.size();
+	while(!mReceiveBuffers.empty()) {
+		recycle(mReceiveBuffers.front());
+		mReceiveBuffers.pop_front();
+	}
+}
+
 bool EngineReceiver::hasLostConnection() const {
 	return mNoDataCount > 300;
 }
@@ -169,5 +686,100 @@ void EngineReceiver::clearLostConnection() {
 	mNoDataCount = 0;
 }
 
+void EngineReceiver::getMissingChunks(std::vector<ds::net::DeChunker::MissingGroup>& missing) {
+	if(!mUseChunker) {
+		missing.clear();
+		return;
+	}
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	mDechunker.getMissing(missing);
+}
+
+bool EngineReceiver::hasUnrecoverableLoss() const {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	return mUseChunker && mDechunker.hasUnrecoverableLoss();
+}
+
+void EngineReceiver::resetChunks() {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	mDechunker.clearReceived();
+}
+
+void EngineReceiver::skipRemainingData() {
+	mSkipRemaining = true;
+}
+
+void EngineReceiver::holdStream(const bool hold) {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	mHoldStream = hold;
+}
+
+bool EngineReceiver::isStreamHeld() const {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	return mHoldStream;
+}
+
+void EngineReceiver::resumeAt(const unsigned groupId) {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	mDechunker.resumeAt(groupId);
+}
+
+unsigned EngineReceiver::getNextGroupId() const {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	return mDechunker.getNextGroupId();
+}
+
+unsigned EngineReceiver::getPendingGroups() const {
+	Poco::FastMutex::ScopedLock		l(mDechunkMutex);
+	return mDechunker.getPendingGroups();
+}
+
+/**
+ * \class EngineReceiver::Worker
+ */
+EngineReceiver::Worker::Worker(EngineReceiver& receiver)
+		: mReceiver(receiver)
+		, mAbort(false) {
+}
+
+void EngineReceiver::Worker::reset() {
+	mAbort = false;
+}
+
+void EngineReceiver::Worker::abort() {
+	mAbort = true;
+}
+
+void EngineReceiver::Worker::run() {
+	std::deque<std::string>		decoded;
+	std::vector<std::string>	spares;
+	std::string					spare;
+
+	while(!mAbort) {
+		while(mReceiver.mReturnedBuffers.pop(spare)) {
+			if(spares.size() < MAX_READY_FRAMES) spares.push_back(std::move(spare));
+		}
+
+		bool		received = false;
+		if(!mReceiver.receiveInto(decoded, spares, received)) {
+			mReceiver.mDecodeFailed = true;
+		}
+		if(received) mReceiver.mReceivedData = true;
+
+		// Strictly in order. If the main thread is that far behind it'll be dropping frames
+		// to catch up soon anyway, so just wait for room.
+		while(!decoded.empty() && !mAbort) {
+			if(mReceiver.mReadyFrames.push(std::move(decoded.front()))) {
+				decoded.pop_front();
+			} else {
+				Poco::Thread::sleep(1);
+			}
+		}
+
+		if(!received) mReceiver.mConnection.waitForData(RECEIVE_WAIT_MS);
+	}
+
+	// Anything still in decoded is dropped. The thread only stops when the connection is going away.
+}
 
 } // namespace ds
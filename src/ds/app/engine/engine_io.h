@@ -2,10 +2,19 @@
 #ifndef DS_APP_ENGINE_ENGINEIO_H_
 #define DS_APP_ENGINE_ENGINEIO_H_
 
+#include <atomic>
+#include <deque>
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
 #include "ds/data/data_buffer.h"
 #include "ds/query/recycle_array.h"
+#include "ds/network/net_codec.h"
 #include "ds/network/net_connection.h"
 #include "ds/network/packet_chunker.h"
+#include "ds/network/replication_stats.h"
+#include "ds/thread/spsc_queue.h"
 
 /**
  * Hide the busy work of sending information between the server and client.
@@ -21,17 +30,122 @@ class BlobRegistry;
  */
 class EngineSender {
 public:
-	EngineSender(ds::NetConnection&, const bool useChunker);
+	EngineSender(ds::NetConnection&, const bool useChunker, const ds::net::Codec = ds::net::CODEC_SNAPPY);
+	~EngineSender();
 
 	void						setPacketNumber(unsigned int packetId);
+	/// The id of the last chunk group sent.
+	unsigned int				getPacketNumber() const { return mPacketId; }
+
+	/// Chunked sends are tagged with a channel. 0 is the main stream, which receivers
+	/// hand back strictly in order. Anything else is handed back as soon as it's complete.
+	void						setChannel(const unsigned channel) { mChannel = channel; }
+
+	/// How every outgoing frame is encoded. The codec travels with the data,
+	/// so the receiving end always decodes exactly once.
+	void						setCodec(const ds::net::Codec);
+	ds::net::Codec				getCodec() const { return mCodec; }
+
+	/// Keep the last numGroups chunk groups around so receivers can ask for
+	/// chunks they lost. 0 turns retransmission off.
+	void						setRetransmitWindow(const size_t numGroups);
+	/// Send chunks of a recent group again. An empty chunkIds resends the whole group.
+	/// Answers false if the group has already fallen out of the retransmit window.
+	bool						resendChunks(const unsigned groupId, const std::vector<unsigned>& chunkIds);
+	/// Answer true if every group from groupId up to the last one sent can still be resent.
+	bool						canResendFrom(const unsigned groupId) const;
+
+	/// How big the last frame sent was, before it was encoded.
+	unsigned					getLastFrameSize() const { return mLastFrameSize; }
+
+	/// Record every frame sent here. The stats have to outlive me.
+	void						setReplicationStats(ds::net::ReplicationStats*);
+
+	/// Encode and send frames on a background thread, so the next frame can be built while the
+	/// last one goes out. Frames still go out strictly in order. Without it, AutoSend sends in place.
+	void						startSendThread();
+	/// Sends anything still queued, then stops the thread.
+	void						stopSendThread();
+	/// Block until everything queued has gone out, for instance before touching the connection.
+	void						waitUntilSent();
+
+	/// Backpressure from the send thread.
+	class Stats {
+	public:
+		Stats();
+		size_t					mFramesSent;
+		/// Frames waiting to go out, including the one going out now.
+		size_t					mFramesQueued;
+		/// How many times a frame had to wait because the network couldn't keep up, and for how long in total.
+		size_t					mStalls;
+		double					mStallSeconds;
+		/// How long encoding and sending the last frame took.
+		double					mLastSendSeconds;
+	};
+	Stats						getStats() const;
 
 private:
+	typedef std::pair<unsigned, std::vector<std::string>> SentGroup;
+
+	/// Encode, chunk and send a frame, and keep it for resending. Called on the send thread, if there is one.
+	void						sendFrame(const ds::DataBuffer&, const unsigned packetId, const ds::net::Codec, const unsigned channel);
+	bool						sendChunks(const unsigned groupId, const std::vector<unsigned>& chunkIds);
+
+	class Worker : public Poco::Runnable {
+	public:
+		Worker(EngineSender&);
+
+		void					reset();
+		/// Takes the frame out of data, which gets an empty buffer back.
+		void					queueFrame(ds::DataBuffer& data, const unsigned packetId, const ds::net::Codec, const unsigned channel);
+		void					queueResend(const unsigned groupId, const std::vector<unsigned>& chunkIds);
+		void					waitUntilIdle();
+		void					abort();
+		Stats					getStats() const;
+
+		virtual void			run();
+
+	private:
+		class Job {
+		public:
+			Job();
+			ds::DataBuffer				mData;
+			/// The frame's packet number, or the group to resend
+			unsigned					mPacketId;
+			ds::net::Codec				mCodec;
+			unsigned					mChannel;
+			bool						mResend;
+			std::vector<unsigned>		mChunkIds;
+		};
+
+		EngineSender&			mSender;
+		mutable Poco::Mutex		mMutex;
+		Poco::Condition			mCondition;
+		bool					mAbort;
+		bool					mBusy;
+		size_t					mPendingFrames;
+		std::deque<Job>			mFrames;
+		/// Buffers of frames that have gone out, traded back to the caller for building the next one.
+		std::vector<ds::DataBuffer>	mSpareBuffers;
+		Stats					mStats;
+	};
+
 	ds::NetConnection&			mConnection;
 	ds::DataBuffer				mSendBuffer;
-	RecycleArray<char>			mRawDataBuffer;
 	std::string					mCompressionBuffer;
 	unsigned int				mPacketId;
+	unsigned					mChannel;
+	unsigned					mLastFrameSize;
 	bool						mUseChunker;
+	ds::net::Codec				mCodec;
+	size_t						mRetransmitWindow;
+	ds::net::ReplicationStats*	mReplicationStats;
+	/// Groups are added on the send thread, and looked up by whoever's handling resend requests.
+	mutable Poco::FastMutex		mSentMutex;
+	std::deque<SentGroup>		mSentGroups;
+
+	Worker						mWorker;
+	Poco::Thread				mThread;
 
 public:
 	class AutoSend {
@@ -53,6 +167,7 @@ public:
 class EngineReceiver {
 public:
 	EngineReceiver(ds::NetConnection&, const bool useChunker);
+	~EngineReceiver();
 
 	/// A bit of a hack -- every state can be set to listen
 	/// only for the header and command, or everything. This
@@ -69,27 +184,122 @@ public:
 	bool						hasLostConnection() const;
 	void						clearLostConnection();
 
+	/// Chunk groups that are holding up delivery. Call once per receive; groups
+	/// are only re-requested every few calls, see DeChunker::getMissing().
+	void						getMissingChunks(std::vector<ds::net::DeChunker::MissingGroup>&);
+	/// A missing chunk couldn't be recovered, so the only way forward is a fresh world.
+	bool						hasUnrecoverableLoss() const;
+	/// Throw away any partially received data and start over with the next chunk.
+	void						resetChunks();
+
+	/// Stop handling the blob currently being read, for instance a keyframe meant for another client.
+	void						skipRemainingData();
+	/// While held, complete groups from the main stream wait in the dechunker instead of being
+	/// handed back. Used while waiting for a keyframe, so nothing after it gets lost.
+	void						holdStream(const bool);
+	/// Continue the main stream at groupId, dropping anything older. Never moves backwards.
+	void						resumeAt(const unsigned groupId);
+	/// The next main stream group that will be handed back.
+	unsigned					getNextGroupId() const;
+	/// How many main stream groups have been heard of but not handed back yet.
+	unsigned					getPendingGroups() const;
+
+	bool						isStreamHeld() const;
+
+	/// How big the last frame handled was, after it was decoded.
+	unsigned					getLastFrameSize() const { return mLastFrameSize; }
+
+	/// Receive, dechunk and decode on a background thread, so a big frame never stalls the main
+	/// thread. receiveBlob() then just picks up whatever frames are ready. Without it, receiveBlob()
+	/// does all the work in place.
+	void						startReceiveThread();
+	void						stopReceiveThread();
+	bool						isReceiveThreadRunning() const { return mThread.isRunning(); }
+
+	/// Frames received but not handled yet, including any still waiting on the receive thread.
+	size_t						getQueuedFrames() const;
+	/// Throw away every frame waiting to be handled, for instance when it's quicker to ask for a keyframe.
+	void						dropQueuedFrames();
+	/// How many frames were never handled because a later world made them pointless, or were dropped.
+	size_t						getSkippedFrames() const { return mSkippedFrames; }
+
+	/// Record every frame handled here. The stats have to outlive me.
+	void						setReplicationStats(ds::net::ReplicationStats*);
+
 private:
+	/// Pull everything off the connection and decode any complete frames into out. Called on the
+	/// receive thread, if there is one. received is set if anything came in at all.
+	bool						receiveInto(std::deque<std::string>& out, std::vector<std::string>& spares, bool& received);
+	/// Decode straight into the next buffer in out, reusing one of spares if there is one.
+	bool						decodeInto(const unsigned codec, const char* src, const size_t size,
+										   std::deque<std::string>& out, std::vector<std::string>& spares);
+	/// Answer true if the frame is a full world send.
+	bool						isWorldFrame(const std::string&) const;
+	/// Answer true if the frame is part of the regular frame sequence, as opposed to a world, keyframe or reply.
+	bool						isSequencedFrame(const std::string&) const;
+	/// Anything in the sequence before the last world in the queue would be wiped out by it, so don't bother.
+	void						collapseSupersededFrames();
+	/// Hand a frame's storage back for decoding the next one.
+	void						recycle(std::string&);
+
+	class Worker : public Poco::Runnable {
+	public:
+		Worker(EngineReceiver&);
+
+		void					reset();
+		void					abort();
+
+		virtual void			run();
+
+	private:
+		EngineReceiver&			mReceiver;
+		std::atomic<bool>		mAbort;
+	};
+
+	/// Reads the frame being handled in place, out of mCurrentFrame.
 	ds::DataBuffer				mCurrentDataBuffer;
+	std::string					mCurrentFrame;
 	ds::NetConnection&			mConnection;
-	std::string					mCompressionBufferRead;
-	std::string					mCompressionBufferWrite;
 	/// The header and command blob IDs, used for filtering. The header
 	/// and command are always processed, but anything else depends on the state
 	char						mHeaderId,
 								mCommandId;
 	bool						mHeaderAndCommandOnly;
+	bool						mSkipRemaining;
+	bool						mHoldStream;
 
 	/// Track when I try to receive but don't have any data. If this happens
 	/// enough, then my network connection has likely dropped.
 	int							mNoDataCount;
+	unsigned					mLastFrameSize;
 
 	/// Keep track of all the packets we receive.
 	/// This is in case we're running slower than the server,
-	/// in which case we can run through and update all the buffers at once and catch up
-	std::vector<std::string>	mReceiveBuffers;
+	/// in which case we can run through and update all the buffers at once and catch up.
+	/// Frames are decoded directly into these and swapped into mCurrentFrame, never copied.
+	std::deque<std::string>		mReceiveBuffers;
+	std::vector<std::string>	mSpareBuffers;
+	/// The dechunkers (and whether the stream is held) are fed on the receive thread, but
+	/// steered from the main thread, for instance when a keyframe says where to pick up from.
+	mutable Poco::FastMutex		mDechunkMutex;
 	ds::net::DeChunker			mDechunker;
+	/// Everything that isn't on the main channel, such as keyframes sent to just this client.
+	ds::net::DeChunker			mSideDechunker;
 	bool						mUseChunker;
+	size_t						mSkippedFrames;
+	ds::net::ReplicationStats*	mReplicationStats;
+	/// Loss counts as of the last frame handled, so each frame only gets what's new
+	ds::net::DeChunker::LossCounts
+								mLastLossCounts;
+
+	/// Frames decoded on the receive thread, in order, and their storage coming back once handled.
+	ds::SpscQueue<std::string>	mReadyFrames;
+	ds::SpscQueue<std::string>	mReturnedBuffers;
+	/// Set on the receive thread, picked up by the next receiveBlob()
+	std::atomic<bool>			mReceivedData;
+	std::atomic<bool>			mDecodeFailed;
+	Worker						mWorker;
+	Poco::Thread				mThread;
 };
 
 } // namespace ds
@@ -25,12 +25,20 @@ const char			CMD_CLIENT_STARTED_REPLY = 2;
 const char			CMD_CLIENT_STARTED = 3;
 const char			CMD_CLIENT_REQUEST_WORLD = 4;
 const char			CMD_CLIENT_RUNNING = 5;
+const char			CMD_CLIENT_REQUEST_CHUNKS = 6;
+const char			CMD_SERVER_SEND_KEYFRAME = 7;
+const char			CMD_CLIENT_REQUEST_RESUME = 8;
 
 const char			ATT_CLIENT = 1;
 const char			ATT_GLOBAL_ID = 2;
 const char			ATT_SESSION_ID = 3;
 const char			ATT_FRAME = 4;
 const char			ATT_ROOTS = 5;
+const char			ATT_CODEC = 6;
+const char			ATT_CHUNKS = 7;
+const char			ATT_GROUP = 8;
+const char			ATT_ADDRESS = 9;
+const char			ATT_ENCODING = 10;
 
 /**
  * \class EngineIoInfo
@@ -7,11 +7,14 @@
 
 namespace ds {
 class DataBuffer;
+class Engine;
 
 // Server -> Client communication
 extern const char				CMD_SERVER_SEND_WORLD;		// The server is sending the entire world
 extern const char				CMD_CLIENT_STARTED_REPLY;	// The server has received a CLIENT_STARTED, and
 															/// is supplying the client with a session ID.
+extern const char				CMD_SERVER_SEND_KEYFRAME;	// The server is sending the entire world, but only clients
+															/// waiting to resume should use it.
 
 // Client -> Server communication
 extern const char				CMD_CLIENT_STARTED;			// The client is notifying the server it's started,
@@ -21,12 +24,23 @@ extern const char				CMD_CLIENT_REQUEST_WORLD;	// The client is requesting the e
 
 extern const char				CMD_CLIENT_RUNNING;			// A general heartbeat from the client.
 
+extern const char				CMD_CLIENT_REQUEST_CHUNKS;	// The client lost some chunks of a world frame, and is
+															/// asking for just those to be resent.
+
+extern const char				CMD_CLIENT_REQUEST_RESUME;	// The client fell behind, and is asking for everything since
+															/// its last frame, or a keyframe if that's too far back.
+
 // ATTRIBUTES
 extern const char				ATT_CLIENT;					// Header for a client, which might have: ATT_GLOBAL_ID, ATT_SESSION_ID
 extern const char				ATT_GLOBAL_ID;				// A string, which is a GUID
 extern const char				ATT_SESSION_ID;				// An int32, which is a client-unique ID
 extern const char				ATT_FRAME;					// A frame number
 extern const char				ATT_ROOTS;					// A list of the roots being sent from the server
+extern const char				ATT_CODEC;					// A char, the ds::net::Codec the server encodes with. Clients reply with the same.
+extern const char				ATT_CHUNKS;					// A list of chunk groups, each with the chunk ids missing (none means the whole group)
+extern const char				ATT_GROUP;					// An unsigned, a chunk group id on the main stream
+extern const char				ATT_ADDRESS;				// A string, the IP address of a client
+extern const char				ATT_ENCODING;				// A ds::CompactEncoding, how the server packs sprite attributes
 
 /**
  * \class EngineIoInfo
@@ -6,7 +6,9 @@
 #include "ds/app/app.h"
 #include "ds/app/blob_reader.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
 #include "ds/util/string_util.h"
+#include <sstream>
 #include "ds/debug/computer_info.h"
 #include "ds/app/engine/engine_events.h"
 #include "ds/content/content_wrangler.h"
@@ -42,20 +44,40 @@ AbstractEngineServer::AbstractEngineServer(	ds::App& app, ds::EngineSettings& se
 	, mBlobReader(mReceiver.getData(), *this)
 	, mState(nullptr)
 	, mContentWrangler(nullptr)
+	, mKeyframeSender(mKeyframeConnection, true)
+	, mKeyframeInterval(0)
 {
 	// NOTE:  Must be EXACTLY the same items as in EngineClient, in same order,
 	// so that the BLOB ids match.
-	HEADER_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveHeader(r.mDataBuffer);});
-	COMMAND_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveCommand(r.mDataBuffer);});
-	DELETE_SPRITE_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveDeleteSprite(r.mDataBuffer);});
-	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer); });
-	CLIENT_INPUT_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientInput(r.mDataBuffer); });
+	HEADER_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveHeader(r.mDataBuffer);}, "header");
+	COMMAND_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveCommand(r.mDataBuffer);}, "command");
+	DELETE_SPRITE_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveDeleteSprite(r.mDataBuffer);}, "delete sprite");
+	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer); }, "client status");
+	CLIENT_INPUT_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientInput(r.mDataBuffer); }, "client input");
+
+	mSender.setCodec(ds::net::codecFromString(settings.getString("server:compression", 0, "snappy")));
+	mSender.setRetransmitWindow(static_cast<size_t>(settings.getInt("server:retransmit_window", 0, 64)));
+	mKeyframeSender.setCodec(mSender.getCodec());
+	mKeyframeSender.setChannel(1);
+	mKeyframeInterval = settings.getInt("server:keyframe_interval", 0, 0);
+	setAttributeEncoding(ds::CompactEncoding::fromSettings(settings));
+	mDirtySprites.setEnabled(true);
+	mReplicationStats.setCapacity(static_cast<size_t>(std::max(0, settings.getInt("server:replication_stats", 0, 600))));
+	nameReplicatedBlobs();
+	mSender.setReplicationStats(&mReplicationStats);
+	mKeyframeSender.setReplicationStats(&mReplicationStats);
+	mServerIp = settings.getString("server:ip");
+	mSendPort = ds::value_to_string(settings.getInt("server:send_port"));
 
 	try {
 		if (settings.getBool("server:connect", 0, true)) {
 			mSendConnection.initialize(true, settings.getString("server:ip"), ds::value_to_string(settings.getInt("server:send_port")));
 			mReceiveConnection.initialize(false, settings.getString("server:ip"), ds::value_to_string(settings.getInt("server:listen_port")));
 		}
+		if (settings.getBool("server:send_thread", 0, true)) {
+			mSender.startSendThread();
+			mKeyframeSender.startSendThread();
+		}
 	} catch (std::exception &e) {
 		DS_LOG_ERROR_M("EngineServer() initializing connection: " << e.what(), ds::ENGINE_LOG);
 	}
@@ -71,6 +93,7 @@ AbstractEngineServer::~AbstractEngineServer() {
 void AbstractEngineServer::installSprite( const std::function<void(ds::BlobRegistry&)>& asServer,
 										 const std::function<void(ds::BlobRegistry&)>& asClient) {
 	if (asServer) asServer(mBlobRegistry);
+	nameReplicatedBlobs();
 }
 
 void AbstractEngineServer::setup(ds::App& app) {
@@ -92,6 +115,7 @@ void AbstractEngineServer::update() {
 	mWorkManager.update();
 	updateServer();
 
+	DS_PROFILE_ZONE("Engine replication");
 	mState->update(*this);
 }
 
@@ -102,6 +126,8 @@ void AbstractEngineServer::draw() {
 void AbstractEngineServer::stopServices() {
 	Engine::stopServices();
 	mWorkManager.stopManager();
+	mSender.stopSendThread();
+	mKeyframeSender.stopSendThread();
 }
 
 void AbstractEngineServer::spriteDeleted(const ds::sprite_id_t &id) {
@@ -116,6 +142,21 @@ int AbstractEngineServer::getBytesSent(){
 	return mSendConnection.getSentBytes();
 }
 
+int AbstractEngineServer::getBytesPerFrame(){
+	return static_cast<int>(mSender.getLastFrameSize());
+}
+
+void AbstractEngineServer::getNetworkStats(std::vector<std::pair<std::string, std::string>>& stats){
+	const EngineSender::Stats	s = mSender.getStats();
+	if(s.mFramesSent > 0) {
+		std::stringstream	ss;
+		ss << s.mFramesQueued << " queued, " << s.mStalls << " stalls (" << static_cast<int>(s.mStallSeconds * 1000.0) << "ms), last " << static_cast<int>(s.mLastSendSeconds * 1000000.0) << "us";
+		stats.push_back(std::make_pair("Send Thread", ss.str()));
+	}
+
+	mReplicationStats.getSummary(stats);
+}
+
 void AbstractEngineServer::receiveHeader(ds::DataBuffer& data) {
 	char            id;
 	while (data.canRead<char>() && (id=data.read<char>()) != ds::TERMINATOR_CHAR) {
@@ -131,6 +172,10 @@ void AbstractEngineServer::receiveCommand(ds::DataBuffer &data) {
 			onClientStartedCommand(data);
 		} else if (cmd == CMD_CLIENT_RUNNING) {
 			onClientRunningCommand(data);
+		} else if (cmd == CMD_CLIENT_REQUEST_CHUNKS) {
+			onClientRequestChunksCommand(data);
+		} else if (cmd == CMD_CLIENT_REQUEST_RESUME) {
+			onClientRequestResumeCommand(data);
 		} else if (cmd == CMD_CLIENT_REQUEST_WORLD) {
 			DS_LOG_INFO_M("CMD_CLIENT_REQUEST_WORLD", ds::IO_LOG);
 			setState(mSendWorldState);
@@ -253,6 +298,176 @@ void AbstractEngineServer::onClientRunningCommand(ds::DataBuffer &data) {
 	mClients.reportingIn(session_id, frame);
 }
 
+void AbstractEngineServer::onClientRequestChunksCommand(ds::DataBuffer &data) {
+	if (!data.canRead<char>()) return;
+
+	// Session ID
+	char				att = data.read<char>();
+	if (att != ATT_SESSION_ID) return;
+	data.read<int32_t>();
+
+	if (!data.canRead<char>()) return;
+	att = data.read<char>();
+	if (att != ATT_CHUNKS) return;
+	if (!data.canRead<int32_t>()) return;
+
+	const int32_t		numGroups = data.read<int32_t>();
+	for (int32_t i = 0; i < numGroups; ++i) {
+		if (!data.canRead<unsigned>()) return;
+		const unsigned	groupId = data.read<unsigned>();
+		if (!data.canRead<int32_t>()) return;
+		const int32_t	numIds = data.read<int32_t>();
+
+		// Somebody already wants the whole group, no need to track individual chunks
+		auto			found = mRequestedChunks.find(groupId);
+		const bool		wholeGroup = (found != mRequestedChunks.end() && found->second.empty());
+		std::set<unsigned>&	ids = mRequestedChunks[groupId];
+		for (int32_t k = 0; k < numIds; ++k) {
+			if (!data.canRead<unsigned>()) return;
+			const unsigned	chunkId = data.read<unsigned>();
+			if (!wholeGroup) ids.insert(chunkId);
+		}
+		if (numIds < 1) ids.clear();
+	}
+}
+
+void AbstractEngineServer::onClientRequestResumeCommand(ds::DataBuffer &data) {
+	if (!data.canRead<char>()) return;
+
+	// Session ID
+	char				att = data.read<char>();
+	if (att != ATT_SESSION_ID) return;
+	if (!data.canRead<int32_t>()) return;
+	const int32_t		sessionId = data.read<int32_t>();
+
+	// The last frame the client applied, and the first group it doesn't have
+	if (!data.canRead<char>()) return;
+	att = data.read<char>();
+	if (att != ATT_FRAME || !data.canRead<int32_t>()) return;
+	const int32_t		frame = data.read<int32_t>();
+
+	if (!data.canRead<char>()) return;
+	att = data.read<char>();
+	if (att != ATT_GROUP || !data.canRead<unsigned>()) return;
+	const unsigned		groupId = data.read<unsigned>();
+
+	// Optionally, where to send a keyframe directly
+	std::string			address;
+	if (data.canRead<char>()) {
+		att = data.read<char>();
+		if (att == ATT_ADDRESS) {
+			address = data.read<std::string>();
+		} else {
+			// Let receiveCommand() see the terminator
+			data.rewindRead<char>();
+		}
+	}
+
+	// Everything since the client's last frame is still around, so just send that again.
+	// Clients that already have it drop it without looking at it.
+	if (frame >= 0 && mSender.canResendFrom(groupId)) {
+		DS_LOG_INFO_M("Client " << sessionId << " resuming from frame " << frame << ", resending from group " << groupId, ds::IO_LOG);
+		for (unsigned id = groupId; id <= mSender.getPacketNumber(); ++id) {
+			mRequestedChunks[id].clear();
+		}
+		return;
+	}
+
+	DS_LOG_INFO_M("Client " << sessionId << " needs a keyframe, last frame=" << frame, ds::IO_LOG);
+	for (auto& it : mKeyframeRequests) {
+		if (it.mSessionId == sessionId) {
+			it.mAddress = address;
+			return;
+		}
+	}
+	KeyframeRequest		request;
+	request.mSessionId = sessionId;
+	request.mAddress = address;
+	mKeyframeRequests.push_back(request);
+}
+
+bool AbstractEngineServer::resendRequestedChunks() {
+	if (mRequestedChunks.empty()) return true;
+
+	bool				allSent = true;
+	std::vector<unsigned> ids;
+	for (auto it = mRequestedChunks.begin(), end = mRequestedChunks.end(); it != end; ++it) {
+		ids.assign(it->second.begin(), it->second.end());
+		if (!mSender.resendChunks(it->first, ids)) {
+			DS_LOG_WARNING_M("A client lost chunk group " << it->first << ", which is too old to resend. It will ask to resume.", ds::IO_LOG);
+			allSent = false;
+		}
+	}
+
+	mRequestedChunks.clear();
+	return allSent;
+}
+
+void AbstractEngineServer::sendKeyframes(const int32_t frame) {
+	const bool			periodic = (mKeyframeInterval > 0 && frame % mKeyframeInterval == 0);
+	if (mKeyframeRequests.empty() && !periodic) return;
+
+	// One client gets its keyframe to itself. If several need one, or we don't know
+	// where a client is, a single keyframe on the multicast group does for all of them.
+	if (!periodic && mKeyframeRequests.size() == 1 && !mKeyframeRequests.front().mAddress.empty()) {
+		sendKeyframe(mKeyframeRequests.front().mSessionId, mKeyframeRequests.front().mAddress, frame);
+	} else {
+		sendKeyframe(0, mServerIp, frame);
+	}
+
+	mKeyframeRequests.clear();
+}
+
+void AbstractEngineServer::sendKeyframe(const int32_t sessionId, const std::string& address, const int32_t frame) {
+	if (address.empty() || mSendPort.empty()) return;
+
+	if (mKeyframeAddress != address || !mKeyframeConnection.initialized()) {
+		// The last keyframe might still be going out to the old address
+		mKeyframeSender.waitUntilSent();
+		if (!mKeyframeConnection.connect(address, mSendPort)) {
+			DS_LOG_WARNING_M("Couldn't open a keyframe connection to " << address, ds::IO_LOG);
+			mKeyframeAddress.clear();
+			return;
+		}
+		mKeyframeAddress = address;
+	}
+
+	EngineSender::AutoSend  send(mKeyframeSender);
+	DS_LOG_INFO_M("SEND KEYFRAME frame=" << frame << " session=" << sessionId << " to " << address, ds::IO_LOG);
+	// The frame lives in the command, so clients that skip this don't lose track of the stream
+	unsigned				start = send.mData.size();
+	send.mData.add(HEADER_BLOB);
+	send.mData.add(static_cast<int>(-1));
+	send.mData.add(ds::net::ReplicationStats::getEpochMicroseconds());
+	send.mData.add(ds::TERMINATOR_CHAR);
+	countBlobBytes(HEADER_BLOB, send.mData, start);
+	start = send.mData.size();
+	send.mData.add(COMMAND_BLOB);
+	send.mData.add(CMD_SERVER_SEND_KEYFRAME);
+	send.mData.add(ATT_SESSION_ID);
+	send.mData.add(sessionId);
+	send.mData.add(ATT_FRAME);
+	send.mData.add(frame);
+	// The keyframe includes every group sent so far, so the stream picks up after that
+	send.mData.add(ATT_GROUP);
+	send.mData.add(mSender.getPacketNumber() + 1);
+	send.mData.add(ds::TERMINATOR_CHAR);
+	countBlobBytes(COMMAND_BLOB, send.mData, start);
+
+	// The last root is the debug root, which never syncs
+	const size_t numRoots = getRootCount();
+	for(size_t i = 0; i + 1 < numRoots; i++){
+		if(!getRootBuilder(i).mSyncronize) continue;
+		ds::ui::Sprite& rooty = getRootSprite(i);
+		rooty.markTreeAsDirty();
+		rooty.writeTo(send.mData);
+	}
+}
+
+void AbstractEngineServer::countBlobBytes(const char blob, const ds::DataBuffer& data, const unsigned start) {
+	if(mReplicationStats.isEnabled()) mReplicationStats.addBlobBytes(blob, data.size() - start);
+}
+
 void AbstractEngineServer::setState(State& s) {
 	if (&s == mState) return;
 
@@ -281,11 +496,15 @@ AbstractEngineServer::State::State() {
 void AbstractEngineServer::State::begin(AbstractEngineServer&) {
 }
 
-void AbstractEngineServer::State::addHeader(ds::DataBuffer& data, const int frame) {
+void AbstractEngineServer::State::addHeader(AbstractEngineServer& engine, ds::DataBuffer& data, const int frame) {
+	const unsigned			start = data.size();
 	data.add(HEADER_BLOB);
 
 	data.add(frame);
+	// When the frame was built, so clients can tell how far behind they're applying it
+	data.add(ds::net::ReplicationStats::getEpochMicroseconds());
 	data.add(ds::TERMINATOR_CHAR);
+	engine.countBlobBytes(HEADER_BLOB, data, start);
 }
 
 /**
@@ -299,12 +518,13 @@ EngineServer::RunningState::RunningState()
 void EngineServer::RunningState::begin(AbstractEngineServer& engine) {
 	DS_LOG_INFO_M("RunningState", ds::IO_LOG);
 	engine.getNotifier().notify(ds::app::EngineStateEvent(ds::app::EngineStateEvent::ENGINE_STATE_CLIENT_RUNNING));
-	mFrame = 0;
+	// Frames keep counting across states, clients use them to resume
 	mDeletedSprites.clear();
 }
 
 void EngineServer::RunningState::update(AbstractEngineServer& engine) {
 	if (engine.mReceiver.hasLostConnection()) {
+		engine.mSender.waitUntilSent();
 		engine.mReceiveConnection.renew();
 		engine.mSendConnection.renew();
 		
@@ -315,19 +535,21 @@ void EngineServer::RunningState::update(AbstractEngineServer& engine) {
 	{
 		EngineSender::AutoSend  send(engine.mSender);
 		// Always send the header
-		addHeader(send.mData, mFrame);
+		addHeader(engine, send.mData, mFrame);
 
+		// Only the sprites marked dirty since the last frame, instead of walking every tree
+		mSyncedRoots.clear();
 		const size_t numRoots = engine.getRootCount();
-		for(int i = 0; i < numRoots - 1; i++){
+		for(size_t i = 0; i + 1 < numRoots; i++){
 			if(!engine.getRootBuilder(i).mSyncronize) continue;
-			ds::ui::Sprite& rooty = engine.getRootSprite(i);
-			if(rooty.isDirty()){
-				rooty.writeTo(send.mData);
-			}
+			mSyncedRoots.push_back(&engine.getRootSprite(i));
 		}
+		engine.getDirtySprites().writeTo(send.mData, mSyncedRoots);
 
 		if (!mDeletedSprites.empty()) {
+			const unsigned	start = send.mData.size();
 			addDeletedSprites(send.mData);
+			engine.countBlobBytes(DELETE_SPRITE_BLOB, send.mData, start);
 			mDeletedSprites.clear();
 		}
 	}
@@ -349,6 +571,12 @@ void EngineServer::RunningState::update(AbstractEngineServer& engine) {
 		}
 	}
 
+	// Resend anything clients lost. If it's too old to resend, the client will ask to resume instead
+	engine.resendRequestedChunks();
+
+	// Now that this frame's delta is out, anyone that fell too far behind can get a keyframe
+	engine.sendKeyframes(mFrame);
+
 	// Track how far behind any clients are
 	engine.mClients.compare(mFrame);
 
@@ -394,7 +622,8 @@ void EngineServer::ClientStartedReplyState::update(AbstractEngineServer& engine)
 		EngineSender::AutoSend  send(engine.mSender);
 		DS_LOG_INFO_M("Send ClientStartedReply " << std::time(0), ds::IO_LOG);
 		// Always send the header
-		addHeader(send.mData, -1);
+		addHeader(engine, send.mData, -1);
+		const unsigned	start = send.mData.size();
 		send.mData.add(COMMAND_BLOB);
 		send.mData.add(CMD_CLIENT_STARTED_REPLY);
 		// Send each client
@@ -407,6 +636,10 @@ void EngineServer::ClientStartedReplyState::update(AbstractEngineServer& engine)
 				send.mData.add(s->mGuid);
 				send.mData.add(ATT_SESSION_ID);
 				send.mData.add(s->mSessionId);
+				send.mData.add(ATT_CODEC);
+				send.mData.add(static_cast<char>(engine.mSender.getCodec()));
+				send.mData.add(ATT_ENCODING);
+				engine.getAttributeEncoding().writeTo(send.mData);
 
 				send.mData.add(ATT_ROOTS);
 				size_t rootCount = engine.getRootCount();
@@ -436,10 +669,12 @@ void EngineServer::ClientStartedReplyState::update(AbstractEngineServer& engine)
 		}
 
 		send.mData.add(ds::TERMINATOR_CHAR);
+		engine.countBlobBytes(COMMAND_BLOB, send.mData, start);
 	}
 
 	clear();
-	engine.setState(engine.mSendWorldState);
+	// New clients ask for a keyframe of their own, so nobody else has to receive the world again
+	engine.setState(engine.mRunningState);
 }
 
 /**
@@ -458,10 +693,12 @@ void EngineServer::SendWorldState::update(AbstractEngineServer& engine) {
 		EngineSender::AutoSend  send(engine.mSender);
 		DS_LOG_INFO_M("SEND WORLD " << std::time(0), ds::IO_LOG);
 		// Always send the header
-		addHeader(send.mData, -1);
+		addHeader(engine, send.mData, -1);
+		const unsigned	start = send.mData.size();
 		send.mData.add(COMMAND_BLOB);
 		send.mData.add(CMD_SERVER_SEND_WORLD);
 		send.mData.add(ds::TERMINATOR_CHAR);
+		engine.countBlobBytes(COMMAND_BLOB, send.mData, start);
 
 		const size_t numRoots = engine.getRootCount();
 		for(size_t i = 0; i < numRoots - 1; i++){
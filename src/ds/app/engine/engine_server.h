@@ -2,10 +2,13 @@
 #ifndef DS_APP_ENGINE_ENGINESERVER_H_
 #define DS_APP_ENGINE_ENGINESERVER_H_
 
+#include <map>
+#include <set>
 #include "ds/app/blob_reader.h"
 #include "ds/app/engine/engine.h"
 #include "ds/app/engine/engine_client_list.h"
 #include "ds/app/engine/engine_io.h"
+#include "ds/network/single_udp_receiver.h"
 #include "ds/network/udp_connection.h"
 
 namespace ds {
@@ -36,6 +39,8 @@ public:
 
 	virtual int						getBytesRecieved();
 	virtual int						getBytesSent();
+	virtual int						getBytesPerFrame();
+	virtual void					getNetworkStats(std::vector<std::pair<std::string, std::string>>&);
 
 private:
 	void							receiveHeader(ds::DataBuffer&);
@@ -45,6 +50,17 @@ private:
 	void							receiveClientInput(ds::DataBuffer&);
 	void							onClientStartedCommand(ds::DataBuffer&);
 	void							onClientRunningCommand(ds::DataBuffer&);
+	void							onClientRequestChunksCommand(ds::DataBuffer&);
+	void							onClientRequestResumeCommand(ds::DataBuffer&);
+	/// Resend whatever chunks clients asked for since the last call. Answers false
+	/// if something asked for has already fallen out of the retransmit window.
+	bool							resendRequestedChunks();
+	/// Send a keyframe to every client that asked for one, plus the periodic keyframe if it's due.
+	/// Must be called after the frame's delta has gone out, so the keyframe includes it.
+	void							sendKeyframes(const int32_t frame);
+	void							sendKeyframe(const int32_t sessionId, const std::string& address, const int32_t frame);
+	/// For the replication stats: everything written to data from start on is one blob, like sprites count themselves.
+	void							countBlobBytes(const char blob, const ds::DataBuffer& data, const unsigned start);
 
 	virtual void					handleMouseTouchBegin(const ci::app::MouseEvent&, int id);
 	virtual void					handleMouseTouchMoved(const ci::app::MouseEvent&, int id);
@@ -58,6 +74,25 @@ private:
 	EngineReceiver					mReceiver;
 	ds::BlobReader					mBlobReader;
 	ContentWrangler*				mContentWrangler;
+	/// Chunk group id to the chunk ids clients are missing. An empty set means the whole group.
+	/// Collected across all clients so each chunk is resent once per frame.
+	std::map<unsigned, std::set<unsigned>>
+									mRequestedChunks;
+
+	/// Keyframes go out on their own channel, either straight to the client that
+	/// needs one or to the multicast group, so they never hold up the main stream.
+	struct KeyframeRequest {
+		int32_t						mSessionId;
+		std::string					mAddress;
+	};
+	std::vector<KeyframeRequest>	mKeyframeRequests;
+	ds::UdpReceiver					mKeyframeConnection;
+	std::string						mKeyframeAddress;
+	EngineSender					mKeyframeSender;
+	std::string						mServerIp;
+	std::string						mSendPort;
+	/// Send a keyframe to anyone waiting every this many frames. 0 means only on request.
+	int								mKeyframeInterval;
 
 	/// STATES
 	class State {
@@ -68,7 +103,7 @@ private:
 		virtual void				spriteDeleted(const ds::sprite_id_t&) { }
 
 	protected:
-		void						addHeader(ds::DataBuffer&, const int frame);
+		void						addHeader(AbstractEngineServer&, ds::DataBuffer&, const int frame);
 	};
 
 	/* Default state: Gathers all changes in the app and sends them out each frame.
@@ -85,6 +120,8 @@ private:
 		void						addDeletedSprites(ds::DataBuffer&) const;
 
 		int32_t						mFrame;
+		/// Scratch for the roots that get replicated
+		std::vector<ds::ui::Sprite*>	mSyncedRoots;
 	};
 
 	/* This state is used to send a client started reply.
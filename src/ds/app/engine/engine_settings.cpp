@@ -171,6 +171,18 @@ void EngineSettings::setDefaults(){
 	getSetting("server:ip", 0, ds::cfg::SETTING_TYPE_STRING, "The multicast group udp address and port of the server", "239.255.42.58");
 	getSetting("server:send_port", 0, ds::cfg::SETTING_TYPE_INT, "The send port of the server. Match these between server and client", "1037", "1", "99999");
 	getSetting("server:listen_port", 0, ds::cfg::SETTING_TYPE_INT, "The listen port of the server (which is what the client sends on). Match these between server and client.", "1038", "1", "99999");
+	getSetting("server:compression", 0, ds::cfg::SETTING_TYPE_STRING, "How the server compresses world frames. Clients are told on connect and use the same codec when replying.", "snappy", "", "", "none, snappy");
+	getSetting("server:retransmit_window", 0, ds::cfg::SETTING_TYPE_INT, "How many recent frames the server keeps to resend chunks clients lost. Clients that fall further behind get a keyframe. 0 turns this off.", "64", "0", "1024");
+	getSetting("server:attribute_encoding", 0, ds::cfg::SETTING_TYPE_STRING, "How sprites pack size, position, rotation, scale, color and opacity. compact quantizes them to the precisions below and only sends how much they changed, which is much smaller for lots of moving sprites.", "raw", "", "", "raw, compact");
+	getSetting("server:attribute_precision:spatial", 0, ds::cfg::SETTING_TYPE_FLOAT, "With compact attribute encoding, the smallest change in size or position that's replicated, in pixels.", "0.01", "0.00001", "10");
+	getSetting("server:attribute_precision:rotation", 0, ds::cfg::SETTING_TYPE_FLOAT, "With compact attribute encoding, the smallest change in rotation that's replicated, in degrees.", "0.01", "0.00001", "10");
+	getSetting("server:attribute_precision:scale", 0, ds::cfg::SETTING_TYPE_FLOAT, "With compact attribute encoding, the smallest change in scale or center that's replicated.", "0.0001", "0.00001", "1");
+	getSetting("server:attribute_precision:color", 0, ds::cfg::SETTING_TYPE_FLOAT, "With compact attribute encoding, the smallest change in color or opacity that's replicated.", "0.001", "0.00001", "1");
+	getSetting("server:send_thread", 0, ds::cfg::SETTING_TYPE_BOOL, "Encode and send frames on their own thread, so the next frame can be built while the last one goes out.", "true");
+	getSetting("client:receive_thread", 0, ds::cfg::SETTING_TYPE_BOOL, "Receive and decode frames from the server on their own thread, so a big frame doesn't hold up drawing.", "true");
+	getSetting("client:max_frame_backlog", 0, ds::cfg::SETTING_TYPE_INT, "If a client has more than this many frames waiting, it drops them and asks the server for a keyframe instead of replaying them all. 0 always replays everything.", "120", "0", "3600");
+	getSetting("server:replication_stats", 0, ds::cfg::SETTING_TYPE_INT, "How many frames of replication stats (bytes per blob type, compression, timing, loss, latency) servers and clients keep for the stats view. Shift-s saves them as CSV. 0 turns this off.", "600", "0", "36000");
+	getSetting("server:keyframe_interval", 0, ds::cfg::SETTING_TYPE_INT, "Send a keyframe every this many frames, for clients waiting to resume. 0 only sends keyframes when a client asks for one.", "0", "0", "3600");
 	getSetting("platform:architecture", 0, ds::cfg::SETTING_TYPE_STRING, "If this is a server (world engine), a client (render engine) or both (world + render). clientserver is an EngineClientServer, which both displays content and can control other instances. standalone does not transmit or receive.", "standalone", "", "", "standalone, client, server, clientserver");
 	getSetting("platform:guid", 0, ds::cfg::SETTING_TYPE_STRING, "Unique identifier for network traffic (appended by additional unique values).", "Downstream");
 	getSetting("xml_importer:cache", 0, ds::cfg::SETTING_TYPE_BOOL, "If the xml importer should cache xml content or reload from disk each time", "true");
@@ -197,6 +209,12 @@ void EngineSettings::setDefaults(){
 	getSetting("platform:mute", 0, ds::cfg::SETTING_TYPE_BOOL, "Mutes all video sound if true", "false");
 	getSetting("animation:duration", 0, ds::cfg::SETTING_TYPE_FLOAT, "Standard duration for animations", "0.35", "0.0", "10.0");
 	getSetting("load_image:threads", 0, ds::cfg::SETTING_TYPE_INT, "Number of threads to spawn for image loading", "1", "0", "32");
+	getSetting("work:update_budget", 0, ds::cfg::SETTING_TYPE_INT, "Microseconds each frame can spend handing finished background work (queries, http requests, runnables) back to the app. 0 for no limit.", "2000", "0", "100000");
+	getSetting("work:update_max_results", 0, ds::cfg::SETTING_TYPE_INT, "How many finished background requests can be handed back to the app each frame. 0 for no limit.", "0", "0", "10000");
+	getSetting("memory:log_interval", 0, ds::cfg::SETTING_TYPE_INT, "Seconds between log lines of what each subsystem is holding on to (sprites by class, textures, content models, query results, data buffers, the log queue). 0 turns it off.", "3600", "0", "86400");
+	getSetting("profiler:frames", 0, ds::cfg::SETTING_TYPE_INT, "How many frames of profiler zones (engine phases, services, work requests, text layout) to keep for the stats view. Ctrl-s saves them as a Chrome trace. 0 turns the profiler off.", "0", "0", "36000");
+	getSetting("profiler:sprite_zones", 0, ds::cfg::SETTING_TYPE_BOOL, "Also profile every sprite's update and draw, by class. Slows things down noticeably with lots of sprites.", "false");
+	getSetting("update:parallel_threads", 0, ds::cfg::SETTING_TYPE_INT, "Worker threads for updating sprite subtrees that opted in with setUpdateParallel(). 0 updates them on the main thread with everything else.", "3", "0", "32");
 
 	getSetting("TOUCH SETTINGS", 0, ds::cfg::SETTING_TYPE_SECTION_HEADER, "");
 	getSetting("touch:mode", 0, ds::cfg::SETTING_TYPE_STRING, "Set the current touch mode: Tuio, TuioAndMouse, System, SystemAndMouse, All.", "SystemAndMouse", "", "", "Tuio, TuioAndMouse, System, SystemAndMouse, All");
@@ -214,6 +232,7 @@ void EngineSettings::setDefaults(){
 	getSetting("touch:tap_threshold", 0, ds::cfg::SETTING_TYPE_FLOAT, "How far a touch moves before it's not a tap, in pixels.", "30", "0", "200");
 	getSetting("touch:minimum_distance", 0, ds::cfg::SETTING_TYPE_FLOAT, "How many pixels away from an existing touch point for a new touch to be considered valid.", "20.0", "1.0", "300");
 	getSetting("touch:smoothing", 0, ds::cfg::SETTING_TYPE_BOOL, "Average out touch points over time for smoother input, but slightly less accurate.", "true");
+	getSetting("touch:coalesce_moves", 0, ds::cfg::SETTING_TYPE_BOOL, "Only handle the latest move for each finger each frame. Turn off if the app needs to see every sample in onTouchesMoved().", "true");
 	getSetting("touch:smooth_frames", 0, ds::cfg::SETTING_TYPE_INT, "How many frames to use when smoothing. Higher numbers are smoother. Lower than 3 is effectively off.", "5", "1", "64");
 	getSetting("touch:swipe:queue_size", 0, ds::cfg::SETTING_TYPE_INT, "How many frames of touch swipe info to account for when calculating swipes", "4", "1", "16");
 	getSetting("touch:swipe:minimum_velocity", 0, ds::cfg::SETTING_TYPE_FLOAT, "The velocity a swipe needs to exceed to count as a swipe", "800.0", "1.0", "2400");
@@ -228,6 +247,7 @@ void EngineSettings::setDefaults(){
 	getSetting("content:node_watch", 0, ds::cfg::SETTING_TYPE_BOOL, "If ContentWrangler should automatically listen to dsnode messages on udp localhost port 7777", "true");
 	getSetting("content:model_location", 0, ds::cfg::SETTING_TYPE_STRING, "Where ContentWrangler should look for an xml file that describes a data model to load sqlite data. Specify multiple locations separated by a semicolon", "%APP%/data/model/content_model.xml");
 	getSetting("content:use_wrangler", 0, ds::cfg::SETTING_TYPE_BOOL, " If ContentWrangler should be used to automatically grab data", "false");
+	getSetting("content:incremental", 0, ds::cfg::SETTING_TYPE_BOOL, "If ContentWrangler should only re-read rows whose updated_field changed and patch the existing content models, instead of replacing them", "false");
 	getSetting("auto_refresh_app", 0, ds::cfg::SETTING_TYPE_BOOL, "Listen to directory changes and auto soft-restart the app.", "false");
 	getSetting("auto_refresh_directories", 0, ds::cfg::SETTING_TYPE_STRING, "Semi-colon separated list of directories to listen to to restart the app. If auto_refresh_app is off, will still listen to these directories", "%APP%");
 
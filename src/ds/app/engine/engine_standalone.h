@@ -30,6 +30,7 @@ public:
 
 	virtual int						getBytesRecieved(){ return 0; }
 	virtual int						getBytesSent(){ return 0; }
+	virtual int						getBytesPerFrame(){ return 0; }
 
 private:
 
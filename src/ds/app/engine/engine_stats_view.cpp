@@ -6,6 +6,8 @@
 #include "ds/data/data_buffer.h"
 #include "engine_data.h"
 #include <ds/debug/computer_info.h>
+#include <ds/debug/profiler.h>
+#include <ds/util/string_util.h>
 
 #pragma warning(disable: 4355)
 
@@ -30,17 +32,25 @@ std::string			make_line(const std::string &key, const float v) {
 	return buf.str();
 }
 
+/// Class names can hold template brackets, which would read as markup
+std::string			escapeMarkup(std::string str) {
+	ds::replace(str, "&", "&amp;");
+	ds::replace(str, "<", "&lt;");
+	ds::replace(str, ">", "&gt;");
+	return str;
+}
+
 }
 
 /**
  * \class EngineStatsView
  */
 void EngineStatsView::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {ds::ui::Sprite::handleBlobFromClient(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {ds::ui::Sprite::handleBlobFromClient(r);}, "EngineStatsView");
 }
 
 void EngineStatsView::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {ds::ui::Sprite::handleBlobFromServer<EngineStatsView>(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {ds::ui::Sprite::handleBlobFromServer<EngineStatsView>(r);}, "EngineStatsView");
 }
 
 /**
@@ -128,16 +138,28 @@ void EngineStatsView::updateStats() {
 	}
 	if(mText){
 		std::stringstream ss;
-		ss << "<span weight='bold'>Sprites:</span> " << mEngine.mSprites.size() << std::endl;
 		ss << "<span weight='bold'>Touch mode (t):</span> " << ds::ui::TouchMode::toString(mEngine.mTouchMode) << std::endl;
 
 		ss << "<span weight='bold'>Physical Memory:</span> " << mEngine.getComputerInfo().getPhysicalMemoryUsedByProcess() << std::endl;
 		ss << "<span weight='bold'>Virtual Memory:</span> " << mEngine.getComputerInfo().getVirtualMemoryUsedByProcess() << std::endl;
 		//ss << "<span weight='bold'>CPU:</span> " << mEngine.getComputerInfo().getPercentUsageCPU() << "%" << std::endl;
 
+		std::vector<std::pair<std::string, std::string>> memoryStats;
+		mEngine.getMemoryStats(memoryStats);
+		for(auto& it : memoryStats){
+			ss << "<span weight='bold'>" << it.first << ":</span> " << escapeMarkup(it.second) << std::endl;
+		}
+
 		if(mEngine.getMode() != ds::ui::SpriteEngine::STANDALONE_MODE){
 			ss << "<span weight='bold'>Bytes Received:</span>\t" << mEngine.getBytesRecieved() << std::endl;
 			ss << "<span weight='bold'>Bytes Sent:</span>\t\t" << mEngine.getBytesSent() << std::endl;
+			ss << "<span weight='bold'>Bytes/Frame:</span>\t" << mEngine.getBytesPerFrame() << std::endl;
+
+			std::vector<std::pair<std::string, std::string>> netStats;
+			mEngine.getNetworkStats(netStats);
+			for(auto& it : netStats){
+				ss << "<span weight='bold'>" << it.first << ":</span> " << it.second << std::endl;
+			}
 		}
 
 		float fpsy = mEngine.getAverageFps();
@@ -149,6 +171,14 @@ void EngineStatsView::updateStats() {
 			ss << "<span weight='bold'>FPS:</span> " << fpsy << std::endl;
 		}
 
+		if(ds::Profiler::get().isEnabled()){
+			std::vector<std::pair<std::string, std::string>> zones;
+			ds::Profiler::get().getSummary(zones);
+			for(auto& it : zones){
+				ss << "<span weight='bold'>" << escapeMarkup(it.first) << ":</span> " << it.second << std::endl;
+			}
+		}
+
 		if(mShowingHelp) {
 			auto appy = dynamic_cast<ds::App*>(ds::App::get());
 			ss << std::endl << "<span size='xx-small'>" << appy->getKeyManager().getAllKeysString() << "</span>";
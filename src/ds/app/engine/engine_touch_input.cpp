@@ -0,0 +1,172 @@
+#include "stdafx.h"
+
+#include "ds/app/engine/engine_touch_input.h"
+
+namespace ds {
+
+/**
+ * \class EngineTouchInput
+ */
+EngineTouchInput::EngineTouchInput(	float& lastTouchTime, const TouchFn& beganFn, const TouchFn& movedFn,
+									const TouchFn& endedFn, const size_t capacity)
+		: mLastTouchTime(lastTouchTime)
+		, mBeganFn(beganFn)
+		, mMovedFn(movedFn)
+		, mEndedFn(endedFn)
+		, mKeepHistory(false)
+		, mCoalesce(true)
+		, mQueue(capacity)
+		, mOverflowing(false)
+		, mLastReceived(0)
+		, mLastSent(0)
+{
+	mEntries.reserve(64);
+	mPendingMoves.reserve(32);
+	mBatch.reserve(32);
+}
+
+void EngineTouchInput::setHistoryFn(const TouchFn& fn) {
+	mHistoryFn = fn;
+}
+
+void EngineTouchInput::setKeepHistory(const bool keep) {
+	mKeepHistory = keep;
+}
+
+void EngineTouchInput::setCoalesce(const bool coalesce) {
+	mCoalesce = coalesce;
+}
+
+void EngineTouchInput::incoming(const Phase phase, const ds::ui::TouchEvent& e) {
+	Poco::FastMutex::ScopedLock		l(mProducerMutex);
+	for(auto it = e.getTouches().begin(), end = e.getTouches().end(); it != end; ++it) {
+		// Once anything has spilled over, everything after it has to as well, or it would jump the line
+		if(!mOverflowing.load(std::memory_order_acquire)
+				&& mQueue.push(Entry(phase, *it, e.getWindow(), e.getInWorldSpace()))) {
+			continue;
+		}
+		Poco::FastMutex::ScopedLock	ol(mOverflowMutex);
+		mOverflow.push_back(Entry(phase, *it, e.getWindow(), e.getInWorldSpace()));
+		mOverflowing.store(true, std::memory_order_release);
+	}
+}
+
+void EngineTouchInput::update(const float currTime) {
+	mEntries.clear();
+	Entry							e;
+	while(mQueue.pop(e)) mEntries.push_back(std::move(e));
+	if(mOverflowing.load(std::memory_order_acquire)) {
+		// Producers only add to the overflow while it's set, so once the ring is drained
+		// again everything in it is older. Anything newer waits in the ring for next frame.
+		Poco::FastMutex::ScopedLock	l(mOverflowMutex);
+		while(mQueue.pop(e)) mEntries.push_back(std::move(e));
+		for(auto& o : mOverflow) mEntries.push_back(std::move(o));
+		mOverflow.clear();
+		mOverflowing.store(false, std::memory_order_release);
+	}
+
+	mLastReceived = mEntries.size();
+	mLastSent = 0;
+	if(mEntries.empty()) return;
+
+	mLastTouchTime = currTime;
+	if(mCoalesce) coalesce();
+
+	// Send runs of the same phase together, the same way the touches arrived
+	size_t							begin = 0;
+	while(begin < mEntries.size()) {
+		if(mEntries[begin].mFolded) {
+			++begin;
+			continue;
+		}
+		size_t						end = begin + 1;
+		while(end < mEntries.size()) {
+			const Entry&			n = mEntries[end];
+			if(!n.mFolded && (n.mPhase != mEntries[begin].mPhase || n.mWindow != mEntries[begin].mWindow
+				|| n.mInWorldSpace != mEntries[begin].mInWorldSpace)) break;
+			++end;
+		}
+		send(begin, end);
+		begin = end;
+	}
+}
+
+void EngineTouchInput::coalesce() {
+	mPendingMoves.clear();
+	for(size_t k = 0; k < mEntries.size(); ++k) {
+		Entry&						e = mEntries[k];
+		const uint32_t				id = e.mTouch.getId();
+		auto						pending = mPendingMoves.begin();
+		while(pending != mPendingMoves.end() && pending->first != id) ++pending;
+
+		if(e.mPhase != PHASE_MOVED) {
+			if(pending != mPendingMoves.end()) mPendingMoves.erase(pending);
+			continue;
+		}
+		if(pending == mPendingMoves.end()) {
+			mPendingMoves.push_back(std::make_pair(id, k));
+			continue;
+		}
+
+		// The newer move takes the older one's place, but keeps where the finger was before
+		// both, so the delta covers the whole frame.
+		Entry&						older = mEntries[pending->second];
+		older.mFolded = true;
+		if(mKeepHistory) {
+			e.mHistory.swap(older.mHistory);
+			e.mHistory.push_back(older.mTouch);
+		}
+		e.mTouch = ci::app::TouchEvent::Touch(e.mTouch.getPos(), older.mTouch.getPrevPos(), id, e.mTouch.getTime(),
+											  const_cast<void*>(e.mTouch.getNative()));
+		pending->second = k;
+	}
+}
+
+void EngineTouchInput::send(const size_t begin, const size_t end) {
+	const Entry&					first = mEntries[begin];
+
+	if(first.mPhase == PHASE_MOVED && mKeepHistory && mHistoryFn) {
+		mBatch.clear();
+		for(size_t k = begin; k < end; ++k) {
+			if(mEntries[k].mFolded) continue;
+			mBatch.insert(mBatch.end(), mEntries[k].mHistory.begin(), mEntries[k].mHistory.end());
+		}
+		if(!mBatch.empty()) mHistoryFn(ds::ui::TouchEvent(first.mWindow, mBatch, first.mInWorldSpace));
+	}
+
+	mBatch.clear();
+	for(size_t k = begin; k < end; ++k) {
+		if(!mEntries[k].mFolded) mBatch.push_back(mEntries[k].mTouch);
+	}
+	mLastSent += mBatch.size();
+
+	const ds::ui::TouchEvent		e(first.mWindow, mBatch, first.mInWorldSpace);
+	if(first.mPhase == PHASE_BEGIN) {
+		if(mBeganFn) mBeganFn(e);
+	} else if(first.mPhase == PHASE_MOVED) {
+		if(mMovedFn) mMovedFn(e);
+	} else {
+		if(mEndedFn) mEndedFn(e);
+	}
+}
+
+/**
+ * \class EngineTouchInput::Entry
+ */
+EngineTouchInput::Entry::Entry()
+		: mPhase(PHASE_MOVED)
+		, mInWorldSpace(false)
+		, mFolded(false)
+{
+}
+
+EngineTouchInput::Entry::Entry(const Phase phase, const ci::app::TouchEvent::Touch& t, const ci::app::WindowRef& w, const bool inWorldSpace)
+		: mPhase(phase)
+		, mTouch(t)
+		, mWindow(w)
+		, mInWorldSpace(inWorldSpace)
+		, mFolded(false)
+{
+}
+
+} // namespace ds
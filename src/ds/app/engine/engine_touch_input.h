@@ -0,0 +1,106 @@
+#pragma once
+#ifndef DS_APP_ENGINE_ENGINETOUCHINPUT_H_
+#define DS_APP_ENGINE_ENGINETOUCHINPUT_H_
+
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include <Poco/Mutex.h>
+
+#include "ds/thread/spsc_queue.h"
+#include "ds/ui/touch/touch_event.h"
+
+namespace ds {
+
+/**
+ * \class EngineTouchInput
+ * \brief Carries touches from whichever thread they arrive on to the engine update. Every
+ * touch goes through a lock-free ring, and once a frame the update drains it, keeping only
+ * the latest move for each finger. Begins and ends are never dropped and keep their order,
+ * so the work done per frame depends on how many fingers are down, not how fast the
+ * touch source is sending.
+ *
+ * The moves that were folded away can still be handed to a history function, so touch
+ * smoothing sees every sample.
+ */
+class EngineTouchInput {
+public:
+	enum Phase { PHASE_BEGIN, PHASE_MOVED, PHASE_ENDED };
+	typedef std::function<void(const ds::ui::TouchEvent&)> TouchFn;
+
+	EngineTouchInput(	float& lastTouchTime, const TouchFn& beganFn, const TouchFn& movedFn,
+						const TouchFn& endedFn, const size_t capacity = 4096);
+
+	/// Receives the moves that were folded into a later one, just before that one is sent.
+	void					setHistoryFn(const TouchFn&);
+	void					setKeepHistory(const bool);
+	/// Off sends every move as it came in, like before.
+	void					setCoalesce(const bool);
+	bool					getCoalesce() const { return mCoalesce; }
+
+	/// Call this as new events arrive, from any thread.
+	void					incoming(const Phase, const ds::ui::TouchEvent&);
+
+	/// Call from the main thread, sends everything that came in since last time.
+	void					update(const float currTime);
+
+	/// How many touches came in and how many were sent during the last update.
+	size_t					getLastReceived() const { return mLastReceived; }
+	size_t					getLastSent() const { return mLastSent; }
+
+private:
+	EngineTouchInput(const EngineTouchInput&);
+	EngineTouchInput&		operator=(const EngineTouchInput&);
+
+	class Entry {
+	public:
+		Entry();
+		Entry(const Phase, const ci::app::TouchEvent::Touch&, const ci::app::WindowRef&, const bool inWorldSpace);
+
+		Phase				mPhase;
+		ci::app::TouchEvent::Touch
+							mTouch;
+		ci::app::WindowRef	mWindow;
+		bool				mInWorldSpace;
+		/// Dropped in favour of a later move by the same finger
+		bool				mFolded;
+		/// The moves folded into this one, oldest first
+		std::vector<ci::app::TouchEvent::Touch>
+							mHistory;
+	};
+
+	void					coalesce();
+	void					send(const size_t begin, const size_t end);
+
+	float&					mLastTouchTime;
+	TouchFn					mBeganFn,
+							mMovedFn,
+							mEndedFn,
+							mHistoryFn;
+	bool					mKeepHistory;
+	bool					mCoalesce;
+
+	/// Touches can come from the main thread, the tuio thread and any extra tuio inputs,
+	/// so producers take turns on the ring. The update never locks unless the ring overflowed.
+	Poco::FastMutex			mProducerMutex;
+	ds::SpscQueue<Entry>	mQueue;
+	/// Used once the ring is full, until the update catches up, to keep everything in order.
+	Poco::FastMutex			mOverflowMutex;
+	std::vector<Entry>		mOverflow;
+	std::atomic<bool>		mOverflowing;
+
+	/// Update only: everything drained this frame, and the pending move for each finger
+	std::vector<Entry>		mEntries;
+	std::vector<std::pair<uint32_t, size_t>>
+							mPendingMoves;
+	std::vector<ci::app::TouchEvent::Touch>
+							mBatch;
+	size_t					mLastReceived;
+	size_t					mLastSent;
+};
+
+} // namespace ds
+
+#endif // DS_APP_ENGINE_ENGINETOUCHINPUT_H_
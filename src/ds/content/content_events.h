@@ -2,12 +2,30 @@
 #ifndef DS_CONTENT_CONTENT_EVENTS
 #define DS_CONTENT_CONTENT_EVENTS
 
+#include <map>
+#include <string>
+#include <vector>
 #include <ds/app/event.h>
 
 namespace ds {
 
+/// The row ids that changed in one table during an incremental update
+struct ContentTableChanges {
+	std::vector<int> mAdded;
+	std::vector<int> mRemoved;
+	std::vector<int> mModified;
+	bool			 mReordered = false;
+};
+
 /// ContentQuery has completed and there is new content available
-class ContentUpdatedEvent : public ds::RegisteredEvent<ContentUpdatedEvent> {};
+class ContentUpdatedEvent : public ds::RegisteredEvent<ContentUpdatedEvent> {
+  public:
+	/// If true, the existing models were patched in place and mChanges says what changed.
+	/// Otherwise the content was replaced, and anything could be different.
+	bool									   mIncremental = false;
+	/// Table name -> the rows that changed in it
+	std::map<std::string, ContentTableChanges> mChanges;
+};
 
 /// A request to re-query content (all queries are asynchronous)
 class RequestContentQueryEvent : public ds::RegisteredEvent<RequestContentQueryEvent> {};
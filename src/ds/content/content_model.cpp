@@ -2,6 +2,8 @@
 
 #include "content_model.h" 
 
+#include <algorithm>
+#include <ds/debug/memory_accounting.h>
 #include <ds/util/string_util.h>
 #include <ds/util/color_util.h>
 
@@ -15,8 +17,24 @@ const ds::Resource					EMPTY_RESOURCE;
 const std::vector<ContentModelRef>		EMPTY_DATAMODELREF_VECTOR;
 const ContentModelRef										EMPTY_DATAMODEL;
 const ContentProperty										EMPTY_PROPERTY;
-const std::map<std::string, ContentProperty>				EMPTY_PROPERTY_MAP;
 
+ds::MemoryTag& modelMemory() {
+	static ds::MemoryTag&	TAG = ds::MemoryAccounting::get().getTag("Content models");
+	return TAG;
+}
+
+ds::MemoryTag& schemaMemory() {
+	static ds::MemoryTag&	TAG = ds::MemoryAccounting::get().getTag("Content schemas");
+	return TAG;
+}
+
+/// Handles cache a NO_SLOT as this, since only 32 bits are kept
+const uint32_t						CACHED_NO_SLOT = 0xffffffff;
+
+uint32_t nextSchemaId() {
+	static std::atomic<uint32_t>	NEXT_ID(1);
+	return NEXT_ID.fetch_add(1, std::memory_order_relaxed);
+}
 }
 
 ContentProperty::ContentProperty()
@@ -173,6 +191,129 @@ const ci::Rectf ContentProperty::getRect() const {
 
 
 
+/**
+ * \class ContentSchema
+ */
+const std::shared_ptr<const ContentSchema>& ContentSchema::getEmpty() {
+	// Never deleted, since models in statics can outlive it otherwise
+	static std::shared_ptr<const ContentSchema>* EMPTY = new std::shared_ptr<const ContentSchema>(new ContentSchema());
+	return *EMPTY;
+}
+
+std::shared_ptr<const ContentSchema> ContentSchema::get(const std::vector<std::string>& names) {
+	std::shared_ptr<const ContentSchema> schema = getEmpty();
+	for(auto& name : names) {
+		schema = schema->with(name);
+	}
+	return schema;
+}
+
+ContentSchema::ContentSchema()
+	: mId(nextSchemaId())
+	, mInterned(true)
+	, mMemory(schemaMemory(), sizeof(ContentSchema))
+{
+}
+
+ContentSchema::~ContentSchema() {
+	if(!mParent || mNames.empty()) return;
+
+	// Someone may have made a new one under the same name since this one's last holder let go
+	Poco::FastMutex::ScopedLock l(mParent->mMutex);
+	auto findy = mParent->mExtensions.find(mNames.back());
+	if(findy != mParent->mExtensions.end() && findy->second.expired()) mParent->mExtensions.erase(findy);
+}
+
+std::shared_ptr<const ContentSchema> ContentSchema::with(const std::string& name) const {
+	if(mSlots.find(name) != mSlots.end()) return shared_from_this();
+
+	if(!mInterned || mNames.size() >= MAX_INTERNED) {
+		std::shared_ptr<ContentSchema> bigger = makePrivate();
+		bigger->append(name);
+		return bigger;
+	}
+
+	Poco::FastMutex::ScopedLock l(mMutex);
+	auto findy = mExtensions.find(name);
+	if(findy != mExtensions.end()) {
+		std::shared_ptr<const ContentSchema> existing = findy->second.lock();
+		if(existing) return existing;
+	}
+
+	std::shared_ptr<ContentSchema> bigger(new ContentSchema());
+	bigger->mParent = shared_from_this();
+	bigger->mNames = mNames;
+	bigger->mSlots = mSlots;
+	bigger->mSlots[name] = bigger->mNames.size();
+	bigger->mNames.push_back(name);
+	mExtensions[name] = bigger;
+	return bigger;
+}
+
+size_t ContentSchema::getSlot(const std::string& name) const {
+	auto findy = mSlots.find(name);
+	if(findy == mSlots.end()) return NO_SLOT;
+	return findy->second;
+}
+
+const std::string& ContentSchema::getName(const size_t slot) const {
+	if(slot >= mNames.size()) return EMPTY_STRING;
+	return mNames[slot];
+}
+
+std::shared_ptr<ContentSchema> ContentSchema::makePrivate() const {
+	std::shared_ptr<ContentSchema> copy(new ContentSchema());
+	copy->mNames = mNames;
+	copy->mSlots = mSlots;
+	copy->mInterned = false;
+	return copy;
+}
+
+void ContentSchema::append(const std::string& name) {
+	if(mSlots.find(name) != mSlots.end()) return;
+	mSlots[name] = mNames.size();
+	mNames.push_back(name);
+	// Handles may have cached this name as missing
+	mId = nextSchemaId();
+}
+
+/**
+ * \class ContentPropertyHandle
+ */
+ContentPropertyHandle::ContentPropertyHandle(const std::string& name)
+	: mName(name)
+	, mCache(0)
+{
+}
+
+ContentPropertyHandle::ContentPropertyHandle(const ContentPropertyHandle& o)
+	: mName(o.mName)
+	, mCache(o.mCache.load(std::memory_order_relaxed))
+{
+}
+
+ContentPropertyHandle& ContentPropertyHandle::operator=(const ContentPropertyHandle& o) {
+	if(this == &o) return *this;
+	mName = o.mName;
+	mCache.store(o.mCache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	return *this;
+}
+
+size_t ContentPropertyHandle::getSlot(const ContentSchema& schema) const {
+	const uint64_t cached = mCache.load(std::memory_order_relaxed);
+	if(static_cast<uint32_t>(cached >> 32) == schema.getId()) {
+		const uint32_t slot = static_cast<uint32_t>(cached);
+		return slot == CACHED_NO_SLOT ? ContentSchema::NO_SLOT : static_cast<size_t>(slot);
+	}
+
+	const size_t slot = schema.getSlot(mName);
+	const uint32_t toCache = slot == ContentSchema::NO_SLOT ? CACHED_NO_SLOT : static_cast<uint32_t>(slot);
+	mCache.store((static_cast<uint64_t>(schema.getId()) << 32) | toCache, std::memory_order_relaxed);
+	return slot;
+}
+
+
+
 class ContentModelRef::Data {
 public:
 	Data()
@@ -180,14 +321,20 @@ public:
 		, mLabel(EMPTY_STRING)
 		, mId(EMPTY_INT)
 		, mUserData(nullptr)
+		, mSchema(ContentSchema::getEmpty())
+		, mMemory(modelMemory(), sizeof(Data))
 	{}
 
 	std::string mName;
 	std::string mLabel;
 	void * mUserData;
 	int mId;
-	std::map<std::string, ContentProperty> mProperties;
+	std::shared_ptr<const ContentSchema> mSchema;
+	/// One per slot in mSchema. The names are left empty, the schema has them
+	std::vector<ContentProperty> mProperties;
 	std::vector<ContentModelRef> mChildren;
+	/// Counts every node in every tree, so a leaked tree shows up
+	ds::MemoryTracked mMemory;
 
 };
 
@@ -269,8 +416,7 @@ ds::model::ContentModelRef ContentModelRef::duplicate() const {
 	
 	if(!mData) return newModel;
 
-	std::map<std::string, ContentProperty> props = mData->mProperties;
-	newModel.setProperties(props);
+	newModel.setPropertiesFrom(*this);
 
 	std::vector<ContentModelRef> newChildren;
 	for(auto it : mData->mChildren) {
@@ -305,8 +451,18 @@ bool ContentModelRef::operator==(const ContentModelRef& b) const {
 	   && mData->mProperties.size() == b.mData->mProperties.size()
 	   && mData->mChildren.size() == b.mData->mChildren.size()
 	   ) {
-		if(!map_compare(mData->mProperties, b.mData->mProperties)) {
-			return false;
+		if(mData->mSchema == b.mData->mSchema) {
+			if(!map_compare(mData->mProperties, b.mData->mProperties)) {
+				return false;
+			}
+		} else {
+			// Same names in a different order
+			for(size_t slot = 0; slot < mData->mProperties.size(); ++slot) {
+				const size_t bSlot = b.mData->mSchema->getSlot(mData->mSchema->getName(slot));
+				if(bSlot == ContentSchema::NO_SLOT || !(mData->mProperties[slot] == b.mData->mProperties[bSlot])) {
+					return false;
+				}
+			}
 		}
 		if(!map_compare(mData->mChildren, b.mData->mChildren)) {
 			return false;
@@ -317,157 +473,292 @@ bool ContentModelRef::operator==(const ContentModelRef& b) const {
 	return false;
 }
 
-const std::map<std::string, ContentProperty>& ContentModelRef::getProperties() {
-	if(!mData) return EMPTY_PROPERTY_MAP;
-	return mData->mProperties;
+const std::map<std::string, ContentProperty> ContentModelRef::getProperties() const {
+	std::map<std::string, ContentProperty> props;
+	if(!mData) return props;
+	for(size_t slot = 0; slot < mData->mProperties.size(); ++slot) {
+		ContentProperty& prop = props[mData->mSchema->getName(slot)];
+		prop = mData->mProperties[slot];
+		prop.setName(mData->mSchema->getName(slot));
+	}
+	return props;
 }
 
 void ContentModelRef::setProperties(const std::map<std::string, ContentProperty>& newProperties) {
 	createData();
-	mData->mProperties = newProperties;
+	std::vector<std::string> names;
+	names.reserve(newProperties.size());
+	for(auto& it : newProperties) {
+		names.push_back(it.first);
+	}
+	mData->mSchema = ContentSchema::get(names);
+	mData->mProperties.clear();
+	mData->mProperties.reserve(newProperties.size());
+	for(auto& it : newProperties) {
+		mData->mProperties.push_back(it.second);
+		mData->mProperties.back().setName(EMPTY_STRING);
+	}
 }
 
-const ds::model::ContentProperty ContentModelRef::getProperty(const std::string& propertyName) {
-	if(!mData) return EMPTY_PROPERTY;
-	auto findy = mData->mProperties.find(propertyName);
-	if(findy != mData->mProperties.end()) {
-		return findy->second;
+void ContentModelRef::setPropertiesFrom(const ContentModelRef& other) {
+	createData();
+	if(!other.mData) {
+		mData->mSchema = ContentSchema::getEmpty();
+		mData->mProperties.clear();
+		return;
 	}
+	if(other.mData == mData) return;
+	mData->mSchema = other.mData->mSchema;
+	mData->mProperties = other.mData->mProperties;
+}
 
-	return EMPTY_PROPERTY;
+const std::shared_ptr<const ContentSchema>& ContentModelRef::getSchema() const {
+	if(!mData) return ContentSchema::getEmpty();
+	return mData->mSchema;
+}
+
+void ContentModelRef::setSchema(const std::shared_ptr<const ContentSchema>& schema) {
+	if(!schema) return;
+	createData();
+	if(mData->mSchema == schema) return;
+
+	std::shared_ptr<const ContentSchema> newSchema = schema;
+	for(size_t slot = 0; slot < mData->mProperties.size(); ++slot) {
+		newSchema = newSchema->with(mData->mSchema->getName(slot));
+	}
+
+	std::vector<ContentProperty> newProperties(newSchema->size());
+	for(size_t slot = 0; slot < mData->mProperties.size(); ++slot) {
+		newProperties[newSchema->getSlot(mData->mSchema->getName(slot))] = mData->mProperties[slot];
+	}
+	mData->mSchema = newSchema;
+	mData->mProperties.swap(newProperties);
+}
+
+bool ContentModelRef::hasSameProperties(const ContentModelRef& other) const {
+	const ContentSchema& schema = *getSchema();
+	const ContentSchema& otherSchema = *other.getSchema();
+	if(schema.size() != otherSchema.size()) return false;
+
+	const bool sameSchema = &schema == &otherSchema;
+	for(size_t slot = 0; slot < schema.size(); ++slot) {
+		const size_t otherSlot = sameSchema ? slot : otherSchema.getSlot(schema.getName(slot));
+		if(otherSlot == ContentSchema::NO_SLOT) return false;
+
+		const ContentProperty& a = mData->mProperties[slot];
+		const ContentProperty& b = other.mData->mProperties[otherSlot];
+		if(a.getValue() != b.getValue() || !(a.getResource() == b.getResource())) return false;
+	}
+	return true;
+}
+
+const ds::model::ContentProperty ContentModelRef::getProperty(const std::string& propertyName) {
+	const ContentProperty* prop = findProperty(propertyName);
+	if(!prop) return EMPTY_PROPERTY;
+
+	ContentProperty named = *prop;
+	named.setName(propertyName);
+	return named;
 }
 
 const std::string ContentModelRef::getPropertyValue(const std::string& propertyName) {
-	return getProperty(propertyName).getValue();
+	const ContentProperty* prop = findProperty(propertyName);
+	return prop ? prop->getValue() : EMPTY_STRING;
 }
 
 bool ContentModelRef::getPropertyBool(const std::string& propertyName) {
-	return getProperty(propertyName).getBool();
+	const ContentProperty* prop = findProperty(propertyName);
+	return prop ? prop->getBool() : EMPTY_PROPERTY.getBool();
 }
 
 int ContentModelRef::getPropertyInt(const std::string& propertyName) {
-	return getProperty(propertyName).getInt();
+	const ContentProperty* prop = findProperty(propertyName);
+	return prop ? prop->getInt() : EMPTY_PROPERTY.getInt();
 }
 
 float ContentModelRef::getPropertyFloat(const std::string& propertyName) {
-	return getProperty(propertyName).getFloat();
+	const ContentProperty* prop = findProperty(propertyName);
+	return prop ? prop->getFloat() : EMPTY_PROPERTY.getFloat();
 }
 
 double ContentModelRef::getPropertyDouble(const std::string& propertyName) {
-	return getProperty(propertyName).getDouble();
+	const ContentProperty* prop = findProperty(propertyName);
+	return prop ? prop->getDouble() : EMPTY_PROPERTY.getDouble();
 }
 
 const ci::Color ContentModelRef::getPropertyColor(ds::ui::SpriteEngine& eng, const std::string& propertyName) {
-	return getProperty(propertyName).getColor(eng);
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getColor(eng);
 }
 
 const ci::ColorA ContentModelRef::getPropertyColorA(ds::ui::SpriteEngine& eng, const std::string& propertyName) {
-	return getProperty(propertyName).getColorA(eng);
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getColorA(eng);
 }
 
 const std::string ContentModelRef::getPropertyString(const std::string& propertyName) {
-	return getProperty(propertyName).getString();
+	return getPropertyValue(propertyName);
 }
 
 const std::wstring ContentModelRef::getPropertyWString(const std::string& propertyName) {
-	return getProperty(propertyName).getWString();
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getWString();
 }
 
 const ci::vec2 ContentModelRef::getPropertyVec2(const std::string& propertyName) {
-	return getProperty(propertyName).getVec2();
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getVec2();
 }
 
 const ci::vec3 ContentModelRef::getPropertyVec3(const std::string& propertyName) {
-	return getProperty(propertyName).getVec3();
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getVec3();
 }
 
 const ci::Rectf ContentModelRef::getPropertyRect(const std::string& propertyName) {
-	return getProperty(propertyName).getRect();
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getRect();
 }
 
 ds::Resource ContentModelRef::getPropertyResource(const std::string& propertyName) {
-	return getProperty(propertyName).getResource();
+	const ContentProperty* prop = findProperty(propertyName);
+	return (prop ? *prop : EMPTY_PROPERTY).getResource();
 }
 
-void ContentModelRef::setProperty(const std::string& propertyName, ContentProperty& datamodel) {
-	createData();
+bool ContentModelRef::hasProperty(const ContentPropertyHandle& handle) const {
+	return findProperty(handle) != nullptr;
+}
+
+const ContentProperty ContentModelRef::getProperty(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	if(!prop) return EMPTY_PROPERTY;
 
-	mData->mProperties[propertyName] = datamodel;
+	ContentProperty named = *prop;
+	named.setName(handle.getName());
+	return named;
 }
 
-void ContentModelRef::setProperty(const std::string& propertyName, const std::string& propertyValue) {
+const std::string& ContentModelRef::getPropertyValue(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return prop ? prop->getValue() : EMPTY_STRING;
+}
+
+bool ContentModelRef::getPropertyBool(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return prop ? prop->getBool() : EMPTY_PROPERTY.getBool();
+}
+
+int ContentModelRef::getPropertyInt(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return prop ? prop->getInt() : EMPTY_PROPERTY.getInt();
+}
+
+float ContentModelRef::getPropertyFloat(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return prop ? prop->getFloat() : EMPTY_PROPERTY.getFloat();
+}
+
+double ContentModelRef::getPropertyDouble(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return prop ? prop->getDouble() : EMPTY_PROPERTY.getDouble();
+}
+
+const std::string& ContentModelRef::getPropertyString(const ContentPropertyHandle& handle) const {
+	return getPropertyValue(handle);
+}
+
+const std::wstring ContentModelRef::getPropertyWString(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return (prop ? *prop : EMPTY_PROPERTY).getWString();
+}
+
+ds::Resource ContentModelRef::getPropertyResource(const ContentPropertyHandle& handle) const {
+	const ContentProperty* prop = findProperty(handle);
+	return (prop ? *prop : EMPTY_PROPERTY).getResource();
+}
+
+void ContentModelRef::setProperty(const std::string& propertyName, const ContentProperty& datamodel) {
 	createData();
-	mData->mProperties[propertyName] = ContentProperty(propertyName, propertyValue);
+	ContentProperty& prop = mData->mProperties[addSlot(propertyName)];
+	prop = datamodel;
+	prop.setName(EMPTY_STRING);
+}
+
+void ContentModelRef::setProperty(const std::string& propertyName, const std::string& propertyValue) {
+	setProperty(propertyName, ContentProperty(EMPTY_STRING, propertyValue));
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const std::wstring& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const int& value) {
-	ContentProperty dp(propertyName, std::to_string(value), value, (double)value);
+	ContentProperty dp(EMPTY_STRING, std::to_string(value), value, (double)value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const double& value) {
-	ContentProperty dp(propertyName, std::to_string(value), (int)round(value), value);
+	ContentProperty dp(EMPTY_STRING, std::to_string(value), (int)round(value), value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const float& value) {
-	ContentProperty dp(propertyName, std::to_string(value), (int)round(value), (double)value);
+	ContentProperty dp(EMPTY_STRING, std::to_string(value), (int)round(value), (double)value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const ci::Color& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const ci::ColorA& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const ci::vec2& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const ci::vec3& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setProperty(const std::string& propertyName, const ci::Rectf& value) {
 	ContentProperty dp;
-	dp.setName(propertyName);
 	dp.setValue(value);
 	setProperty(propertyName, dp);
 }
 
 void ContentModelRef::setPropertyResource(const std::string& propertyName, const ds::Resource& resource) {
 	createData();
-	auto findy = mData->mProperties.find(propertyName);
-	if(findy != mData->mProperties.end()) {
-		findy->second.setResource(resource);
-	} else {
-		ContentProperty dp;
-		dp.setName(propertyName);
-		dp.setResource(resource);
-		setProperty(propertyName, dp);
-	}
+	mData->mProperties[addSlot(propertyName)].setResource(resource);
+}
+
+void ContentModelRef::setProperty(const ContentPropertyHandle& handle, const ContentProperty& theProp) {
+	createData();
+	size_t slot = handle.getSlot(*mData->mSchema);
+	if(slot == ContentSchema::NO_SLOT) slot = addSlot(handle.getName());
+
+	ContentProperty& prop = mData->mProperties[slot];
+	prop = theProp;
+	prop.setName(EMPTY_STRING);
+}
+
+void ContentModelRef::setPropertyResource(const ContentPropertyHandle& handle, const ds::Resource& resource) {
+	createData();
+	size_t slot = handle.getSlot(*mData->mSchema);
+	if(slot == ContentSchema::NO_SLOT) slot = addSlot(handle.getName());
+	mData->mProperties[slot].setResource(resource);
 }
 
 const std::vector<ContentModelRef>& ContentModelRef::getChildren() const {
@@ -608,7 +899,7 @@ void ContentModelRef::printTree(const bool verbose, const std::string& indent) {
 		DS_LOG_INFO(indent << "ContentModel id:" << mData->mId << " name:" << mData->mName << " label:" << mData->mLabel);
 		if(verbose) {
 
-			for(auto it : mData->mProperties) {
+			for(auto it : getProperties()) {
 				if(!it.second.getResource().empty()) {
 					DS_LOG_INFO(indent << "          resource:" << it.second.getResource().getAbsoluteFilePath());
 				} else {
@@ -633,5 +924,34 @@ void ContentModelRef::createData() {
 	if(!mData) mData.reset(new Data());
 }
 
+size_t ContentModelRef::addSlot(const std::string& name) {
+	createData();
+	const size_t slot = mData->mSchema->getSlot(name);
+	if(slot != ContentSchema::NO_SLOT) return slot;
+
+	// A big schema only this model holds can grow in place, instead of being copied for every name
+	if(!mData->mSchema->mInterned && mData->mSchema.use_count() == 1) {
+		const_cast<ContentSchema&>(*mData->mSchema).append(name);
+	} else {
+		mData->mSchema = mData->mSchema->with(name);
+	}
+	mData->mProperties.resize(mData->mSchema->size());
+	return mData->mSchema->getSlot(name);
+}
+
+const ContentProperty* ContentModelRef::findProperty(const std::string& name) const {
+	if(!mData) return nullptr;
+	const size_t slot = mData->mSchema->getSlot(name);
+	if(slot >= mData->mProperties.size()) return nullptr;
+	return &mData->mProperties[slot];
+}
+
+const ContentProperty* ContentModelRef::findProperty(const ContentPropertyHandle& handle) const {
+	if(!mData) return nullptr;
+	const size_t slot = handle.getSlot(*mData->mSchema);
+	if(slot >= mData->mProperties.size()) return nullptr;
+	return &mData->mProperties[slot];
+}
+
 } // namespace model
 } // namespace ds
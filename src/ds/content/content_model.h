@@ -6,8 +6,14 @@
 #include <cinder/Rect.h>
 #include <cinder/Vector.h>
 #include <ds/data/resource.h>
+#include <ds/debug/memory_accounting.h>
+#include <Poco/Mutex.h>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -80,6 +86,88 @@ class ContentProperty {
 };
 
 
+/**
+ * \class ContentSchema
+ * \brief The property names of a ContentModelRef, each with a slot. A node keeps its values
+ *		 in a flat vector by slot, so the names aren't repeated on every node.
+ *		 Schemas never change once they're made, and they're interned: the same names, in the
+ *		 same order, give back the same schema for as long as anything holds it. So every row
+ *		 from a table shares one. The stats view counts them under "Content schemas".
+ */
+class ContentSchema : public std::enable_shared_from_this<ContentSchema> {
+  public:
+	static const size_t NO_SLOT = static_cast<size_t>(-1);
+	/// Past this many names, schemas aren't interned, and a node with its own schema grows it in place
+	static const size_t MAX_INTERNED = 128;
+
+	/// The schema with no names, where every node starts
+	static const std::shared_ptr<const ContentSchema>& getEmpty();
+	/// The schema with these names in this order. Repeated names are only added once
+	static std::shared_ptr<const ContentSchema> get(const std::vector<std::string>& names);
+
+	/// This schema with one more name on the end, or this one if it already has it
+	std::shared_ptr<const ContentSchema> with(const std::string& name) const;
+
+	/// The slot for this name, or NO_SLOT
+	size_t			   getSlot(const std::string& name) const;
+	const std::string& getName(const size_t slot) const;
+	size_t			   size() const { return mNames.size(); }
+
+	/// Unique to this schema for the life of the app, so it can be cached in place of a pointer
+	uint32_t getId() const { return mId; }
+
+	~ContentSchema();
+
+  private:
+	friend class ContentModelRef;
+	ContentSchema();
+	ContentSchema(const ContentSchema&);
+	ContentSchema& operator=(const ContentSchema&);
+
+	/// A copy that isn't interned, for a node to grow on its own
+	std::shared_ptr<ContentSchema> makePrivate() const;
+	/// Only for schemas that aren't interned and only one node holds. Gets a new id
+	void append(const std::string& name);
+
+	std::vector<std::string>				mNames;
+	std::unordered_map<std::string, size_t> mSlots;
+	uint32_t								mId;
+	bool									mInterned;
+	/// The schema this one was made from by with(). Held so it stays interned while this one's in use
+	std::shared_ptr<const ContentSchema>	mParent;
+	/// The schemas made by with(), so every node that adds the same name ends up with the same one.
+	/// Weak, so they go away with the last node using them, and take their entry with them.
+	mutable Poco::FastMutex					mMutex;
+	mutable std::unordered_map<std::string, std::weak_ptr<const ContentSchema>> mExtensions;
+	ds::MemoryTracked						mMemory;
+};
+
+
+/**
+ * \class ContentPropertyHandle
+ * \brief A property name that remembers its slot in the last schema it was looked up in.
+ *		 Make one up front (a static or a member) and look properties up with it in hot code:
+ *		 rows from the same table share a schema, so after the first row there's no string
+ *		 hashing at all.
+ */
+class ContentPropertyHandle {
+  public:
+	explicit ContentPropertyHandle(const std::string& name);
+	ContentPropertyHandle(const ContentPropertyHandle&);
+	ContentPropertyHandle& operator=(const ContentPropertyHandle&);
+
+	const std::string& getName() const { return mName; }
+
+	/// The slot for this name in this schema, or ContentSchema::NO_SLOT
+	size_t getSlot(const ContentSchema&) const;
+
+  private:
+	std::string mName;
+	/// The id of the last schema looked up in the high 32 bits, the slot in the low
+	mutable std::atomic<uint64_t> mCache;
+};
+
+
 /**
  * \class ContentModelRef
  * \brief A nodal hierarchy-based generic content model
@@ -136,8 +224,20 @@ class ContentModelRef {
 
 
 	/// Use this for looking stuff up only. Recommend using the other functions to manage the list
-	const std::map<std::string, ContentProperty>& getProperties();
-	void										  setProperties(const std::map<std::string, ContentProperty>& newProperties);
+	/// The properties are kept by slot (see getSchema()), so this map is built when it's called
+	const std::map<std::string, ContentProperty> getProperties() const;
+	void										 setProperties(const std::map<std::string, ContentProperty>& newProperties);
+	/// Replaces the properties with a copy of another model's, sharing its schema
+	void setPropertiesFrom(const ContentModelRef& other);
+
+	/// The names of the properties, in the order they were added. Rows from the same table share one
+	const std::shared_ptr<const ContentSchema>& getSchema() const;
+	/// Gives this model every name in the schema up front, as empty properties, so rows can be filled in by
+	/// handle without the schema growing a name at a time. Properties this model already has are kept.
+	void setSchema(const std::shared_ptr<const ContentSchema>& schema);
+
+	/// Same names and values. Unlike operator==, resources are compared by value instead of by pointer.
+	bool hasSameProperties(const ContentModelRef& other) const;
 
 	/// This can return an empty property, which is why it's const.
 	/// If you want to modify a property, use the setProperty() function
@@ -157,8 +257,22 @@ class ContentModelRef {
 	const ci::Rectf		  getPropertyRect(const std::string& propertyName);
 	ds::Resource	      getPropertyResource(const std::string& propertyName);
 
-	/// Set the property with a given name
-	void setProperty(const std::string& propertyName, ContentProperty& theProp);
+	/// The same lookups by handle, for hot code. Rows from one table share a schema, so these skip the
+	/// string lookup after the first row. The references are only good until this model's properties
+	/// change: setting any property by a name it doesn't have yet, or replacing them all, moves every value.
+	bool				  hasProperty(const ContentPropertyHandle& handle) const;
+	const ContentProperty getProperty(const ContentPropertyHandle& handle) const;
+	const std::string&	  getPropertyValue(const ContentPropertyHandle& handle) const;
+	bool				  getPropertyBool(const ContentPropertyHandle& handle) const;
+	int					  getPropertyInt(const ContentPropertyHandle& handle) const;
+	float				  getPropertyFloat(const ContentPropertyHandle& handle) const;
+	double				  getPropertyDouble(const ContentPropertyHandle& handle) const;
+	const std::string&	  getPropertyString(const ContentPropertyHandle& handle) const;
+	const std::wstring	  getPropertyWString(const ContentPropertyHandle& handle) const;
+	ds::Resource		  getPropertyResource(const ContentPropertyHandle& handle) const;
+
+	/// Set the property with a given name. The name stored is the one given here, not the property's own
+	void setProperty(const std::string& propertyName, const ContentProperty& theProp);
 	void setProperty(const std::string& propertyName, const std::string& value);
 	void setProperty(const std::string& propertyName, const std::wstring& value);
 	void setProperty(const std::string& propertyName, const int& value);
@@ -170,6 +284,8 @@ class ContentModelRef {
 	void setProperty(const std::string& propertyName, const ci::vec3& value);
 	void setProperty(const std::string& propertyName, const ci::Rectf& value);
 	void setPropertyResource(const std::string& propertyName, const ds::Resource& resource);
+	void setProperty(const ContentPropertyHandle& handle, const ContentProperty& theProp);
+	void setPropertyResource(const ContentPropertyHandle& handle, const ds::Resource& resource);
 
 	/// Gets all of the children
 	/// Don't modify the children here, use the other functions
@@ -224,6 +340,11 @@ class ContentModelRef {
 
   private:
 	void createData();
+	/// The slot for this name, adding it to the schema if it's new
+	size_t addSlot(const std::string& name);
+	/// Null if there's no such property
+	const ContentProperty* findProperty(const std::string& name) const;
+	const ContentProperty* findProperty(const ContentPropertyHandle& handle) const;
 	class Data;
 	std::shared_ptr<Data> mData;
 };
@@ -4,9 +4,13 @@
 
 #include <ds/debug/logger.h>
 #include <ds/query/query_client.h>
+#include <ds/query/sql_connection_pool.h>
 #include <ds/util/file_meta_data.h>
+#include <cstring>
 #include <map>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include <ds/app/environment.h>
 
@@ -15,6 +19,20 @@
 
 namespace ds {
 
+namespace {
+template <typename K>
+using JoinIndex = std::unordered_map<K, std::vector<ds::model::ContentModelRef>>;
+
+/// Add row to every parent with this key, answering how many that was
+template <typename K>
+size_t linkRow(const JoinIndex<K>& index, const K& key, ds::model::ContentModelRef& row) {
+	auto found = index.find(key);
+	if (found == index.end()) return 0;
+	for (auto parChild : found->second) parChild.addChild(row);
+	return found->second.size();
+}
+}
+
 ContentQuery::ContentQuery()
   : mTableId(0)
   , mCheckUpdatedResources(true) {}
@@ -24,13 +42,20 @@ void ContentQuery::run() {
 	mData.setProperty("cms_database", mCmsDatabase);
 	mData.setProperty("model_xml", mXmlDataModel);
 	mTableId = 0;
+	mTables = ds::model::ContentModelRef("tables");
+	mRowOrder.clear();
+	mUpdatedResources.clear();
 
 	Poco::Timestamp::TimeVal before = Poco::Timestamp().epochMicroseconds();
 
 	auto metaData = readXml();
 
-	mLastUpdatedResource.clear();
-	mAllResources.clear();
+	// Incremental runs pick up where the last one left off
+	if (!mIncremental) {
+		mLastUpdatedResource.clear();
+		mAllResources.clear();
+		mSyncStamps.clear();
+	}
 
 	auto metaNode = metaData.getChildByName("meta");
 	if (!metaNode.empty()){
@@ -90,6 +115,8 @@ void ContentQuery::run() {
 	if (ds::getLogger().hasVerboseLevel(4)) metaData.printTree(true, "");
 
 	if (metaData.empty()) {
+		// Nothing to sync against
+		mIncremental = false;
 		getDataFromTable(mData, "sqlite_master");
 		// auto table = mData.getChild("tables");
 		auto tables = mData.getChildren();
@@ -100,11 +127,11 @@ void ContentQuery::run() {
 	} else {
 
 		/// First we get all the tables independently in a list
-		auto tablesData = ds::model::ContentModelRef("tables");
-		getDataFromTable(tablesData, metaData, mCmsDatabase, mAllResources, 0, mTableId);
+		getDataFromTable(mTables, metaData, mCmsDatabase, mAllResources, 0, mTableId);
 
-		/// then we link all the tables together based on depth and parent id's
-		assembleModels(tablesData);
+		/// then we link all the tables together based on depth and parent id's.
+		/// Incremental runs only have the changed rows, so ContentWrangler links once they're patched in.
+		if (!mIncremental) assembleModels(mTables);
 	}
 
 	Poco::Timestamp::TimeVal after = Poco::Timestamp().epochMicroseconds();
@@ -112,7 +139,12 @@ void ContentQuery::run() {
 	DS_LOG_VERBOSE(1, "Finished data query in " << (float)(after - before) / 1000000.0f << " seconds.");
 }
 
-void ContentQuery::assembleModels(ds::model::ContentModelRef tablesParent) {
+size_t ContentQuery::linkTables(ds::model::ContentModelRef tablesParent) {
+	/// Parent rows by join column, built the first time a table links to them. Int keys for
+	/// the id modes, so they compare as numbers like getPropertyInt() does.
+	std::unordered_map<std::string, JoinIndex<int>>			intIndexes;
+	std::unordered_map<std::string, JoinIndex<std::string>> stringIndexes;
+	size_t													linkedRows = 0;
 
 	/// find the highest depth
 	int maxDepth = 0;
@@ -130,7 +162,7 @@ void ContentQuery::assembleModels(ds::model::ContentModelRef tablesParent) {
 				// find the parent model for this table
 				ds::model::ContentModelRef parentModel = tablesParent.getChildById(it.getPropertyInt("parent_id"));
 				if (parentModel.empty()) {
-					DS_LOG_WARNING("ContentQuery::assembleModels() no parent table found! this will leave the table "
+					DS_LOG_WARNING("ContentQuery::linkTables() no parent table found! this will leave the table "
 								   << it.getName() << " orphaned!");
 					continue;
 				}
@@ -139,48 +171,71 @@ void ContentQuery::assembleModels(ds::model::ContentModelRef tablesParent) {
 				auto parentForeignId = it.getPropertyString("parent_foreign_id");
 				auto childLocalMap   = it.getPropertyString("child_local_map");
 
-				std::function<bool(ds::model::ContentModelRef&, ds::model::ContentModelRef&)> isMatchFn;
-
+				// Index the parent rows by the join column once, then each row looks up its parents
+				// directly. Parents are kept in order, so each one gets its children in row order.
+				const std::string parentKey = std::to_string(parentModel.getId()) + ":";
 				if (!childLocalId.empty()) {
-					isMatchFn = [childLocalId](ds::model::ContentModelRef& parChild, ds::model::ContentModelRef& row) {
-						return parChild.getId() == row.getPropertyInt(childLocalId);
-					};
+					auto& index = intIndexes[parentKey];
+					if (index.empty()) {
+						for (auto parChild : parentModel.getChildren()) index[parChild.getId()].push_back(parChild);
+					}
+					for (auto row : it.getChildren()) {
+						linkedRows += linkRow(index, row.getPropertyInt(childLocalId), row);
+					}
 				} else if (!parentForeignId.empty()) {
-					isMatchFn = [parentForeignId](ds::model::ContentModelRef& parChild,
-												   ds::model::ContentModelRef& row) {
-						return parChild.getPropertyInt(parentForeignId) == row.getId();
-					};
+					auto& index = intIndexes[parentKey + parentForeignId];
+					if (index.empty()) {
+						for (auto parChild : parentModel.getChildren()) {
+							index[parChild.getPropertyInt(parentForeignId)].push_back(parChild);
+						}
+					}
+					for (auto row : it.getChildren()) {
+						linkedRows += linkRow(index, row.getId(), row);
+					}
 				} else if (!childLocalMap.empty()) {
 					auto mapChildTo = ds::split(childLocalMap, ":", true);
 					if (mapChildTo.size() == 2) {
-						isMatchFn = [mapChildTo](ds::model::ContentModelRef& parChild,
-												  ds::model::ContentModelRef& row) {
-							return parChild.getPropertyString(mapChildTo[1]) == row.getPropertyString(mapChildTo[0]);
-						};
+						auto& index = stringIndexes[parentKey + mapChildTo[1]];
+						if (index.empty()) {
+							for (auto parChild : parentModel.getChildren()) {
+								index[parChild.getPropertyString(mapChildTo[1])].push_back(parChild);
+							}
+						}
+						for (auto row : it.getChildren()) {
+							linkedRows += linkRow(index, row.getPropertyString(mapChildTo[0]), row);
+						}
 					} else {
-						DS_LOG_WARNING("ContentQuery::assembleModels() child_local_map parameter invalid.");
+						DS_LOG_WARNING("ContentQuery::linkTables() child_local_map parameter invalid.");
 						// Nothing to do here!
 						continue;
 					}
+				} else {
+					DS_LOG_WARNING("ContentQuery::linkTables() no child_local_id, parent_foreign_id or child_local_map for the table "
+								   << it.getName() << ", so it won't be linked to its parent.");
+					continue;
 				}
-
-				for (auto row : it.getChildren()) {
-					for (auto parChild : parentModel.getChildren()) {
-						if (isMatchFn(parChild, row)) {
-							parChild.addChild(row);
-						}
-					}
-				} // End of this table's rows
 			} // End of this depth check
 		} // End of tables in this for loop
 	} // End of depth for loop
 
+	return linkedRows;
+}
+
+void ContentQuery::assembleModels(ds::model::ContentModelRef tablesParent) {
+	Poco::Timestamp::TimeVal before = Poco::Timestamp().epochMicroseconds();
+
+	const size_t linkedRows = linkTables(tablesParent);
+
 	/// assign top level to the final output
 	for (auto it : tablesParent.getChildren()) {
 		if (it.getPropertyInt("depth") == 1) {
 			mData.addChild(it);
 		}
 	}
+
+	Poco::Timestamp::TimeVal after = Poco::Timestamp().epochMicroseconds();
+	DS_LOG_VERBOSE(1, "ContentQuery: assembled models, " << linkedRows << " rows linked in "
+														 << (float)(after - before) / 1000000.0f << " seconds.");
 }
 
 ds::model::ContentModelRef ContentQuery::readXml() {
@@ -240,6 +295,20 @@ std::string getSqliteString(sqlite3_stmt* statement, const int columnIndex) {
 	return theData;
 }
 
+/// Positive if this column is newer than a stamp saved from it earlier. Numbers compare as numbers, anything else as text.
+int compareSqliteStamp(sqlite3_stmt* statement, const int columnIndex, const std::string& stamp) {
+	const int type = sqlite3_column_type(statement, columnIndex);
+	if (type == SQLITE_NULL) return stamp.empty() ? 0 : -1;
+	if (stamp.empty()) return 1;
+	if (type == SQLITE_INTEGER || type == SQLITE_FLOAT) {
+		const double value = sqlite3_column_double(statement, columnIndex);
+		const double last  = ds::string_to_double(stamp);
+		return value > last ? 1 : (value < last ? -1 : 0);
+	}
+	auto theText = sqlite3_column_text(statement, columnIndex);
+	return std::strcmp(reinterpret_cast<const char*>(theText), stamp.c_str());
+}
+
 /// TODO: rewrite to use raw sqlite calls or use column names for better portability
 /// TODO: Improve speed
 void ContentQuery::updateResourceCache() {
@@ -274,20 +343,15 @@ void ContentQuery::updateResourceCache() {
 	}
 
 	/// Lets do the query!
-	sqlite3* db = NULL;
-	// open the database
-	const int sqliteResultCode =
-		sqlite3_open_v2(ds::getNormalizedPath(mCmsDatabase).c_str(), &db, SQLITE_OPEN_READONLY, 0);
+	int	sqliteResultCode = SQLITE_OK;
+	// open the database, or reuse this thread's connection to it
+	auto db = ds::query::SqlConnectionPool::get().getDatabase(mCmsDatabase, SQLITE_OPEN_READONLY, &sqliteResultCode);
 
 	/// if everything went ok
-	if (sqliteResultCode == SQLITE_OK) {
-		sqlite3_busy_timeout(db, 1500);
-		sqlite3_stmt* statement;
-		const int	 err = sqlite3_prepare_v2(db, resQuery.c_str(), -1, &statement, 0);
-		if (err != SQLITE_OK) {
-			sqlite3_finalize(statement);
-			DS_LOG_ERROR("ContentQuery::updateResourceQuery::rawSelect SQL error code="
-					<< err << " message=" << sqlite3_errstr(err) << " on select=" << resQuery << std::endl);
+	if (db) {
+		sqlite3_stmt* statement = db->acquire(resQuery);
+		if (!statement) {
+			DS_LOG_ERROR("ContentQuery::updateResourceQuery couldn't prepare select=" << resQuery << std::endl);
 
 		} else {
 
@@ -301,7 +365,7 @@ void ContentQuery::updateResourceCache() {
 					int			thisId  = sqlite3_column_int(statement, 0);
 					std::string thePath = getSqliteString(statement, 6);
 
-					mAllResources[thisId] = ds::Resource(thisId,  // db id
+					ds::Resource reccy(thisId,  // db id
 							ds::Resource::makeTypeFromString(getSqliteString(
 									statement, 1)),  // type (image, video, pdf) as int
 							sqlite3_column_double(statement, 2),		  // duration
@@ -313,7 +377,6 @@ void ContentQuery::updateResourceCache() {
 							""  // full filepath (set in a second)
 							);
 
-					auto& reccy = mAllResources[thisId];
 					if (reccy.getType() == ds::Resource::WEB_TYPE) {
 						auto webPath = reccy.getFileName();
 						// detect if this is a local path
@@ -332,12 +395,19 @@ void ContentQuery::updateResourceCache() {
 						reccy.setLocalFilePath(ret, false);
 					}
 
+					// Incremental runs start with the last run's resources, so rows using these get refreshed
+					auto existing = mAllResources.find(thisId);
+					if (existing == mAllResources.end() || existing->second != reccy) {
+						mUpdatedResources.push_back(thisId);
+					}
+					mAllResources[thisId] = reccy;
+
 					if(mCheckUpdatedResources){
 						mLastUpdatedResource = getSqliteString(statement, 8);
 					}
 
 				} else {
-					sqlite3_finalize(statement);
+					db->release(statement);
 					break;
 				}
 			}
@@ -385,8 +455,9 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, ds::
 		std::string primaryId   = tableDescription.getPropertyString("id");
 		std::string theName		= tableDescription.getPropertyString("name_field");
 		std::string theLabel	= tableDescription.getPropertyString("label_field");
+		std::string updatedField = tableDescription.getPropertyString("updated_field");
 
-		tableModel.setProperties(tableDescription.getProperties());
+		tableModel.setPropertiesFrom(tableDescription);
 		tableModel.setProperty("depth", depth);
 		tableModel.setProperty("parent_id", parentModelId);
 		tableModel.setId(thisId);
@@ -432,30 +503,42 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, ds::
 		auto resourceColumns = ds::split(reccys, ", ", true);
 
 		/// Lets do the query!
-		sqlite3* db = NULL;
-		// open the database
-		const int sqliteResultCode =
-			sqlite3_open_v2(ds::getNormalizedPath(dbPath).c_str(), &db, SQLITE_OPEN_READONLY, 0);
+		int	sqliteResultCode = SQLITE_OK;
+		// open the database, or reuse this thread's connection to it
+		auto db = ds::query::SqlConnectionPool::get().getDatabase(dbPath, SQLITE_OPEN_READONLY, &sqliteResultCode);
 
 		/// if everything went ok
-		if (sqliteResultCode == SQLITE_OK) {
-			sqlite3_busy_timeout(db, 1500);
-
+		if (db) {
 			DS_LOG_VERBOSE(4, "Executing SQL query " << theQuery.str());
 
-			sqlite3_stmt* statement;
-			const int	 err = sqlite3_prepare_v2(db, theQuery.str().c_str(), -1, &statement, 0);
-			if (err != SQLITE_OK) {
-				sqlite3_finalize(statement);
-				DS_LOG_ERROR("ContentQuery::rawSelect SQL error code=" << err << " message=" << sqlite3_errstr(err)
-																	   << " on select=" << theQuery.str().c_str()
-																	   << std::endl);
+			sqlite3_stmt* statement = db->acquire(theQuery.str());
+			if (!statement) {
+				DS_LOG_ERROR("ContentQuery::rawSelect couldn't prepare select=" << theQuery.str() << std::endl);
 
 			} else {
 
 				/// in case there's no id field specified or a primary key column
 				int id = 1;
 
+				/// Incremental runs skip building rows that haven't been updated since the last run's stamp,
+				/// as long as they can be told apart by id
+				auto		stampIt		  = mSyncStamps.find(thisId);
+				const bool	hasStamp	  = mIncremental && stampIt != mSyncStamps.end();
+				std::string lastStamp	  = hasStamp ? stampIt->second : "";
+				std::string newestStamp   = lastStamp;
+				int			idColumn	  = -1;
+				int			updatedColumn = -1;
+				auto&		rowOrder	  = mRowOrder[thisId];
+
+				bool parsedMetadata = false;
+
+				/// Every row from this table gets the same schema, so the cells are set by handle
+				std::shared_ptr<const ds::model::ContentSchema> rowSchema;
+				std::vector<ds::model::ContentPropertyHandle>	columnHandles;
+				std::vector<bool>								resourceColumn;
+				int												nameColumn  = -1;
+				int												labelColumn = -1;
+
 				/// go through all the rows
 				while (true) {
 
@@ -463,48 +546,81 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, ds::
 					auto statementResult = sqlite3_step(statement);
 					if (statementResult == SQLITE_ROW) {
 
-						bool parsedMetadata = false;
+						auto columnCount = sqlite3_data_count(statement);
+
+						// only parse metada for the first row
+						if (!parsedMetadata) {
+							for (int i = 0; i < columnCount; i++) {
+								auto columnName = sqlite3_column_name(statement, i);
+
+								/// If we don't have a primary id set already, look up the metadata for this column and see
+								/// if it's the primary key
+								if (primaryId.empty()) {
+									const char* dataType	 = NULL;
+									const char* collSequence = NULL;
+									int			notNull		 = 0;
+									int			primaryKey   = 0;
+									int			autoInc		 = 0;
+									int			resulty =
+										sqlite3_table_column_metadata(db->getHandle(), NULL, theTable.c_str(), columnName, &dataType,
+																	  &collSequence, &notNull, &primaryKey, &autoInc);
+
+									if (primaryKey) {
+										primaryId = columnName;
+									}
+
+									if (ds::getLogger().hasVerboseLevel(3)) {
+										if (dataType) {
+											DS_LOG_VERBOSE(3, " Column "
+																  << columnName << " type:" << dataType
+																  << " col seq:" << collSequence << " not null:" << notNull
+																  << " prim key:" << primaryKey << " autoinc:" << autoInc);
+										} else {
+											DS_LOG_VERBOSE(3, " Column "
+																  << columnName << " type:NULL col seq:" << collSequence
+																  << " not null:" << notNull << " prim key:" << primaryKey
+																  << " autoinc:" << autoInc);
+										}
+									}
+								}
+							}
+
+							std::vector<std::string> columnNames;
+							for (int i = 0; i < columnCount; i++) {
+								std::string columnName = sqlite3_column_name(statement, i);
+								if (columnName == primaryId) idColumn = i;
+								if (!updatedField.empty() && columnName == updatedField) updatedColumn = i;
+								if (!theName.empty() && columnName == theName) nameColumn = i;
+								if (!theLabel.empty() && columnName == theLabel) labelColumn = i;
+								columnHandles.emplace_back(columnName);
+								resourceColumn.push_back(std::find(resourceColumns.begin(), resourceColumns.end(), columnName) !=
+														 resourceColumns.end());
+								columnNames.push_back(columnName);
+							}
+							rowSchema	   = ds::model::ContentSchema::get(columnNames);
+							parsedMetadata = true;
+						}
+
+						if (updatedColumn >= 0) {
+							if (compareSqliteStamp(statement, updatedColumn, newestStamp) > 0) {
+								newestStamp = getSqliteString(statement, updatedColumn);
+							}
+							/// Rows stamped the same as the last run are built again, since they could have been
+							/// edited within the same stamp; the wrangler drops them if nothing changed
+							if (hasStamp && idColumn >= 0 && compareSqliteStamp(statement, updatedColumn, lastStamp) < 0) {
+								rowOrder.push_back(sqlite3_column_int(statement, idColumn));
+								id++;
+								continue;
+							}
+						}
 
-						auto					   columnCount = sqlite3_data_count(statement);
 						ds::model::ContentModelRef thisRow =
 							ds::model::ContentModelRef(theTableAlias, id, theTable + " row");
+						thisRow.setSchema(rowSchema);
 						id++;
 
 						for (int i = 0; i < columnCount; i++) {
 
-							auto columnName = sqlite3_column_name(statement, i);
-
-							/// If we don't have a primary id set already, look up the metadata for this column and see
-							/// if it's the primary key
-							if (primaryId.empty() && !parsedMetadata) {
-								const char* dataType	 = NULL;
-								const char* collSequence = NULL;
-								int			notNull		 = 0;
-								int			primaryKey   = 0;
-								int			autoInc		 = 0;
-								int			resulty =
-									sqlite3_table_column_metadata(db, NULL, theTable.c_str(), columnName, &dataType,
-																  &collSequence, &notNull, &primaryKey, &autoInc);
-
-								if (primaryKey) {
-									primaryId = columnName;
-								}
-
-								if (ds::getLogger().hasVerboseLevel(3)) {
-									if (dataType) {
-										DS_LOG_VERBOSE(3, " Column "
-															  << columnName << " type:" << dataType
-															  << " col seq:" << collSequence << " not null:" << notNull
-															  << " prim key:" << primaryKey << " autoinc:" << autoInc);
-									} else {
-										DS_LOG_VERBOSE(3, " Column "
-															  << columnName << " type:NULL col seq:" << collSequence
-															  << " not null:" << notNull << " prim key:" << primaryKey
-															  << " autoinc:" << autoInc);
-									}
-								}
-							}
-
 							auto theText = sqlite3_column_text(statement, i);
 
 							auto theInt  = sqlite3_column_int(statement, i);
@@ -515,37 +631,35 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, ds::
 								theData = reinterpret_cast<const char*>(theText);
 							}
 
-							if (columnName == primaryId) {
+							if (i == idColumn) {
 								thisRow.setId(theInt);
 							}
 
-							if (!theName.empty() && columnName == theName) {
+							if (i == nameColumn) {
 								thisRow.setName(theData);
 							}
-							if (!theLabel.empty() && columnName == theLabel) {
+							if (i == labelColumn) {
 								thisRow.setLabel(theData);
 							}
 
-							thisRow.setProperty(columnName,
-												ds::model::ContentProperty(columnName, theData, theInt, theDoub));
+							thisRow.setProperty(columnHandles[i], ds::model::ContentProperty("", theData, theInt, theDoub));
 
-							if (!resourceColumns.empty() && std::find(resourceColumns.begin(), resourceColumns.end(),
-																	  columnName) != resourceColumns.end()) {
-								thisRow.setPropertyResource(columnName, allResources[ds::string_to_int(theData)]);
+							if (resourceColumn[i]) {
+								thisRow.setPropertyResource(columnHandles[i], allResources[ds::string_to_int(theData)]);
 							}
 						}
 
-						// only parse metada for the first row
-						parsedMetadata = true;
-
+						rowOrder.push_back(thisRow.getId());
 						tableModel.addChild(thisRow);
 
 
 					} else {
-						sqlite3_finalize(statement);
+						db->release(statement);
 						break;
 					}
 				}
+
+				if (updatedColumn >= 0) mSyncStamps[thisId] = newestStamp;
 			}
 		} else {
 			DS_LOG_ERROR("ContentQuery: Unable to access the database " << dbPath << " (SQLite error "
@@ -567,16 +681,12 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, cons
 
 	std::string dbPath			 = cms.getDatabasePath();
 	std::string sampleQuery		 = "SELECT * FROM " + theTable;
-	sqlite3*	db				 = NULL;
-	const int   sqliteResultCode = sqlite3_open_v2(ds::getNormalizedPath(dbPath).c_str(), &db, SQLITE_OPEN_READONLY, 0);
-	if (sqliteResultCode == SQLITE_OK) {
-		sqlite3_busy_timeout(db, 1500);
-
-		sqlite3_stmt* statement;
-		const int	 err = sqlite3_prepare_v2(db, sampleQuery.c_str(), -1, &statement, 0);
-		if (err != SQLITE_OK) {
-			sqlite3_finalize(statement);
-			DS_LOG_ERROR("SqlDatabase::rawSelect SQL error = " << err << " on select=" << sampleQuery << std::endl);
+	int			sqliteResultCode = SQLITE_OK;
+	auto		db				 = ds::query::SqlConnectionPool::get().getDatabase(dbPath, SQLITE_OPEN_READONLY, &sqliteResultCode);
+	if (db) {
+		sqlite3_stmt* statement = db->acquire(sampleQuery);
+		if (!statement) {
+			DS_LOG_ERROR("SqlDatabase::rawSelect couldn't prepare select=" << sampleQuery << std::endl);
 		} else {
 			int id = 1;
 
@@ -601,7 +711,7 @@ void ContentQuery::getDataFromTable(ds::model::ContentModelRef parentModel, cons
 					parentModel.addChild(thisRow);
 
 				} else {
-					sqlite3_finalize(statement);
+					db->release(statement);
 					break;
 				}
 			}
@@ -3,6 +3,8 @@
 #define DS_CONTENT_CONTENT_QUERY
 
 #include <functional>
+#include <unordered_map>
+#include <vector>
 #include <Poco/Runnable.h>
 #include <ds/query/query_result.h>
 
@@ -21,6 +23,8 @@ public:
 
 	virtual void							run();
 
+	/// Link the rows of every table in tablesParent to their parent rows, answering how many links were made
+	static size_t							linkTables(ds::model::ContentModelRef tablesParent);
 	void									assembleModels(ds::model::ContentModelRef tablesParent);
 	void									updateResourceCache();
 
@@ -34,6 +38,21 @@ public:
 
 	std::string								mLastUpdatedResource;
 	std::unordered_map<int, ds::Resource>	mAllResources;
+	/// Resources that were new or different in this run
+	std::vector<int>						mUpdatedResources;
+
+	/// Every table from the model, flat and by table id. Linked together, unless this was an incremental run.
+	ds::model::ContentModelRef				mTables;
+	/// Table id -> the id of every row in the table, in query order
+	std::unordered_map<int, std::vector<int>> mRowOrder;
+
+	/// Set this, mSyncStamps, mLastUpdatedResource and mAllResources from the last run to only build
+	/// rows that changed since then. Tables with an updated_field and an id column only get rows whose
+	/// updated_field is at least their stamp; the rest are built in full. Nothing is linked, and
+	/// mData isn't filled in; the ContentWrangler patches its existing models from mTables.
+	bool									mIncremental = false;
+	/// Table id -> the newest updated_field value seen, in and out
+	std::unordered_map<int, std::string>	mSyncStamps;
 
 	bool mCheckUpdatedResources = true;
 	std::unordered_map<std::string, std::string> mResourceRemap =
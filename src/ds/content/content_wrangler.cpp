@@ -2,14 +2,27 @@
 
 #include "content_wrangler.h"
 
+#include <unordered_set>
+
 #include <ds/app/event_notifier.h>
 #include <ds/ui/sprite/sprite_engine.h>
+#include <ds/util/string_util.h>
 
 #include "content_events.h"
 
 
 namespace ds {
 
+namespace {
+/// Row id -> row, false if an id shows up twice
+bool indexRows(const std::vector<ds::model::ContentModelRef>& rows, std::unordered_map<int, ds::model::ContentModelRef>& out) {
+	for (auto row : rows) {
+		if (!out.emplace(row.getId(), row).second) return false;
+	}
+	return true;
+}
+}
+
 ContentWrangler::ContentWrangler(ds::ui::SpriteEngine& se)
   : mNodeWatcher(se, "localhost", 7777, false)
   , mEngine(se)
@@ -41,6 +54,15 @@ ContentWrangler::ContentWrangler(ds::ui::SpriteEngine& se)
 }
 
 void ContentWrangler::recieveQuery(ContentQuery& q) {
+	if (q.mIncremental) {
+		if (!applyIncremental(q)) {
+			DS_LOG_VERBOSE(1, "ContentWrangler: incremental query for " << q.mXmlDataModel << " didn't match the existing content, running a full query");
+			mSyncStates.erase(q.mXmlDataModel);
+			startQuery(q.mXmlDataModel, false);
+		}
+		return;
+	}
+
 	if (q.mData.empty()) {
 		DS_LOG_WARNING("ContentWrangler: runQuery() completed with no data.");
 		return;
@@ -83,17 +105,157 @@ void ContentWrangler::recieveQuery(ContentQuery& q) {
 			/// replace all children of the top-level node
 			match.setChildren(mergedList);
 		}else{
-			// Just straight up replace, no merge
-			match.clear();
-			match = q.mData;
+			// Just straight up replace, no merge. Replace what's in the existing node, since anyone
+			// holding on to it should see the new content.
+			match.setChildren(q.mData.getChildren());
+			match.setPropertiesFrom(q.mData);
 		}
 	} else {
 		mEngine.mContent.addChild(q.mData);
 	}
 
+	storeSyncState(q);
+
 	mEngine.getNotifier().notify(ContentUpdatedEvent());
 }
 
+void ContentWrangler::storeSyncState(ContentQuery& q) {
+	if (!mEngine.getEngineSettings().getBool("content:incremental") || q.mTables.getChildren().empty()) {
+		mSyncStates.erase(q.mXmlDataModel);
+		mAllResources.swap(q.mAllResources);
+		return;
+	}
+
+	auto& sync				  = mSyncStates[q.mXmlDataModel];
+	sync.mTables			  = q.mTables;
+	sync.mSyncStamps		  = q.mSyncStamps;
+	sync.mLastUpdatedResource = q.mLastUpdatedResource;
+	sync.mAllResources		  = q.mAllResources;
+	mAllResources.swap(q.mAllResources);
+}
+
+bool ContentWrangler::applyIncremental(ContentQuery& q) {
+	auto found = mSyncStates.find(q.mXmlDataModel);
+	if (found == mSyncStates.end()) return false;
+	auto& sync = found->second;
+
+	/// Check everything lines up before touching anything, so a mismatch can fall back to a full query
+	const auto& newTables	  = q.mTables.getChildren();
+	const auto& existingTables = sync.mTables.getChildren();
+	if (newTables.size() != existingTables.size()) return false;
+
+	std::vector<std::unordered_map<int, ds::model::ContentModelRef>> changedRows(newTables.size());
+	std::vector<std::unordered_map<int, ds::model::ContentModelRef>> existingRows(newTables.size());
+	for (size_t i = 0; i < newTables.size(); ++i) {
+		auto newTable	  = newTables[i];
+		auto existingTable = existingTables[i];
+		if (newTable.getId() != existingTable.getId() || newTable.getName() != existingTable.getName()) return false;
+		if (!indexRows(newTable.getChildren(), changedRows[i]) || !indexRows(existingTable.getChildren(), existingRows[i])) {
+			return false;
+		}
+
+		std::unordered_set<int> seen;
+		for (auto id : q.mRowOrder[newTable.getId()]) {
+			if (!seen.insert(id).second) return false;
+			if (changedRows[i].find(id) == changedRows[i].end() && existingRows[i].find(id) == existingRows[i].end()) {
+				return false;
+			}
+		}
+	}
+
+	std::unordered_set<int> updatedResources(q.mUpdatedResources.begin(), q.mUpdatedResources.end());
+	ContentUpdatedEvent		event;
+	event.mIncremental = true;
+	bool anyChanges	= false;
+
+	for (size_t i = 0; i < newTables.size(); ++i) {
+		auto				 table = existingTables[i];
+		ContentTableChanges  changes;
+		const auto&			 rowOrder = q.mRowOrder[table.getId()];
+		auto				 resourceColumns = ds::split(table.getPropertyString("resources"), ", ", true);
+
+		std::vector<ds::model::ContentModelRef> newOrder;
+		newOrder.reserve(rowOrder.size());
+		for (auto id : rowOrder) {
+			auto existing = existingRows[i].find(id);
+			auto changed  = changedRows[i].find(id);
+
+			if (changed == changedRows[i].end()) {
+				/// Unchanged row, but a resource it points at might have been updated
+				auto row	  = existing->second;
+				bool modified = false;
+				for (auto& col : resourceColumns) {
+					const int resourceId = row.getPropertyInt(col);
+					if (updatedResources.find(resourceId) == updatedResources.end()) continue;
+					row.setPropertyResource(col, q.mAllResources[resourceId]);
+					modified = true;
+				}
+				if (modified) changes.mModified.push_back(id);
+				newOrder.push_back(row);
+
+			} else if (existing == existingRows[i].end()) {
+				changes.mAdded.push_back(id);
+				newOrder.push_back(changed->second);
+
+			} else {
+				/// Patch the existing row, so anyone holding on to it sees the change
+				auto row	   = existing->second;
+				auto changedRow = changed->second;
+				/// hasSameProperties() rather than ==, since rows from different queries never share resource pointers
+				if (!row.hasSameProperties(changedRow) || row.getName() != changedRow.getName() ||
+					row.getLabel() != changedRow.getLabel()) {
+					row.setPropertiesFrom(changedRow);
+					row.setName(changedRow.getName());
+					row.setLabel(changedRow.getLabel());
+					changes.mModified.push_back(id);
+				}
+				newOrder.push_back(row);
+			}
+		}
+
+		std::unordered_set<int> kept(rowOrder.begin(), rowOrder.end());
+		const auto&				oldOrder = table.getChildren();
+		for (auto row : oldOrder) {
+			if (kept.find(row.getId()) == kept.end()) changes.mRemoved.push_back(row.getId());
+		}
+		if (changes.mAdded.empty() && changes.mRemoved.empty() && oldOrder.size() == newOrder.size()) {
+			for (size_t k = 0; k < newOrder.size(); ++k) {
+				if (oldOrder[k].getId() != newOrder[k].getId()) {
+					changes.mReordered = true;
+					break;
+				}
+			}
+		}
+
+		table.setChildren(newOrder);
+
+		if (!changes.mAdded.empty() || !changes.mRemoved.empty() || !changes.mModified.empty() || changes.mReordered) {
+			event.mChanges[table.getName()] = changes;
+			anyChanges						= true;
+		}
+	}
+
+	sync.mSyncStamps		  = q.mSyncStamps;
+	sync.mLastUpdatedResource = q.mLastUpdatedResource;
+	sync.mAllResources		  = q.mAllResources;
+	mAllResources.swap(q.mAllResources);
+
+	if (!anyChanges) {
+		DS_LOG_VERBOSE(3, "ContentWrangler: incremental query for " << q.mXmlDataModel << " found no changes");
+		return true;
+	}
+
+	/// Rows might have moved between parents, so link everything again from scratch
+	for (auto table : existingTables) {
+		for (auto row : table.getChildren()) row.clearChildren();
+	}
+	ContentQuery::linkTables(sync.mTables);
+
+	DS_LOG_VERBOSE(3, "ContentWrangler: incremental query for " << q.mXmlDataModel << " changed " << event.mChanges.size() << " tables");
+	mEngine.getNotifier().notify(event);
+	return true;
+}
+
 /// This will be called on every hard or soft app restart
 void ContentWrangler::initialize() {
 	if (!mEngine.getEngineSettings().getBool("content:use_wrangler")) {
@@ -128,16 +290,29 @@ void ContentWrangler::runQuery() {
 
 	DS_LOG_VERBOSE(3, "ContentWrangler: runQuery() starting");
 
-	auto allModels = ds::split(mModelModelLocation, ";", true);
+	const bool incremental = mEngine.getEngineSettings().getBool("content:incremental");
+	auto	   allModels   = ds::split(mModelModelLocation, ";", true);
 	for (auto it : allModels) {
-		auto thisModel = it;
-		mContentQuery.start([this, thisModel](ds::ContentQuery& dq) {
-			const ds::Resource::Id cms(ds::Resource::Id::CMS_TYPE, 0);
-			dq.mXmlDataModel     = thisModel;
-			dq.mCmsDatabase      = cms.getDatabasePath();
-			dq.mResourceLocation = cms.getResourcePath();
-		});
+		startQuery(it, incremental && mSyncStates.find(it) != mSyncStates.end());
 	}
 }
 
+void ContentWrangler::startQuery(const std::string& model, const bool incremental) {
+	mContentQuery.start([this, model, incremental](ds::ContentQuery& dq) {
+		const ds::Resource::Id cms(ds::Resource::Id::CMS_TYPE, 0);
+		dq.mXmlDataModel     = model;
+		dq.mCmsDatabase      = cms.getDatabasePath();
+		dq.mResourceLocation = cms.getResourcePath();
+		dq.mIncremental		 = false;
+
+		auto found = mSyncStates.find(model);
+		if (incremental && found != mSyncStates.end()) {
+			dq.mIncremental			= true;
+			dq.mSyncStamps			= found->second.mSyncStamps;
+			dq.mLastUpdatedResource = found->second.mLastUpdatedResource;
+			dq.mAllResources		= found->second.mAllResources;
+		}
+	});
+}
+
 }  // namespace ds
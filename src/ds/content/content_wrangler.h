@@ -38,6 +38,19 @@ class ContentWrangler {
 	void runQuery();
 
   private:
+	/// What the last query of one model left behind, so the next one can only read what changed
+	struct SyncState {
+		ds::model::ContentModelRef			  mTables;
+		std::unordered_map<int, std::string>  mSyncStamps;
+		std::string							  mLastUpdatedResource;
+		std::unordered_map<int, ds::Resource> mAllResources;
+	};
+
+	void startQuery(const std::string& model, const bool incremental);
+	/// Patch the rows from an incremental query into the existing models. False if they don't line up.
+	bool applyIncremental(ContentQuery& q);
+	void storeSyncState(ContentQuery& q);
+
 	ds::ui::SpriteEngine&              mEngine;
 	ds::ParallelRunnable<ContentQuery> mContentQuery;
 
@@ -45,6 +58,9 @@ class ContentWrangler {
 	ds::EventClient        mEventClient;
 
 	std::string mModelModelLocation;
+
+	/// Model xml location -> its sync state, only kept when content:incremental is on
+	std::unordered_map<std::string, SyncState> mSyncStates;
 };
 
 }  // namespace ds
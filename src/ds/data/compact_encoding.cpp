@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+#include "ds/data/compact_encoding.h"
+
+#include <cmath>
+#include <limits>
+#include "ds/cfg/settings.h"
+#include "ds/data/data_buffer.h"
+
+namespace ds {
+
+namespace {
+// Anything finer than this would overflow the int32 steps for ordinary screen coordinates
+const float			MIN_PRECISION = 0.00001f;
+
+float clampPrecision(const float p) {
+	if(!(p >= MIN_PRECISION)) return MIN_PRECISION;
+	return p;
+}
+}
+
+/**
+ * \class CompactEncoding
+ */
+CompactEncoding::CompactEncoding()
+	: mEnabled(false)
+	, mSpatialPrecision(0.01f)
+	, mRotationPrecision(0.01f)
+	, mScalePrecision(0.0001f)
+	, mColorPrecision(0.001f)
+{
+}
+
+CompactEncoding CompactEncoding::fromSettings(ds::cfg::Settings& settings) {
+	CompactEncoding		ans;
+	ans.mEnabled = (settings.getString("server:attribute_encoding", 0, "raw") == "compact");
+	ans.mSpatialPrecision = clampPrecision(settings.getFloat("server:attribute_precision:spatial", 0, ans.mSpatialPrecision));
+	ans.mRotationPrecision = clampPrecision(settings.getFloat("server:attribute_precision:rotation", 0, ans.mRotationPrecision));
+	ans.mScalePrecision = clampPrecision(settings.getFloat("server:attribute_precision:scale", 0, ans.mScalePrecision));
+	ans.mColorPrecision = clampPrecision(settings.getFloat("server:attribute_precision:color", 0, ans.mColorPrecision));
+	return ans;
+}
+
+void CompactEncoding::writeTo(ds::DataBuffer& buf) const {
+	buf.add(mEnabled);
+	buf.add(mSpatialPrecision);
+	buf.add(mRotationPrecision);
+	buf.add(mScalePrecision);
+	buf.add(mColorPrecision);
+}
+
+void CompactEncoding::readFrom(ds::DataBuffer& buf) {
+	mEnabled = buf.read<bool>();
+	mSpatialPrecision = clampPrecision(buf.read<float>());
+	mRotationPrecision = clampPrecision(buf.read<float>());
+	mScalePrecision = clampPrecision(buf.read<float>());
+	mColorPrecision = clampPrecision(buf.read<float>());
+}
+
+int32_t CompactEncoding::quantize(const float value, const float precision) {
+	const double		steps = std::floor(static_cast<double>(value) / static_cast<double>(precision) + 0.5);
+	if(!(steps > static_cast<double>(std::numeric_limits<int32_t>::min()))) return std::numeric_limits<int32_t>::min();
+	if(!(steps < static_cast<double>(std::numeric_limits<int32_t>::max()))) return std::numeric_limits<int32_t>::max();
+	return static_cast<int32_t>(steps);
+}
+
+float CompactEncoding::dequantize(const int32_t value, const float precision) {
+	return static_cast<float>(static_cast<double>(value) * static_cast<double>(precision));
+}
+
+void CompactEncoding::addVarint(ds::DataBuffer& buf, uint32_t value) {
+	while(value >= 0x80) {
+		buf.add(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	buf.add(static_cast<char>(value));
+}
+
+uint32_t CompactEncoding::readVarint(ds::DataBuffer& buf) {
+	uint32_t			value = 0;
+	// A uint32 never needs more than 5 bytes, anything longer is a broken packet
+	for(int shift = 0; shift < 35 && buf.canRead<char>(); shift += 7) {
+		const unsigned char		b = static_cast<unsigned char>(buf.read<char>());
+		value |= static_cast<uint32_t>(b & 0x7f) << shift;
+		if((b & 0x80) == 0) break;
+	}
+	return value;
+}
+
+void CompactEncoding::addSignedVarint(ds::DataBuffer& buf, const int32_t value) {
+	const uint32_t		v = static_cast<uint32_t>(value);
+	addVarint(buf, (v << 1) ^ (0u - (v >> 31)));
+}
+
+int32_t CompactEncoding::readSignedVarint(ds::DataBuffer& buf) {
+	const uint32_t		v = readVarint(buf);
+	return static_cast<int32_t>((v >> 1) ^ (0u - (v & 1u)));
+}
+
+} // namespace ds
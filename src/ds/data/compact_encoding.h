@@ -0,0 +1,55 @@
+#pragma once
+#ifndef DS_DATA_COMPACT_ENCODING_H_
+#define DS_DATA_COMPACT_ENCODING_H_
+
+#include <stdint.h>
+
+namespace ds {
+class DataBuffer;
+namespace cfg {
+class Settings;
+}
+
+/**
+ * \class CompactEncoding
+ * \brief How the server packs the common sprite attributes (size, position, rotation etc)
+ * into a frame. Raw sends every float as-is. Compact quantizes each value to a fixed
+ * precision, sends the difference from the last value sent for that sprite, and packs
+ * the result as a varint, so a sprite that barely moved costs a byte or two per value.
+ */
+class CompactEncoding {
+public:
+	CompactEncoding();
+
+	/// Reads server:attribute_encoding and the server:attribute_precision settings
+	static CompactEncoding		fromSettings(ds::cfg::Settings&);
+
+	/// The server tells clients how it encodes, so they don't depend on their own settings matching
+	void						writeTo(ds::DataBuffer&) const;
+	void						readFrom(ds::DataBuffer&);
+
+	bool						mEnabled;
+	/// The smallest change that gets replicated, in pixels for size and position
+	float						mSpatialPrecision;
+	/// In degrees
+	float						mRotationPrecision;
+	/// For scale and center, which are usually 0 - 1
+	float						mScalePrecision;
+	/// For color and opacity, which are 0 - 1
+	float						mColorPrecision;
+
+	/// Round value to the nearest multiple of precision, as a count of precision steps
+	static int32_t				quantize(const float value, const float precision);
+	static float				dequantize(const int32_t value, const float precision);
+
+	/// 7 bits at a time, smallest first, with the high bit set on every byte but the last
+	static void					addVarint(ds::DataBuffer&, uint32_t value);
+	static uint32_t				readVarint(ds::DataBuffer&);
+	/// Zigzag so small negative numbers stay small: 0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+	static void					addSignedVarint(ds::DataBuffer&, const int32_t value);
+	static int32_t				readSignedVarint(ds::DataBuffer&);
+};
+
+} // namespace ds
+
+#endif // DS_DATA_COMPACT_ENCODING_H_
@@ -2,54 +2,146 @@
 
 #include "data_buffer.h"
 #include <string>
+#include <utility>
 
 namespace ds {
 
+namespace {
+ds::MemoryTag& arenaMemory() {
+	static ds::MemoryTag&	TAG = ds::MemoryAccounting::get().getTag("DataBuffer arenas");
+	return TAG;
+}
+}
+
 DataBuffer::DataBuffer(unsigned initialStreamSize)
-	: mStream(initialStreamSize)
+	: mWrapped(nullptr)
+	, mReadPosition(0)
+	, mWritePosition(0)
+	, mEnd(0)
+	, mArenaMemory(arenaMemory())
 {
+	mArena.resize(initialStreamSize);
+	mArenaMemory.setBytes(mArena.size());
 }
 
-unsigned DataBuffer::size(){
-	unsigned currentPosition = mStream.getReadPosition();
+DataBuffer::DataBuffer(const DataBuffer& o)
+	: mArena(o.mArena)
+	, mWrapped(o.mWrapped)
+	, mReadPosition(o.mReadPosition)
+	, mWritePosition(o.mWritePosition)
+	, mEnd(o.mEnd)
+	, mArenaMemory(arenaMemory(), mArena.size())
+{
+}
 
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
+DataBuffer::DataBuffer(DataBuffer&& o)
+	: mWrapped(nullptr)
+	, mReadPosition(0)
+	, mWritePosition(0)
+	, mEnd(0)
+	, mArenaMemory(arenaMemory())
+{
+	swap(o);
+}
+
+DataBuffer& DataBuffer::operator=(const DataBuffer& o){
+	if(this == &o)
+		return *this;
+	mArena = o.mArena;
+	mWrapped = o.mWrapped;
+	mReadPosition = o.mReadPosition;
+	mWritePosition = o.mWritePosition;
+	mEnd = o.mEnd;
+	mArenaMemory.setBytes(mArena.size());
+	return *this;
+}
 
-	return length;
+DataBuffer& DataBuffer::operator=(DataBuffer&& o){
+	swap(o);
+	return *this;
 }
 
 void DataBuffer::seekBegin(){
-	mStream.setReadPosition(ReadWriteBuffer::Begin);
-	mStream.setWritePosition(ReadWriteBuffer::Begin);
+	mReadPosition = 0;
+	mWritePosition = 0;
 }
 
 void DataBuffer::clear(){
-	mStream.clear();
+	mWrapped = nullptr;
+	mReadPosition = 0;
+	mWritePosition = 0;
+	mEnd = 0;
 }
 
-void DataBuffer::addRaw(const char *b, unsigned size){
-	mStream.write(b, size);
+void DataBuffer::reserve(unsigned size){
+	if(mArena.size() < size) {
+		mArena.resize(size);
+		mArenaMemory.setBytes(mArena.size());
+	}
 }
 
-bool DataBuffer::readRaw(char *b, unsigned size){
-	unsigned currentPosition = mStream.getReadPosition();
+void DataBuffer::swap(DataBuffer& other){
+	mArena.swap(other.mArena);
+	std::swap(mWrapped, other.mWrapped);
+	std::swap(mReadPosition, other.mReadPosition);
+	std::swap(mWritePosition, other.mWritePosition);
+	std::swap(mEnd, other.mEnd);
+	mArenaMemory.swap(other.mArenaMemory);
+}
+
+void DataBuffer::wrap(const char *data, unsigned size){
+	mWrapped = data;
+	mReadPosition = 0;
+	mWritePosition = size;
+	mEnd = size;
+}
+
+void DataBuffer::unwrap(){
+	if(!mWrapped)
+		return;
+
+	const char *wrapped = mWrapped;
+	mWrapped = nullptr;
+	reserve(mEnd);
+	if(mEnd > 0)
+		memcpy(mArena.data(), wrapped, mEnd);
+}
 
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
+void DataBuffer::writeSlow(const char *b, unsigned size){
+	unwrap();
 
-	if(size > (length - currentPosition))
+	if(mWritePosition + size > mArena.size()) {
+		// Grow geometrically, so a frame that keeps getting bigger doesn't copy on every add
+		size_t newSize = mArena.size() < 64 ? 64 : mArena.size();
+		while(newSize < mWritePosition + size)
+			newSize *= 2;
+		mArena.resize(newSize);
+		mArenaMemory.setBytes(mArena.size());
+	}
+
+	if(size > 0)
+		memcpy(mArena.data() + mWritePosition, b, size);
+	mWritePosition += size;
+	if(mWritePosition > mEnd)
+		mEnd = mWritePosition;
+}
+
+void DataBuffer::addRaw(const char *b, unsigned size){
+	write(b, size);
+}
+
+bool DataBuffer::readRaw(char *b, unsigned size){
+	if(size > (mEnd - mReadPosition))
 		return false;
 
-	mStream.read(b, size);
+	memcpy(b, data() + mReadPosition, size);
+	mReadPosition += size;
 	return true;
 }
 
 void DataBuffer::add(const char *b, unsigned size){
 	add(size);
-	mStream.write(b, size);
+	write(b, size);
 }
 
 void DataBuffer::add(const char *cs){
@@ -63,21 +155,17 @@ void DataBuffer::add(const wchar_t *cs){
 bool DataBuffer::read(char *b, unsigned size){
 	unsigned wsize = read<unsigned>();
 	if(wsize != size) {
-		add(wsize);
+		rewindRead<unsigned>();
 		return false;
 	}
 
-	unsigned currentPosition = mStream.getReadPosition();
-
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
-
-	if(size > (length - currentPosition))
+	if(size > (mEnd - mReadPosition)) {
+		rewindRead<unsigned>();
 		return false;
+	}
 
-
-	mStream.read(b, size);
+	memcpy(b, data() + mReadPosition, size);
+	mReadPosition += size;
 	return true;
 }
 
@@ -87,54 +175,43 @@ template <>
 void DataBuffer::add<std::string>(const std::string &s){
 	unsigned size = (unsigned)s.size();
 	add(size);
-	mStream.write(s.c_str(), size);
+	write(s.c_str(), size);
 }
 
 template <>
 void DataBuffer::add<std::wstring>(const std::wstring &ws){
 	unsigned size = (static_cast<unsigned int>(ws.size()))*sizeof(wchar_t);
 	add(size);
-	mStream.write((const char *)(ws.c_str()), size);
+	write((const char *)(ws.c_str()), size);
 }
 
 template <>
 std::string DataBuffer::read<std::string>(){
 	unsigned size = read<unsigned>();
-	unsigned currentPosition = mStream.getReadPosition();
-
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
-
-	if(size > (length - currentPosition)) {
-		add(size);
+	if(size > (mEnd - mReadPosition)) {
+		rewindRead<unsigned>();
 		return std::string();
 	}
 
-	mStringBuffer.setSize(size);
-
-	mStream.read(mStringBuffer.data(), size);
-	return std::string(mStringBuffer.data(), size);
+	// Straight out of the span, no staging buffer
+	std::string s(data() + mReadPosition, size);
+	mReadPosition += size;
+	return s;
 }
 
 template <>
 std::wstring DataBuffer::read<std::wstring>(){
 	unsigned size = read<unsigned>();
-	unsigned currentPosition = mStream.getReadPosition();
-
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
-
-	if(size > (length - currentPosition)) {
-		add(size);
+	if(size > (mEnd - mReadPosition)) {
+		rewindRead<unsigned>();
 		return std::wstring();
 	}
 
-	mWStringBuffer.setSize(size);
-
-	mStream.read((char *)mWStringBuffer.data(), size);
-	return std::wstring((const wchar_t *)mWStringBuffer.data(), size / 2);
+	std::wstring ws(size / sizeof(wchar_t), L'\0');
+	if(size > 0)
+		memcpy(&ws[0], data() + mReadPosition, (size / sizeof(wchar_t)) * sizeof(wchar_t));
+	mReadPosition += size;
+	return ws;
 }
 
 } // namespace ds
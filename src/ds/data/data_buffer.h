@@ -1,26 +1,48 @@
 #pragma once
 #ifndef DS_DATA_BUFFER_H
 #define DS_DATA_BUFFER_H
+#include <cstring>
 #include <string>
-#include "read_write_buffer.h"
-#include "ds/query/recycle_array.h"
+#include <vector>
+#include "ds/debug/memory_accounting.h"
 
 namespace ds {
 
 /*
 	* brief
 	*   add functions must be matched be read function.
+	*
+	*   Writes go into an arena that keeps its capacity across clear(), so a buffer
+	*   that's reused every frame stops allocating once it's seen the biggest frame.
+	*   Reads come from a span with known bounds: either the arena, or someone else's
+	*   bytes handed over with wrap(), which are read in place without being copied.
 	*/
 class DataBuffer
 {
 public:
 	DataBuffer(unsigned initialStreamSize = 0);
-	unsigned size();
+	DataBuffer(const DataBuffer&);
+	DataBuffer(DataBuffer&&);
+	DataBuffer& operator=(const DataBuffer&);
+	DataBuffer& operator=(DataBuffer&&);
+	unsigned size() const { return mEnd; }
 	void seekBegin();
 	void clear();
+	/// Make room for at least size bytes without reallocating.
+	void reserve(unsigned size);
+	/// Trade contents (and arenas) with other, without copying anything.
+	void swap(DataBuffer& other);
+
+	/// Read straight out of data instead of the arena, without copying it. The bytes need to
+	/// stay put until the next clear() or wrap(). Adding anything copies them into the arena first.
+	void wrap(const char *data, unsigned size);
+	/// Everything that's been added (or wrapped), from the start.
+	const char* data() const { return mWrapped ? mWrapped : mArena.data(); }
 
 	template <typename T>
-	bool canRead();
+	bool canRead() const { return sizeof(T) <= mEnd - mReadPosition; }
+	/// How far reading has got, from the start.
+	unsigned getReadPosition() const { return mReadPosition; }
 
 	/// function to add raw data no size added.
 	void addRaw(const char *b, unsigned size);
@@ -45,55 +67,68 @@ public:
 	template <typename T>
 	void rewindAdd();
 private:
-	ReadWriteBuffer		mStream;
-	RecycleArray<char>	mStringBuffer;
-	RecycleArray<char>	mWStringBuffer;
+	void write(const char *b, unsigned size);
+	/// Anything write() can't do in place: unwrapping or growing the arena.
+	void writeSlow(const char *b, unsigned size);
+	/// Copy wrapped bytes into the arena, so they can be added to.
+	void unwrap();
+
+	std::vector<char>	mArena;
+	const char*			mWrapped;
+	unsigned			mReadPosition;
+	unsigned			mWritePosition;
+	/// One past the last readable byte
+	unsigned			mEnd;
+	/// The arena's size, counted under "DataBuffer arenas"
+	MemoryTracked		mArenaMemory;
 };
 
-template <typename T>
-bool ds::DataBuffer::canRead(){
-	unsigned size = sizeof(T);
-	unsigned currentPosition = mStream.getReadPosition();
-
-	mStream.setReadPosition(ReadWriteBuffer::End);
-	unsigned length = mStream.getReadPosition();
-	mStream.setReadPosition(currentPosition);
+inline void ds::DataBuffer::write(const char *b, unsigned size){
+	if(mWrapped || mWritePosition + size > mArena.size()) {
+		writeSlow(b, size);
+		return;
+	}
 
-	if(size > (length - currentPosition))
-		return false;
-	return true;
+	memcpy(mArena.data() + mWritePosition, b, size);
+	mWritePosition += size;
+	if(mWritePosition > mEnd)
+		mEnd = mWritePosition;
 }
 
 template <typename T>
 void ds::DataBuffer::add(const T &t){
-	mStream.write((const char *)(&t), sizeof(t));
+	write((const char *)(&t), sizeof(t));
 }
 
 template <typename T>
 T ds::DataBuffer::read(){
-	T t;
-	mStream.read((char *)(&t), sizeof(t));
+	T t = T();
+	if(!canRead<T>())
+		return t;
+
+	memcpy((char *)(&t), data() + mReadPosition, sizeof(t));
+	mReadPosition += sizeof(t);
 	return t;
 }
 
 template <typename T>
 void ds::DataBuffer::rewindRead(){
-	unsigned currentPosition = mStream.getReadPosition();
-
-	if(sizeof(T) > currentPosition)
+	if(sizeof(T) > mReadPosition)
 		return;
 
-	mStream.rewindRead(sizeof(T));
+	mReadPosition -= sizeof(T);
 }
 
 template <typename T>
 void ds::DataBuffer::rewindAdd(){
-	unsigned currentPosition = mStream.getWritePosition();
-
-	if(sizeof(T) > currentPosition)
+	if(sizeof(T) > mWritePosition)
 		return;
 
-	mStream.rewindWrite(sizeof(T));
+	if(mWritePosition == mEnd)
+		mEnd -= sizeof(T);
+	mWritePosition -= sizeof(T);
+	if(mReadPosition > mEnd)
+		mReadPosition = mEnd;
 }
 
 // Template specializations
@@ -11,6 +11,7 @@
 #include <Poco/String.h>
 #include "ds/app/environment.h"
 #include "ds/cfg/settings.h"
+#include "ds/debug/memory_accounting.h"
 #include "ds/util/string_util.h"
 
 using namespace ds;
@@ -38,6 +39,12 @@ std::string			LOG_FILE;
 
 Poco::Semaphore		BLOCK_SEM(0, 1);
 
+// Lines waiting for the logging thread
+ds::MemoryTag& queueMemory() {
+	static ds::MemoryTag&	TAG = ds::MemoryAccounting::get().getTag("Logger queue");
+	return TAG;
+}
+
 // Maintain the modules associated with names so I can let the user know what's available
 std::map<int, std::string>*  MODULE_MAP = nullptr;
 }
@@ -286,6 +293,7 @@ void Logger::Loop::log(const int level, const std::string& str)
 		e.mMsg = str;
 		e.mLevel = level;
 		e.mTime = Poco::LocalDateTime().timestamp().epochMicroseconds();
+		queueMemory().add(1, static_cast<int64_t>(sizeof(entry) + e.mMsg.capacity()));
 	} catch(std::exception&) {
 		return;
 	}
@@ -332,6 +340,10 @@ void Logger::Loop::run()
 
 void Logger::Loop::consume(std::vector<entry>& ins)
 {
+	int64_t						queued = 0;
+	for (int k=0; k<ins.size(); k++) queued += static_cast<int64_t>(sizeof(entry) + ins[k].mMsg.capacity());
+	queueMemory().add(-static_cast<int64_t>(ins.size()), -queued);
+
 	for (int k=0; k<ins.size(); k++) {
 		const entry&			e = ins[k];
 		if (e.mLevel == LOG_LEVEL_BLOCK_CODE) BLOCK_SEM.set();
@@ -0,0 +1,110 @@
+#include "stdafx.h"
+
+#include "ds/debug/memory_accounting.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace ds {
+
+/**
+ * \class MemoryTag
+ */
+MemoryTag::MemoryTag(const std::string& name)
+		: mName(name)
+		, mCount(0)
+		, mBytes(0)
+		, mPeakBytes(0) {
+}
+
+void MemoryTag::add(const int64_t count, const int64_t bytes) {
+	if(count != 0) mCount.fetch_add(count, std::memory_order_relaxed);
+	if(bytes == 0) return;
+	const int64_t				now = mBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	int64_t						peak = mPeakBytes.load(std::memory_order_relaxed);
+	while(now > peak && !mPeakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) { }
+}
+
+/**
+ * \class MemoryAccounting
+ */
+MemoryAccounting& MemoryAccounting::get() {
+	// Never deleted, since static buffers and the logger can still be counting on the way out
+	static MemoryAccounting*	ACCOUNTING = new MemoryAccounting();
+	return *ACCOUNTING;
+}
+
+MemoryAccounting::MemoryAccounting() {
+}
+
+MemoryTag& MemoryAccounting::getTag(const std::string& name) {
+	Poco::FastMutex::ScopedLock	l(mMutex);
+	for(auto& t : mTags) {
+		if(t->getName() == name) return *t;
+	}
+	mTags.push_back(std::unique_ptr<MemoryTag>(new MemoryTag(name)));
+	return *mTags.back();
+}
+
+void MemoryAccounting::getSummary(std::vector<std::pair<std::string, std::string>>& out) const {
+	Poco::FastMutex::ScopedLock	l(mMutex);
+	for(auto& t : mTags) {
+		std::stringstream		ss;
+		ss << t->getCount();
+		if(t->getBytes() != 0 || t->getPeakBytes() != 0) {
+			ss << ", " << formatBytes(t->getBytes()) << " (peak " << formatBytes(t->getPeakBytes()) << ")";
+		}
+		out.push_back(std::make_pair(t->getName(), ss.str()));
+	}
+}
+
+std::string MemoryAccounting::formatBytes(const int64_t bytes) {
+	std::stringstream			ss;
+	const double				b = static_cast<double>(bytes);
+	if(bytes >= 1024 * 1024 || bytes <= -1024 * 1024) ss << std::fixed << std::setprecision(1) << (b / (1024.0 * 1024.0)) << " MB";
+	else if(bytes >= 1024 || bytes <= -1024) ss << std::fixed << std::setprecision(1) << (b / 1024.0) << " KB";
+	else ss << bytes << " B";
+	return ss.str();
+}
+
+/**
+ * \class MemoryTracked
+ */
+MemoryTracked::MemoryTracked(MemoryTag& tag, const int64_t bytes)
+		: mTag(tag)
+		, mBytes(bytes) {
+	mTag.add(1, mBytes);
+}
+
+MemoryTracked::MemoryTracked(const MemoryTracked& o)
+		: mTag(o.mTag)
+		, mBytes(o.mBytes) {
+	mTag.add(1, mBytes);
+}
+
+MemoryTracked& MemoryTracked::operator=(const MemoryTracked&) {
+	return *this;
+}
+
+MemoryTracked::~MemoryTracked() {
+	mTag.add(-1, -mBytes);
+}
+
+void MemoryTracked::setBytes(const int64_t bytes) {
+	if(bytes == mBytes) return;
+	mTag.add(0, bytes - mBytes);
+	mBytes = bytes;
+}
+
+void MemoryTracked::swap(MemoryTracked& o) {
+	if(&mTag == &o.mTag) {
+		std::swap(mBytes, o.mBytes);
+		return;
+	}
+	// Different tags have to hand the bytes across
+	const int64_t				mine = mBytes;
+	setBytes(o.mBytes);
+	o.setBytes(mine);
+}
+
+} // namespace ds
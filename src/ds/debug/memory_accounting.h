@@ -0,0 +1,108 @@
+#pragma once
+#ifndef DS_DEBUG_MEMORYACCOUNTING_H_
+#define DS_DEBUG_MEMORYACCOUNTING_H_
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+
+/**
+ * \class MemoryTag
+ * \brief How many objects one subsystem has alive, and roughly how many bytes they hold.
+ * Safe to add to from any thread.
+ */
+class MemoryTag {
+public:
+	MemoryTag(const std::string& name);
+
+	const std::string&			getName() const		{ return mName; }
+	/// Negative to take away
+	void						add(const int64_t count, const int64_t bytes);
+	int64_t						getCount() const	{ return mCount.load(std::memory_order_relaxed); }
+	int64_t						getBytes() const	{ return mBytes.load(std::memory_order_relaxed); }
+	int64_t						getPeakBytes() const { return mPeakBytes.load(std::memory_order_relaxed); }
+
+private:
+	MemoryTag(const MemoryTag&);
+	MemoryTag&					operator=(const MemoryTag&);
+
+	const std::string			mName;
+	std::atomic<int64_t>		mCount;
+	std::atomic<int64_t>		mBytes;
+	std::atomic<int64_t>		mPeakBytes;
+};
+
+/**
+ * \class MemoryAccounting
+ * \brief Every MemoryTag, so slow growth over weeks can be pinned on a subsystem without
+ * attaching a profiler. The counts come from the subsystems themselves (sprites, textures,
+ * content models, query results, data buffers, the logger), so they're what each one is
+ * holding on to, not what the heap says.
+ *
+ * Shown in the stats view, and logged every memory:log_interval seconds.
+ */
+class MemoryAccounting {
+public:
+	static MemoryAccounting&	get();
+
+	/// The tag with this name, made the first time it's asked for. Tags are never deleted,
+	/// so hold on to the reference, typically in a static.
+	MemoryTag&					getTag(const std::string& name);
+
+	/// One name / value line per tag, in the order they were made.
+	void						getSummary(std::vector<std::pair<std::string, std::string>>&) const;
+
+	static std::string			formatBytes(const int64_t bytes);
+
+private:
+	MemoryAccounting();
+	MemoryAccounting(const MemoryAccounting&);
+	MemoryAccounting&			operator=(const MemoryAccounting&);
+
+	mutable Poco::FastMutex		mMutex;
+	std::vector<std::unique_ptr<MemoryTag>>
+								mTags;
+};
+
+/**
+ * \class MemoryTracked
+ * \brief Counts the object it's a member of against a tag for as long as it's alive,
+ * copies included, along with however many bytes the owner says it holds.
+ */
+class MemoryTracked {
+public:
+	MemoryTracked(MemoryTag&, const int64_t bytes = 0);
+	MemoryTracked(const MemoryTracked&);
+	/// Keeps its own tag and bytes, owners update the bytes themselves
+	MemoryTracked&				operator=(const MemoryTracked&);
+	~MemoryTracked();
+
+	void						setBytes(const int64_t bytes);
+	int64_t						getBytes() const	{ return mBytes; }
+	/// Trade bytes, for owners that trade contents.
+	void						swap(MemoryTracked&);
+
+private:
+	MemoryTag&					mTag;
+	int64_t						mBytes;
+};
+
+/// Hand out a copy of p that counts against the tag until the last copy of it goes away,
+/// for things like textures that get passed around and outlive whoever made them.
+template <typename T>
+std::shared_ptr<T>				trackMemory(const std::shared_ptr<T>& p, MemoryTag& tag, const int64_t bytes) {
+	if(!p) return p;
+	tag.add(1, bytes);
+	std::shared_ptr<T>			held(p);
+	return std::shared_ptr<T>(p.get(), [held, &tag, bytes](T*) mutable { held.reset(); tag.add(-1, -bytes); });
+}
+
+} // namespace ds
+
+#endif // DS_DEBUG_MEMORYACCOUNTING_H_
@@ -0,0 +1,283 @@
+#include "stdafx.h"
+
+#include "ds/debug/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <typeindex>
+#include <unordered_map>
+#include <Poco/Thread.h>
+#include "ds/app/event.h"
+
+namespace ds {
+
+namespace {
+void writeJsonString(std::ostream& out, const char* str) {
+	out << '"';
+	for(const char* c = str; c && *c; ++c) {
+		if(*c == '"' || *c == '\\') out << '\\' << *c;
+		else if(static_cast<unsigned char>(*c) < 0x20) out << ' ';
+		else out << *c;
+	}
+	out << '"';
+}
+}
+
+/**
+ * \class Profiler
+ */
+Profiler& Profiler::get() {
+	static Profiler		PROFILER;
+	return PROFILER;
+}
+
+Profiler::Profiler()
+		: mEnabled(false)
+		, mSpriteZones(false)
+		, mCapacity(0)
+		, mNext(0)
+		, mCount(0)
+		, mFrameNumber(0)
+		, mFrameStart(now()) {
+}
+
+void Profiler::setCapacity(const size_t capacity) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	mCapacity = capacity;
+	mFrames.clear();
+	mFrames.resize(capacity);
+	mNext = 0;
+	mCount = 0;
+	mEnabled.store(capacity > 0, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string& name) {
+	ThreadLog&						log = getThreadLog();
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	log.mName = name;
+}
+
+void Profiler::endFrame() {
+	ThreadLog&						main = getThreadLog();
+	const int64_t					end = now();
+
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	if(main.mName.empty()) main.mName = "main";
+
+	mPending.mFrame = mFrameNumber++;
+	mPending.mStart = mFrameStart;
+	mPending.mEnd = end;
+	mFrameStart = end;
+	for(auto& t : mThreads) {
+		Poco::FastMutex::ScopedLock	tl(t->mMutex);
+		if(mCapacity > 0) mPending.mZones.insert(mPending.mZones.end(), t->mZones.begin(), t->mZones.end());
+		t->mZones.clear();
+	}
+	if(mCapacity < 1) {
+		mPending.clear();
+		return;
+	}
+
+	// Trade with the slot being overwritten, so the zone list keeps its storage
+	std::swap(mFrames[mNext], mPending);
+	mNext = (mNext + 1) % mCapacity;
+	if(mCount < mCapacity) ++mCount;
+	mPending.clear();
+}
+
+int64_t Profiler::now() {
+	static const std::chrono::steady_clock::time_point	START = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+const char* Profiler::getClassName(const std::type_info& type) {
+	// Each thread checks its own cache first, so only a class's first zone on a thread takes the lock
+	static thread_local std::unordered_map<std::type_index, const char*>	CACHE;
+	const std::type_index			key(type);
+	auto							found = CACHE.find(key);
+	if(found != CACHE.end()) return found->second;
+
+	// Never deleted, since recorded zones point into it
+	static Poco::FastMutex*			MUTEX = new Poco::FastMutex();
+	static std::unordered_map<std::type_index, std::string>*	NAMES = new std::unordered_map<std::type_index, std::string>();
+	Poco::FastMutex::ScopedLock		l(*MUTEX);
+	std::string&					name = (*NAMES)[key];
+	if(name.empty()) name = demangleTypeName(type.name());
+	CACHE[key] = name.c_str();
+	return name.c_str();
+}
+
+void Profiler::getFrames(std::vector<Frame>& out) const {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	out.clear();
+	out.reserve(mCount);
+	for(size_t k = 0; k < mCount; ++k) {
+		out.push_back(mFrames[(mNext + mCapacity - mCount + k) % mCapacity]);
+	}
+}
+
+void Profiler::getSummary(std::vector<std::pair<std::string, std::string>>& out, const size_t maxZones) const {
+	std::vector<Frame>				frames;
+	getFrames(frames);
+	if(frames.empty()) return;
+
+	double							frameTime = 0.0;
+	// By name rather than pointer, the same literal can live at different addresses
+	std::unordered_map<std::string, std::pair<double, size_t>>
+									zones;
+	for(auto& f : frames) {
+		frameTime += static_cast<double>(f.mEnd - f.mStart);
+		for(auto& z : f.mZones) {
+			if(z.mNested) continue;
+			auto&					total = zones[z.mName ? z.mName : ""];
+			total.first += static_cast<double>(z.mEnd - z.mStart);
+			++total.second;
+		}
+	}
+	const double					n = static_cast<double>(frames.size());
+
+	std::stringstream				ss;
+	ss << std::fixed << std::setprecision(2) << (frameTime / n / 1000000.0) << " ms over " << frames.size() << " frames";
+	out.push_back(std::make_pair("Avg Frame", ss.str()));
+
+	std::vector<std::pair<double, std::pair<std::string, size_t>>>
+									top;
+	for(auto& z : zones) top.push_back(std::make_pair(z.second.first, std::make_pair(z.first, z.second.second)));
+	std::sort(top.begin(), top.end(), [](const std::pair<double, std::pair<std::string, size_t>>& a,
+										 const std::pair<double, std::pair<std::string, size_t>>& b) { return a.first > b.first; });
+	for(size_t k = 0; k < top.size() && k < maxZones; ++k) {
+		ss.str("");
+		ss << (top[k].first / n / 1000000.0) << " ms";
+		const double				calls = static_cast<double>(top[k].second.second) / n;
+		if(calls > 1.0) ss << " (" << std::setprecision(0) << calls << "x)" << std::setprecision(2);
+		out.push_back(std::make_pair(top[k].second.first, ss.str()));
+	}
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+	std::vector<Frame>				frames;
+	getFrames(frames);
+
+	std::vector<std::pair<uint32_t, std::string>>
+									threads;
+	{
+		Poco::FastMutex::ScopedLock	l(mMutex);
+		for(auto& t : mThreads) threads.push_back(std::make_pair(t->mId, t->mName));
+	}
+
+	std::ofstream					out(path.c_str(), std::ios::out | std::ios::trunc);
+	if(!out.is_open()) return false;
+
+	// Timestamps are in microseconds, keep the nanoseconds as decimals
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::endl;
+	bool							first = true;
+	for(auto& t : threads) {
+		std::stringstream			name;
+		if(t.second.empty()) name << "thread " << t.first;
+		else name << t.second;
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t.first << ",\"args\":{\"name\":";
+		writeJsonString(out, name.str().c_str());
+		out << "}}";
+		first = false;
+	}
+	for(auto& f : frames) {
+		// A marker across all threads where each frame starts
+		out << (first ? "" : ",\n") << "{\"name\":\"frame " << f.mFrame << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":"
+			<< (static_cast<double>(f.mStart) / 1000.0) << "}";
+		first = false;
+		for(auto& z : f.mZones) {
+			out << ",\n{\"name\":";
+			writeJsonString(out, z.mName);
+			out << ",\"cat\":\"ds\",\"ph\":\"X\",\"pid\":1,\"tid\":" << z.mThread
+				<< ",\"ts\":" << (static_cast<double>(z.mStart) / 1000.0)
+				<< ",\"dur\":" << (static_cast<double>(z.mEnd - z.mStart) / 1000.0) << "}";
+		}
+	}
+	out << std::endl << "]}" << std::endl;
+	return out.good();
+}
+
+Profiler::ThreadLog& Profiler::getThreadLog() {
+	static thread_local ThreadLog*	LOG = nullptr;
+	if(LOG) return *LOG;
+
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	mThreads.push_back(std::unique_ptr<ThreadLog>(new ThreadLog(static_cast<uint32_t>(mThreads.size()))));
+	LOG = mThreads.back().get();
+	Poco::Thread*					thread = Poco::Thread::current();
+	if(thread) LOG->mName = thread->getName();
+	return *LOG;
+}
+
+/**
+ * \class Profiler::Frame
+ */
+Profiler::Frame::Frame() {
+	clear();
+}
+
+void Profiler::Frame::clear() {
+	mFrame = -1;
+	mStart = 0;
+	mEnd = 0;
+	// Keep the storage, it's about to be filled again
+	mZones.clear();
+}
+
+/**
+ * \class Profiler::Scope
+ */
+Profiler::Scope::Scope(const char* name)
+		: mLog(nullptr) {
+	if(Profiler::get().isEnabled()) begin(name);
+}
+
+Profiler::Scope::Scope(const char* name, const bool spriteZone)
+		: mLog(nullptr) {
+	Profiler&						p = Profiler::get();
+	if(p.isEnabled() && (!spriteZone || p.getSpriteZones())) begin(name);
+}
+
+Profiler::Scope::Scope(const std::type_info& type, const bool spriteZone)
+		: mLog(nullptr) {
+	Profiler&						p = Profiler::get();
+	if(p.isEnabled() && (!spriteZone || p.getSpriteZones())) begin(Profiler::getClassName(type));
+}
+
+Profiler::Scope::~Scope() {
+	if(!mLog) return;
+	const int64_t					end = Profiler::now();
+	mLog->mOpen.pop_back();
+
+	Zone							z;
+	z.mName = mName;
+	z.mStart = mStart;
+	z.mEnd = end;
+	z.mThread = mLog->mId;
+	z.mDepth = static_cast<uint32_t>(mLog->mOpen.size());
+	z.mNested = mNested;
+	Poco::FastMutex::ScopedLock		l(mLog->mMutex);
+	mLog->mZones.push_back(z);
+}
+
+void Profiler::Scope::begin(const char* name) {
+	mLog = &Profiler::get().getThreadLog();
+	mName = name;
+	mNested = std::find(mLog->mOpen.begin(), mLog->mOpen.end(), name) != mLog->mOpen.end();
+	mLog->mOpen.push_back(name);
+	mStart = Profiler::now();
+}
+
+/**
+ * \class Profiler::ThreadLog
+ */
+Profiler::ThreadLog::ThreadLog(const uint32_t id)
+		: mId(id) {
+	mOpen.reserve(32);
+}
+
+} // namespace ds
@@ -0,0 +1,162 @@
+#pragma once
+#ifndef DS_DEBUG_PROFILER_H_
+#define DS_DEBUG_PROFILER_H_
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+
+/**
+ * \class Profiler
+ * \brief Records where each frame goes. Code marks a block with DS_PROFILE_ZONE("name"),
+ * which notes when it started and finished and on which thread, and once a frame the
+ * engine files everything recorded into a ring of the last few hundred frames. Shown in
+ * the stats view, and written out in the Chrome trace format (load it in chrome://tracing
+ * or https://ui.perfetto.dev) for a closer look.
+ *
+ * Zone names must be string literals or otherwise live forever; only the pointer is kept.
+ * To name a zone after a class, pass a typeid() instead, e.g. DS_PROFILE_ZONE(typeid(*this)).
+ * Recording is off until the engine gives the profiler a capacity, and costs a single
+ * check per zone while it's off. Define DS_DISABLE_PROFILER to compile the zones out.
+ */
+class Profiler {
+	class ThreadLog;
+
+public:
+	/// A finished zone. Times are nanoseconds since the profiler started.
+	class Zone {
+	public:
+		const char*				mName;
+		int64_t					mStart;
+		int64_t					mEnd;
+		uint32_t				mThread;
+		/// How many zones it was inside of on its thread
+		uint32_t				mDepth;
+		/// Inside another zone of the same name, so its time is already counted there
+		bool					mNested;
+	};
+
+	class Frame {
+	public:
+		Frame();
+		void					clear();
+
+		int64_t					mFrame;
+		int64_t					mStart;
+		int64_t					mEnd;
+		std::vector<Zone>		mZones;
+	};
+
+	/// Times the enclosing block, if the profiler is recording. Use the macros below.
+	class Scope {
+	public:
+		Scope(const char* name);
+		/// Sprite zones are only recorded if turned on separately, since there can be thousands a frame.
+		Scope(const char* name, const bool spriteZone);
+		/// Named after the class. The name is only looked up while recording.
+		Scope(const std::type_info& type, const bool spriteZone = false);
+		~Scope();
+
+	private:
+		Scope(const Scope&);
+		Scope&					operator=(const Scope&);
+		void					begin(const char* name);
+
+		ThreadLog*				mLog;
+		const char*				mName;
+		int64_t					mStart;
+		bool					mNested;
+	};
+
+	static Profiler&			get();
+
+	/// How many frames to keep. 0 stops recording, which is the default.
+	void						setCapacity(const size_t);
+	bool						isEnabled() const			{ return mEnabled.load(std::memory_order_relaxed); }
+	/// Also time every sprite's update and draw, by class.
+	void						setSpriteZones(const bool on) { mSpriteZones.store(on, std::memory_order_relaxed); }
+	bool						getSpriteZones() const		{ return mSpriteZones.load(std::memory_order_relaxed); }
+
+	/// Name the calling thread in traces. Poco threads are named after the Poco::Thread.
+	void						setThreadName(const std::string&);
+
+	/// File everything recorded since the last call as one frame. Call once a frame from the
+	/// main thread, which is also how the main thread gets its name.
+	void						endFrame();
+
+	/// Nanoseconds since the profiler started.
+	static int64_t				now();
+
+	/// The class's demangled name, kept for the life of the app so zones can point at it.
+	/// Demangled once per class, then cached per thread.
+	static const char*			getClassName(const std::type_info&);
+
+	/// Every recorded frame, oldest first.
+	void						getFrames(std::vector<Frame>&) const;
+	/// The zones taking up the most time per frame, as name / value lines for the stats view.
+	void						getSummary(std::vector<std::pair<std::string, std::string>>&, const size_t maxZones = 8) const;
+	/// Every recorded frame in the Chrome trace event format. Answers false if the file couldn't be written.
+	bool						writeChromeTrace(const std::string& path) const;
+
+private:
+	Profiler();
+	Profiler(const Profiler&);
+	Profiler&					operator=(const Profiler&);
+
+	class ThreadLog {
+	public:
+		ThreadLog(const uint32_t id);
+
+		uint32_t				mId;
+		std::string				mName;
+		/// Zones still open, only touched by the owning thread
+		std::vector<const char*>
+								mOpen;
+		/// Finished zones waiting for endFrame()
+		Poco::FastMutex			mMutex;
+		std::vector<Zone>		mZones;
+	};
+
+	ThreadLog&					getThreadLog();
+
+	std::atomic<bool>			mEnabled;
+	std::atomic<bool>			mSpriteZones;
+
+	mutable Poco::FastMutex		mMutex;
+	std::vector<std::unique_ptr<ThreadLog>>
+								mThreads;
+	size_t						mCapacity;
+	std::vector<Frame>			mFrames;
+	/// Where the next frame goes, and how many are filled
+	size_t						mNext;
+	size_t						mCount;
+	int64_t						mFrameNumber;
+	int64_t						mFrameStart;
+	Frame						mPending;
+};
+
+} // namespace ds
+
+#define DS_PROFILE_CONCAT_(a, b)		a##b
+#define DS_PROFILE_CONCAT(a, b)			DS_PROFILE_CONCAT_(a, b)
+
+#ifndef DS_DISABLE_PROFILER
+	/// Time the rest of the enclosing block
+	#define DS_PROFILE_ZONE(name)			ds::Profiler::Scope DS_PROFILE_CONCAT(ds_profile_zone_, __LINE__)(name)
+	/// Same, but only when sprite zones are on
+	#define DS_PROFILE_SPRITE_ZONE(name)	ds::Profiler::Scope DS_PROFILE_CONCAT(ds_profile_zone_, __LINE__)(name, true)
+	#define DS_PROFILE_END_FRAME()			ds::Profiler::get().endFrame()
+#else
+	#define DS_PROFILE_ZONE(name)			(void)0
+	#define DS_PROFILE_SPRITE_ZONE(name)	(void)0
+	#define DS_PROFILE_END_FRAME()			(void)0
+#endif
+
+#endif // DS_DEBUG_PROFILER_H_
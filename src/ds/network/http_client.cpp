@@ -2,6 +2,7 @@
 
 #include "ds/network/http_client.h"
 
+#include <algorithm>
 #include <iostream>
 #include <Poco/Net/HTMLForm.h>
 #include <Poco/Net/HTTPClientSession.h>
@@ -92,6 +93,17 @@ void HttpClient::handleResult(std::unique_ptr<WorkRequest>& wr)
 	mCache.push(r);
 }
 
+void HttpClient::handleCancelled(std::unique_ptr<WorkRequest>& wr)
+{
+	std::unique_ptr<Request>		r(ds::unique_dynamic_cast<Request, WorkRequest>(wr));
+	if (!r) return;
+
+	r->mReply.clear();
+	r->mReply.mStatus = HttpReply::REPLY_CANCELLED;
+	if (mResultHandler) mResultHandler(r->mReply);
+	mCache.push(r);
+}
+
 bool HttpClient::sendHttp(	const int opt, const std::string &verb, const std::wstring& url, const std::string& body,
 							const std::function<void(Poco::Net::HTMLForm&)>& postFn,
 							const std::function<void(Poco::Net::HTTPRequest&)>& requestFn)
@@ -111,6 +123,7 @@ bool HttpClient::sendHttp(	const int opt, const std::string &verb, const std::ws
 	r->mPostFn = postFn;
 	r->mRequestFn = requestFn;
 	r->mReply.clear();
+	prepareRequest(*r);
 	return mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, Request>(r));
 }
 
@@ -146,9 +159,32 @@ void ds::HttpReply::clear()
 HttpClient::Request::Request(const void* clientId)
 	: WorkRequest(clientId)
 	, mOpt(HTTP_GET_OPT)
+	, mReplyHighWater(0)
 {
 }
 
+void HttpClient::Request::recycle() {
+	mReplyHighWater = std::max(mReplyHighWater, std::max(mReply.mMsg.size(), mResponse.size()));
+	// Keeps the storage
+	mReply.clear();
+	mResponse.clear();
+	// Don't hold on to whatever the callbacks captured
+	mPostFn = nullptr;
+	mRequestFn = nullptr;
+}
+
+void HttpClient::Request::trim() {
+	if (mReply.mMsg.capacity() > mReplyHighWater) {
+		std::wstring().swap(mReply.mMsg);
+		mReply.mMsg.reserve(mReplyHighWater);
+	}
+	if (mResponse.capacity() > mReplyHighWater) {
+		std::string().swap(mResponse);
+		mResponse.reserve(mReplyHighWater);
+	}
+	mReplyHighWater = 0;
+}
+
 void HttpClient::Request::run() {
 	mReply.clear();
 	const std::string						url8 = ds::utf8_from_wstr(mUrl);
@@ -219,9 +255,9 @@ std::cout << "DONE" << std::endl;
 		Poco::Net::HTTPResponse			response;
 		std::istream&					rs = s.receiveResponse(response);
 		if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-			std::string					str;
-			Poco::StreamCopier::copyToString(rs, str);
-			if (!str.empty()) mReply.mMsg = ds::wstr_from_utf8(str);
+			mResponse.clear();
+			Poco::StreamCopier::copyToString(rs, mResponse);
+			if (!mResponse.empty()) ds::wstr_from_utf8(mResponse, mReply.mMsg);
 			mReply.mStatus = ds::HttpReply::REPLY_OK;
 #ifdef _DEBUG
 //			wcout << "DBG HttpClient response OK msg=" << mReply.mMsg << endl;
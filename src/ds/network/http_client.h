@@ -23,6 +23,8 @@ public:
 	static const int		REPLY_OK = 0;
 	static const int		REPLY_UNKNOWN_ERROR = -1;
 	static const int		REPLY_CONNECTION_ERROR = -2;
+	/// The request was cancelled, or threw, before it finished.
+	static const int		REPLY_CANCELLED = -3;
 
 public:
 	std::wstring			mMsg;
@@ -65,6 +67,8 @@ public:
 
 protected:
 	virtual void					handleResult(std::unique_ptr<WorkRequest>&);
+	/// Cancelled requests go to the result handler too, as REPLY_CANCELLED.
+	virtual void					handleCancelled(std::unique_ptr<WorkRequest>&);
 
 private:
     typedef ds::WorkClient  inherited;
@@ -89,6 +93,14 @@ private:
 		ds::HttpReply				mReply;
 
 		virtual void				run();
+		virtual void				recycle();
+		virtual void				trim();
+
+	private:
+		/// The response comes in here before it's converted into the reply
+		std::string					mResponse;
+		/// The longest reply since the last trim()
+		size_t						mReplyHighWater;
 	};
 
 	ds::WorkRequestList<Request>	mCache;
@@ -0,0 +1,69 @@
+#include "stdafx.h"
+
+#include "ds/network/net_codec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "snappy.h"
+
+namespace ds {
+namespace net {
+
+Codec codecFromString(const std::string& name, const Codec fallback) {
+	std::string lower = name;
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if(lower == "none" || lower == "off" || lower == "false") return CODEC_NONE;
+	if(lower == "snappy") return CODEC_SNAPPY;
+	return fallback;
+}
+
+std::string codecToString(const Codec codec) {
+	if(codec == CODEC_NONE) return "none";
+	if(codec == CODEC_SNAPPY) return "snappy";
+	return "unknown";
+}
+
+bool isValidCodec(const int codec) {
+	return codec >= CODEC_NONE && codec < CODEC_COUNT;
+}
+
+bool encode(const Codec codec, const char* src, const size_t size, std::string& dst, const size_t dstOffset) {
+	if(dst.size() < dstOffset) {
+		dst.resize(dstOffset);
+	}
+
+	if(codec == CODEC_NONE) {
+		dst.resize(dstOffset + size);
+		if(size > 0) memcpy(&dst[dstOffset], src, size);
+		return true;
+	}
+
+	if(codec == CODEC_SNAPPY) {
+		dst.resize(dstOffset + snappy::MaxCompressedLength(size));
+		size_t compressedSize = 0;
+		snappy::RawCompress(src, size, &dst[dstOffset], &compressedSize);
+		dst.resize(dstOffset + compressedSize);
+		return true;
+	}
+
+	return false;
+}
+
+bool decode(const Codec codec, const char* src, const size_t size, std::string& dst) {
+	if(codec == CODEC_NONE) {
+		dst.assign(src, size);
+		return true;
+	}
+
+	if(codec == CODEC_SNAPPY) {
+		return snappy::Uncompress(src, size, &dst);
+	}
+
+	dst.clear();
+	return false;
+}
+
+} // namespace net
+} // namespace ds
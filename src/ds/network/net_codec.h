@@ -0,0 +1,34 @@
+#pragma once
+#ifndef DS_NETWORK_NETCODEC_H_
+#define DS_NETWORK_NETCODEC_H_
+
+#include <string>
+
+namespace ds {
+namespace net {
+
+/// How a network payload was encoded. Every payload on the wire states its codec
+/// exactly once (in the ChunkHeader for chunked sends, or as a leading byte for
+/// unchunked sends), so receivers never have to guess how many decode passes to run.
+enum Codec {
+	CODEC_NONE		= 0,
+	CODEC_SNAPPY	= 1,
+	/// Not a codec, just the number of codecs
+	CODEC_COUNT
+};
+
+/// "none" or "snappy", case insensitive. Answers the fallback if the name isn't recognized.
+Codec				codecFromString(const std::string&, const Codec fallback = CODEC_SNAPPY);
+std::string			codecToString(const Codec);
+bool				isValidCodec(const int);
+
+/// Encode size bytes of src into dst. The first dstOffset bytes of dst are preserved,
+/// so callers can reserve room for their own header in front of the payload.
+bool				encode(const Codec, const char* src, const size_t size, std::string& dst, const size_t dstOffset = 0);
+/// Decode size bytes of src into dst, replacing anything in dst.
+bool				decode(const Codec, const char* src, const size_t size, std::string& dst);
+
+} // namespace net
+} // namespace ds
+
+#endif // DS_NETWORK_NETCODEC_H_
@@ -3,6 +3,7 @@
 #define DS_NETWORK_NETCONNECTION_H
 
 #include <string>
+#include <Poco/Thread.h>
 
 namespace ds
 {
@@ -22,6 +23,9 @@ public:
 	virtual bool	sendMessage(const char *data, int size) = 0;
 
 	virtual int		recvMessage(std::string &msg) = 0;
+	/// Block until there's something to receive, or milliseconds have passed. Answer true if there's data.
+	/// Connections that can't tell just wait it out.
+	virtual bool	waitForData(const int milliseconds) { Poco::Thread::sleep(milliseconds); return false; }
 
 	virtual bool	isServer() const = 0;
 
@@ -1,9 +1,10 @@
 #include "stdafx.h"
 
 #include "packet_chunker.h"
-#include "snappy.h"
 #include <iostream>
 #include <algorithm>
+#include <cstring>
+#include "ds/debug/logger.h"
 
 namespace ds {
 namespace net {
@@ -13,14 +14,12 @@ Chunker::Chunker()
 {
 }
 
-void Chunker::Chunkify(const char *src, unsigned size, unsigned groupId, std::vector<std::string> &dst){
+void Chunker::Chunkify(const char *src, unsigned size, unsigned groupId, std::vector<std::string> &dst, const unsigned codec, const unsigned channel){
 
 	unsigned chunkSize = mChunkSize - sizeof(ChunkHeader);
 	unsigned pos = 0;
 
-	snappy::Compress(src, size, &mCompressedBuffer);
-
-	unsigned nSize = static_cast<unsigned>(mCompressedBuffer.size());
+	unsigned nSize = size;
 	unsigned numIterations = nSize / chunkSize;
 
 	unsigned excess = nSize % chunkSize;
@@ -29,14 +28,14 @@ void Chunker::Chunkify(const char *src, unsigned size, unsigned groupId, std::ve
 
 	dst.resize(total);
 
-	ChunkHeader header = { groupId, nSize, 0, total, chunkSize };
+	ChunkHeader header = { groupId, nSize, 0, total, chunkSize, codec, channel };
 
 	int i;
 	for(i = 0; i < numIterations; ++i){
 		header.mId = i;
 		dst[i].resize(sizeof(ChunkHeader) + chunkSize);
 		std::copy(reinterpret_cast<char *>(&header), reinterpret_cast<char *>(&header) + sizeof(ChunkHeader), dst[i].begin());
-		std::copy(mCompressedBuffer.begin() + pos, mCompressedBuffer.begin() + pos + chunkSize, dst[i].begin() + sizeof(ChunkHeader));
+		std::copy(src + pos, src + pos + chunkSize, dst[i].begin() + sizeof(ChunkHeader));
 		pos += chunkSize;
 	}
 
@@ -44,18 +43,39 @@ void Chunker::Chunkify(const char *src, unsigned size, unsigned groupId, std::ve
 		header.mId = i;
 		dst[i].resize(sizeof(ChunkHeader) + excess);
 		std::copy(reinterpret_cast<char *>(&header), reinterpret_cast<char *>(&header) + sizeof(ChunkHeader), dst[i].begin());
-		std::copy(mCompressedBuffer.begin() + pos, mCompressedBuffer.begin() + pos + excess, dst[i].begin() + sizeof(ChunkHeader));
+		std::copy(src + pos, src + pos + excess, dst[i].begin() + sizeof(ChunkHeader));
 		pos += chunkSize;
 	}
 }
 
-void Chunker::Chunkify(std::string src, unsigned groupId, std::vector<std::string> &dst){
-	Chunkify(src.c_str(), static_cast<unsigned>(src.size()), groupId, dst);
+void Chunker::Chunkify(const std::string& src, unsigned groupId, std::vector<std::string> &dst, const unsigned codec, const unsigned channel){
+	Chunkify(src.c_str(), static_cast<unsigned>(src.size()), groupId, dst, codec, channel);
+}
+
+bool Chunker::getChannel(const char *chunk, unsigned size, unsigned &channel){
+	if(size < sizeof(ChunkHeader)){
+		return false;
+	}
+
+	ChunkHeader chunkHeader;
+	memcpy(reinterpret_cast<char *>(&chunkHeader), chunk, sizeof(ChunkHeader));
+	channel = chunkHeader.mChannel;
+	return true;
 }
 
 
-DeChunker::DeChunker(){
-	mMaxReceivedSize = 1000;
+DeChunker::DeChunker(const bool ordered)
+	: mNextGroupId(0)
+	, mHighestGroupId(0)
+	, mOrdered(ordered)
+	, mStarted(false)
+	, mHandedBack(false)
+	, mUnrecoverable(false)
+	, mMaxReceivedSize(1000)
+	, mNackInterval(6)
+	, mMaxNacks(4)
+	, mMaxPendingGroups(90)
+{
 }
 
 bool DeChunker::addChunk(std::string &chunk){
@@ -70,15 +90,41 @@ bool DeChunker::addChunk(const char *chunk, unsigned size){
 	ChunkHeader chunkHeader;
 	memcpy(reinterpret_cast<char *>(&chunkHeader), chunk, sizeof(ChunkHeader));
 
+	if(chunkHeader.mTotal < 1 || chunkHeader.mId >= chunkHeader.mTotal || chunkHeader.mChunkSize < 1){
+		return false;
+	}
+
 	if(chunkHeader.mId == 0 && chunkHeader.mGroupId == 0){
 		clearReceived();
 	}
 
-	if(std::find(mReceived.begin(), mReceived.end(), chunkHeader.mGroupId) != mReceived.end()
-	   && std::find(mGroupsReceived.begin(), mGroupsReceived.end(), chunkHeader.mGroupId) == mGroupsReceived.end()){
+	if(!mOrdered){
+		return addUnorderedChunk(chunkHeader, chunk, size);
+	}
+
+	if(!mStarted){
+		mStarted = true;
+		mNextGroupId = chunkHeader.mGroupId;
+		mHighestGroupId = chunkHeader.mGroupId;
+	}
+
+	// Way behind what we've already handed back means the sender started over
+	if(chunkHeader.mGroupId + mMaxReceivedSize < mNextGroupId){
+		clearReceived();
+		mStarted = true;
+		mNextGroupId = chunkHeader.mGroupId;
+		mHighestGroupId = chunkHeader.mGroupId;
+	}
+
+	// Already handed back (or given up on), so this is a retransmit someone else asked for
+	if(chunkHeader.mGroupId < mNextGroupId){
 		return false;
 	}
 
+	if(chunkHeader.mGroupId > mHighestGroupId){
+		mHighestGroupId = chunkHeader.mGroupId;
+	}
+
 	auto found = mDataChunks.find(chunkHeader.mGroupId);
 
 	auto &stats = mDataChunks[chunkHeader.mGroupId];
@@ -99,33 +145,12 @@ bool DeChunker::addChunk(const char *chunk, unsigned size){
 			stats.mData.get()->resize(chunkHeader.mSize);
 		}
 
-		mGroupsReceived.push_back(chunkHeader.mGroupId);
-		mReceived.push_back(chunkHeader.mGroupId);
-
-		while(mReceived.size() > mMaxReceivedSize){
-			mReceived.pop_front();
-		}
-
-		std::sort(mGroupsReceived.begin(), mGroupsReceived.end(), [](unsigned a, unsigned b) -> bool {
-			if(a > b)
-				return true;
-			return false;
-		});
+		stats.mCodec = chunkHeader.mCodec;
 	}
 
 	addChunkToGroup(stats, chunk, size);
 
-	if(stats.mIdsMissing.empty()){
-		mGroupsAvailable.push_back(chunkHeader.mGroupId);
-		std::sort(mGroupsAvailable.begin(), mGroupsAvailable.end(), [](unsigned a, unsigned b) -> bool {
-			if(a > b){
-				return true;
-			}
-			return false;
-		});
-		return true;
-	}
-	return false;
+	return stats.mIdsMissing.empty();
 }
 
 void DeChunker::addChunkToGroup(DeChunkStats &stats, const char *chunk, unsigned size){
@@ -136,49 +161,196 @@ void DeChunker::addChunkToGroup(DeChunkStats &stats, const char *chunk, unsigned
 	if(found == stats.mIdsMissing.end())
 		return;
 
-	unsigned nSize = chunkHeader.mSize / chunkHeader.mChunkSize;
 	unsigned pos = chunkHeader.mId * chunkHeader.mChunkSize;
 
 	if(stats.mData.get()){
+		if(pos + (size - sizeof(ChunkHeader)) > stats.mData.get()->size()){
+			return;
+		}
 		std::copy(chunk + sizeof(ChunkHeader), chunk + size, stats.mData.get()->begin() + pos);
 	}
-	stats.mIdsMissing.remove(chunkHeader.mId);
+	stats.mIdsMissing.erase(found);
 }
 
-bool DeChunker::getNextGroup(std::string &dst){
-	if(!mGroupsAvailable.empty() && !mGroupsReceived.empty())	{
+bool DeChunker::addUnorderedChunk(const ChunkHeader &chunkHeader, const char *chunk, unsigned size){
+	auto found = mDataChunks.find(chunkHeader.mGroupId);
+	auto &stats = mDataChunks[chunkHeader.mGroupId];
+	if(found == mDataChunks.end()){
+		for(unsigned i = 0; i < chunkHeader.mTotal; ++i){
+			stats.mIdsMissing.push_back(i);
+		}
 
-		unsigned groupId = mGroupsAvailable.back();
-		
-		auto gr = std::find(mGroupsReceived.begin(), mGroupsReceived.end(), groupId);
-		if(gr != mGroupsReceived.end()){
-			mGroupsAvailable.pop_back();
-			mGroupsReceived.erase(gr);
+		if(!mReserveStrings.empty()) {
+			stats.mData = std::move(mReserveStrings.back());
+			mReserveStrings.pop_back();
+		} else {
+			stats.mData = std::unique_ptr<std::string>(new std::string);
+		}
 
-			if(mDataChunks[groupId].mData.get()){
-				snappy::Uncompress(mDataChunks[groupId].mData.get()->c_str(), mDataChunks[groupId].mData.get()->size(), &dst);
-			}
+		stats.mData.get()->resize(chunkHeader.mSize);
+		stats.mCodec = chunkHeader.mCodec;
+	}
 
-			mReserveStrings.push_back(std::move(mDataChunks[groupId].mData));
-			mDataChunks.erase(groupId);
+	addChunkToGroup(stats, chunk, size);
 
+	if(!stats.mIdsMissing.empty()){
+		return false;
+	}
+
+	// Nobody is going to fill in older groups that never finished, so drop them
+	for(auto it = mDataChunks.begin(); it != mDataChunks.end() && it->first < chunkHeader.mGroupId;){
+		if(it->second.mIdsMissing.empty()){
+			++it;
+			continue;
+		}
+		if(it->second.mData) mReserveStrings.push_back(std::move(it->second.mData));
+		it = mDataChunks.erase(it);
+	}
+	return true;
+}
+
+bool DeChunker::isComplete(const unsigned groupId) const {
+	auto found = mDataChunks.find(groupId);
+	return found != mDataChunks.end() && found->second.mIdsMissing.empty();
+}
+
+size_t DeChunker::getAvailable() const {
+	if(!mOrdered){
+		size_t available = 0;
+		for(auto& it : mDataChunks){
+			if(it.second.mIdsMissing.empty()) ++available;
+		}
+		return available;
+	}
+
+	if(!mStarted) return 0;
+
+	size_t available = 0;
+	while(isComplete(mNextGroupId + static_cast<unsigned>(available))){
+		++available;
+	}
+	return available;
+}
+
+bool DeChunker::getNextGroup(std::string &dst, unsigned &codec){
+	if(!mOrdered){
+		for(auto it = mDataChunks.begin(); it != mDataChunks.end(); ++it){
+			if(!it->second.mIdsMissing.empty()) continue;
+
+			codec = it->second.mCodec;
+			if(it->second.mData.get()){
+				dst.swap(*it->second.mData.get());
+			}
+			mReserveStrings.push_back(std::move(it->second.mData));
+			mDataChunks.erase(it);
 			return true;
-		} else {
-			std::cout << "Big trubs with mismatched lists!" << std::endl;
+		}
+		return false;
+	}
+
+	if(!mStarted || !isComplete(mNextGroupId)){
+		DS_LOG_VERBOSE(4, "DeChunker: group " << mNextGroupId << " isn't complete yet");
+		return false;
+	}
+
+	auto& stats = mDataChunks[mNextGroupId];
+	codec = stats.mCodec;
+	if(stats.mData.get()){
+		dst.swap(*stats.mData.get());
+	}
+
+	mReserveStrings.push_back(std::move(stats.mData));
+	mDataChunks.erase(mNextGroupId);
+	auto nack = mNacks.find(mNextGroupId);
+	if(nack != mNacks.end()){
+		if(nack->second.mRequests > 0) mLossCounts.mGroupsRecovered++;
+		mNacks.erase(nack);
+	}
+	++mNextGroupId;
+	mHandedBack = true;
+	// Something got through, so whatever was lost may have been recovered after all
+	mUnrecoverable = false;
+
+	return true;
+}
+
+void DeChunker::getMissing(std::vector<MissingGroup> &dst){
+	dst.clear();
+	if(!mOrdered || !mStarted || mUnrecoverable) return;
+
+	// Everything from the next group up to the newest one we've heard of should be here.
+	// The newest group can be missing its tail, so it's included too; it'll just age a pass first.
+	if(mHighestGroupId >= mNextGroupId && mHighestGroupId - mNextGroupId > mMaxPendingGroups){
+		mUnrecoverable = true;
+		return;
+	}
+
+	for(unsigned groupId = mNextGroupId; groupId <= mHighestGroupId; ++groupId){
+		if(isComplete(groupId)) continue;
+
+		auto& nack = mNacks[groupId];
+		nack.mPasses++;
+		if(nack.mRequests > 0 && nack.mPasses < mNackInterval) continue;
+		if(nack.mRequests == 0 && nack.mPasses < 2) continue;
+
+		if(nack.mRequests >= mMaxNacks){
+			mUnrecoverable = true;
+			dst.clear();
+			return;
 		}
 
+		if(nack.mRequests == 0) mLossCounts.mGroupsLost++;
+		nack.mPasses = 0;
+		nack.mRequests++;
+
+		MissingGroup missing;
+		missing.mGroupId = groupId;
+		auto found = mDataChunks.find(groupId);
+		if(found != mDataChunks.end()){
+			missing.mIds.assign(found->second.mIdsMissing.begin(), found->second.mIdsMissing.end());
+		}
+		mLossCounts.mChunksRequested += std::max(static_cast<unsigned>(missing.mIds.size()), 1u);
+		dst.push_back(missing);
 	}
+}
 
-	std::cout << "get next group is borking: " << mGroupsAvailable.empty() << " " << mGroupsReceived.empty() << std::endl;
+unsigned DeChunker::getPendingGroups() const {
+	if(!mOrdered || !mStarted || mHighestGroupId < mNextGroupId) return 0;
+	return mHighestGroupId - mNextGroupId + 1;
+}
 
-	return false;
+void DeChunker::resumeAt(const unsigned groupId){
+	mNacks.clear();
+	mUnrecoverable = false;
+	if(mStarted && mHandedBack && groupId <= mNextGroupId){
+		return;
+	}
+
+	for(auto it = mDataChunks.begin(); it != mDataChunks.end();){
+		if(it->first >= groupId) break;
+		if(it->second.mData) mReserveStrings.push_back(std::move(it->second.mData));
+		it = mDataChunks.erase(it);
+	}
+
+	mStarted = true;
+	mHandedBack = false;
+	mNextGroupId = groupId;
+	if(mHighestGroupId < groupId){
+		mHighestGroupId = groupId;
+	}
 }
 
 void DeChunker::clearReceived(){
-	mReceived.clear();
+	for(auto& it : mDataChunks){
+		if(it.second.mData) mReserveStrings.push_back(std::move(it.second.mData));
+	}
 	mDataChunks.clear();
-	mGroupsAvailable.clear();
-	mGroupsReceived.clear();
+	mNacks.clear();
+	mStarted = false;
+	mHandedBack = false;
+	mUnrecoverable = false;
+	mNextGroupId = 0;
+	mHighestGroupId = 0;
 }
 
 }
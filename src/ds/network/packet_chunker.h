@@ -17,6 +17,12 @@ struct ChunkHeader {
 	unsigned mId;
 	unsigned mTotal;
 	unsigned mChunkSize;
+	/// The ds::net::Codec the group payload was encoded with. The chunker never
+	/// encodes anything itself, it just records what the sender already did.
+	unsigned mCodec;
+	/// Which stream the group belongs to. Each channel has its own group ids, so a receiver
+	/// listening to more than one sender on the same socket can keep them apart.
+	unsigned mChannel;
 };
 
 /// Chunker splits packets up into byte-sized pieces. HA! Wordplay!
@@ -24,44 +30,107 @@ class Chunker {
 
 public:
 	Chunker();
-	void Chunkify(const char *src, unsigned size, unsigned groupId, std::vector<std::string> &dst);
-	void Chunkify(std::string src, unsigned groupId, std::vector<std::string> &dst);
+	void Chunkify(const char *src, unsigned size, unsigned groupId, std::vector<std::string> &dst, const unsigned codec = 0, const unsigned channel = 0);
+	void Chunkify(const std::string& src, unsigned groupId, std::vector<std::string> &dst, const unsigned codec = 0, const unsigned channel = 0);
+
+	/// Answer the channel of a chunk, or false if it's too small to be one.
+	static bool getChannel(const char *chunk, unsigned size, unsigned &channel);
 
 private:
 	unsigned mChunkSize;
-	std::string mCompressedBuffer;
 };
 
-/// DeChunker recombines the pieces into a single unit
+/// DeChunker recombines the pieces into a single unit.
+/// By default groups are handed back strictly in group id order. If a chunk goes missing, later groups
+/// are held until it's recovered (see getMissing()), or until the loss is declared unrecoverable.
+/// Unordered dechunkers hand back complete groups as they arrive, and never ask for anything.
 class DeChunker {
 public:
-	DeChunker();
+	/// A group that can't be delivered yet. An empty mIds means none of the group has arrived.
+	struct MissingGroup {
+		unsigned				mGroupId;
+		std::vector<unsigned>	mIds;
+	};
+
+	DeChunker(const bool ordered = true);
 	bool addChunk(const char *chunk, unsigned size);
 	bool addChunk(std::string &chunk);
-	bool getNextGroup(std::string &dst);
+	/// Hands back the payload exactly as it was chunked, along with the codec it was encoded with.
+	bool getNextGroup(std::string &dst, unsigned &codec);
 	void clearReceived();
-	size_t getAvailable() { return mGroupsAvailable.size(); }
+	/// The number of groups that can be handed back in order right now.
+	size_t getAvailable() const;
+
+	/// Answers the groups that are holding up delivery. Meant to be called once per receive pass:
+	/// each call ages the pending groups so they're only re-requested every few passes.
+	void getMissing(std::vector<MissingGroup> &dst);
+	/// True once a missing group has been requested too many times, or too many groups are waiting behind it.
+	/// Call clearReceived() to start over (and get the whole world resent).
+	bool hasUnrecoverableLoss() const { return mUnrecoverable; }
+
+	/// Pick up again at groupId, for instance after a keyframe told us where the stream continues.
+	/// Anything older is thrown away and anything newer is kept. Missing groups get a fresh set of requests.
+	/// Never moves backwards once something has been handed back.
+	void resumeAt(const unsigned groupId);
+	/// The next group that will be handed back from an ordered dechunker.
+	unsigned getNextGroupId() const { return mNextGroupId; }
+	/// How many groups have been heard of but not handed back yet.
+	unsigned getPendingGroups() const;
+
+	/// Running totals since the dechunker was made: groups that had to be asked for, how many of
+	/// those were handed back in the end, and how many chunk requests went out (a whole group counts as one).
+	struct LossCounts {
+		LossCounts() : mGroupsLost(0), mGroupsRecovered(0), mChunksRequested(0) {}
+		unsigned mGroupsLost;
+		unsigned mGroupsRecovered;
+		unsigned mChunksRequested;
+	};
+	const LossCounts& getLossCounts() const { return mLossCounts; }
 
 private:
 	struct DeChunkStats	{
-		DeChunkStats(){}
+		DeChunkStats() : mCodec(0) {}
 		DeChunkStats(DeChunkStats &&rhs)		{
 			mData = std::move(rhs.mData);
 			mIdsMissing = rhs.mIdsMissing;
+			mCodec = rhs.mCodec;
 		}
 
 		std::list<unsigned> mIdsMissing;
+		unsigned mCodec;
 		std::unique_ptr<std::string> mData;
 	};
 
+	/// How long a group has been holding things up, and how often it's been requested.
+	struct NackState {
+		NackState() : mPasses(0), mRequests(0) {}
+		int mPasses;
+		int mRequests;
+	};
+
 	void addChunkToGroup(DeChunkStats &stats, const char *chunk, unsigned size);
+	bool addUnorderedChunk(const ChunkHeader &chunkHeader, const char *chunk, unsigned size);
+	bool isComplete(const unsigned groupId) const;
 
 	std::map<unsigned, DeChunkStats>				mDataChunks;
-	std::vector<unsigned>							mGroupsAvailable;
-	std::vector<unsigned>							mGroupsReceived;
-	std::list<unsigned>							mReceived;
+	std::map<unsigned, NackState>					mNacks;
+	/// The next group to hand back. Anything before this has been delivered or given up on.
+	unsigned										mNextGroupId;
+	unsigned										mHighestGroupId;
+	bool											mOrdered;
+	bool											mStarted;
+	/// True once a group has been handed back since starting
+	bool											mHandedBack;
+	bool											mUnrecoverable;
+	/// If a group shows up this far behind the next expected, the sender restarted.
 	unsigned										mMaxReceivedSize;
+	/// Receive passes before a missing group is requested again, how many requests before giving up,
+	/// and how many groups can wait behind a missing one.
+	int												mNackInterval;
+	int												mMaxNacks;
+	unsigned										mMaxPendingGroups;
 	std::vector<std::unique_ptr<std::string>>	mReserveStrings;
+	LossCounts										mLossCounts;
 };
 
 }
@@ -0,0 +1,236 @@
+#include "stdafx.h"
+
+#include "ds/network/replication_stats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace ds {
+namespace net {
+
+namespace {
+size_t blobIndex(const char blob) {
+	return static_cast<size_t>(static_cast<unsigned char>(blob));
+}
+}
+
+/**
+ * \class ReplicationStats
+ */
+ReplicationStats::ReplicationStats()
+		: mCapacity(0)
+		, mNext(0)
+		, mCount(0)
+		, mDecodedBytes(0)
+		, mDecodedChunks(0)
+		, mDecodeSeconds(0.0) {
+}
+
+void ReplicationStats::setCapacity(const size_t capacity) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	mCapacity = capacity;
+	mFrames.clear();
+	mFrames.resize(capacity);
+	mNext = 0;
+	mCount = 0;
+	mPending.clear();
+}
+
+void ReplicationStats::nameBlob(const char blob, const std::string& name) {
+	const size_t		index = blobIndex(blob);
+	if(index >= mBlobNames.size()) mBlobNames.resize(index + 1);
+	mBlobNames[index] = name;
+}
+
+std::string ReplicationStats::getBlobName(const char blob) const {
+	const size_t		index = blobIndex(blob);
+	if(index < mBlobNames.size() && !mBlobNames[index].empty()) return mBlobNames[index];
+
+	std::stringstream	ss;
+	ss << "blob " << index;
+	return ss.str();
+}
+
+void ReplicationStats::addBlobBytes(const char blob, const unsigned bytes) {
+	const size_t		index = blobIndex(blob);
+	if(index >= mPending.mBlobBytes.size()) mPending.mBlobBytes.resize(index + 1, 0);
+	mPending.mBlobBytes[index] += bytes;
+}
+
+void ReplicationStats::commitFrame() {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	if(mCapacity < 1) return;
+
+	mPending.mTime = getTime();
+	if(mDecodedChunks > 0 || mDecodedBytes > 0) {
+		mPending.mEncodedBytes = mDecodedBytes;
+		mPending.mChunks = mDecodedChunks;
+		mPending.mCodecSeconds = mDecodeSeconds;
+		mDecodedBytes = 0;
+		mDecodedChunks = 0;
+		mDecodeSeconds = 0.0;
+	}
+
+	// Trade with the slot being overwritten, so the blob counts keep their storage
+	std::swap(mFrames[mNext], mPending);
+	mNext = (mNext + 1) % mCapacity;
+	if(mCount < mCapacity) ++mCount;
+	mPending.clear();
+}
+
+void ReplicationStats::addEncodeResult(const unsigned channel, const unsigned packetId, const unsigned encodedBytes, const unsigned chunks, const double seconds) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	// The frame was almost always committed just before, so look from the newest back
+	for(size_t k = 0; k < mCount; ++k) {
+		Frame&		f = mFrames[(mNext + mCapacity - 1 - k) % mCapacity];
+		if(f.mPacketId != packetId || f.mChannel != channel) continue;
+		f.mEncodedBytes = encodedBytes;
+		f.mChunks = chunks;
+		f.mCodecSeconds = seconds;
+		return;
+	}
+}
+
+void ReplicationStats::addDecodeResult(const unsigned encodedBytes, const unsigned chunks, const double seconds) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	if(mCapacity < 1) return;
+	mDecodedBytes += encodedBytes;
+	mDecodedChunks += chunks;
+	mDecodeSeconds += seconds;
+}
+
+double ReplicationStats::getTime() const {
+	return static_cast<double>(mStart.elapsed()) / 1000000.0;
+}
+
+int64_t ReplicationStats::getEpochMicroseconds() {
+	return static_cast<int64_t>(Poco::Timestamp().epochMicroseconds());
+}
+
+void ReplicationStats::getFrames(std::vector<Frame>& out) const {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	out.clear();
+	out.reserve(mCount);
+	for(size_t k = 0; k < mCount; ++k) {
+		out.push_back(mFrames[(mNext + mCapacity - mCount + k) % mCapacity]);
+	}
+}
+
+void ReplicationStats::getSummary(std::vector<std::pair<std::string, std::string>>& out) const {
+	std::vector<Frame>		frames;
+	getFrames(frames);
+	if(frames.empty()) return;
+
+	double					raw = 0.0, encoded = 0.0, chunks = 0.0, codec = 0.0, apply = 0.0, latency = 0.0;
+	size_t					latencyCount = 0;
+	unsigned				requested = 0, lost = 0, recovered = 0;
+	std::vector<double>		blobs;
+	for(auto& f : frames) {
+		raw += f.mRawBytes;
+		encoded += f.mEncodedBytes;
+		chunks += f.mChunks;
+		codec += f.mCodecSeconds;
+		apply += f.mApplySeconds;
+		if(f.mLatencySeconds >= 0.0) {
+			latency += f.mLatencySeconds;
+			++latencyCount;
+		}
+		requested += f.mChunksRequested;
+		lost += f.mGroupsLost;
+		recovered += f.mGroupsRecovered;
+		if(f.mBlobBytes.size() > blobs.size()) blobs.resize(f.mBlobBytes.size(), 0.0);
+		for(size_t b = 0; b < f.mBlobBytes.size(); ++b) blobs[b] += f.mBlobBytes[b];
+	}
+	const double			n = static_cast<double>(frames.size());
+
+	std::stringstream		ss;
+	ss << static_cast<int>(raw / n) << " B raw, " << static_cast<int>(encoded / n) << " B sent";
+	if(raw > 0.0 && encoded > 0.0) ss << " (" << static_cast<int>(100.0 * encoded / raw) << "%)";
+	ss << ", " << (chunks / n) << " chunks";
+	out.push_back(std::make_pair("Avg Frame", ss.str()));
+
+	ss.str("");
+	ss << "codec " << static_cast<int>(codec * 1000000.0 / n) << "us";
+	if(apply > 0.0) ss << ", apply " << static_cast<int>(apply * 1000000.0 / n) << "us";
+	if(latencyCount > 0) ss << ", latency " << static_cast<int>(latency * 1000.0 / static_cast<double>(latencyCount)) << "ms";
+	out.push_back(std::make_pair("Avg Timing", ss.str()));
+
+	if(requested > 0 || lost > 0) {
+		ss.str("");
+		ss << requested << " chunks requested, " << lost << " groups lost, " << recovered << " recovered";
+		out.push_back(std::make_pair("Loss", ss.str()));
+	}
+
+	// The few blob types taking up the most room
+	std::vector<std::pair<double, size_t>>	top;
+	for(size_t b = 0; b < blobs.size(); ++b) {
+		if(blobs[b] > 0.0) top.push_back(std::make_pair(blobs[b], b));
+	}
+	std::sort(top.begin(), top.end(), [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first > b.first; });
+	ss.str("");
+	for(size_t k = 0; k < top.size() && k < 3; ++k) {
+		if(k > 0) ss << ", ";
+		ss << getBlobName(static_cast<char>(top[k].second)) << " " << static_cast<int>(top[k].first / n) << " B";
+	}
+	if(!top.empty()) out.push_back(std::make_pair("Avg Blobs", ss.str()));
+}
+
+bool ReplicationStats::writeTo(const std::string& path) const {
+	std::vector<Frame>		frames;
+	getFrames(frames);
+
+	size_t					numBlobs = 0;
+	for(auto& f : frames) numBlobs = std::max(numBlobs, f.mBlobBytes.size());
+
+	std::ofstream			out(path.c_str(), std::ios::out | std::ios::trunc);
+	if(!out.is_open()) return false;
+
+	out << "time,frame,channel,packet,raw_bytes,encoded_bytes,chunks,codec_us,apply_us,latency_ms,chunks_requested,groups_lost,groups_recovered";
+	for(size_t b = 0; b < numBlobs; ++b) {
+		std::string			name = getBlobName(static_cast<char>(b));
+		std::replace(name.begin(), name.end(), ',', ';');
+		out << "," << name;
+	}
+	out << std::endl;
+
+	for(auto& f : frames) {
+		out << f.mTime << "," << f.mFrame << "," << f.mChannel << "," << f.mPacketId << "," << f.mRawBytes << "," << f.mEncodedBytes << "," << f.mChunks
+			<< "," << (f.mCodecSeconds * 1000000.0) << "," << (f.mApplySeconds * 1000000.0)
+			<< "," << (f.mLatencySeconds >= 0.0 ? f.mLatencySeconds * 1000.0 : -1.0)
+			<< "," << f.mChunksRequested << "," << f.mGroupsLost << "," << f.mGroupsRecovered;
+		for(size_t b = 0; b < numBlobs; ++b) {
+			out << "," << (b < f.mBlobBytes.size() ? f.mBlobBytes[b] : 0);
+		}
+		out << std::endl;
+	}
+	return out.good();
+}
+
+/**
+ * \class ReplicationStats::Frame
+ */
+ReplicationStats::Frame::Frame() {
+	clear();
+}
+
+void ReplicationStats::Frame::clear() {
+	mFrame = -1;
+	mPacketId = 0;
+	mChannel = 0;
+	mTime = 0.0;
+	mRawBytes = 0;
+	mEncodedBytes = 0;
+	mChunks = 0;
+	mCodecSeconds = 0.0;
+	mApplySeconds = 0.0;
+	mLatencySeconds = -1.0;
+	mChunksRequested = 0;
+	mGroupsLost = 0;
+	mGroupsRecovered = 0;
+	// Keep the storage, it's about to be filled again
+	std::fill(mBlobBytes.begin(), mBlobBytes.end(), 0);
+}
+
+} // namespace net
+} // namespace ds
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef DS_NETWORK_REPLICATIONSTATS_H_
+#define DS_NETWORK_REPLICATIONSTATS_H_
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+namespace net {
+
+/**
+ * \class ReplicationStats
+ * \brief A ring of the last few hundred frames a server sent or a client applied, with where
+ * the bytes went, how well they compressed, how long encoding and decoding took, what got
+ * lost on the way and how late frames were applied. Shown in the stats view, and dumped as
+ * CSV for sizing a network offline.
+ *
+ * Frames are built up on the main thread, and encode and decode timings come in from the
+ * send and receive threads, so anything that isn't main-thread only locks.
+ */
+class ReplicationStats {
+public:
+	class Frame {
+	public:
+		Frame();
+		void					clear();
+
+		/// The server frame number, or -1 for anything outside the sequence (worlds, keyframes, replies)
+		int32_t					mFrame;
+		/// The chunk group the frame went out as, and on which channel. Only known on the server.
+		unsigned				mPacketId;
+		unsigned				mChannel;
+		/// Seconds since recording started, when the frame was sent or applied
+		double					mTime;
+		/// Before encoding, and on the wire
+		unsigned				mRawBytes;
+		unsigned				mEncodedBytes;
+		unsigned				mChunks;
+		/// Server: encoding and chunking this frame. Client: decoding everything since the last frame applied.
+		double					mCodecSeconds;
+		/// Client: handling every blob in the frame.
+		double					mApplySeconds;
+		/// Client: from the server stamping the frame to it being applied. Only meaningful if the clocks are synced.
+		double					mLatencySeconds;
+		/// Server: chunks resent on request. Client: chunks asked for again.
+		unsigned				mChunksRequested;
+		/// Client: chunk groups that had to be asked for, and how many of those then showed up.
+		unsigned				mGroupsLost;
+		unsigned				mGroupsRecovered;
+		/// Bytes per blob type, indexed by BlobRegistry id. Sprite blobs are one per installed sprite
+		/// class, so subclasses that don't install their own count under the class they inherit it from.
+		std::vector<unsigned>	mBlobBytes;
+	};
+
+	ReplicationStats();
+
+	/// How many frames to keep. 0 stops recording, which is the default.
+	void						setCapacity(const size_t);
+	bool						isEnabled() const { return mCapacity > 0; }
+
+	/// Blob ids mean nothing offline, so each one gets the readable name it was registered under.
+	void						nameBlob(const char blob, const std::string& name);
+	std::string					getBlobName(const char blob) const;
+
+	/// The frame being built or handled right now. Main thread only.
+	Frame&						getPending() { return mPending; }
+	void						addBlobBytes(const char blob, const unsigned bytes);
+	/// Stamp the pending frame, file it and start a new one.
+	void						commitFrame();
+
+	/// From the send thread, matched up with the frame sent as packetId on channel.
+	void						addEncodeResult(const unsigned channel, const unsigned packetId, const unsigned encodedBytes, const unsigned chunks, const double seconds);
+	/// From the receive thread, added to the next frame committed.
+	void						addDecodeResult(const unsigned encodedBytes, const unsigned chunks, const double seconds);
+	/// Seconds since recording started, for stamping frames.
+	double						getTime() const;
+	/// Microseconds since the epoch, which is what servers stamp their frames with.
+	static int64_t				getEpochMicroseconds();
+
+	/// Every recorded frame, oldest first.
+	void						getFrames(std::vector<Frame>&) const;
+	/// Averages over the recorded frames, as name / value lines for the stats view.
+	void						getSummary(std::vector<std::pair<std::string, std::string>>&) const;
+	/// Every recorded frame as CSV, one row per frame and one column per blob type. Answers false if the file couldn't be written.
+	bool						writeTo(const std::string& path) const;
+
+private:
+	ReplicationStats(const ReplicationStats&);
+	ReplicationStats&			operator=(const ReplicationStats&);
+
+	mutable Poco::FastMutex		mMutex;
+	size_t						mCapacity;
+	std::vector<Frame>			mFrames;
+	/// Where the next frame goes, and how many are filled
+	size_t						mNext;
+	size_t						mCount;
+	Frame						mPending;
+	/// Decoding done since the last commit
+	unsigned					mDecodedBytes;
+	unsigned					mDecodedChunks;
+	double						mDecodeSeconds;
+	std::vector<std::string>	mBlobNames;
+	Poco::Timestamp				mStart;
+};
+
+} // namespace net
+} // namespace ds
+
+#endif // DS_NETWORK_REPLICATIONSTATS_H_
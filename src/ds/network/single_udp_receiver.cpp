@@ -183,6 +183,21 @@ bool UdpReceiver::canRecv() const{
 	return false;
 }
 
+bool UdpReceiver::waitForData(const int milliseconds){
+	if(!mInitialized){
+		Poco::Thread::sleep(milliseconds);
+		return false;
+	}
+
+	try	{
+		return mSocket.poll(Poco::Timespan(static_cast<long>(milliseconds) * 1000), Poco::Net::Socket::SELECT_READ);
+	} catch(std::exception &e){
+		std::cout << e.what() << std::endl;
+	}
+
+	return false;
+}
+
 bool UdpReceiver::initialized() const {
 	return mInitialized;
 }
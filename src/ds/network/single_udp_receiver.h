@@ -35,6 +35,7 @@ public:
 
 	/// Answer true if I have more data to receive, false otherwise.
 	bool canRecv() const;
+	virtual bool waitForData(const int milliseconds) override;
 
 	bool initialized() const;
 	bool isConnected() const { return mConnected; }
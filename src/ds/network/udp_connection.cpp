@@ -169,6 +169,23 @@ bool UdpConnection::canRecv() const{
 	return false;
 }
 
+bool UdpConnection::waitForData(const int milliseconds){
+	if(!mInitialized){
+		Poco::Thread::sleep(milliseconds);
+		return false;
+	}
+
+	try{
+		return mSocket.poll(Poco::Timespan(static_cast<long>(milliseconds) * 1000), Poco::Net::Socket::SELECT_READ);
+	} catch(Poco::Net::NetException &e)	{
+		DS_LOG_WARNING("UdpConnection::waitForData() error " << e.message());
+	} catch(std::exception &e)	{
+		DS_LOG_WARNING("UdpConnection::waitForData() std::exception: " << e.what());
+	}
+
+	return false;
+}
+
 bool UdpConnection::isServer() const{
 	return mServer;
 }
@@ -178,15 +195,11 @@ bool UdpConnection::initialized() const{
 }
 
 int UdpConnection::getReceivedBytes(){
-	int returnAmount = mReccBytes;
-	mReccBytes = 0;
-	return returnAmount;
+	return mReccBytes.exchange(0);
 }
 
 int UdpConnection::getSentBytes(){
-	int returnAmount = mSentBytes;
-	mSentBytes = 0;
-	return returnAmount;
+	return mSentBytes.exchange(0);
 }
 
 }
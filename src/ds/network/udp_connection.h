@@ -2,6 +2,7 @@
 #ifndef DS_NETWORK_UDPCONNECTION_H
 #define DS_NETWORK_UDPCONNECTION_H
 
+#include <atomic>
 #include <memory>
 #include <Poco/Net/MulticastSocket.h>
 #include "ds/query/recycle_array.h"
@@ -28,6 +29,7 @@ public:
 	int recvMessage(std::string &msg);
 	/// Answer true if I have more data to receive, false otherwise.
 	bool canRecv() const;
+	bool waitForData(const int milliseconds);
 
 	bool isServer() const;
 
@@ -39,8 +41,9 @@ public:
 
 private:
 	Poco::Net::MulticastSocket	mSocket;
-	int							mSentBytes;
-	int							mReccBytes;
+	/// Counted on whichever thread sends or receives, collected on the main thread
+	std::atomic<int>			mSentBytes;
+	std::atomic<int>			mReccBytes;
 	bool						mInitialized;
 	int							mReceiveBufferMaxSize;
 	RecycleArray<char>			mReceiveBuffer;
@@ -2,18 +2,25 @@
 
 #include "ds/query/query_client.h"
 
+#include <algorithm>
 #include "ds/debug/debug_defines.h"
 #include "ds/util/memory_ds.h"
 #include "ds/thread/work_manager.h"
-#include "ds/query/sql_database.h"
+#include "ds/query/sql_connection_pool.h"
 #include "ds/query/sql_query_result_builder.h"
 
-static bool run_query(ds::query::SqlDatabase& db,  const std::string& select, ds::query::Result& qr, const int flags = 0)
+static bool run_query(ds::query::SqlDatabase& db,  const std::string& select, const std::vector<ds::query::Param>& params,
+					  ds::query::Result& qr, const int flags = 0)
 {
 	qr.clear();
 	if (select.empty()) return false;
 
-	ds::query::SqlResultBuilder		qrb(qr, db.rawSelect(select));
+	sqlite3_stmt*					statement = db.acquire(select);
+	if (!ds::query::SqlDatabase::bind(statement, params)) {
+		db.release(statement);
+		return false;
+	}
+	ds::query::SqlResultBuilder		qrb(qr, statement, &db);
 	qrb.build((flags&ds::query::Client::INCLUDE_COLUMN_NAMES_F) != 0);
 	return qrb.isValid();
 }
@@ -24,26 +31,36 @@ namespace query {
 
 bool Client::query(	const std::string& database, const std::string& select,
 					          Result& qr, const int flags)
+{
+	return query(database, select, std::vector<Param>(), qr, flags);
+}
+
+bool Client::query(	const std::string& database, const std::string& select,
+					const std::vector<Param>& params, Result& qr, const int flags)
 {
 	qr.clear();
 	if (database.empty() || select.empty()) return false;
 
-	int							errorCode = 0;
-	SqlDatabase					sqlDb(database, SQLITE_OPEN_READONLY, &errorCode);
-	if (errorCode != SQLITE_OK) return false;
-	return run_query(sqlDb, select, qr, flags);
+	SqlDatabase*				sqlDb = SqlConnectionPool::get().getDatabase(database, SQLITE_OPEN_READONLY);
+	if (!sqlDb) return false;
+	return run_query(*sqlDb, select, params, qr, flags);
 }
 
 bool Client::queryWrite(const std::string& database, const std::string& select,
 						            Result& qr)
+{
+	return queryWrite(database, select, std::vector<Param>(), qr);
+}
+
+bool Client::queryWrite(const std::string& database, const std::string& select,
+						const std::vector<Param>& params, Result& qr)
 {
 	qr.clear();
 	if (database.empty()) return false;
 
-	int							errorCode = 0;
-	SqlDatabase					sqlDb(database, SQLITE_OPEN_READWRITE, &errorCode);
-	if (errorCode != SQLITE_OK) return false;
-	return run_query(sqlDb, select, qr);
+	SqlDatabase*				sqlDb = SqlConnectionPool::get().getDatabase(database, SQLITE_OPEN_READWRITE);
+	if (!sqlDb) return false;
+	return run_query(*sqlDb, select, params, qr);
 }
 
 /**
@@ -64,6 +81,12 @@ void Client::setResultHandler(const std::function<void(const Result&, Talkback&)
 
 bool Client::runAsync(	const std::string& database, const std::string& query,
 						Poco::Timestamp* sendTime, int* id)
+{
+	return runAsync(database, query, std::vector<Param>(), sendTime, id);
+}
+
+bool Client::runAsync(	const std::string& database, const std::string& query,
+						const std::vector<Param>& params, Poco::Timestamp* sendTime, int* id)
 {
 	if (database.empty() || query.empty()) {
 		DS_LOG_WARNING("ds::query::Client() empty value database=" << database << " query=" << query);
@@ -76,9 +99,9 @@ bool Client::runAsync(	const std::string& database, const std::string& query,
 	r->mRunId = (mRunId++);
 	r->mDatabase = database;
 	r->mQuery = query;
-	r->mResult.clear();
-	r->mTalkback.clear();
+	r->mParams = params;
 	if (id) *id = r->mRunId;
+	prepareRequest(*r);
 	return mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, Request>(r), sendTime);
 }
 
@@ -92,22 +115,61 @@ void Client::handleResult(std::unique_ptr<WorkRequest>& wr)
 	mCache.push(r);
 }
 
+void Client::handleCancelled(std::unique_ptr<WorkRequest>& wr)
+{
+	std::unique_ptr<Request>		r(ds::unique_dynamic_cast<Request, WorkRequest>(wr));
+	if (!r) return;
+
+	r->setCancelled();
+	if (mResultHandler) mResultHandler(r->mResult, r->mTalkback);
+	mCache.push(r);
+}
+
 Client::Request::Request(const void* clientId)
 	: WorkRequest(clientId)
 	, mRunId(0)
+	, mRowHighWater(0)
 {
 	mDatabase.reserve(128);
 	mQuery.reserve(256);
 }
 
+void Client::Request::recycle()
+{
+	mRowHighWater = std::max(mRowHighWater, static_cast<size_t>(mResult.getRowSize()));
+	mResult.recycle();
+	mTalkback.clear();
+	mParams.clear();
+}
+
+void Client::Request::setCancelled()
+{
+	// Whatever got built is incomplete. Keep the stamps, so handlers matching on the id still see it.
+	mResult.recycle();
+	ResultBuilder::setRequestTime(mResult, mRequestTime);
+	ResultBuilder::setClientId(mResult, mRunId);
+	mTalkback.mCancelled = true;
+}
+
+void Client::Request::trim()
+{
+	mResult.trim(mRowHighWater);
+	mRowHighWater = 0;
+}
+
 void Client::Request::run()
 {
 	int							errorCode = 0;
-	SqlDatabase					resourceDB(mDatabase, SQLITE_OPEN_READONLY, &errorCode);
-	if (errorCode != SQLITE_OK) {
+	SqlDatabase*				resourceDB = SqlConnectionPool::get().getDatabase(mDatabase, SQLITE_OPEN_READONLY, &errorCode);
+	if (!resourceDB) {
 		DS_LOG_WARNING("ds::query::Client::Request: Unable to access the resource database (SQLite error " << errorCode << ").");
 	} else {
-		SqlResultBuilder		qrb(mResult, resourceDB.rawSelect(mQuery));
+		sqlite3_stmt*			statement = resourceDB->acquire(mQuery);
+		if (!SqlDatabase::bind(statement, mParams)) {
+			resourceDB->release(statement);
+			statement = nullptr;
+		}
+		SqlResultBuilder		qrb(mResult, statement, resourceDB);
 		qrb.build();
 
 		ResultBuilder::setRequestTime(mResult, mRequestTime);
@@ -3,8 +3,10 @@
 #define DS_QUERY_QUERYCLIENT_H_
 
 #include <functional>
+#include <vector>
 #include "ds/thread/work_client.h"
 #include "ds/thread/work_request_list.h"
+#include "ds/query/query_param.h"
 #include "ds/query/query_result.h"
 #include "ds/query/query_talkback.h"
 
@@ -15,6 +17,8 @@ namespace query {
 /**
  * \class Client
  * \brief Handle SQLite queries. Use "query" in a thread to grab content from a sqlite database.
+ * Connections and prepared statements are kept per thread (see SqlConnectionPool), so
+ * prefer ?s and params over building a new SQL string for every value.
  */
 class Client : public ds::WorkClient {
   public:			
@@ -36,6 +40,12 @@ class Client : public ds::WorkClient {
 	static bool             query(const std::string& database, const std::string& query,
 								  Result& result, const int flags = 0);
 
+	/** \brief Same as above, with params bound to the ?s in the query, in order.
+		E.g. query(db, "SELECT * FROM slides WHERE id = ?", { 12 }, result)
+	*/
+	static bool             query(const std::string& database, const std::string& query,
+								  const std::vector<Param>& params, Result& result, const int flags = 0);
+
 	/** \brief Run a synchronous query in write mode. Only use this method over "query()" if you need to commit something to the db.
 		\param database The filepath of the sqlite db to query
 		\param query The string of the query statement to run on the db. E.g. "SELECT * FROM tablename"
@@ -44,6 +54,8 @@ class Client : public ds::WorkClient {
 	*/
 	static bool             queryWrite(	const std::string& database, const std::string& query,
 									   Result& result);
+	static bool             queryWrite(	const std::string& database, const std::string& query,
+									   const std::vector<Param>& params, Result& result);
 
 	/** \brief Regular constructor for non-static queries. In most cases, you can safely use the static API.	
 	*/
@@ -65,11 +77,17 @@ class Client : public ds::WorkClient {
 	*/
 	bool                    runAsync(	const std::string& database, const std::string& query,
 									  Poco::Timestamp* sendTime = nullptr, int* id = nullptr);
+	/// With params bound to the ?s in the query
+	bool                    runAsync(	const std::string& database, const std::string& query,
+									  const std::vector<Param>& params,
+									  Poco::Timestamp* sendTime = nullptr, int* id = nullptr);
 
   protected:
 	 /** 
 	 */
 	virtual void            handleResult(std::unique_ptr<WorkRequest>&);
+	/// Cancelled queries go to the result handler too, empty and flagged in the talkback.
+	virtual void            handleCancelled(std::unique_ptr<WorkRequest>&);
 
   private:
 	typedef ds::WorkClient  inherited;
@@ -82,12 +100,21 @@ class Client : public ds::WorkClient {
 		int                 mRunId;
 		std::string         mDatabase,
 							mQuery;
+		std::vector<Param>  mParams;
 
 		/// output
 		ds::query::Result   mResult;
 		ds::query::Talkback mTalkback;
 
 		void                run();
+		/// Empty the result and flag it, for a query that never finished
+		void                setCancelled();
+		virtual void        recycle();
+		virtual void        trim();
+
+	  private:
+		/// The most rows any result had since the last trim()
+		size_t              mRowHighWater;
 	};
 
 	ds::WorkRequestList<Request>
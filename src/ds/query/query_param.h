@@ -0,0 +1,39 @@
+#pragma once
+#ifndef DS_QUERY_QUERYPARAM_H_
+#define DS_QUERY_QUERYPARAM_H_
+
+#include <stdint.h>
+#include <string>
+
+namespace ds {
+
+namespace query {
+
+/**
+ * \class Param
+ * \brief A value bound to a ? in a query, so the same SQL can be reused with
+ * different values and nothing needs escaping.
+ */
+class Param
+{
+public:
+	enum Type { NULL_TYPE, INT_TYPE, DOUBLE_TYPE, STRING_TYPE };
+
+	Param()								: mType(NULL_TYPE), mInt(0), mDouble(0.0) { }
+	Param(const int v)					: mType(INT_TYPE), mInt(v), mDouble(0.0) { }
+	Param(const int64_t v)				: mType(INT_TYPE), mInt(v), mDouble(0.0) { }
+	Param(const double v)				: mType(DOUBLE_TYPE), mInt(0), mDouble(v) { }
+	Param(const std::string& v)			: mType(STRING_TYPE), mInt(0), mDouble(0.0), mString(v) { }
+	Param(const char* v)				: mType(v ? STRING_TYPE : NULL_TYPE), mInt(0), mDouble(0.0), mString(v ? v : "") { }
+
+	Type					mType;
+	int64_t					mInt;
+	double					mDouble;
+	std::string				mString;
+};
+
+} // namespace query
+
+} // namespace ds
+
+#endif // DS_QUERY_QUERYPARAM_H_
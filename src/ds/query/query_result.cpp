@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <stdarg.h>
 #include <math.h>
 #include <ds/util/string_util.h>
@@ -14,6 +16,20 @@
 namespace {
 const std::string				RESULT_EMPTY_STR("");
 const std::wstring				RESULT_EMPTY_WSTR(L"");
+
+ds::MemoryTag& resultMemory() {
+	static ds::MemoryTag&		TAG = ds::MemoryAccounting::get().getTag("Query results");
+	return TAG;
+}
+
+template <typename T>
+void shrink_vector(std::vector<T>& v, const size_t size) {
+	if (v.capacity() <= size) return;
+	std::vector<T>				shrunk;
+	shrunk.reserve(std::max(size, v.size()));
+	shrunk.assign(v.begin(), v.end());
+	v.swap(shrunk);
+}
 }
 
 #ifndef WIN32
@@ -31,10 +47,18 @@ const int					QUERY_NULL = 3;
 
 /* QUERY-RESULT
  ******************************************************************/
-Result::Result() {
-}
-
-Result::Result(const Result& o) {
+Result::Result()
+		: mRows(0)
+		, mCharsHighWater(0)
+		, mClientId(0)
+		, mMemory(resultMemory()) {
+}
+
+Result::Result(const Result& o)
+		: mRows(0)
+		, mCharsHighWater(0)
+		, mClientId(0)
+		, mMemory(resultMemory()) {
 	*this = o;
 }
 
@@ -42,6 +66,7 @@ Result& Result::operator=(const Result& o) {
 	if (this != &o) {
 		clear();
 		mCol = o.mCol;
+		mColNames = o.mColNames;
 		addRows(o);
 		mRequestTime = o.mRequestTime;
 		mClientId = o.mClientId;
@@ -50,6 +75,14 @@ Result& Result::operator=(const Result& o) {
 }
 
 Result& Result::operator=(const RowIterator& it) {
+	if (&it.mResult == this) {
+		// Copy the row out before I'm cleared
+		Result				row;
+		row = it;
+		swap(row);
+		return *this;
+	}
+
 	clear();
 	mCol = it.mResult.mCol;
 	mColNames = it.mResult.mColNames;
@@ -57,15 +90,10 @@ Result& Result::operator=(const RowIterator& it) {
 	mClientId = it.mResult.mClientId;
 
 	try {
-		if (it.mRowIt != it.mResult.mRow.end()) {
-			const Row*			src = it.mRowIt->get();
-			if (src) {
-				Result::Row*	dst = pushBackRow();
-				*dst = *src;
-			}
-		}
+		if (it.hasValue()) appendRows(it.mResult, it.mRow, 1);
 	} catch (std::exception const&) {
 	}
+	updateMemory();
 
 	return *this;
 }
@@ -73,11 +101,56 @@ Result& Result::operator=(const RowIterator& it) {
 void Result::clear() {
 	mCol.clear();
 	mColNames.clear();
-	mRow.clear();
+	mColumn.clear();
+	mSpareColumn.clear();
+	mRows = 0;
+	std::string().swap(mChars);
+	mCharsHighWater = 0;
+	mNames.clear();
+	mRequestTime = Poco::Timestamp(0);
+	mClientId = 0;
+	updateMemory();
+}
+
+void Result::recycle() {
+	mCol.clear();
+	mColNames.clear();
+	try {
+		mSpareColumn.reserve(mSpareColumn.size() + mColumn.size());
+		// Backwards, so the first column comes back out first
+		for (auto it = mColumn.rbegin(), end = mColumn.rend(); it != end; ++it) {
+			if (!*it) continue;
+			(*it)->clear();
+			mSpareColumn.push_back(std::move(*it));
+		}
+	} catch (std::exception const&) {
+	}
+	mColumn.clear();
+	mRows = 0;
+	mCharsHighWater = std::max(mCharsHighWater, mChars.size());
+	mChars.clear();
+	mNames.clear();
 	mRequestTime = Poco::Timestamp(0);
 	mClientId = 0;
 }
 
+void Result::trim(const size_t rows) {
+	for (auto& c : mSpareColumn) {
+		shrink_vector(c->mNumeric, rows);
+		shrink_vector(c->mString, rows);
+		shrink_vector(c->mNull, (rows + 63) / 64);
+	}
+	const size_t			chars = std::max(mCharsHighWater, mChars.size());
+	if (mChars.capacity() > chars) {
+		std::string			shrunk;
+		shrunk.reserve(chars);
+		shrunk.assign(mChars);
+		mChars.swap(shrunk);
+	}
+	mCharsHighWater = 0;
+	updateMemory();
+}
+
 bool Result::matches(const int* curType, ...) const
 {
 	bool			ans = true;
@@ -126,11 +199,11 @@ const std::string& Result::getColumnName(const int idx) const {
 }
 
 bool Result::rowsAreEmpty() const {
-	return mRow.empty();
+	return mRows < 1;
 }
 
 int Result::getRowSize() const {
-	return static_cast<int>(mRow.size());
+	return static_cast<int>(mRows);
 }
 
 Result::RowIterator Result::getRows() const {
@@ -144,164 +217,311 @@ Result::RowIterator Result::rowAt(const size_t index) const {
 bool Result::addRows(const Result& src)
 {
 	_ASSERT(mCol.size() == src.mCol.size());
+	if (&src == this) {
+		const Result		copy(src);
+		return addRows(copy);
+	}
 	try {
-		RowIterator			it(src);
-		bool				ans = true;
-		while (it.hasValue()) {
-			const Row&		src = **(it.mRowIt);
-			Row*			dst = pushBackRow();
-			*dst = src;
-			// Not completely safe but the odds of not being able to
-			// allocate a few bytes for the ints and floats...  sheesh...
-			if (dst->mString.size() != src.mString.size()) ans = false;
-			++it;
-		}
-		return ans;
+		appendRows(src, 0, src.mRows);
+		updateMemory();
+		return true;
 	} catch (std::exception&) {
 	}
 	return false;
 }
 
 void Result::popRowFront() {
-	if (!mRow.empty()) {
-		mRow.erase(mRow.begin());
-	}
+	if (mRows < 1) return;
+	std::vector<size_t>		order(mRows - 1);
+	for (size_t k = 0; k < order.size(); ++k) order[k] = k + 1;
+	reorder(order);
 }
 
 void Result::swap(Result& o)  {
 	mCol.swap(o.mCol);
-	mRow.swap(o.mRow);
+	mColNames.swap(o.mColNames);
+	mColumn.swap(o.mColumn);
+	mSpareColumn.swap(o.mSpareColumn);
+	std::swap(mRows, o.mRows);
+	mChars.swap(o.mChars);
+	std::swap(mCharsHighWater, o.mCharsHighWater);
+	mNames.swap(o.mNames);
 	std::swap(mRequestTime, o.mRequestTime);
 	std::swap(mClientId, o.mClientId);
+	mMemory.swap(o.mMemory);
 }
 
 void Result::sortByString(const int columnIndex, const std::function<bool(const std::string& a, const std::string& b)>& clientFn) {
-	if (!clientFn) return;
+	if (!clientFn || columnIndex < 0) return;
 
-	auto fn = [columnIndex, &clientFn](const std::unique_ptr<Row>& a, const std::unique_ptr<Row>& b)->bool {
-		const size_t	ci(static_cast<size_t>(columnIndex));
-		const Row*		ar = a.get();
-		const Row*		br = b.get();
-		if (!ar || !br) return false;
-		if (ar->mString.size() <= ci || br->mString.size() <= ci) return false;
-		return clientFn(ar->mString[ci], br->mString[ci]);
-	};
-
-	std::sort(mRow.begin(), mRow.end(), fn);
+	const size_t			ci(static_cast<size_t>(columnIndex));
+	std::vector<size_t>		order(mRows);
+	for (size_t k = 0; k < mRows; ++k) order[k] = k;
+	std::sort(order.begin(), order.end(), [this, ci, &clientFn](const size_t a, const size_t b)->bool {
+		return clientFn(getStringAt(ci, a), getStringAt(ci, b));
+	});
+	reorder(order);
 }
 
 void Result::sort_if(const std::function<bool(const RowIterator& a, const RowIterator& b)> &clientFn) {
 	if (!clientFn) return;
 
-	auto fn = [this, &clientFn](const std::unique_ptr<Row> &_a, const std::unique_ptr<Row> &_b)->bool {
+	std::vector<size_t>		order(mRows);
+	for (size_t k = 0; k < mRows; ++k) order[k] = k;
+	std::sort(order.begin(), order.end(), [this, &clientFn](const size_t _a, const size_t _b)->bool {
 		const RowIterator	a(*this, _a),
 							b(*this, _b);
-		if (!a.hasValue() || !b.hasValue()) {
-			return false;
-		}
 		return clientFn(a, b);
-	};
+	});
+	reorder(order);
+}
 
-	std::sort(mRow.begin(), mRow.end(), fn);
+size_t Result::pushBackRow() {
+	return mRows++;
 }
 
-Result::Row* Result::pushBackRow() {
-	mRow.push_back(std::move(std::unique_ptr<Row>(new Row())));
-	return mRow.back().get();
+Result::Column& Result::writeColumn(const size_t column) {
+	while (mColumn.size() <= column) {
+		if (!mSpareColumn.empty()) {
+			mColumn.push_back(std::move(mSpareColumn.back()));
+			mSpareColumn.pop_back();
+		} else {
+			mColumn.push_back(std::unique_ptr<Column>(new Column()));
+		}
+	}
+	return *mColumn[column];
 }
 
-/* QUERY-RESULT::ROW
- ******************************************************************/
-Result::Row::Row() {
+void Result::setNumeric(const size_t column, const double v) {
+	if (mRows < 1) return;
+	Column&					c = writeColumn(column);
+	if (c.mNumeric.size() < mRows) c.mNumeric.resize(mRows, 0.0);
+	c.mNumeric[mRows - 1] = v;
 }
 
-void Result::Row::clear() {
-	mName.clear();
-	mNumeric.clear();
-	mString.clear();
-	mWString.clear();
+bool Result::setString(const size_t column, const char* chars, const size_t length) {
+	if (mRows < 1) return true;
+	// Spans are 32 bits, which is a lot of query
+	if (mChars.size() + length > std::numeric_limits<uint32_t>::max()) return false;
+	Column&					c = writeColumn(column);
+	c.dropCaches();
+	if (c.mString.size() < mRows) {
+		const Span			empty = { 0, 0 };
+		c.mString.resize(mRows, empty);
+	}
+	Span&					span = c.mString[mRows - 1];
+	span.mOffset = static_cast<uint32_t>(mChars.size());
+	span.mLength = static_cast<uint32_t>(length);
+	if (length > 0) mChars.append(chars, length);
+	return true;
+}
+
+void Result::setNull(const size_t column) {
+	if (mRows < 1) return;
+	Column&					c = writeColumn(column);
+	const size_t			row = mRows - 1;
+	if (c.mNull.size() <= row / 64) c.mNull.resize(row / 64 + 1, 0);
+	c.mNull[row / 64] |= (uint64_t(1) << (row % 64));
+}
+
+void Result::setName(const std::string& name) {
+	if (mRows < 1) return;
+	if (mNames.size() < mRows) mNames.resize(mRows);
+	mNames[mRows - 1] = name;
+}
+
+void Result::appendRows(const Result& src, const size_t first, const size_t count) {
+	const size_t			end = std::min(first + count, src.mRows);
+	if (first >= end) return;
+	if (first == 0 && end == src.mRows) mChars.reserve(mChars.size() + src.mChars.size());
+
+	for (size_t row = first; row < end; ++row) {
+		pushBackRow();
+		for (size_t col = 0; col < src.mColumn.size(); ++col) {
+			const Column&	c = *src.mColumn[col];
+			if (row < c.mNumeric.size()) setNumeric(col, c.mNumeric[row]);
+			if (row < c.mString.size()) {
+				const Span&	span = c.mString[row];
+				if (!setString(col, src.mChars.data() + span.mOffset, span.mLength)) throw std::length_error("query::Result out of string room");
+			}
+			if (src.isNullAt(col, row)) setNull(col);
+		}
+		if (row < src.mNames.size()) setName(src.mNames[row]);
+	}
 }
 
-void Result::Row::initialize(const int columns) {
-	if (columns > 0) {
-		mNumeric.resize(columns, 0.0);
-		mNumeric.clear();
+void Result::reorder(const std::vector<size_t>& order) {
+	for (auto& cp : mColumn) {
+		Column&				c = *cp;
+		c.dropCaches();
+		if (!c.mNumeric.empty()) {
+			std::vector<double>		numeric(order.size(), 0.0);
+			for (size_t k = 0; k < order.size(); ++k) {
+				if (order[k] < c.mNumeric.size()) numeric[k] = c.mNumeric[order[k]];
+			}
+			c.mNumeric.swap(numeric);
+		}
+		if (!c.mString.empty()) {
+			const Span				empty = { 0, 0 };
+			std::vector<Span>		strings(order.size(), empty);
+			for (size_t k = 0; k < order.size(); ++k) {
+				if (order[k] < c.mString.size()) strings[k] = c.mString[order[k]];
+			}
+			c.mString.swap(strings);
+		}
+		if (!c.mNull.empty()) {
+			std::vector<uint64_t>	nulls((order.size() + 63) / 64, 0);
+			for (size_t k = 0; k < order.size(); ++k) {
+				if (order[k] / 64 < c.mNull.size() && (c.mNull[order[k] / 64] & (uint64_t(1) << (order[k] % 64))) != 0) {
+					nulls[k / 64] |= (uint64_t(1) << (k % 64));
+				}
+			}
+			c.mNull.swap(nulls);
+		}
 	}
+	if (!mNames.empty()) {
+		std::vector<std::string>	names(order.size());
+		for (size_t k = 0; k < order.size(); ++k) {
+			if (order[k] < mNames.size()) names[k].swap(mNames[order[k]]);
+		}
+		mNames.swap(names);
+	}
+	mRows = order.size();
 }
 
-Result::Row& Result::Row::operator=(const Row& o) {
-	if (this != &o) {
-		try {
-			mName = o.mName;
-			mNumeric = o.mNumeric;
-			mString = o.mString;
-			mWString = o.mWString;
-		} catch (std::exception&) {
+double Result::getNumericAt(const size_t column, const size_t row) const {
+	if (column >= mColumn.size()) return 0.0;
+	const Column&			c = *mColumn[column];
+	return row < c.mNumeric.size() ? c.mNumeric[row] : 0.0;
+}
+
+const char* Result::getCharsAt(const size_t column, const size_t row, size_t* length) const {
+	if (length) *length = 0;
+	if (column >= mColumn.size()) return nullptr;
+	const Column&			c = *mColumn[column];
+	if (row >= c.mString.size()) return nullptr;
+	if (length) *length = c.mString[row].mLength;
+	return mChars.data() + c.mString[row].mOffset;
+}
+
+bool Result::isNullAt(const size_t column, const size_t row) const {
+	if (column >= mColumn.size()) return false;
+	const Column&			c = *mColumn[column];
+	if (row / 64 >= c.mNull.size()) return false;
+	return (c.mNull[row / 64] & (uint64_t(1) << (row % 64))) != 0;
+}
+
+const std::string& Result::getStringAt(const size_t column, const size_t row) const {
+	if (column >= mColumn.size()) return RESULT_EMPTY_STR;
+	const Column&			c = *mColumn[column];
+	if (row >= c.mString.size()) return RESULT_EMPTY_STR;
+
+	std::vector<std::string>*	cache = c.mStringCache.load(std::memory_order_acquire);
+	if (!cache) {
+		std::unique_ptr<std::vector<std::string>>	made(new std::vector<std::string>(c.mString.size()));
+		for (size_t k = 0; k < c.mString.size(); ++k) {
+			(*made)[k].assign(mChars.data() + c.mString[k].mOffset, c.mString[k].mLength);
 		}
+		// Another thread might have got there first
+		if (c.mStringCache.compare_exchange_strong(cache, made.get(), std::memory_order_acq_rel)) cache = made.release();
 	}
-	return *this;
+	return (*cache)[row];
+}
+
+const std::wstring& Result::getWStringAt(const size_t column, const size_t row) const {
+	if (column >= mColumn.size()) return RESULT_EMPTY_WSTR;
+	const Column&			c = *mColumn[column];
+	if (row >= c.mString.size()) return RESULT_EMPTY_WSTR;
+
+	std::vector<std::wstring>*	cache = c.mWStringCache.load(std::memory_order_acquire);
+	if (!cache) {
+		std::unique_ptr<std::vector<std::wstring>>	made(new std::vector<std::wstring>(c.mString.size()));
+		std::string				utf8;
+		for (size_t k = 0; k < c.mString.size(); ++k) {
+			if (c.mString[k].mLength < 1) continue;
+			utf8.assign(mChars.data() + c.mString[k].mOffset, c.mString[k].mLength);
+			ds::wstr_from_utf8(utf8, (*made)[k]);
+		}
+		if (c.mWStringCache.compare_exchange_strong(cache, made.get(), std::memory_order_acq_rel)) cache = made.release();
+	}
+	return (*cache)[row];
+}
+
+void Result::updateMemory() {
+	size_t					bytes = mChars.capacity() + mNames.capacity() * sizeof(std::string);
+	for (auto& c : mColumn) bytes += c->getBytes();
+	for (auto& c : mSpareColumn) bytes += c->getBytes();
+	mMemory.setBytes(static_cast<int64_t>(bytes));
+}
+
+/* QUERY-RESULT::COLUMN
+ ******************************************************************/
+Result::Column::Column()
+		: mStringCache(nullptr)
+		, mWStringCache(nullptr) {
+}
+
+Result::Column::~Column() {
+	dropCaches();
+}
+
+void Result::Column::clear() {
+	mNumeric.clear();
+	mString.clear();
+	mNull.clear();
+	dropCaches();
+}
+
+void Result::Column::dropCaches() {
+	delete mStringCache.exchange(nullptr);
+	delete mWStringCache.exchange(nullptr);
+}
+
+size_t Result::Column::getBytes() const {
+	return sizeof(Column) + mNumeric.capacity() * sizeof(double) + mString.capacity() * sizeof(Span) + mNull.capacity() * sizeof(uint64_t);
 }
 
 /* QUERY-RESULT::ROW-ITERATOR
  ******************************************************************/
 Result::RowIterator::RowIterator(const RowIterator& o)
 		: mResult(o.mResult)
-		, mRowIt(o.mRowIt)
-		, mOverride(nullptr) {
+		, mRow(o.mRow) {
 }
 
 Result::RowIterator::RowIterator(const Result& qr)
 		: mResult(qr)
-		, mRowIt(qr.mRow.begin())
-		, mOverride(nullptr) {
+		, mRow(0) {
 }
 
 Result::RowIterator::RowIterator(const Result& qr, const std::string& str)
 		: mResult(qr)
-		, mRowIt(qr.mRow.begin())
-		, mOverride(nullptr) {
-	while (mRowIt != mResult.mRow.end()) {
-		if (mRowIt->get()->mName == str) break;
-		++mRowIt;
+		, mRow(0) {
+	while (mRow < mResult.mRows) {
+		if (getName() == str) break;
+		++mRow;
 	}
 }
 
 Result::RowIterator::RowIterator(const Result& qr, const size_t index)
 		: mResult(qr)
-		, mRowIt(qr.mRow.end())
-		, mOverride(nullptr) {
-	if (index < qr.mRow.size()) mRowIt = qr.mRow.begin() + index;
-}
-
-Result::RowIterator::RowIterator(const Result &qr, const std::unique_ptr<Row> &r)
-		: mResult(qr)
-		, mRowIt(qr.mRow.end())
-		, mOverride(r.get()) {
+		, mRow(index < qr.mRows ? index : qr.mRows) {
 }
 
 void Result::RowIterator::operator++() {
-	if (mOverride) {
-		mOverride = nullptr;
-	} else {
-		++mRowIt;
-	}
+	++mRow;
 }
 
 void Result::RowIterator::operator+=(const int count) {
-	if (!mOverride) mRowIt += count;
+	mRow += count;
 }
 
 bool Result::RowIterator::hasValue() const {
-	if (mOverride) return true;
-	return mRowIt != mResult.mRow.end() && mRowIt->get() != nullptr;
+	return mRow < mResult.mRows;
 }
 
 const std::string& Result::RowIterator::getName() const {
-	if (mOverride) {
-		return mOverride->mName;
-	}
-	if (!hasValue()) return RESULT_EMPTY_STR;
-	return (**mRowIt).mName;
+	if (mRow >= mResult.mNames.size()) return RESULT_EMPTY_STR;
+	return mResult.mNames[mRow];
 }
 
 // Surely somewhere in oF there's been a rounding function defined??  Well, use
@@ -316,66 +536,78 @@ inline int64_t query_round_64(const double d) {
 
 int Result::RowIterator::getInt(const int columnIndex) const {
 	if (columnIndex < 0) return 0;
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
 	// Deal with the case where the column got misinterpreted as a string --
 	// this can happen when there's a NULL in the data set.
-	if (columnIndex < row.mWString.size() && !row.mWString[columnIndex].empty()) {
+	size_t			length = 0;
+	const char*		chars = mResult.getCharsAt(columnIndex, mRow, &length);
+	if (length > 0) {
 		int			ans = 0;
-		if (ds::wstring_to_value(row.mWString[columnIndex], ans)) {
+		if (ds::string_to_value(std::string(chars, length), ans)) {
 			return ans;
 		}
 	}
-	if (row.mNumeric.size() <= columnIndex) return 0;
-	return query_round(row.mNumeric[columnIndex]);
+	return query_round(mResult.getNumericAt(columnIndex, mRow));
 }
 
 int64_t Result::RowIterator::getInt64(const int columnIndex) const {
 	if (columnIndex < 0) return 0;
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
 	// Deal with the case where the column got misinterpreted as a string --
 	// this can happen when there's a NULL in the data set.
-	if (columnIndex < row.mWString.size() && !row.mWString[columnIndex].empty()) {
+	size_t			length = 0;
+	const char*		chars = mResult.getCharsAt(columnIndex, mRow, &length);
+	if (length > 0) {
 		int64_t		ans = 0;
-		if (ds::wstring_to_value(row.mWString[columnIndex], ans)) {
+		if (ds::string_to_value(std::string(chars, length), ans)) {
 			return ans;
 		}
 	}
-	if (row.mNumeric.size() <= columnIndex) return 0;
-	return query_round_64(row.mNumeric[columnIndex]);
+	return query_round_64(mResult.getNumericAt(columnIndex, mRow));
 }
 
 float Result::RowIterator::getFloat(const int columnIndex) const {
 	if (columnIndex < 0) return 0;
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
 	// Deal with the case where the column got misinterpreted as a string --
 	// this can happen when there's a NULL in the data set.
-	if (columnIndex < row.mWString.size() && !row.mWString[columnIndex].empty()) {
+	size_t			length = 0;
+	const char*		chars = mResult.getCharsAt(columnIndex, mRow, &length);
+	if (length > 0) {
 		float		ans = 0.0f;
-		if (ds::wstring_to_value(row.mWString[columnIndex], ans)) {
+		if (ds::string_to_value(std::string(chars, length), ans)) {
 			return ans;
 		}
 	}
-	if (row.mNumeric.size() <= columnIndex) return 0.0f;
-	return static_cast<float>(row.mNumeric[columnIndex]);
+	return static_cast<float>(mResult.getNumericAt(columnIndex, mRow));
 }
 
 const std::string& Result::RowIterator::getString(const int columnIndex) const {
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
-	if (columnIndex >= 0 && columnIndex < row.mString.size()) return row.mString[columnIndex];
-	return RESULT_EMPTY_STR;
+	if (columnIndex < 0) return RESULT_EMPTY_STR;
+	return mResult.getStringAt(columnIndex, mRow);
 }
 
 const std::wstring& Result::RowIterator::getWString(const int columnIndex) const {
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
-	if (columnIndex >= 0 && columnIndex < row.mWString.size()) return row.mWString[columnIndex];
-	return RESULT_EMPTY_WSTR;
+	if (columnIndex < 0) return RESULT_EMPTY_WSTR;
+	return mResult.getWStringAt(columnIndex, mRow);
+}
+
+const char* Result::RowIterator::getChars(const int columnIndex, size_t* length) const {
+	if (columnIndex < 0) {
+		if (length) *length = 0;
+		return nullptr;
+	}
+	return mResult.getCharsAt(columnIndex, mRow, length);
+}
+
+bool Result::RowIterator::isNull(const int columnIndex) const {
+	if (columnIndex < 0) return false;
+	return mResult.isNullAt(columnIndex, mRow);
 }
 
 const Poco::DateTime Result::RowIterator::getDateTime(const int columnIndex) const {
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
-	if (columnIndex >= 0 && columnIndex < row.mString.size()) {
+	size_t			length = 0;
+	const char*		chars = getChars(columnIndex, &length);
+	if (chars) {
 		try{
-			std::string stringToParse = row.mString[columnIndex];
+			std::string stringToParse(chars, length);
 			int tzd = 0;
 			Poco::DateTime output;
 			Poco::DateTimeParser::parse("%Y-%o-%d %h:%M:%S %a", stringToParse, output, tzd);
@@ -387,10 +619,11 @@ const Poco::DateTime Result::RowIterator::getDateTime(const int columnIndex) con
 }
 
 const Poco::DateTime Result::RowIterator::getDateTime24hr(const int columnIndex) const {
-	const Row&		row = (mOverride ? *mOverride : **mRowIt);
-	if(columnIndex >= 0 && columnIndex < row.mString.size()) {
+	size_t			length = 0;
+	const char*		chars = getChars(columnIndex, &length);
+	if (chars) {
 		try {
-			std::string stringToParse = row.mString[columnIndex];
+			std::string stringToParse(chars, length);
 			int tzd = 0;
 			Poco::DateTime output;
 			Poco::DateTimeParser::parse("%Y-%m-%d %H:%M:%S", stringToParse, output, tzd);
@@ -403,7 +636,7 @@ const Poco::DateTime Result::RowIterator::getDateTime24hr(const int columnIndex)
 
 #ifdef _DEBUG
 void Result::print() const {
-	std::cout << "QueryResult columnSize=" << mCol.size() << " rows=" << mRow.size() << std::endl;
+	std::cout << "QueryResult columnSize=" << mCol.size() << " rows=" << mRows << std::endl;
 	if (mCol.size() > 0) {
 		std::cout << "\tcols ";
 		for (auto it=mCol.begin(), end=mCol.end(); it!=end; ++it) {
@@ -2,6 +2,7 @@
 #ifndef DS_THREAD_QUERYRESULT_H_
 #define DS_THREAD_QUERYRESULT_H_
 
+#include <atomic>
 #include <functional>
 #include <stdint.h>
 #include <string>
@@ -9,6 +10,7 @@
 #include <memory>
 #include <Poco/Timestamp.h>
 #include <Poco/DateTime.h>
+#include "ds/debug/memory_accounting.h"
 
 namespace ds {
 
@@ -23,12 +25,13 @@ extern const int		QUERY_NULL;
 /**
  * \class Result
  * \brief A datastore for query results.
+ * Stored a column at a time: a column only holds numbers if it has any, every string
+ * in the result shares one block of chars, and SQL NULLs are a bit each. The strings
+ * getString() and getWString() hand out references to are made the first time a
+ * column is asked for them, so prefer getChars() when reading lots of rows.
  */
 class Result
 {
-private:
-	class Row;
-
 public:
 	class RowIterator {
 	public:
@@ -52,21 +55,22 @@ public:
 		float							getFloat(const int columnIndex) const;
 		const std::string&				getString(const int columnIndex) const;
 		const std::wstring&				getWString(const int columnIndex) const;
+		/// The utf-8 chars of a string column in place, not null terminated, with no
+		/// copy. Null if this row has no string there.
+		const char*						getChars(const int columnIndex, size_t* length = nullptr) const;
+		/// True if the value was NULL in the database
+		bool							isNull(const int columnIndex) const;
 		const Poco::DateTime			getDateTime(const int columnIndex) const;
 		const Poco::DateTime			getDateTime24hr(const int columnIndex) const;
 
 	private:
 		friend class ds::query::Result;
 		RowIterator();
-		RowIterator(const Result&, const std::unique_ptr<Row>&);
 		void							operator++(int);
 		RowIterator&					operator=(const RowIterator&);
 
 		const Result&					mResult;
-		std::vector<std::unique_ptr<Row>>::const_iterator
-										mRowIt;
-		/// A utility -- directly override my current item. Can't increment
-		Row*							mOverride;
+		size_t							mRow;
 	};
 
 public:
@@ -78,6 +82,12 @@ public:
 	Result&					operator=(const RowIterator&);
 
 	void					clear();
+	/// Empty me like clear(), but hold on to my storage to be filled again, for
+	/// results that are rebuilt over and over.
+	void					recycle();
+	/// Let go of storage held by recycle() beyond this many rows, and beyond the most
+	/// string data any result has had since the last trim.
+	void					trim(const size_t rows);
 
 	/// In certain situations clients can do an assert test to make
 	/// sure the structure matches what they're expecting, i.e.:
@@ -114,36 +124,87 @@ public:
 	void					sort_if(const std::function<bool(const RowIterator& a, const RowIterator& b)>&);
 
 private:
-	/// Convenience to add a new row at the end, throwing if I fail
-	Row*								pushBackRow();
-
 	friend class ResultBuilder;
 	friend class ResultEditor;
 	friend class ResultRandomizer;
-	class Row {
+
+	/// Where a string sits in mChars
+	struct Span {
+		uint32_t						mOffset;
+		uint32_t						mLength;
+	};
+
+	/// One column, top to bottom. Each vector only reaches as far as the last row that
+	/// set something in it; past that the values are zero, empty and not NULL.
+	class Column {
 	public:
-		/// Rows have an optional name.  This isn't used when returning results from
-		/// a query, but it is used when we are using the QueryResult as a general data
-		/// storage mechanism locally in apps.
-		std::string						mName;
-		std::vector<double>				mNumeric;
-		std::vector<std::string>		mString;
-		std::vector<std::wstring>		mWString;
+		Column();
+		~Column();
 
-		Row();
+		/// Empty, keeping the storage
 		void							clear();
-		void							initialize(const int columns);
-		Row&							operator=(const Row&);
+		void							dropCaches();
+		size_t							getBytes() const;
+
+		std::vector<double>				mNumeric;
+		std::vector<Span>				mString;
+		/// A bit per row, set where the value was NULL
+		std::vector<uint64_t>			mNull;
+		/// The strings from mString as strings, made the first time a reference is asked for
+		mutable std::atomic<std::vector<std::string>*>
+										mStringCache;
+		mutable std::atomic<std::vector<std::wstring>*>
+										mWStringCache;
+
+	private:
+		Column(const Column&);
+		Column&							operator=(const Column&);
 	};
 
+	/// Add an empty row at the end, answering its index. The set functions fill it in.
+	size_t								pushBackRow();
+	void								setNumeric(const size_t column, const double);
+	/// False if the result has run out of room for strings
+	bool								setString(const size_t column, const char* chars, const size_t length);
+	void								setNull(const size_t column);
+	/// Rows have an optional name.  This isn't used when returning results from
+	/// a query, but it is used when we are using the QueryResult as a general data
+	/// storage mechanism locally in apps.
+	void								setName(const std::string&);
+	/// Add count rows from src, starting at first. The columns should match.
+	void								appendRows(const Result& src, const size_t first, const size_t count);
+	/// Rearrange the rows so row k is the one that was at order[k]
+	void								reorder(const std::vector<size_t>& order);
+	Column&								writeColumn(const size_t column);
+
+	double								getNumericAt(const size_t column, const size_t row) const;
+	const char*							getCharsAt(const size_t column, const size_t row, size_t* length) const;
+	bool								isNullAt(const size_t column, const size_t row) const;
+	const std::string&					getStringAt(const size_t column, const size_t row) const;
+	const std::wstring&					getWStringAt(const size_t column, const size_t row) const;
+	void								updateMemory();
+
 	/// column types
 	std::vector<int>					mCol;
 	std::vector<std::string>			mColNames;
-	std::vector<std::unique_ptr<Row>>	mRow;
+	std::vector<std::unique_ptr<Column>>
+										mColumn;
+	/// Columns emptied by recycle(), handed out again by writeColumn()
+	std::vector<std::unique_ptr<Column>>
+										mSpareColumn;
+	size_t								mRows;
+	/// Every string in every column, end to end
+	std::string							mChars;
+	/// The most mChars has held since the last trim()
+	size_t								mCharsHighWater;
+	/// Row names, as far as the last named row
+	std::vector<std::string>			mNames;
 
 	/// The time this query was requested.
 	Poco::Timestamp						mRequestTime;
 	int									mClientId;
+	/// Counts every result, with the bytes its columns hold
+	ds::MemoryTracked					mMemory;
 
 #ifdef _DEBUG
 public:
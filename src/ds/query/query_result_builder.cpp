@@ -24,11 +24,11 @@ void ResultBuilder::setClientId(Result& qr, const int id)
 
 ResultBuilder::ResultBuilder(Result& qr)
 	: mResult(qr)
-	, mRow(NULL)
 	, mColIdx(0)
 	, mError(false)
 {
-	qr.clear();
+	// Whatever storage was there gets filled again before anything new is made
+	qr.recycle();
 }
 
 ResultBuilder::~ResultBuilder()
@@ -42,50 +42,90 @@ bool ResultBuilder::isValid() const
 
 ResultBuilder& ResultBuilder::startRow()
 {
-	mRow = nullptr;
-	try {
-		mRow = mResult.pushBackRow();
-		// Make sure the numbers are initialized to zero.  This is critical because of
-		// the design of SQLite -- any numeric fields with NULL values show up as text
-		// fields, but if the client is expecting a number, we want to default to zero
-		// still, not whatever happened to be there.
-		mRow->initialize(static_cast<int>(mResult.mCol.size()));
-		mColIdx = 0;
-	} catch (std::exception&) {
-		mError = true;
-	}
+	// Numbers in a new row are zero until they're set.  This is critical because of
+	// the design of SQLite -- any numeric fields with NULL values show up as text
+	// fields, but if the client is expecting a number, we want to default to zero
+	// still, not whatever happened to be there.
+	mResult.pushBackRow();
+	mColIdx = 0;
 	return *this;
 }
 
 ResultBuilder& ResultBuilder::addNumeric(const double v)
 {
-	if (mError || !mRow) return *this;
-	const int			at = mColIdx;
-	mColIdx++;
-
-	mRow->mNumeric.resize(mColIdx);
-	mRow->mNumeric[at] = v;
+	if (mError) return *this;
+	setNumeric(mColIdx++, v);
 	return *this;
 }
 
 ResultBuilder& ResultBuilder::addString(const std::string& v)
 {
-	if (mError || !mRow) return *this;
-	const int			at = mColIdx;
-	mColIdx++;
+	if (mError) return *this;
+	setString(mColIdx++, v.data(), v.size());
+	return *this;
+}
+
+const std::vector<int>& ResultBuilder::getColumnTypes() const
+{
+	return mResult.mCol;
+}
 
+void ResultBuilder::setNumeric(const int column, const double v)
+{
 	try {
-		// First the utf-8 string.  Ideally this goes away
-		while (mRow->mString.size() < mColIdx) mRow->mString.push_back("");
-		mRow->mString[at] = v;
-		// Now the wstring
-		while (mRow->mWString.size() < mColIdx) mRow->mWString.push_back(L"");
-		mRow->mWString[at] = ds::wstr_from_utf8(v);
+		mResult.setNumeric(column, v);
 	} catch (std::exception&) {
 		mError = true;
 	}
+}
 
-	return *this;
+void ResultBuilder::setString(const int column, const char* chars, const size_t length)
+{
+	try {
+		if (!mResult.setString(column, chars, length)) mError = true;
+	} catch (std::exception&) {
+		mError = true;
+	}
+}
+
+void ResultBuilder::setNull(const int column)
+{
+	try {
+		mResult.setNull(column);
+	} catch (std::exception&) {
+		mError = true;
+	}
+}
+
+void ResultBuilder::readRow()
+{
+	for (int k=0; k<mResult.mCol.size(); k++) {
+		const int		col = mResult.mCol.data()[k];
+		if (col == QUERY_NUMERIC) {
+			double		v = 0.0f;
+			if (!getDouble(k, v)) mError = true;
+			addNumeric(v);
+		} else if (col == QUERY_STRING) {
+			mStringBuffer.clear();
+			if (!getString(k, mStringBuffer)) mError = true;
+			addString(mStringBuffer);
+		} else if (col == QUERY_NULL) {
+			// I can't determine at any point the actual type of the column,
+			// because it looks like sqlite always bases that info on the first
+			// row in the result set. So in this case, I've got to just get
+			// every type.
+			double		v = 0.0f;
+			if (!getDouble(k, v)) v = 0.0f;
+			addNumeric(v);
+
+			--mColIdx;
+			mStringBuffer.clear();
+			getString(k, mStringBuffer);
+			addString(mStringBuffer);
+		} else {
+			++mColIdx;
+		}
+	}
 }
 
 void ResultBuilder::build(const bool columnNames)
@@ -127,33 +167,10 @@ void ResultBuilder::build(const bool columnNames)
 	// Read the rows
 	while (hasNext()) {
 		startRow();
-		for (int k=0; k<mResult.mCol.size(); k++) {
-			const int		col = mResult.mCol.data()[k];
-			if (col == QUERY_NUMERIC) {
-				double		v = 0.0f;
-				if (!getDouble(k, v)) mError = true;
-				addNumeric(v);
-			} else if (col == QUERY_STRING) {
-				std::string		v;
-				if (!getString(k, v)) mError = true;
-				addString(v);
-			} else if (col == QUERY_NULL) {
-				// I can't determine at any point the actual type of the column,
-				// because it looks like sqlite always bases that info on the first
-				// row in the result set. So in this case, I've got to just get
-				// every type.
-				double		v = 0.0f;
-				if (!getDouble(k, v)) v = 0.0f;
-				addNumeric(v);
-
-				--mColIdx;
-				std::string		str;
-				getString(k, str);
-				addString(str);
-			}
-		}
+		readRow();
 		next();
 	}
+	mResult.updateMemory();
 }
 
 } // namespace query
@@ -46,15 +46,28 @@ public:
 	virtual bool				getString(const int column, std::string&) = 0;
 
 protected:
+	/// Fill in the row build() just started. This reads every column through getDouble()
+	/// and getString(); builders that can read their source in place should override it
+	/// and use the set functions.
+	virtual void				readRow();
+
 	ResultBuilder&				startRow();
 
 	ResultBuilder&				addNumeric(const double);
 	ResultBuilder&				addString(const std::string&);
 
+	/// The type of each column, once build() has read them
+	const std::vector<int>&		getColumnTypes() const;
+	/// Set a column in the current row directly
+	void						setNumeric(const int column, const double);
+	void						setString(const int column, const char* chars, const size_t length);
+	void						setNull(const int column);
+
 private:
 	Result&						mResult;
-	Result::Row*				mRow;
 	int							mColIdx;
+	/// Each string goes through here on its way into the row, so it's only allocated once
+	std::string					mStringBuffer;
 
 protected:
 	bool						mError;
@@ -13,7 +13,7 @@ namespace query {
  */
 ResultEditor::ResultEditor(Result& qr, const bool append)
 		: mResult(qr)
-		, mRow(NULL)
+		, mHasRow(false)
 		, mColIdx(0)
 		, mError(false) {
 	if(!append) qr.clear();
@@ -42,49 +42,37 @@ ResultEditor& ResultEditor::setColumn(const size_t index, const int type, const
 }
 
 ResultEditor& ResultEditor::startRow() {
-	mRow = nullptr;
-	try {
-		mRow = mResult.pushBackRow();
-		// Make sure the numbers are initialized to zero.  This is critical because of
-		// the design of SQLite -- any numeric fields with NULL values show up as text
-		// fields, but if the client is expecting a number, we want to default to zero
-		// still, not whatever happened to be there.
-		mRow->initialize(static_cast<int>(mResult.mCol.size()));
-		mColIdx = 0;
-	} catch (std::exception&) {
-		mError = true;
-	}
+	// Numbers in a new row are zero until they're set.  This is critical because of
+	// the design of SQLite -- any numeric fields with NULL values show up as text
+	// fields, but if the client is expecting a number, we want to default to zero
+	// still, not whatever happened to be there.
+	mResult.pushBackRow();
+	mResult.updateMemory();
+	mHasRow = true;
+	mColIdx = 0;
 	return *this;
 }
 
 ResultEditor& ResultEditor::addNumeric(const double v)
 {
-	if (mError || !mRow) return *this;
-	const int			at = mColIdx;
-	mColIdx++;
-
-	mRow->mNumeric.resize(mColIdx);
-	mRow->mNumeric[at] = v;
+	if (mError || !mHasRow) return *this;
+	try {
+		mResult.setNumeric(mColIdx++, v);
+	} catch (std::exception&) {
+		mError = true;
+	}
 	return *this;
 }
 
 ResultEditor& ResultEditor::addString(const std::wstring& v)
 {
-	if (mError || !mRow) return *this;
-	const int			at = mColIdx;
-	mColIdx++;
-
+	if (mError || !mHasRow) return *this;
 	try {
-		// First the utf-8 string.  Ideally this goes away
-		while (mRow->mString.size() < mColIdx) mRow->mString.push_back("");
-		mRow->mString[at] = ds::utf8_from_wstr(v);
-		// Now the wstring
-		while (mRow->mWString.size() < mColIdx) mRow->mWString.push_back(L"");
-		mRow->mWString[at] = v;
+		const std::string	utf8 = ds::utf8_from_wstr(v);
+		if (!mResult.setString(mColIdx++, utf8.data(), utf8.size())) mError = true;
 	} catch (std::exception&) {
 		mError = true;
 	}
-
 	return *this;
 }
 
@@ -29,7 +29,7 @@ public:
 
 private:
 	Result&						mResult;
-	Result::Row*				mRow;
+	bool						mHasRow;
 	int							mColIdx;
 	bool						mError;
 };
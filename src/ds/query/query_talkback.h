@@ -8,15 +8,17 @@ namespace query {
 
 /**
  * \class Talkback
- * \brief This is a placeholder class, in case we ever want to add
- * response info to query results handling.
+ * \brief Response info that goes along with query results.
  */
 class Talkback
 {
 public:
-	Talkback()						{ }
+	Talkback() : mCancelled(false)	{ }
 
-	void			clear()			{ }
+	void			clear()			{ mCancelled = false; }
+
+	/// The query was cancelled, or threw, before it finished. The result is empty.
+	bool			mCancelled;
 };
 
 } // namespace query
@@ -0,0 +1,94 @@
+#include "stdafx.h"
+
+#include "ds/query/sql_connection_pool.h"
+
+#include <algorithm>
+#include "ds/debug/logger.h"
+#include "ds/util/file_meta_data.h"
+
+namespace ds {
+
+namespace query {
+
+/**
+ * \class SqlConnectionPool
+ */
+SqlConnectionPool& SqlConnectionPool::get()
+{
+	static thread_local SqlConnectionPool	POOL;
+	return POOL;
+}
+
+SqlConnectionPool::SqlConnectionPool()
+{
+}
+
+SqlConnectionPool::~SqlConnectionPool()
+{
+	mConnections.clear();
+}
+
+SqlDatabase* SqlConnectionPool::getDatabase(const std::string& database, const int flags, int* errorCode)
+{
+	const std::string			path = ds::getNormalizedPath(database);
+	const std::string			key = std::to_string(flags) + ":" + path;
+	Poco::Timestamp				modified(0);
+	Poco::File::FileSize		size = 0;
+	const bool					exists = readFileStamp(path, modified, size);
+
+	for (auto it = mConnections.begin(); it != mConnections.end(); ++it) {
+		Connection&				c = **it;
+		if (c.mKey != key) continue;
+
+		// Keep a connection that still has a statement out, whatever happened to the file
+		const bool				changed = !exists || c.mModified != modified || c.mSize != size;
+		if (changed && c.mDatabase->getAcquiredCount() < 1) {
+			DS_LOG_VERBOSE(2, "SqlConnectionPool: " << path << " changed on disk, reopening");
+			mConnections.erase(it);
+			break;
+		}
+
+		if (errorCode) *errorCode = SQLITE_OK;
+		if (it != mConnections.begin()) std::rotate(mConnections.begin(), it, it + 1);
+		return mConnections.front()->mDatabase.get();
+	}
+
+	int							result = SQLITE_OK;
+	std::unique_ptr<Connection>	c(new Connection());
+	c->mKey = key;
+	c->mDatabase.reset(new SqlDatabase(path, flags, &result));
+	c->mModified = modified;
+	c->mSize = size;
+	if (errorCode) *errorCode = result;
+	if (result != SQLITE_OK) return nullptr;
+
+	mConnections.insert(mConnections.begin(), std::move(c));
+	// Drop the least recently used, unless they're busy
+	for (size_t k = mConnections.size(); k > MAX_CONNECTIONS; --k) {
+		if (mConnections[k - 1]->mDatabase->getAcquiredCount() < 1) mConnections.erase(mConnections.begin() + (k - 1));
+	}
+	return mConnections.front()->mDatabase.get();
+}
+
+void SqlConnectionPool::clear()
+{
+	for (size_t k = mConnections.size(); k > 0; --k) {
+		if (mConnections[k - 1]->mDatabase->getAcquiredCount() < 1) mConnections.erase(mConnections.begin() + (k - 1));
+	}
+}
+
+bool SqlConnectionPool::readFileStamp(const std::string& path, Poco::Timestamp& modified, Poco::File::FileSize& size)
+{
+	try {
+		const Poco::File		f(path);
+		modified = f.getLastModified();
+		size = f.getSize();
+		return true;
+	} catch (std::exception&) {
+	}
+	return false;
+}
+
+} // namespace query
+
+} // namespace ds
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef DS_QUERY_SQLCONNECTIONPOOL_H_
+#define DS_QUERY_SQLCONNECTIONPOOL_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <Poco/File.h>
+#include <Poco/Timestamp.h>
+#include "ds/query/sql_database.h"
+
+namespace ds {
+
+namespace query {
+
+/**
+ * \class SqlConnectionPool
+ * \brief Open database connections, one pool per thread, so repeated queries skip
+ * opening the database and (through SqlDatabase::acquire()) preparing the SQL.
+ *
+ * A connection is reopened when the database file's size or modification time
+ * changes, so a database that gets replaced on disk is picked up. Changes made
+ * through SQLite itself don't need that, the connection sees them anyway.
+ */
+class SqlConnectionPool
+{
+public:
+	/// The calling thread's pool
+	static SqlConnectionPool&	get();
+
+	~SqlConnectionPool();
+
+	/// An open connection to the database with these SQLite open flags, or null
+	/// if it couldn't be opened. Owned by the pool: don't hold on to it past the
+	/// query, the next call can close it.
+	SqlDatabase*				getDatabase(const std::string& database, const int flags, int* errorCode = nullptr);
+
+	/// Close every connection this thread isn't using
+	void						clear();
+
+	static const size_t			MAX_CONNECTIONS = 4;
+
+private:
+	SqlConnectionPool();
+	SqlConnectionPool(const SqlConnectionPool&);
+	SqlConnectionPool&			operator=(const SqlConnectionPool&);
+
+	class Connection {
+	public:
+		std::string				mKey;
+		std::unique_ptr<SqlDatabase>
+								mDatabase;
+		Poco::Timestamp			mModified;
+		Poco::File::FileSize	mSize;
+	};
+
+	/// False if the file can't be read
+	static bool					readFileStamp(const std::string& path, Poco::Timestamp& modified, Poco::File::FileSize& size);
+
+	/// Most recently used first
+	std::vector<std::unique_ptr<Connection>>
+								mConnections;
+};
+
+} // namespace query
+
+} // namespace ds
+
+#endif // DS_QUERY_SQLCONNECTIONPOOL_H_
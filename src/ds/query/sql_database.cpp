@@ -110,6 +110,7 @@ namespace query {
 SqlDatabase::SqlDatabase(const std::string& sDB, int flags, int *errorCode)
 	: db(NULL)
 	, db_file(ds::getNormalizedPath(sDB))
+	, mAcquired(0)
 {
 	const int		result = sqlite3_open_v2(db_file.c_str(), &db, flags, 0);
 	if (errorCode) *errorCode = result;
@@ -119,6 +120,9 @@ SqlDatabase::SqlDatabase(const std::string& sDB, int flags, int *errorCode)
 		sqlite3_create_function(db, "rank", -1, SQLITE_ANY, NULL, &rankfunc, NULL, NULL);
 		
 	} else {
+		// Even a failed open hands back a handle
+		sqlite3_close(db);
+		db = NULL;
 		// Actually a fatal error but ...
 		// GN, much much later: I dunno how this is a fatal error. Maybe your app can run just fine without this particular database. Just sayin'
 		DS_LOG_ERROR("  SqlDatabase: Unable to access the database " << sDB << " (SQLite error " << result << ")." << std::endl);
@@ -131,6 +135,7 @@ SqlDatabase::SqlDatabase(const std::string& sDB, int flags, int *errorCode)
 
 SqlDatabase::~SqlDatabase()
 {
+	for (auto& it : mStatements) sqlite3_finalize(it.second);
 	sqlite3_close(db);
 }
 
@@ -146,6 +151,71 @@ sqlite3_stmt* SqlDatabase::rawSelect(const std::string& rawSqlSelect)
 	return statement;
 }
 
+sqlite3_stmt* SqlDatabase::acquire(const std::string& sql)
+{
+	auto					found = mStatementLookup.find(sql);
+	if (found != mStatementLookup.end()) {
+		sqlite3_stmt*		statement = found->second->second;
+		mStatements.erase(found->second);
+		mStatementLookup.erase(found);
+		++mAcquired;
+		return statement;
+	}
+
+	if (!db) return NULL;
+	sqlite3_stmt*			statement = NULL;
+	const int				err = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &statement, 0);
+	if (err != SQLITE_OK) {
+		sqlite3_finalize(statement);
+		DS_LOG_ERROR("SqlDatabase::acquire SQL error = " << err << " message=" << sqlite3_errmsg(db) << " on select=" << sql << std::endl);
+		return NULL;
+	}
+	++mAcquired;
+	return statement;
+}
+
+void SqlDatabase::release(sqlite3_stmt* statement)
+{
+	if (!statement) return;
+	--mAcquired;
+	sqlite3_reset(statement);
+	sqlite3_clear_bindings(statement);
+
+	const char*				sql = sqlite3_sql(statement);
+	// Two of the same statement in use at once, keep the first one back
+	if (!sql || mStatementLookup.find(sql) != mStatementLookup.end()) {
+		sqlite3_finalize(statement);
+		return;
+	}
+	mStatements.push_front(std::make_pair(std::string(sql), statement));
+	mStatementLookup[mStatements.front().first] = mStatements.begin();
+	while (mStatements.size() > MAX_STATEMENTS) {
+		mStatementLookup.erase(mStatements.back().first);
+		sqlite3_finalize(mStatements.back().second);
+		mStatements.pop_back();
+	}
+}
+
+bool SqlDatabase::bind(sqlite3_stmt* statement, const std::vector<Param>& params)
+{
+	if (!statement) return false;
+	for (size_t k = 0; k < params.size(); ++k) {
+		const Param&		p = params[k];
+		// Parameters count from 1
+		const int			index = static_cast<int>(k) + 1;
+		int					err = SQLITE_OK;
+		if (p.mType == Param::INT_TYPE) err = sqlite3_bind_int64(statement, index, p.mInt);
+		else if (p.mType == Param::DOUBLE_TYPE) err = sqlite3_bind_double(statement, index, p.mDouble);
+		else if (p.mType == Param::STRING_TYPE) err = sqlite3_bind_text(statement, index, p.mString.c_str(), static_cast<int>(p.mString.size()), SQLITE_TRANSIENT);
+		else err = sqlite3_bind_null(statement, index);
+		if (err != SQLITE_OK) {
+			DS_LOG_ERROR("SqlDatabase::bind error = " << err << " on parameter " << index << " of " << sqlite3_sql(statement) << std::endl);
+			return false;
+		}
+	}
+	return true;
+}
+
 } // namespace query
 
 } // namespace ds
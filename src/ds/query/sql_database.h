@@ -2,7 +2,11 @@
 #ifndef DS_QUERY_SQLDATABASE_H_
 #define DS_QUERY_SQLDATABASE_H_
 
+#include <list>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
+#include "ds/query/query_param.h"
 #include "ds/query/sqlite/sqlite3.h"
 
 namespace ds {
@@ -24,9 +28,38 @@ public:
 	/// Client is responsible for finalizing the statement.
 	sqlite3_stmt*			rawSelect(const std::string& rawSqlSelect);
 
+	/// Answer a prepared statement for sql, reusing one from an earlier release() if
+	/// there is one. Hand it back with release() instead of finalizing it. Null on an
+	/// SQL error.
+	sqlite3_stmt*			acquire(const std::string& sql);
+	/// Reset the statement and keep it for the next acquire() of the same SQL. The
+	/// least recently used ones are finalized past MAX_STATEMENTS.
+	void					release(sqlite3_stmt*);
+	/// Statements acquired and not released yet
+	int						getAcquiredCount() const	{ return mAcquired; }
+
+	/// Bind params to the ?s in the statement, in order. False if one didn't take.
+	static bool				bind(sqlite3_stmt*, const std::vector<Param>& params);
+
+	bool					isOpen() const				{ return db != nullptr; }
+	sqlite3*				getHandle() const			{ return db; }
+
+	static const size_t		MAX_STATEMENTS = 32;
+
 private:
+	SqlDatabase(const SqlDatabase&);
+	SqlDatabase&			operator=(const SqlDatabase&);
+
 	sqlite3* db;
 	std::string db_file;
+
+	/// Released statements, most recently used first
+	typedef std::list<std::pair<std::string, sqlite3_stmt*>>
+							StatementList;
+	StatementList			mStatements;
+	std::unordered_map<std::string, StatementList::iterator>
+							mStatementLookup;
+	int						mAcquired;
 };
 
 } // namespace query
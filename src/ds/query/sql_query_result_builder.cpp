@@ -13,9 +13,10 @@ namespace query {
 /**
  * \class SqlResultBuilder
  */
-SqlResultBuilder::SqlResultBuilder(Result& qr, sqlite3_stmt* stmt)
+SqlResultBuilder::SqlResultBuilder(Result& qr, sqlite3_stmt* stmt, SqlDatabase* acquiredFrom)
 	: ResultBuilder(qr)
 	, mStatement(stmt)
+	, mAcquiredFrom(acquiredFrom)
 	, mStatementResult(SQLITE_ERROR)
 {
 	next();
@@ -23,7 +24,8 @@ SqlResultBuilder::SqlResultBuilder(Result& qr, sqlite3_stmt* stmt)
 
 SqlResultBuilder::~SqlResultBuilder()
 {
-	if (mStatement) sqlite3_finalize(mStatement);
+	if (mStatement && mAcquiredFrom) mAcquiredFrom->release(mStatement);
+	else if (mStatement) sqlite3_finalize(mStatement);
 }
 
 int SqlResultBuilder::getColumnCount() const
@@ -82,19 +84,34 @@ bool SqlResultBuilder::getDouble(const int column, double& out)
 	return true;
 }
 
+void SqlResultBuilder::readRow()
+{
+	const std::vector<int>&		types = getColumnTypes();
+	for (int k = 0; k < static_cast<int>(types.size()); ++k) {
+		const int				type = types[k];
+		const bool				isNull = sqlite3_column_type(mStatement, k) == SQLITE_NULL;
+		if (isNull) setNull(k);
+
+		// NULL columns get both, same as ResultBuilder::readRow()
+		if (type == QUERY_NUMERIC || type == QUERY_NULL) {
+			if (!isNull) setNumeric(k, sqlite3_column_double(mStatement, k));
+		}
+		if (type == QUERY_STRING || type == QUERY_NULL) {
+			// Text first, then the byte count of that text
+			const unsigned char*	text = sqlite3_column_text(mStatement, k);
+			if (text) setString(k, reinterpret_cast<const char*>(text), static_cast<size_t>(sqlite3_column_bytes(mStatement, k)));
+		}
+	}
+}
+
 bool SqlResultBuilder::getString(const int column, std::string& out)
 {
 	if (mStatementResult != SQLITE_ROW) return false;
 
 	const unsigned char*	ans = sqlite3_column_text(mStatement, column);
 	if (ans == NULL) out.clear();
-	else {
-		// Clear out the buffer -- NOTE:  Some platforms are bugged and this
-		// does not work.  Hopefully it's fine on any machine we use.
-		mStrBuf.str("");
-		mStrBuf << ans;
-		out = mStrBuf.str();
-	}
+	// Assign in place, so whatever out already holds gets reused
+	else out.assign(reinterpret_cast<const char*>(ans));
 	return true;
 }
 
@@ -5,6 +5,7 @@
 #include <sstream>
 #include "ds/query/sqlite/sqlite3.h"
 #include "ds/query/query_result_builder.h"
+#include "ds/query/sql_database.h"
 
 namespace ds {
 
@@ -17,7 +18,9 @@ namespace query {
 class SqlResultBuilder : public ResultBuilder
 {
 public:
-	SqlResultBuilder(Result&, sqlite3_stmt* = nullptr);
+	/// The statement is finalized when done, or released back to the database it was
+	/// acquired from, if one is supplied.
+	SqlResultBuilder(Result&, sqlite3_stmt* = nullptr, SqlDatabase* acquiredFrom = nullptr);
 	virtual ~SqlResultBuilder();
 
 	virtual int					getColumnCount() const;
@@ -28,11 +31,14 @@ public:
 	virtual bool				getDouble(const int column, double&);
 	virtual bool				getString(const int column, std::string&);
 
+protected:
+	/// Straight from the statement into the result, no strings in between
+	virtual void				readRow();
+
 private:
 	sqlite3_stmt*				mStatement;
+	SqlDatabase*				mAcquiredFrom;
 	int							mStatementResult;
-	/// Reuse our string buffer
-	std::stringstream			mStrBuf;
 };
 
 } // namespace query
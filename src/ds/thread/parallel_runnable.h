@@ -5,7 +5,7 @@
 #include <assert.h>
 #include <functional>
 #include <vector>
-#include "ds/thread/runnable_client.h"
+#include "ds/thread/runnable_executor.h"
 #include "ds/util/memory_ds.h"
 
 namespace ds {
@@ -16,6 +16,10 @@ namespace ds {
  * define the type through the template, set a function to handle any
  * replies, then kick of a query with start().
  *
+ * By default everything started runs right away. To keep a lid on it, set
+ * a maximum number running at once, or point several runnables at one
+ * shared RunnableExecutor so they take turns under a single limit.
+ *
  *** IMPLICIT INTERFACE
  *
  * T is a subclass of Poco::Runnable
@@ -29,27 +33,66 @@ public:
 	/// If T has a constructor without arguments, ignore the alloc. If you need
 	/// to supply info to the constructor, supply a custom alloc.
 	ParallelRunnable(ui::SpriteEngine&, const std::function<T*(void)>& alloc = nullptr);
+	~ParallelRunnable();
 	
-	/// Start a new runnable, intializing it via the handler block.
+	/// Start a new runnable, intializing it via the handler block. Answers false if it
+	/// couldn't be created, or the queue was full and refused it.
 	bool							start(const HandlerFunc& = nullptr);
 	void							setReplyHandler(const HandlerFunc& f) { mReplyHandler = f; }
+	/// Starts that never ran: pushed out of a full queue, replaced by a newer start or cancelled.
+	void							setDroppedHandler(const HandlerFunc& f) { mDroppedHandler = f; }
+
+	/// At most this many running at once, 0 for no limit. Anything past that waits,
+	/// and the policy decides what happens once maxQueued are waiting.
+	void							setMaxRunning(	const size_t, const RunnableExecutor::QueuePolicy = RunnableExecutor::QUEUE_ALL,
+													const size_t maxQueued = 0);
+	/// Keep only the latest start waiting, the way SerialRunnable does, but with any number running.
+	void							setMergeQueued(const bool merge) { mMergeQueued = merge; }
+	/// Share a limit with other runnables. Set it before starting anything, and make sure it
+	/// outlives this.
+	void							setExecutor(RunnableExecutor&);
+	RunnableExecutor&				getExecutor() { return *mExecutor; }
 
 private:
 	void							receive(std::unique_ptr<Poco::Runnable>&);
+	void							dropped(std::unique_ptr<Poco::Runnable>&);
+	void							recycle(std::unique_ptr<T>&);
 
-	RunnableClient					mClient;
+	RunnableExecutor				mOwnExecutor;
+	RunnableExecutor*				mExecutor;
 	std::vector<std::unique_ptr<T>>	mCache;
 	HandlerFunc						mReplyHandler;
+	HandlerFunc						mDroppedHandler;
 	std::function<T*(void)>			mAlloc;
+	bool							mMergeQueued;
 };
 
 template <class T>
 ParallelRunnable<T>::ParallelRunnable(ui::SpriteEngine& se, const std::function<T*(void)>& alloc)
-		: mClient(se)
+		: mOwnExecutor(se)
+		, mExecutor(&mOwnExecutor)
 		, mReplyHandler(nullptr)
-		, mAlloc(alloc) {
+		, mDroppedHandler(nullptr)
+		, mAlloc(alloc)
+		, mMergeQueued(false) {
 	mCache.reserve(4);
-	mClient.setResultHandler([this](std::unique_ptr<Poco::Runnable>& r) { receive(r); });
+}
+
+template <class T>
+ParallelRunnable<T>::~ParallelRunnable() {
+	if (mExecutor != &mOwnExecutor) mExecutor->forget(this);
+}
+
+template <class T>
+void ParallelRunnable<T>::setMaxRunning(const size_t maxRunning, const RunnableExecutor::QueuePolicy policy, const size_t maxQueued) {
+	mExecutor->setMaxRunning(maxRunning);
+	mExecutor->setQueuePolicy(policy, maxQueued);
+}
+
+template <class T>
+void ParallelRunnable<T>::setExecutor(RunnableExecutor& e) {
+	if (mExecutor != &mOwnExecutor) mExecutor->forget(this);
+	mExecutor = &e;
 }
 
 template <class T>
@@ -68,9 +111,16 @@ bool ParallelRunnable<T>::start(const HandlerFunc& f) {
 
 	if (f) f(*(up.get()));
 
-  std::unique_ptr<Poco::Runnable>		payload(ds::unique_dynamic_cast<Poco::Runnable, T>(up));
-  if (!payload) return false;
-  return mClient.run(payload);
+	std::unique_ptr<Poco::Runnable>		payload(ds::unique_dynamic_cast<Poco::Runnable, T>(up));
+	if (!payload) return false;
+	if (mExecutor->run(payload, this,	[this](std::unique_ptr<Poco::Runnable>& r) { receive(r); },
+										[this](std::unique_ptr<Poco::Runnable>& r) { dropped(r); }, mMergeQueued)) {
+		return true;
+	}
+	// Refused, so it goes straight back in the cache
+	std::unique_ptr<T>					back(ds::unique_dynamic_cast<T, Poco::Runnable>(payload));
+	recycle(back);
+	return false;
 }
 
 template <class T>
@@ -80,10 +130,24 @@ void ParallelRunnable<T>::receive(std::unique_ptr<Poco::Runnable>& r) {
 		assert(false);
 	} else {
 		if (mReplyHandler) mReplyHandler(*(payload.get()));
-		try {
-			mCache.push_back(std::move(payload));
-		} catch (std::exception const&) {
-		}
+		recycle(payload);
+	}
+}
+
+template <class T>
+void ParallelRunnable<T>::dropped(std::unique_ptr<Poco::Runnable>& r) {
+	std::unique_ptr<T>		payload(ds::unique_dynamic_cast<T, Poco::Runnable>(r));
+	if (!payload) return;
+	if (mDroppedHandler) mDroppedHandler(*(payload.get()));
+	recycle(payload);
+}
+
+template <class T>
+void ParallelRunnable<T>::recycle(std::unique_ptr<T>& payload) {
+	if (!payload) return;
+	try {
+		mCache.push_back(std::move(payload));
+	} catch (std::exception const&) {
 	}
 }
 
@@ -22,6 +22,11 @@ void RunnableClient::setResultHandler(const std::function<void(std::unique_ptr<P
 	mResultHandler = h;
 }
 
+void RunnableClient::setCancelledHandler(const std::function<void(std::unique_ptr<Poco::Runnable>&)>& h)
+{
+	mCancelledHandler = h;
+}
+
 bool RunnableClient::run(std::unique_ptr<Poco::Runnable>& payload)
 {
 	if (!payload) return false;
@@ -30,6 +35,7 @@ bool RunnableClient::run(std::unique_ptr<Poco::Runnable>& payload)
 	if (!r) return false;
 
 	r.get()->mPayload = std::move(payload);
+	prepareRequest(*r);
 	return mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, Request>(r));
 }
 
@@ -43,6 +49,16 @@ void RunnableClient::handleResult(std::unique_ptr<WorkRequest>& wr)
 	mCache.push(r);
 }
 
+void RunnableClient::handleCancelled(std::unique_ptr<WorkRequest>& wr)
+{
+	std::unique_ptr<Request>		r(ds::unique_dynamic_cast<Request, WorkRequest>(wr));
+	if (!r) return;
+
+	if (mCancelledHandler) mCancelledHandler(r.get()->mPayload);
+	r.get()->mPayload.reset();
+	mCache.push(r);
+}
+
 /**
  * \class Request
  */
@@ -19,11 +19,14 @@ public:
 	RunnableClient(ui::SpriteEngine&, const std::function<void(std::unique_ptr<Poco::Runnable>&)>& = nullptr);
 	
 	void						setResultHandler(const std::function<void(std::unique_ptr<Poco::Runnable>&)>&);
+	/// Runnables that were cancelled come back here instead. Without a handler they're deleted.
+	void						setCancelledHandler(const std::function<void(std::unique_ptr<Poco::Runnable>&)>&);
 
 	bool						run(std::unique_ptr<Poco::Runnable>&);
 
 protected:
 	virtual void				handleResult(std::unique_ptr<WorkRequest>&);
+	virtual void				handleCancelled(std::unique_ptr<WorkRequest>&);
 
 private:
 	typedef WorkClient			inherited;
@@ -40,7 +43,8 @@ private:
 	WorkRequestList<Request>	mCache;
 
 	std::function<void(std::unique_ptr<Poco::Runnable>&)>
-								mResultHandler;
+								mResultHandler,
+								mCancelledHandler;
 };
 
 } // namespace ds
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+
+#include "ds/thread/runnable_executor.h"
+
+#include <ds/debug/logger.h>
+
+namespace ds {
+
+/**
+ * \class RunnableExecutor
+ */
+RunnableExecutor::RunnableExecutor(ui::SpriteEngine& se, const size_t maxRunning)
+	: mClient(se)
+	, mMaxRunning(maxRunning)
+	, mQueuePolicy(QUEUE_ALL)
+	, mMaxQueued(0)
+	, mPeakQueued(0)
+	, mStarted(0)
+	, mCompleted(0)
+	, mDropped(0)
+	, mMerged(0)
+{
+	mClient.setResultHandler([this](std::unique_ptr<Poco::Runnable>& r) { receive(r, false); });
+	mClient.setCancelledHandler([this](std::unique_ptr<Poco::Runnable>& r) { receive(r, true); });
+}
+
+RunnableExecutor::~RunnableExecutor()
+{
+	// Owners might already be gone, so anything left is just deleted.
+	mQueue.clear();
+	mRunning.clear();
+}
+
+void RunnableExecutor::setMaxRunning(const size_t maxRunning)
+{
+	mMaxRunning = maxRunning;
+	sendQueued();
+}
+
+void RunnableExecutor::setQueuePolicy(const QueuePolicy policy, const size_t maxQueued)
+{
+	mQueuePolicy = policy;
+	mMaxQueued = maxQueued;
+	if (mQueuePolicy == QUEUE_ALL) return;
+
+	// Trim anything that no longer fits, oldest or newest first depending on the policy
+	while (mQueue.size() > mMaxQueued) {
+		if (mQueuePolicy == QUEUE_DROP_OLDEST) {
+			drop(mQueue.front());
+			mQueue.pop_front();
+		} else {
+			drop(mQueue.back());
+			mQueue.pop_back();
+		}
+	}
+}
+
+bool RunnableExecutor::run(std::unique_ptr<Poco::Runnable>& payload, const void* owner, const PayloadFn& result,
+						   const PayloadFn& dropped, const bool merge)
+{
+	if (!payload) return false;
+
+	Start						s;
+	s.mPayload = std::move(payload);
+	s.mOwner = owner;
+	s.mResult = result;
+	s.mDropped = dropped;
+
+	if (merge) {
+		for (auto it = mQueue.begin(), end = mQueue.end(); it != end; ++it) {
+			if (it->mOwner != owner) continue;
+			// Keep its place in line, the newer start just takes it over
+			Start				old(std::move(*it));
+			*it = std::move(s);
+			++mMerged;
+			handBack(old);
+			return true;
+		}
+	}
+
+	if (mQueue.empty() && hasRoom()) {
+		if (send(s)) return true;
+		payload = std::move(s.mPayload);
+		++mDropped;
+		return false;
+	}
+
+	if (mQueuePolicy != QUEUE_ALL && mQueue.size() >= mMaxQueued) {
+		if (mQueuePolicy == QUEUE_DROP_NEWEST || mMaxQueued < 1) {
+			payload = std::move(s.mPayload);
+			++mDropped;
+			return false;
+		}
+		drop(mQueue.front());
+		mQueue.pop_front();
+	}
+
+	mQueue.push_back(std::move(s));
+	if (mQueue.size() > mPeakQueued) mPeakQueued = mQueue.size();
+	return true;
+}
+
+void RunnableExecutor::forget(const void* owner)
+{
+	for (auto it = mQueue.begin(); it != mQueue.end(); ) {
+		if (it->mOwner == owner) it = mQueue.erase(it);
+		else ++it;
+	}
+	for (auto it = mRunning.begin(), end = mRunning.end(); it != end; ++it) {
+		if (it->second.mOwner != owner) continue;
+		it->second.mOwner = nullptr;
+		it->second.mResult = nullptr;
+		it->second.mDropped = nullptr;
+	}
+}
+
+void RunnableExecutor::cancel()
+{
+	// Dropped functions can start new work, which should wait until this is done
+	std::deque<Start>			queue;
+	queue.swap(mQueue);
+	for (auto it = queue.begin(), end = queue.end(); it != end; ++it) drop(*it);
+	mClient.cancelRequests();
+}
+
+void RunnableExecutor::resetCounters()
+{
+	mPeakQueued = mQueue.size();
+	mStarted = 0;
+	mCompleted = 0;
+	mDropped = 0;
+	mMerged = 0;
+}
+
+bool RunnableExecutor::hasRoom() const
+{
+	return mMaxRunning < 1 || mRunning.size() < mMaxRunning;
+}
+
+bool RunnableExecutor::send(Start& s)
+{
+	const Poco::Runnable*		key = s.mPayload.get();
+	std::unique_ptr<Poco::Runnable>
+								payload(std::move(s.mPayload));
+	// In the map first, in case the work manager is somehow quicker than this
+	mRunning[key] = std::move(s);
+	if (!mClient.run(payload)) {
+		// The work manager is shutting down. It might have deleted the payload already.
+		s = std::move(mRunning[key]);
+		mRunning.erase(key);
+		s.mPayload = std::move(payload);
+		DS_LOG_WARNING("RunnableExecutor couldn't start a runnable");
+		return false;
+	}
+	++mStarted;
+	return true;
+}
+
+void RunnableExecutor::sendQueued()
+{
+	while (!mQueue.empty() && hasRoom()) {
+		Start					s(std::move(mQueue.front()));
+		mQueue.pop_front();
+		if (!send(s)) drop(s);
+	}
+}
+
+void RunnableExecutor::drop(Start& s)
+{
+	++mDropped;
+	handBack(s);
+}
+
+void RunnableExecutor::handBack(Start& s)
+{
+	if (s.mDropped && s.mPayload) s.mDropped(s.mPayload);
+	s.mPayload.reset();
+}
+
+void RunnableExecutor::receive(std::unique_ptr<Poco::Runnable>& payload, const bool cancelled)
+{
+	Start						s;
+	auto						found = mRunning.find(payload.get());
+	if (found != mRunning.end()) {
+		s = std::move(found->second);
+		mRunning.erase(found);
+	}
+	s.mPayload = std::move(payload);
+
+	// Fill the freed slot before handing the result out, so the handler's own starts line up behind it
+	sendQueued();
+
+	if (cancelled) {
+		drop(s);
+		return;
+	}
+	++mCompleted;
+	if (s.mResult) s.mResult(s.mPayload);
+}
+
+} // namespace ds
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef DS_THREAD_RUNNABLEEXECUTOR_H_
+#define DS_THREAD_RUNNABLEEXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "ds/thread/runnable_client.h"
+
+namespace ds {
+
+/**
+ * \class RunnableExecutor
+ * \brief Runs Poco::Runnables on the work manager, but never more than a set number at
+ * once. Anything started past the limit waits in a queue, and what happens when that
+ * queue fills up is up to the queue policy. Several ParallelRunnables and SerialRunnables
+ * can share one executor, so for example every PDF thumbnail in the app can be held to
+ * two reads at a time.
+ *
+ * Main thread only, like the rest of the work clients. Everything started is owned by
+ * the executor until it comes back through its result or dropped function.
+ */
+class RunnableExecutor {
+public:
+	typedef std::function<void(std::unique_ptr<Poco::Runnable>&)>	PayloadFn;
+
+	enum QueuePolicy {
+		QUEUE_ALL,			// Everything waits its turn, the queue is never full
+		QUEUE_DROP_NEWEST,	// When the queue is full, new starts are refused
+		QUEUE_DROP_OLDEST	// When the queue is full, new starts push out the one that's been waiting longest
+	};
+
+	/// 0 running means no limit, which is how the work manager behaves on its own.
+	RunnableExecutor(ui::SpriteEngine&, const size_t maxRunning = 0);
+	~RunnableExecutor();
+
+	void						setMaxRunning(const size_t);
+	size_t						getMaxRunning() const	{ return mMaxRunning; }
+	/// maxQueued is ignored for QUEUE_ALL.
+	void						setQueuePolicy(const QueuePolicy, const size_t maxQueued);
+	QueuePolicy					getQueuePolicy() const	{ return mQueuePolicy; }
+	size_t						getMaxQueued() const	{ return mMaxQueued; }
+	void						setRequestPriority(const WorkRequest::Priority p) { mClient.setRequestPriority(p); }
+
+	/// Run it as soon as there's room. The owner is whoever started it, so it can be
+	/// forgotten, and with merge set a start still waiting for the same owner is replaced
+	/// by this one. The result function gets the payload back when it's done, the dropped
+	/// function when it's pushed out, merged away or cancelled.
+	/// Answers false, and leaves the payload alone, if it was refused.
+	bool						run(std::unique_ptr<Poco::Runnable>&, const void* owner, const PayloadFn& result,
+									const PayloadFn& dropped = nullptr, const bool merge = false);
+
+	/// Throw away everything the owner started that hasn't started running, and ignore
+	/// the results of the rest. Owners sharing an executor must call this before they go away.
+	void						forget(const void* owner);
+	/// Drop everything that's waiting and cancel everything that's running.
+	void						cancel();
+
+	/// Queue depth and counters, for tuning the limit.
+	size_t						getRunning() const		{ return mRunning.size(); }
+	size_t						getQueued() const		{ return mQueue.size(); }
+	size_t						getPeakQueued() const	{ return mPeakQueued; }
+	size_t						getStarted() const		{ return mStarted; }
+	size_t						getCompleted() const	{ return mCompleted; }
+	size_t						getDropped() const		{ return mDropped; }
+	size_t						getMerged() const		{ return mMerged; }
+	void						resetCounters();
+
+private:
+	RunnableExecutor(const RunnableExecutor&);
+	RunnableExecutor&			operator=(const RunnableExecutor&);
+
+	class Start {
+	public:
+		Start() : mOwner(nullptr) { }
+
+		std::unique_ptr<Poco::Runnable>
+								mPayload;
+		const void*				mOwner;
+		PayloadFn				mResult;
+		PayloadFn				mDropped;
+	};
+
+	bool						hasRoom() const;
+	bool						send(Start&);
+	void						sendQueued();
+	void						drop(Start&);
+	/// Give the payload back through the dropped function, without counting it
+	void						handBack(Start&);
+	void						receive(std::unique_ptr<Poco::Runnable>&, const bool cancelled);
+
+	RunnableClient				mClient;
+	size_t						mMaxRunning;
+	QueuePolicy					mQueuePolicy;
+	size_t						mMaxQueued;
+	std::deque<Start>			mQueue;
+	/// Whatever's on the work manager right now, by payload
+	std::unordered_map<const Poco::Runnable*, Start>
+								mRunning;
+
+	size_t						mPeakQueued;
+	size_t						mStarted;
+	size_t						mCompleted;
+	size_t						mDropped;
+	size_t						mMerged;
+};
+
+} // namespace ds
+
+#endif // DS_THREAD_RUNNABLEEXECUTOR_H_
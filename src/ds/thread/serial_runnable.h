@@ -4,7 +4,7 @@
 
 #include <functional>
 #include <vector>
-#include "ds/thread/runnable_client.h"
+#include "ds/thread/runnable_executor.h"
 #include "ds/util/memory_ds.h"
 #include <ds/debug/logger.h>
 
@@ -27,6 +27,11 @@ namespace ds {
  * really need an op to start immediately, they should probably include
  * a way to stop the running operation.
  *
+ * Lots of serial runnables (one per thumbnail, say) can share a
+ * RunnableExecutor so only a few of them run at once. If the shared
+ * executor drops a start, it's gone; the runnable just goes back to
+ * waiting for the next start().
+ *
  *** IMPLICIT INTERFACE
  *
  * T is a subclass of Poco::Runnable
@@ -40,9 +45,15 @@ public:
 	/// The alloc function is to create a new instance of the runnable, required
 	/// NotifyWhenWaiting will send the reply handler even if there's another serial runnable about to be run
 	SerialRunnable(	ui::SpriteEngine&,	const std::function<T*(void)>& alloc, const bool notifyWhenWaiting = false);
+	~SerialRunnable();
 	
 	void					setReplyHandler(const HandlerFunc& f) { mReplyHandler = f; }
 
+	/// Share a limit with other runnables. Set it before starting anything, and make sure it
+	/// outlives this.
+	void					setExecutor(RunnableExecutor&);
+	RunnableExecutor&		getExecutor() { return *mExecutor; }
+
 	/// Start a new runnable, initializing it via the handler block.  Any previous, unfinished runs
 	/// will be ignored.
 	/// If waitForResult is true, this will be run synchronously, blocking until the operation is finished.
@@ -56,8 +67,10 @@ public:
 private:
 	bool					send();
 	void					receive(std::unique_ptr<Poco::Runnable>&);
+	void					dropped(std::unique_ptr<Poco::Runnable>&);
 
-	RunnableClient			mClient;
+	RunnableExecutor		mOwnExecutor;
+	RunnableExecutor*		mExecutor;
 	enum State {
 		CACHED,				// mCache is valid, nothing is running --NOTE this state is redundant with mCache existing, so favour that
 		RUNNING,			// mCache is empty, and as soon as I receive something, I'm done
@@ -73,7 +86,8 @@ private:
 
 template <class T>
 SerialRunnable<T>::SerialRunnable(ui::SpriteEngine& se, const std::function<T*(void)>& alloc, const bool notifyWhenWaiting)
-		: mClient(se)
+		: mOwnExecutor(se)
+		, mExecutor(&mOwnExecutor)
 		, mState(CACHED)
 		, mReplyHandler(nullptr)
 		, mStartHandler(nullptr)
@@ -89,8 +103,17 @@ SerialRunnable<T>::SerialRunnable(ui::SpriteEngine& se, const std::function<T*(v
 	if(!mCache) {
 		DS_LOG_WARNING("Can't allocate serial runnable");
 	}
+}
+
+template <class T>
+SerialRunnable<T>::~SerialRunnable() {
+	if (mExecutor != &mOwnExecutor) mExecutor->forget(this);
+}
 
-	mClient.setResultHandler([this](std::unique_ptr<Poco::Runnable>& r) { receive(r); });
+template <class T>
+void SerialRunnable<T>::setExecutor(RunnableExecutor& e) {
+	if (mExecutor != &mOwnExecutor) mExecutor->forget(this);
+	mExecutor = &e;
 }
 
 template <class T>
@@ -129,7 +152,13 @@ bool SerialRunnable<T>::send() {
 	std::unique_ptr<Poco::Runnable>		payload(ds::unique_dynamic_cast<Poco::Runnable, T>(mCache));
 	if (!payload) return false;
 
-	if (!mClient.run(payload)) return false;
+	if (!mExecutor->run(payload, this,	[this](std::unique_ptr<Poco::Runnable>& r) { receive(r); },
+										[this](std::unique_ptr<Poco::Runnable>& r) { dropped(r); })) {
+		// Refused, so hang on to it for next time
+		mCache = ds::unique_dynamic_cast<T, Poco::Runnable>(payload);
+		mState = CACHED;
+		return false;
+	}
 
 	mState = RUNNING;
 	return true;
@@ -152,6 +181,15 @@ void SerialRunnable<T>::receive(std::unique_ptr<Poco::Runnable>& r) {
 	}
 }
 
+template <class T>
+void SerialRunnable<T>::dropped(std::unique_ptr<Poco::Runnable>& r) {
+	// Don't try again, even if there's a start waiting: with a full shared queue that would
+	// just push out someone else's start, who'd push out this one.
+	mCache = ds::unique_dynamic_cast<T, Poco::Runnable>(r);
+	mStartHandler = nullptr;
+	mState = CACHED;
+}
+
 } // namespace ds
 
 #endif // DS_THREAD_SERIALRUNNABLE_H_
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef DS_THREAD_SPSCQUEUE_H_
+#define DS_THREAD_SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ds {
+
+/**
+ * \class SpscQueue
+ * \brief Lock-free, fixed size queue for exactly one thread pushing and exactly one other
+ * thread popping. Neither side ever blocks: push() answers false when the queue is full,
+ * pop() answers false when it's empty. Entries are moved in and out, so large entries
+ * (strings, buffers) can be passed between threads without copying.
+ */
+template <typename T>
+class SpscQueue {
+public:
+	/// The capacity is rounded up to a power of two.
+	explicit SpscQueue(const size_t capacity = 256);
+
+	/// Only call from the producing thread.
+	bool					push(T&&);
+	/// Only call from the consuming thread.
+	bool					pop(T&);
+
+	/// Only approximate while the other thread is busy.
+	size_t					size() const;
+	bool					empty() const { return size() == 0; }
+	size_t					capacity() const { return mSlots.size(); }
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue&				operator=(const SpscQueue&);
+
+	std::vector<T>			mSlots;
+	size_t					mMask;
+	/// Next slot to pop, only written by the consumer
+	std::atomic<size_t>		mHead;
+	/// Next slot to push, only written by the producer
+	std::atomic<size_t>		mTail;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(const size_t capacity)
+		: mHead(0)
+		, mTail(0)
+{
+	size_t		size = 2;
+	while(size < capacity) size *= 2;
+	mSlots.resize(size);
+	mMask = size - 1;
+}
+
+template <typename T>
+bool SpscQueue<T>::push(T&& t)
+{
+	const size_t	tail = mTail.load(std::memory_order_relaxed);
+	if(tail - mHead.load(std::memory_order_acquire) >= mSlots.size()) return false;
+
+	mSlots[tail & mMask] = std::move(t);
+	mTail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::pop(T& t)
+{
+	const size_t	head = mHead.load(std::memory_order_relaxed);
+	if(head == mTail.load(std::memory_order_acquire)) return false;
+
+	t = std::move(mSlots[head & mMask]);
+	mHead.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+size_t SpscQueue<T>::size() const
+{
+	return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+}
+
+} // namespace ds
+
+#endif // DS_THREAD_SPSCQUEUE_H_
@@ -12,6 +12,7 @@ namespace ds {
  */
 WorkClient::WorkClient(ui::SpriteEngine& e)
 	: mManager(e.getWorkManager())
+	, mRequestPriority(WorkRequest::PRIORITY_NORMAL)
 {
 	mManager.addClient(*this);
 }
@@ -21,8 +22,31 @@ WorkClient::~WorkClient()
 	mManager.removeClient(*this);
 }
 
+void WorkClient::setRequestPriority(const WorkRequest::Priority p)
+{
+	if (p < WorkRequest::PRIORITY_HIGH || p >= WorkRequest::PRIORITY_COUNT) return;
+	mRequestPriority = p;
+}
+
+void WorkClient::cancelRequests()
+{
+	// Everything already sent shares the old token, new requests get a fresh one.
+	mCancelToken.cancel();
+	mCancelToken = CancelToken();
+}
+
 void WorkClient::handleResult(std::unique_ptr<WorkRequest>&)
 {
 }
 
+void WorkClient::handleCancelled(std::unique_ptr<WorkRequest>&)
+{
+}
+
+void WorkClient::prepareRequest(WorkRequest& r) const
+{
+	r.setPriority(mRequestPriority);
+	r.setCancelToken(mCancelToken);
+}
+
 } // namespace ds
@@ -22,14 +22,33 @@ public:
 	WorkClient(ui::SpriteEngine&);
 	virtual ~WorkClient();
 
+	/// Applies to everything sent after this. Quick, latency-sensitive clients
+	/// (thumbnails, UI lookups) should go high, bulk loads low.
+	void					setRequestPriority(const WorkRequest::Priority);
+	WorkRequest::Priority	getRequestPriority() const		{ return mRequestPriority; }
+
+	/// Cancel everything sent so far that hasn't come back yet. Requests that haven't
+	/// started are skipped, and they all come back through handleCancelled() instead
+	/// of handleResult().
+	void					cancelRequests();
+
 protected:
 	friend class WorkManager;
 
 	/// Subclasses should take ownership if they want to recycle the request.
 	virtual void			handleResult(std::unique_ptr<WorkRequest>&);
+	/// A request that was cancelled before or while running, or that threw. By default it's just deleted.
+	virtual void			handleCancelled(std::unique_ptr<WorkRequest>&);
+
+	/// Give the request this client's priority and cancel token. Call before sending.
+	void					prepareRequest(WorkRequest&) const;
 
 protected:
 	WorkManager&			mManager;
+
+private:
+	WorkRequest::Priority	mRequestPriority;
+	CancelToken				mCancelToken;
 };
 
 } // namespace ds
@@ -4,25 +4,60 @@
 
 #include <algorithm>
 #include <iostream>
+#include <typeinfo>
+#include <Poco/Environment.h>
+#include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
 #include "ds/thread/work_client.h"
 
 using namespace ds;
 //using namespace std;
 
 static const std::string					WORK_THREAD_NAME("ds_work");
+// Keep at least 4 threads running, because we use this for all async ops, and
+// plenty of those (queries, http) spend most of their time blocked.
+static const unsigned						MIN_WORKERS = 4;
+static const unsigned						MAX_WORKERS = 16;
+// Idle workers check back this often even if nobody wakes them, just in case
+static const long							IDLE_WAIT_MS = 250;
+// Default time update() can spend handing out results per frame
+static const int							DEFAULT_UPDATE_BUDGET_MICROS = 2000;
 
 /**
  * \class WorkManager
  */
 WorkManager::WorkManager()
-	: mPool(WORK_THREAD_NAME, 4, 16)		// Keep at least 4 threads running, because we use this for all async ops
-//	: mPool(WORK_THREAD_NAME, 1, 1)
-	, mLoop(*this)
+	: mNextWorker(0)
+	, mStopped(false)
+	, mNextResults(0)
+	, mResultCount(0)
+	, mBudgetMicroseconds(DEFAULT_UPDATE_BUDGET_MICROS)
+	, mBudgetResults(0)
 {
 	mClient.reserve(64);
-	mInput.reserve(64);
-	mOutput.reserve(64);
-	mOutputTmp.reserve(64);
+	mResults.reserve(64);
+	for (int p = 0; p < WorkRequest::PRIORITY_COUNT; ++p) {
+		mQueued[p] = 0;
+	}
+
+	const unsigned		count = std::min(MAX_WORKERS, std::max(MIN_WORKERS, Poco::Environment::processorCount()));
+	mWorkers.reserve(count);
+	for (unsigned k = 0; k < count; ++k) {
+		try {
+			std::unique_ptr<Worker>		w(new Worker(*this, mWorkers.size()));
+			w->mThread.setName(WORK_THREAD_NAME);
+			w->mThread.setPriority(Poco::Thread::PRIO_LOW);
+			mWorkers.push_back(std::move(w));
+		} catch (std::exception const&) {
+		}
+	}
+	// Only start once the list is done growing, since the workers steal from each other
+	for (auto it=mWorkers.begin(), end=mWorkers.end(); it != end; ++it) {
+		try {
+			(*it)->mThread.start(**it);
+		} catch (std::exception const&) {
+		}
+	}
 }
 
 WorkManager::~WorkManager()
@@ -32,7 +67,7 @@ WorkManager::~WorkManager()
 
 void WorkManager::addClient(WorkClient& c)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
+	Poco::Mutex::ScopedLock		l(mClientMutex);
 	try {
 		mClient.push_back(&c);
 	} catch (std::exception const&) {
@@ -41,7 +76,7 @@ void WorkManager::addClient(WorkClient& c)
 
 void WorkManager::removeClient(WorkClient& c)
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
+	Poco::Mutex::ScopedLock		l(mClientMutex);
 	try {
 		mClient.erase( remove( mClient.begin(), mClient.end(), &c ), mClient.end() );
 	} catch (std::exception const&) {
@@ -50,105 +85,207 @@ void WorkManager::removeClient(WorkClient& c)
 
 bool WorkManager::sendRequest(std::unique_ptr<WorkRequest> upR, Poco::Timestamp* sendTime)
 {
-	if (!upR.get()) return false;
-	// Push new input onto the stack
+	if (!upR.get() || mWorkers.empty()) return false;
+
+	int							priority = upR->mPriority;
+	if (priority < WorkRequest::PRIORITY_HIGH || priority >= WorkRequest::PRIORITY_COUNT) priority = WorkRequest::PRIORITY_NORMAL;
+	upR->mRequestTime = Poco::Timestamp();
+	if (sendTime) *sendTime = upR->mRequestTime;
+
+	// Push new input onto a worker's queue
 	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
+		Poco::FastMutex::ScopedLock	l(mIdleMutex);
+		if (mStopped) return false;
+	}
+	Worker&						w = pickWorker();
+	{
+		Poco::FastMutex::ScopedLock	l(w.mMutex);
 		try {
-			upR.get()->mRequestTime = Poco::Timestamp();
-			if (sendTime) *sendTime = upR.get()->mRequestTime;
-			mInput.push_back(std::move(upR));
+			w.mQueue[priority].push_back(std::move(upR));
 		} catch (std::exception&) {
 			return false;
 		}
 	}
-	return inputAdded();
+	++mQueued[priority];
+
+	// Wake someone up. The idle lock makes sure a worker that just found nothing
+	// to do is either already waiting or will see the new count.
+	Poco::FastMutex::ScopedLock	l(mIdleMutex);
+	mIdle.signal();
+	return true;
 }
 
 void WorkManager::stopManager()
 {
-	// Clear out the inputs so the threads will finish.
 	{
-		Poco::Mutex::ScopedLock		l(mInputMutex);
-		mInput.clear();
+		Poco::FastMutex::ScopedLock	l(mIdleMutex);
+		if (mStopped) return;
+		mStopped = true;
+		mIdle.broadcast();
 	}
 
-	try {
-		mPool.joinAll();
-	} catch (std::exception&) {
+	// Clear out the inputs so the threads will finish.
+	for (auto it=mWorkers.begin(), end=mWorkers.end(); it != end; ++it) {
+		Poco::FastMutex::ScopedLock	l((*it)->mMutex);
+		for (int p = 0; p < WorkRequest::PRIORITY_COUNT; ++p) {
+			(*it)->mQueue[p].clear();
+		}
+	}
+	for (int p = 0; p < WorkRequest::PRIORITY_COUNT; ++p) {
+		mQueued[p] = 0;
+	}
+
+	for (auto it=mWorkers.begin(), end=mWorkers.end(); it != end; ++it) {
+		try {
+			(*it)->mThread.join();
+		} catch (std::exception&) {
+		}
 	}
 }
 
 void WorkManager::update()
 {
-	// To control how much processing the client does, pop off a single result
-	// in an update cycle.
-	mOutputTmp.clear();
-	{
-		Poco::Mutex::ScopedLock		l(mOutputMutex);
-		if (!mOutput.empty()) {
-			// I suspect there's a 1-line way to do this but haven't found it so far
-//			std::move(mOutput.begin(), mOutput.begin()+1, mOutputTmp.end());
-			std::unique_ptr<WorkRequest>	r(std::move(mOutput.front()));
-			mOutput.erase(mOutput.begin());
-			mOutputTmp.push_back(std::move(r));
+	DS_PROFILE_ZONE("WorkManager update");
+	sortOutput();
+	if (mResultCount < 1) return;
+
+	const Poco::Timestamp			start;
+	int								handled = 0;
+	Poco::Mutex::ScopedLock			l(mClientMutex);
+	while (mResultCount > 0) {
+		if (handled > 0) {
+			if (mBudgetResults > 0 && handled >= mBudgetResults) break;
+			if (mBudgetMicroseconds > 0 && start.elapsed() >= mBudgetMicroseconds) break;
 		}
+
+		// Next client in line with something waiting
+		if (mNextResults >= mResults.size()) mNextResults = 0;
+		RequestQueue&				q = mResults[mNextResults++]->mResults;
+		if (q.empty()) continue;
+
+		std::unique_ptr<WorkRequest>	r(std::move(q.front()));
+		q.pop_front();
+		--mResultCount;
+		if (!r) continue;
+		// Any requests that weren't claimed by a client are lost
+		WorkClient*					client = findClientLocked(r->mClientId);
+		if (!client) continue;
+
+		if (r->isCancelled()) client->handleCancelled(r);
+		else client->handleResult(r);
+		++handled;
 	}
-	if (mOutputTmp.empty()) return;
 
+	if (mResultCount < 1) pruneResultsLocked();
+}
+
+void WorkManager::setUpdateBudget(const int microseconds, const int maxResults)
+{
+	mBudgetMicroseconds = std::max(0, microseconds);
+	mBudgetResults = std::max(0, maxResults);
+}
+
+void WorkManager::sortOutput()
+{
 	{
-		Poco::Mutex::ScopedLock		l(mClientMutex);
-		for (auto it=mOutputTmp.begin(), end=mOutputTmp.end(); it != end; ++it) {
-			WorkRequest*			r(it->get());
-			if (!r) continue;
-			WorkClient*				client = findClientLocked(r->mClientId);
-			if (!client) continue;
-
-			client->handleResult(*it);
+		Poco::Mutex::ScopedLock		l(mOutputMutex);
+		if (mOutput.empty()) return;
+		mOutput.swap(mOutputTmp);
+	}
+
+	ClientResults*					last = nullptr;
+	for (auto it=mOutputTmp.begin(), end=mOutputTmp.end(); it != end; ++it) {
+		if (!*it) continue;
+		const void*					id = (*it)->mClientId;
+		// Results tend to come in runs from the same client
+		if (!last || last->mClientId != id) {
+			last = nullptr;
+			for (auto rit=mResults.begin(), rend=mResults.end(); rit != rend; ++rit) {
+				if ((*rit)->mClientId == id) {
+					last = rit->get();
+					break;
+				}
+			}
+			if (!last) {
+				try {
+					mResults.push_back(std::unique_ptr<ClientResults>(new ClientResults(id)));
+				} catch (std::exception const&) {
+					continue;
+				}
+				last = mResults.back().get();
+			}
+		}
+		try {
+			last->mResults.push_back(std::move(*it));
+			++mResultCount;
+		} catch (std::exception const&) {
 		}
 	}
-	// Any requests that weren't claimed by a client are lost
 	mOutputTmp.clear();
 }
 
-bool WorkManager::inputAdded()
+void WorkManager::pruneResultsLocked()
 {
-	// Start a new thread to handle the input.  If we can't start one, no big deal,
-	// that means we've got threads running that will handle it.  And note that
-	// we always have a minimum number of threads running, so there's always someone
-	// who can handle it eventually.
-	try {
-		// This is a little ugly, but I have VS set to break on handled exceptions, which I want
-		// in general.  However, it's pretty easy to use up my thread pool, and I don't care
-		// about those warnings.  BUT, in practice, I imagine there's a remote possibility that
-		// somewhere after checking if threads are available but before calling start(), all the
-		// threads might HAVE been in use but time out, causing a thread not to get started.
-		// Granted, even if this happens it just means an input will sit there until someone
-		// else starts a thread, but still, in practice, I always want to try and create a thread.
-#ifdef _DEBUG
-		if (mPool.available() > 1) {
-			mPool.startWithPriority(Poco::Thread::PRIO_LOW, mLoop);
+	mResults.erase(std::remove_if(mResults.begin(), mResults.end(),
+			[this](const std::unique_ptr<ClientResults>& c) { return c->mResults.empty() && !findClientLocked(c->mClientId); }),
+			mResults.end());
+	mNextResults = 0;
+}
+
+WorkManager::Worker& WorkManager::pickWorker()
+{
+	// Work spawned by a request stays on its thread, where it's likely to be run
+	// soon after. Anything else gets dealt out evenly.
+	Poco::Thread*				current = Poco::Thread::current();
+	if (current) {
+		for (auto it=mWorkers.begin(), end=mWorkers.end(); it != end; ++it) {
+			if (&(*it)->mThread == current) return **it;
 		}
-#else
-		mPool.startWithPriority(Poco::Thread::PRIO_LOW, mLoop);
-#endif
-	} catch (Poco::NoThreadAvailableException&) {
-	} catch (std::exception&) {
 	}
+	return *mWorkers[mNextWorker++ % mWorkers.size()];
+}
 
+bool WorkManager::popNextInput(const size_t workerIndex, std::unique_ptr<WorkRequest>& out)
+{
+	const size_t				count = mWorkers.size();
+	for (int p = 0; p < WorkRequest::PRIORITY_COUNT; ++p) {
+		if (mQueued[p] < 1) continue;
+		for (size_t k = 0; k < count; ++k) {
+			if (popInputFrom(*mWorkers[(workerIndex + k) % count], p, out)) {
+				--mQueued[p];
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool WorkManager::popInputFrom(Worker& w, const int priority, std::unique_ptr<WorkRequest>& out)
+{
+	Poco::FastMutex::ScopedLock	l(w.mMutex);
+	auto&						q = w.mQueue[priority];
+	if (q.empty()) return false;
+	out = std::move(q.front());
+	q.pop_front();
 	return true;
 }
 
-void WorkManager::popNextInput(RequestList& in)
+int WorkManager::getQueuedCount() const
 {
-	Poco::Mutex::ScopedLock		l(mInputMutex);
-	if (!mInput.empty()) {
-		if (in.empty()) {
-			in.swap(mInput);
-		} else {
-			std::move(mInput.begin(), mInput.end(), in.begin());
-		}
+	int							ans = 0;
+	for (int p = 0; p < WorkRequest::PRIORITY_COUNT; ++p) {
+		ans += mQueued[p];
+	}
+	return ans;
+}
+
+bool WorkManager::waitForInput()
+{
+	Poco::FastMutex::ScopedLock	l(mIdleMutex);
+	if (!mStopped && getQueuedCount() < 1) {
+		mIdle.tryWait(mIdleMutex, IDLE_WAIT_MS);
 	}
+	return !mStopped;
 }
 
 void WorkManager::addOutput(std::unique_ptr<WorkRequest>& r)
@@ -169,46 +306,54 @@ WorkClient* WorkManager::findClientLocked(const void* clientId)
 }
 
 /**
- * \class Loop
+ * \class Worker
  */
-WorkManager::Loop::Loop(WorkManager& qm)
+WorkManager::Worker::Worker(WorkManager& qm, const size_t index)
 	: mManager(qm)
+	, mIndex(index)
 {
 }
 
-void WorkManager::Loop::run()
+void WorkManager::Worker::run()
 {
 	DS_DBG_THREAD_CODE(mManager.debugThreadStarted(Poco::Thread::current()));
 
-	// Run for as long as I have input, then let the thread die to be reclaimed.
-	RequestList						ins;
-	mManager.popNextInput(ins);
-	while (!ins.empty()) {
-		// Process
-		for (auto it=ins.begin(), end=ins.end(); it != end; ++it) {
-			handleInput(*it);
+	// Run until the manager stops, sleeping whenever there's nothing anywhere to do.
+	std::unique_ptr<WorkRequest>	r;
+	while (true) {
+		if (mManager.popNextInput(mIndex, r)) {
+			handleInput(r);
+			r.reset();
+		} else if (!mManager.waitForInput()) {
+			break;
 		}
-		ins.clear();
-
-		// Testing!  Which is not great -- should have some randomization
-		// so they're not all in sync.
-//		Poco::Thread::sleep(500);
-
-		// Continue processing if we've got input
-		mManager.popNextInput(ins);
 	}
 
 	DS_DBG_THREAD_CODE(mManager.debugThreadStopped(Poco::Thread::current()));
 }
 
-void WorkManager::Loop::handleInput(std::unique_ptr<WorkRequest>& upR) const
+void WorkManager::Worker::handleInput(std::unique_ptr<WorkRequest>& upR) const
 {
 	WorkRequest*			r = upR.get();
 	if (!r) return;
 
-	r->run();
+	// Cancelled requests still go back to their client, so it can recycle them.
+	if (!r->isCancelled()) {
+		DS_PROFILE_ZONE(typeid(*r));
+		try {
+			r->run();
+		} catch (std::exception const& ex) {
+			// A bad request shouldn't take a thread out of the pool with it. Hand it back
+			// cancelled, so the client hears about it and can recycle it. It gets its own
+			// token, since the one it has can be shared with the rest of its batch.
+			DS_LOG_WARNING("WorkManager request threw " << ex.what());
+			CancelToken		failed;
+			failed.cancel();
+			r->setCancelToken(failed);
+		}
+	}
 
-  mManager.addOutput(upR);
+	mManager.addOutput(upR);
 }
 
 /* QUERY-DEBUG
@@ -2,10 +2,15 @@
 #ifndef DS_THREAD_WORKMANAGER_H_
 #define DS_THREAD_WORKMANAGER_H_
 
+#include <atomic>
+#include <deque>
 #include <string>
 #include <vector>
 #include <memory>
-#include <Poco/ThreadPool.h>
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
 #include "ds/thread/thread_defs.h"
 #include "ds/thread/work_request.h"
 
@@ -17,6 +22,11 @@ class WorkClient;
  * \brief Run a thread pool that can be continually fed WorRequests. These requests are generally
  * mediated through a WorkClient subclass, which handles the broad types of requests an app might
  * want.  Typically, the app will instantiate a WorkClient and let it take care of all the details.
+ *
+ * The threads live as long as the manager. Each has its own queue per priority; requests
+ * sent from the main thread are dealt out across the threads, requests sent from inside a
+ * request stay on that thread, and a thread that runs dry steals from the others. Higher
+ * priorities are always started first, wherever they're queued.
  */
 class WorkManager
 {
@@ -27,12 +37,17 @@ public:
 	/// I take ownership of the request.
 	bool							sendRequest(std::unique_ptr<WorkRequest>, Poco::Timestamp* sendTime = nullptr);
 
-	/// Called from the world engine during each update cycle, which is probably
-	/// excessive, but the performance hit is nil.  This is where we handle
-	/// any pending query outputs.
+	/// Called from the world engine during each update cycle.  This is where we
+	/// hand finished requests back to their clients, as many as the budget allows,
+	/// with clients taking turns so a busy one can't hold up the rest.
 	void							update();
 
+	/// How long update() can spend handing out results each frame, and how many it can hand out.
+	/// 0 for no limit. At least one result goes out per update, if there are any.
+	void							setUpdateBudget(const int microseconds, const int maxResults);
+
 	/// Stop the thread pool.  Called from the destructor, if a client doesn't call it earlier.
+	/// Anything still waiting is dropped; anything running is finished first.
 	void							stopManager();
 
 protected:
@@ -43,50 +58,86 @@ protected:
 
 	/// Thread entry
 private:
-	class Loop : public Poco::Runnable {
+	class Worker : public Poco::Runnable {
 	public:
-		Loop(WorkManager&);
+		Worker(WorkManager&, const size_t index);
 
-		/// needs to be reentrant, since we are passed to multiple threads
 		virtual void				run();
 
 		void						handleInput(std::unique_ptr<WorkRequest>&) const;
 
+		Poco::Thread				mThread;
+		/// Guards the queues. Owner and thieves both take from the front, so
+		/// requests run roughly in the order they were sent.
+		Poco::FastMutex				mMutex;
+		std::deque<std::unique_ptr<WorkRequest>>
+									mQueue[WorkRequest::PRIORITY_COUNT];
+
 	private:
 		WorkManager&				mManager;
+		const size_t				mIndex;
 	};
 
 private:
-	typedef std::vector<std::unique_ptr<WorkRequest>> RequestList;
-
 	/* NOTE ON LOCK ORDER:  Clients and the output can have nested locks.  Client
 	 * is always locked first.  XXX actually I think that changed.  I think there's
-	 * no nesting at the moment.
+	 * no nesting at the moment.  Worker queues are never held while taking any other lock.
 	 */
-	/// Synchronization
-	Poco::ThreadPool				mPool;
-	Loop							mLoop;
-
 	/// Input
-	Poco::Mutex						mInputMutex;
-	RequestList						mInput;
+	std::vector<std::unique_ptr<Worker>>
+									mWorkers;
+	/// Requests waiting in all the queues, by priority, so empty priorities can be skipped without locking
+	std::atomic<int>				mQueued[WorkRequest::PRIORITY_COUNT];
+	/// Where the next request from outside the pool goes
+	std::atomic<unsigned>			mNextWorker;
+
+	/// Idle workers wait here for input
+	Poco::FastMutex					mIdleMutex;
+	Poco::Condition					mIdle;
+	bool							mStopped;
 
-	/// Output
+	typedef std::deque<std::unique_ptr<WorkRequest>> RequestQueue;
+
+	/// Output, as the workers finish
 	Poco::Mutex						mOutputMutex;
-	RequestList						mOutput, mOutputTmp;
+	RequestQueue					mOutput, mOutputTmp;
+
+	/// Output waiting to be handed out, main thread only. One queue per client, so they can take turns.
+	class ClientResults {
+	public:
+		ClientResults(const void* clientId) : mClientId(clientId) { }
+		const void*					mClientId;
+		RequestQueue				mResults;
+	};
+	std::vector<std::unique_ptr<ClientResults>>
+									mResults;
+	/// Whose turn it is
+	size_t							mNextResults;
+	size_t							mResultCount;
+	int								mBudgetMicroseconds;
+	int								mBudgetResults;
 
 	/// Clients
 	Poco::Mutex						mClientMutex;
 	std::vector<WorkClient*>		mClient;
 
-	/// Call after you've added more input
-	bool							inputAdded();
+	/// Answer the worker a request should be queued with
+	Worker&							pickWorker();
+
+	/// Find the highest priority request, first in the worker's own queues, then in everyone else's
+	bool							popNextInput(const size_t workerIndex, std::unique_ptr<WorkRequest>&);
+	bool							popInputFrom(Worker&, const int priority, std::unique_ptr<WorkRequest>&);
+	int								getQueuedCount() const;
 
-	/// Find the best match with database and put it in the list
-	void							popNextInput(RequestList&);
+	/// Block the calling worker until there's something to do. Answers false once it's time to quit.
+	bool							waitForInput();
 
 	/// Add to the output list
 	void							addOutput(std::unique_ptr<WorkRequest>&);
+	/// Move finished requests into their client's queue
+	void							sortOutput();
+	/// Drop the queues of clients that have gone away. Assumes the client list is locked.
+	void							pruneResultsLocked();
 
 	/// Answer the client, if it exists.  Assumes the client list is locked.
 	WorkClient*						findClientLocked(const void* clientId);
@@ -4,11 +4,36 @@
 
 namespace ds {
 
+/**
+ * \class CancelToken
+ */
+CancelToken::CancelToken()
+	: mFlag(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+void CancelToken::cancel()
+{
+	mFlag->store(true);
+}
+
+bool CancelToken::isCancelled() const
+{
+	return mFlag->load();
+}
+
+void CancelToken::reset()
+{
+	if (mFlag.use_count() == 1) mFlag->store(false);
+	else mFlag = std::make_shared<std::atomic<bool>>(false);
+}
+
 /**
  * \class WorkRequest
  */
 WorkRequest::WorkRequest(const void* clientId)
 	: mClientId(clientId)
+	, mPriority(PRIORITY_NORMAL)
 {
 }
 
@@ -16,4 +41,20 @@ WorkRequest::~WorkRequest()
 {
 }
 
+void WorkRequest::setPriority(const Priority p)
+{
+	if (p < PRIORITY_HIGH || p >= PRIORITY_COUNT) return;
+	mPriority = p;
+}
+
+void WorkRequest::setCancelToken(const CancelToken& t)
+{
+	mCancelToken = t;
+}
+
+void WorkRequest::resetCancelToken()
+{
+	mCancelToken.reset();
+}
+
 } // namespace ds
@@ -2,25 +2,71 @@
 #ifndef DS_THREAD_WORKREQUEST_H_
 #define DS_THREAD_WORKREQUEST_H_
 
+#include <atomic>
+#include <memory>
 #include <Poco/Timestamp.h>
 #include <Poco/Runnable.h>
 
 namespace ds {
 
+/**
+ * \class CancelToken
+ * \brief A flag that can be shared between any number of requests and flipped from any thread.
+ * Copies share the flag, so keep a copy of a request's token before sending it off.
+ */
+class CancelToken {
+public:
+	CancelToken();
+
+	void						cancel();
+	bool						isCancelled() const;
+	/// Not cancelled any more. Clears the flag in place if nothing else shares it,
+	/// otherwise lets go of the shared one.
+	void						reset();
+
+private:
+	std::shared_ptr<std::atomic<bool>>
+								mFlag;
+};
+
 /**
  * \class WorkRequest
  * \brief Abstract class for anything that can be sent into the work manager.
  */
 class WorkRequest : public Poco::Runnable {
 public:
+	/// Waiting requests are always started highest priority first. Within a priority, roughly oldest first.
+	enum Priority				{ PRIORITY_HIGH = 0, PRIORITY_NORMAL, PRIORITY_LOW, PRIORITY_COUNT };
+
 	WorkRequest(const void* clientId);
 	virtual ~WorkRequest();
 
+	void						setPriority(const Priority);
+	Priority					getPriority() const			{ return mPriority; }
+
+	/// Replace this request's token, i.e. to cancel a batch of requests all at once.
+	void						setCancelToken(const CancelToken&);
+	const CancelToken&			getCancelToken() const		{ return mCancelToken; }
+	/// Start over uncancelled, for requests that get reused. See CancelToken::reset().
+	void						resetCancelToken();
+	/// Cancelled requests aren't run if they haven't started. Long-running
+	/// requests should check this now and then and bail out early.
+	bool						isCancelled() const			{ return mCancelToken.isCancelled(); }
+
+	/// Called when a WorkRequestList takes the request back. Empty out any results, but
+	/// keep their storage for the next run.
+	virtual void				recycle()					{ }
+	/// Called now and then on recycled requests that are waiting to be reused. Let go of
+	/// any storage beyond what recent runs needed.
+	virtual void				trim()						{ }
+
 protected:
 	friend class WorkManager;
 
 	const void*					mClientId;
 	Poco::Timestamp				mRequestTime;
+	Priority					mPriority;
+	CancelToken					mCancelToken;
 
 private:
 	WorkRequest();
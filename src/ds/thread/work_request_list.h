@@ -2,6 +2,7 @@
 #ifndef DS_THREAD_WORKREQUESTLIST_H_
 #define DS_THREAD_WORKREQUESTLIST_H_
 
+#include <algorithm>
 #include <vector>
 #include <memory>
 
@@ -10,13 +11,21 @@ namespace ds {
 /**
  * \class WorkRequestList
  * \brief Utility to manager a list of WorkRequests, so clients can easily reuse them.
+ * Requests are recycled as they come back, keeping their result storage, so a client
+ * sending a steady stream of requests stops allocating once it's warmed up.
+ *
+ * Every TRIM_INTERVAL pushes, the requests that sat idle the whole time are deleted
+ * (down to the reserve) and the rest trim their storage to what they recently needed,
+ * so a burst of requests or one huge result isn't held on to forever.
  */
 template <typename T>
 class WorkRequestList {
 public:
-	WorkRequestList(const void* clientId);
+	/// reserve requests are made up front, and never trimmed away.
+	WorkRequestList(const void* clientId, const size_t reserve = 0);
 
-	/// Answer the next free item or create one, if I can
+	/// Answer the next free item or create one, if I can. It still has the cancel token from
+	/// its last run; WorkClient::prepareRequest() gives it the client's current one.
 	std::unique_ptr<T>			next();
 	/// Give ownership of the arg to the list.
 	void						push(std::unique_ptr<T>&);
@@ -24,19 +33,37 @@ public:
 private:
 	WorkRequestList();
 
+	static const size_t			TRIM_INTERVAL = 64;
+	void						trim();
+
 	const void*					mClientId;
+	const size_t				mReserve;
 
 	std::vector<std::unique_ptr<T>>
 								mRequest;
+	/// The fewest requests that were waiting here since the last trim(). That
+	/// many were never needed.
+	size_t						mLowWater;
+	size_t						mPushes;
 };
 
 /**
  * implementation
  */
 template <class T>
-WorkRequestList<T>::WorkRequestList(const void* clientId)
+WorkRequestList<T>::WorkRequestList(const void* clientId, const size_t reserve)
 	: mClientId(clientId)
+	, mReserve(reserve)
+	, mLowWater(reserve)
+	, mPushes(0)
 {
+	try {
+		mRequest.reserve(std::max<size_t>(reserve, 8));
+		for (size_t k = 0; k < reserve; ++k) {
+			mRequest.push_back(std::unique_ptr<T>(new T(mClientId)));
+		}
+	} catch (std::exception const&) {
+	}
 }
 
 template <class T>
@@ -47,6 +74,7 @@ std::unique_ptr<T> WorkRequestList<T>::next()
 		ans = std::move(mRequest.back());
 		mRequest.pop_back();
 	}
+	mLowWater = std::min(mLowWater, mRequest.size());
 	if (!ans.get()) ans = std::move(std::unique_ptr<T>(new T(mClientId)));
 	return ans;
 }
@@ -57,9 +85,24 @@ void WorkRequestList<T>::push(std::unique_ptr<T>& obj)
 	if (!obj) return;
 
 	try {
+		obj->recycle();
 		mRequest.push_back(std::move(obj));
 	} catch (std::exception const&) {
 	}
+	if (++mPushes >= TRIM_INTERVAL) trim();
+}
+
+template <class T>
+void WorkRequestList<T>::trim()
+{
+	// Take the unused ones off the bottom, they're the ones that have sat longest
+	const size_t				excess = std::min(mLowWater, mRequest.size() > mReserve ? mRequest.size() - mReserve : 0);
+	if (excess > 0) mRequest.erase(mRequest.begin(), mRequest.begin() + excess);
+	for (auto& r : mRequest) {
+		if (r) r->trim();
+	}
+	mLowWater = mRequest.size();
+	mPushes = 0;
 }
 
 } // namespace ds
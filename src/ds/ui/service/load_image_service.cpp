@@ -5,12 +5,28 @@
 #include <chrono>
 
 #include <ds/debug/logger.h>
+#include <ds/debug/memory_accounting.h>
 #include <ds/util/file_meta_data.h>
 
 
 namespace ds {
 namespace ui {
 
+namespace {
+ds::MemoryTag& textureMemory() {
+	static ds::MemoryTag&	TAG = ds::MemoryAccounting::get().getTag("Image textures");
+	return TAG;
+}
+
+/// Counts the texture until the last copy of it goes away, sprites included
+ci::gl::TextureRef trackTexture(const ci::gl::TextureRef& tex, const bool mipmapped) {
+	if(!tex) return tex;
+	int64_t					bytes = static_cast<int64_t>(tex->getWidth()) * static_cast<int64_t>(tex->getHeight()) * 4;
+	if(mipmapped) bytes += bytes / 3;
+	return ds::trackMemory(tex, textureMemory(), bytes);
+}
+}
+
 LoadImageService::LoadImageService(ds::ui::SpriteEngine& eng)
   : ds::AutoUpdate(eng, AutoUpdateType::SERVER | AutoUpdateType::CLIENT)
   , mShouldQuit(false) 
@@ -94,7 +110,7 @@ void LoadImageService::update(const ds::UpdateParams&) {
 						fmt.setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
 					}
 
-					it.mTexture = ci::gl::Texture::create(it.mImageSourceRef, fmt);
+					it.mTexture = trackTexture(ci::gl::Texture::create(it.mImageSourceRef, fmt), fmt.hasMipmapping());
 					if(!it.mTexture || it.mTexture->getId() < 1) {
 						DS_LOG_WARNING("LoadImageService: couldn't load an image texture on the main thread for " << it.mFilePath);
 					}
@@ -273,7 +289,7 @@ void LoadImageService::loadImagesThreadFn(ci::gl::ContextRef context) {
 					} else {
 #endif
 
-						nextImage.mTexture = tex;
+						nextImage.mTexture = trackTexture(tex, fmt.hasMipmapping());
                         nextImage.mLoading = false;
 
 						std::lock_guard<std::mutex> lock(mLoadedMutex);
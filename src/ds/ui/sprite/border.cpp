@@ -27,11 +27,11 @@ namespace {
 }
 
 void Border::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "Border");
 }
 
 void Border::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Border>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Border>(r); }, "Border");
 }
 
 Border::Border(SpriteEngine& engine)
@@ -128,11 +128,11 @@ namespace {
 }
 
 void CircleBorder::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "CircleBorder");
 }
 
 void CircleBorder::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<CircleBorder>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<CircleBorder>(r); }, "CircleBorder");
 }
 
 CircleBorder::CircleBorder(SpriteEngine& engine)
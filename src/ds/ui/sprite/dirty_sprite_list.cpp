@@ -0,0 +1,101 @@
+#include "stdafx.h"
+
+#include "ds/ui/sprite/dirty_sprite_list.h"
+
+#include <algorithm>
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class DirtySpriteList
+ */
+DirtySpriteList::DirtySpriteList()
+	: mEnabled(false)
+	, mConcurrent(false)
+{
+}
+
+void DirtySpriteList::setEnabled(const bool on) {
+	if(!on) clear();
+	mEnabled = on;
+}
+
+void DirtySpriteList::add(Sprite& s) {
+	if(!mEnabled || s.mDirtyListIndex >= 0) return;
+
+	s.mDirtyListIndex = static_cast<int>(mSprites.size());
+	mSprites.push_back(&s);
+}
+
+void DirtySpriteList::remove(Sprite& s) {
+	if(s.mDirtyListIndex < 0) return;
+
+	if(s.mDirtyListIndex < static_cast<int>(mSprites.size()) && mSprites[s.mDirtyListIndex] == &s) {
+		mSprites[s.mDirtyListIndex] = nullptr;
+	}
+	s.mDirtyListIndex = -1;
+}
+
+void DirtySpriteList::clear() {
+	for(auto it : mSprites) {
+		if(it) it->mDirtyListIndex = -1;
+	}
+	mSprites.clear();
+}
+
+void DirtySpriteList::writeTo(ds::DataBuffer& buf, const std::vector<Sprite*>& roots) {
+	mSorted.clear();
+	for(auto it : mSprites) {
+		if(!it) continue;
+		it->mDirtyListIndex = -1;
+		// Already went out with a parent, or as part of a world send
+		if(it->mDirty.isEmpty()) continue;
+
+		int			depth = 0;
+		bool		replicated = true;
+		Sprite*		top = it;
+		while(true) {
+			if(top->getNoReplicationOptimization()) replicated = false;
+			if(!top->mParent) break;
+			top = top->mParent;
+			++depth;
+		}
+		if(!replicated) continue;
+		if(std::find(roots.begin(), roots.end(), top) == roots.end()) continue;
+
+		mSorted.push_back(std::make_pair(depth, it));
+	}
+	mSprites.clear();
+
+	// Parents have to exist on the client before their children can be added to them
+	std::stable_sort(mSorted.begin(), mSorted.end(), [](const std::pair<int, Sprite*>& a, const std::pair<int, Sprite*>& b) {
+		return a.first < b.first;
+	});
+
+	for(auto& it : mSorted) {
+		it.second->writeQueuedTo(buf);
+	}
+	for(auto& it : mSorted) {
+		it.second->clearAncestorsChildDirty();
+	}
+	mSorted.clear();
+}
+
+/**
+ * \class DirtySpriteList::ScopedLock
+ */
+DirtySpriteList::ScopedLock::ScopedLock(DirtySpriteList& list)
+	: mList(list)
+	, mLocked(list.mConcurrent)
+{
+	if(mLocked) mList.mMutex.lock();
+}
+
+DirtySpriteList::ScopedLock::~ScopedLock() {
+	if(mLocked) mList.mMutex.unlock();
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef DS_UI_SPRITE_DIRTYSPRITELIST_H_
+#define DS_UI_SPRITE_DIRTYSPRITELIST_H_
+
+#include <utility>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+class DataBuffer;
+namespace ui {
+class Sprite;
+
+/**
+ * \class DirtySpriteList
+ * \brief Every sprite that's been marked dirty since the last send, so the server
+ * only serializes what changed instead of walking every tree each frame.
+ * Sprites remember their own slot, so adding is a no-op if they're already
+ * queued and removing (when a sprite is deleted) doesn't have to search.
+ */
+class DirtySpriteList {
+public:
+	/// Locks the list, but only while it's shared between threads (during a parallel sprite update).
+	class ScopedLock {
+	public:
+		ScopedLock(DirtySpriteList&);
+		~ScopedLock();
+	private:
+		ScopedLock(const ScopedLock&);
+		ScopedLock&				operator=(const ScopedLock&);
+		DirtySpriteList&		mList;
+		const bool				mLocked;
+	};
+
+	DirtySpriteList();
+
+	/// Only engines that replicate need this, anything else would just grow the list forever.
+	void						setEnabled(const bool);
+	bool						isEnabled() const { return mEnabled; }
+
+	/// While on, sprites marking themselves dirty lock the list first. Main thread only.
+	void						setConcurrent(const bool on) { mConcurrent = on; }
+
+	/// Queue the sprite, once. Called by Sprite::markAsDirty().
+	void						add(Sprite&);
+	/// Called when a sprite is deleted.
+	void						remove(Sprite&);
+	void						clear();
+	size_t						size() const { return mSprites.size(); }
+
+	/// Write every queued sprite that's in one of roots, parents before children, then empty the list.
+	/// Sprites that aren't in any of roots keep their dirty state and go out whenever they get added to one.
+	void						writeTo(ds::DataBuffer&, const std::vector<Sprite*>& roots);
+
+private:
+	std::vector<Sprite*>		mSprites;
+	/// Scratch for writeTo(), sprites with their depth in the tree
+	std::vector<std::pair<int, Sprite*>>
+								mSorted;
+	bool						mEnabled;
+	bool						mConcurrent;
+	Poco::FastMutex				mMutex;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_DIRTYSPRITELIST_H_
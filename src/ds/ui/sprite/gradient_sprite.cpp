@@ -27,11 +27,11 @@ const char			BR_ATT				= 83;
 
 
 void Gradient::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);}, "Gradient");
 }
 
 void Gradient::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Gradient>(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Gradient>(r);}, "Gradient");
 }
 
 Gradient& Gradient::makeH(SpriteEngine& e, const ci::ColorA& x1, const ci::ColorA& x2, Sprite* parent) {
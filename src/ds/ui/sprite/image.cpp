@@ -144,11 +144,11 @@ const std::string CircleCropVert =
 }
 
 void Image::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r);}, "Image");
 }
 
 void Image::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Image>(r);});
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Image>(r);}, "Image");
 }
 
 Image& Image::makeImage(SpriteEngine& e, const std::string& fn, Sprite* parent) {
@@ -0,0 +1,189 @@
+#include "stdafx.h"
+
+#include "ds/ui/sprite/parallel_sprite_update.h"
+
+#include <algorithm>
+#include "ds/debug/logger.h"
+#include "ds/debug/profiler.h"
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+const std::string			PARALLEL_THREAD_NAME("ds_sprite_update");
+}
+
+/**
+ * \class ParallelSpriteUpdate
+ */
+ParallelSpriteUpdate::ParallelSpriteUpdate()
+	: mThreadCount(0)
+	, mParams(nullptr)
+	, mServer(false)
+	, mNext(0)
+	, mTickets(0)
+	, mBusy(0)
+	, mStop(false)
+{
+}
+
+ParallelSpriteUpdate::~ParallelSpriteUpdate() {
+	stopWorkers();
+}
+
+void ParallelSpriteUpdate::setThreadCount(const int count) {
+	const int			n = std::max(0, count);
+	if(n == mThreadCount) return;
+
+	// Workers are started the first time there's something for them to do
+	stopWorkers();
+	mThreadCount = n;
+}
+
+void ParallelSpriteUpdate::add(Sprite& s) {
+	if(std::find(mMarked.begin(), mMarked.end(), &s) != mMarked.end()) return;
+	mMarked.push_back(&s);
+}
+
+void ParallelSpriteUpdate::remove(Sprite& s) {
+	mMarked.erase(std::remove(mMarked.begin(), mMarked.end(), &s), mMarked.end());
+	// Could be deleted between update() and finish()
+	mBatch.erase(std::remove(mBatch.begin(), mBatch.end(), &s), mBatch.end());
+}
+
+void ParallelSpriteUpdate::update(const std::vector<Sprite*>& roots, const ds::UpdateParams& p, const bool server) {
+	mBatch.clear();
+	if(!isEnabled()) return;
+
+	// Only the topmost marked sprite of each attached tree goes out
+	for(auto it : mMarked) {
+		bool			covered = false;
+		Sprite*			top = it;
+		while(top->mParent) {
+			top = top->mParent;
+			if(top->mUpdateParallel) covered = true;
+		}
+		if(covered || top == it) continue;
+		if(std::find(roots.begin(), roots.end(), top) == roots.end()) continue;
+		mBatch.push_back(it);
+	}
+	if(mBatch.empty()) return;
+
+	for(auto it : mBatch) {
+		it->mUpdatedInParallel = true;
+		// Transforms are built lazily, so build everything above the subtree now.
+		// Otherwise two threads checking bounds could both try to build the same parent.
+		it->mParent->buildGlobalTransform();
+	}
+
+	mParams = &p;
+	mServer = server;
+	mNext = 0;
+
+	// The main thread takes a subtree too, so only wake as many workers as there's work for
+	const int			helpers = std::min(mThreadCount, static_cast<int>(mBatch.size()) - 1);
+	if(helpers > 0) {
+		startWorkers();
+		Poco::FastMutex::ScopedLock		l(mMutex);
+		mTickets = helpers;
+		mBusy = helpers;
+		for(int k = 0; k < helpers; ++k) mStart.signal();
+	}
+
+	updateBatch();
+
+	if(helpers > 0) {
+		Poco::FastMutex::ScopedLock		l(mMutex);
+		while(mBusy > 0) mDone.wait(mMutex);
+	}
+	mParams = nullptr;
+}
+
+void ParallelSpriteUpdate::finish() {
+	for(auto it : mBatch) {
+		it->mUpdatedInParallel = false;
+	}
+}
+
+void ParallelSpriteUpdate::startWorkers() {
+	if(!mWorkers.empty() || mThreadCount < 1) return;
+
+	mStop = false;
+	for(int k = 0; k < mThreadCount; ++k) {
+		try {
+			std::unique_ptr<Worker>		w(new Worker(*this));
+			w->mThread.setName(PARALLEL_THREAD_NAME);
+			w->mThread.start(*w);
+			mWorkers.push_back(std::move(w));
+		} catch(std::exception const& ex) {
+			DS_LOG_WARNING("ParallelSpriteUpdate couldn't start a worker: " << ex.what());
+			break;
+		}
+	}
+	// Don't hand out more tickets than there are workers to take them
+	mThreadCount = static_cast<int>(mWorkers.size());
+}
+
+void ParallelSpriteUpdate::stopWorkers() {
+	{
+		Poco::FastMutex::ScopedLock		l(mMutex);
+		mStop = true;
+		mStart.broadcast();
+	}
+	for(auto& it : mWorkers) {
+		try {
+			it->mThread.join();
+		} catch(std::exception const&) {
+		}
+	}
+	mWorkers.clear();
+}
+
+void ParallelSpriteUpdate::updateBatch() {
+	const size_t		count = mBatch.size();
+	while(true) {
+		const size_t	index = mNext++;
+		if(index >= count) break;
+
+		Sprite*			s = mBatch[index];
+		DS_PROFILE_ZONE("ParallelSpriteUpdate subtree");
+		try {
+			if(mServer) s->updateServer(*mParams);
+			else s->updateClient(*mParams);
+		} catch(std::exception const& ex) {
+			// Don't let one subtree take a worker, and the barrier, down with it
+			DS_LOG_WARNING("ParallelSpriteUpdate sprite " << s->getId() << " threw " << ex.what());
+		}
+	}
+}
+
+/**
+ * \class ParallelSpriteUpdate::Worker
+ */
+ParallelSpriteUpdate::Worker::Worker(ParallelSpriteUpdate& o)
+	: mOwner(o)
+{
+}
+
+void ParallelSpriteUpdate::Worker::run() {
+	while(true) {
+		{
+			Poco::FastMutex::ScopedLock		l(mOwner.mMutex);
+			// Wait for a batch that still needs a hand
+			while(!mOwner.mStop && mOwner.mTickets < 1) {
+				mOwner.mStart.wait(mOwner.mMutex);
+			}
+			if(mOwner.mStop) return;
+			--mOwner.mTickets;
+		}
+
+		mOwner.updateBatch();
+
+		Poco::FastMutex::ScopedLock		l(mOwner.mMutex);
+		if(--mOwner.mBusy < 1) mOwner.mDone.signal();
+	}
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef DS_UI_SPRITE_PARALLELSPRITEUPDATE_H_
+#define DS_UI_SPRITE_PARALLELSPRITEUPDATE_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+
+namespace ds {
+class UpdateParams;
+namespace ui {
+class Sprite;
+
+/**
+ * \class ParallelSpriteUpdate
+ * \brief Updates the subtrees of sprites that called setUpdateParallel(true) on a small pool of
+ * worker threads, with the main thread pitching in, and only returns once every one of them is
+ * done. The engine runs this before walking the rest of the tree, which then skips them, so
+ * everything has finished updating before anything is drawn.
+ *
+ * Only the topmost marked sprite in a tree counts; anything marked below it is updated on the
+ * same thread as the rest of that subtree. Sprites that aren't attached to a root aren't updated
+ * at all, same as always.
+ *
+ * See doc/basics/Parallel Update.md for what's safe to do in there.
+ */
+class ParallelSpriteUpdate {
+public:
+	ParallelSpriteUpdate();
+	~ParallelSpriteUpdate();
+
+	/// Worker threads, besides the main thread. 0 updates marked subtrees on the main thread like everything else.
+	void						setThreadCount(const int);
+	bool						isEnabled() const { return mThreadCount > 0 && !mMarked.empty(); }
+
+	/// Called by Sprite::setUpdateParallel() and the sprite destructor.
+	void						add(Sprite&);
+	void						remove(Sprite&);
+
+	/// Update every marked subtree under one of roots, and wait for them all. They stay
+	/// flagged so the regular walk skips them until finish() is called.
+	void						update(const std::vector<Sprite*>& roots, const ds::UpdateParams&, const bool server);
+	void						finish();
+
+	/// How many subtrees went out in the last update, for the stats view.
+	size_t						getLastBatchSize() const { return mBatch.size(); }
+
+private:
+	ParallelSpriteUpdate(const ParallelSpriteUpdate&);
+	ParallelSpriteUpdate&		operator=(const ParallelSpriteUpdate&);
+
+	class Worker : public Poco::Runnable {
+	public:
+		Worker(ParallelSpriteUpdate&);
+
+		virtual void			run();
+
+		Poco::Thread			mThread;
+
+	private:
+		ParallelSpriteUpdate&	mOwner;
+	};
+
+	void						startWorkers();
+	void						stopWorkers();
+	/// Keep claiming subtrees from the batch until there are none left. Called from every thread in the batch.
+	void						updateBatch();
+
+	int							mThreadCount;
+	std::vector<std::unique_ptr<Worker>>
+								mWorkers;
+	/// Every sprite that opted in, and the ones going out this frame
+	std::vector<Sprite*>		mMarked;
+	std::vector<Sprite*>		mBatch;
+	const ds::UpdateParams*		mParams;
+	bool						mServer;
+	/// Next subtree in the batch to be claimed
+	std::atomic<size_t>			mNext;
+
+	Poco::FastMutex				mMutex;
+	Poco::Condition				mStart;
+	Poco::Condition				mDone;
+	/// Workers that can still join the current batch, and workers that are in it and haven't finished
+	int							mTickets;
+	int							mBusy;
+	bool						mStop;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_PARALLELSPRITEUPDATE_H_
@@ -10,9 +10,11 @@
 #include "ds/data/data_buffer.h"
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/profiler.h"
 #include "ds/math/math_defs.h"
 #include "ds/math/math_func.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/sprite/sprite_pool.h"
 #include "ds/ui/tween/tweenline.h"
 #include "ds/util/string_util.h"
 #include "util/clip_plane.h"
@@ -21,6 +23,7 @@
 #include "cinder/ImageIo.h"
 #include <cinder/Ray.h>
 #include <cinder/Rand.h>
+#include <typeinfo>
 
 //#include <glm/gtx/rotate_vector.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -66,6 +69,30 @@ const char			SORTORDER_ATT		= 12;
 const char			ROTATION_ATT		= 13;
 const char			CHECKBOUNDS_ATT		= 14;
 const char			CORNERRADIUS_ATT	= 15;
+const char			COMPACT_ATT			= 16;
+
+// Compact attribute encoding. Each field is a bit in the mask at the front of COMPACT_ATT,
+// and owns 3 values in the baseline (opacity just uses 1).
+const int			COMPACT_SIZE_F		= 0;
+const int			COMPACT_POSITION_F	= 1;
+const int			COMPACT_CENTER_F	= 2;
+const int			COMPACT_ROTATION_F	= 3;
+const int			COMPACT_SCALE_F		= 4;
+const int			COMPACT_COLOR_F		= 5;
+const int			COMPACT_OPACITY_F	= 6;
+const int			COMPACT_FIELD_COUNT	= 7;
+const int			COMPACT_VALUE_COUNT	= 19;
+const uint32_t		COMPACT_ALL_FIELDS	= (1 << COMPACT_FIELD_COUNT) - 1;
+const uint32_t		COMPACT_TRANSFORM_FIELDS = (1 << COMPACT_SIZE_F) | (1 << COMPACT_POSITION_F) | (1 << COMPACT_CENTER_F) | (1 << COMPACT_ROTATION_F) | (1 << COMPACT_SCALE_F);
+// Values are absolute instead of differences from the baseline
+const uint32_t		COMPACT_ABSOLUTE	= (1 << 7);
+
+float compactPrecision(const ds::CompactEncoding& enc, const int field) {
+	if(field == COMPACT_SIZE_F || field == COMPACT_POSITION_F) return enc.mSpatialPrecision;
+	if(field == COMPACT_ROTATION_F) return enc.mRotationPrecision;
+	if(field == COMPACT_CENTER_F || field == COMPACT_SCALE_F) return enc.mScalePrecision;
+	return enc.mColorPrecision;
+}
 
 // flags
 const int			VISIBLE_F			= (1<<0);
@@ -82,11 +109,11 @@ const ds::BitMask	SPRITE_LOG = ds::Logger::newModule("sprite");
 }
 
 void Sprite::installAsServer(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "Sprite");
 }
 
 void Sprite::installAsClient(ds::BlobRegistry& registry) {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Sprite>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Sprite>(r); }, "Sprite");
 }
 
 void Sprite::handleBlobFromClient(ds::BlobReader& r) {
@@ -112,6 +139,9 @@ Sprite::Sprite(SpriteEngine& engine, float width /*= 0.0f*/, float height /*= 0.
 	, mPerspective(false)
 	, mUseDepthBuffer(false)
 	, mShaderTexture(nullptr)
+	, mDirtyListIndex(-1)
+	, mUpdateParallel(false)
+	, mUpdatedInParallel(false)
 {
 	init(mEngine.nextSpriteId());
 	setSize(width, height);
@@ -130,6 +160,9 @@ Sprite::Sprite(SpriteEngine& engine, const ds::sprite_id_t id, const bool perspe
 	, mPerspective(perspective)
 	, mUseDepthBuffer(false)
 	, mShaderTexture(nullptr)
+	, mDirtyListIndex(-1)
+	, mUpdateParallel(false)
+	, mUpdatedInParallel(false)
 {
 	init(id);
 }
@@ -200,6 +233,9 @@ Sprite::~Sprite() {
 	animStop();
 	cancelDelayedCall();
 
+	mEngine.getDirtySprites().remove(*this);
+	if(mUpdateParallel) mEngine.getParallelUpdate().remove(*this);
+
 	mEngine.removeFromDragDestinationList(this);
 
 	// We only want to request a delete for the sprite at the head of a tree,
@@ -221,7 +257,16 @@ Sprite::~Sprite() {
 	}
 }
 
+void* Sprite::operator new(std::size_t size) {
+	return SpritePool::get().allocate(size);
+}
+
+void Sprite::operator delete(void* p, std::size_t size) {
+	SpritePool::get().deallocate(p, size);
+}
+
 void Sprite::updateClient(const UpdateParams &p) {
+	DS_PROFILE_SPRITE_ZONE(typeid(*this));
 	mIdleTimer.update();
 
 	if(mCheckBounds) {
@@ -229,6 +274,7 @@ void Sprite::updateClient(const UpdateParams &p) {
 	}
 
 	for(auto it = mChildren.begin(), it2 = mChildren.end(); it != it2; ++it) {
+		if((*it)->mUpdatedInParallel) continue;
 		(*it)->updateClient(p);
 	}
 
@@ -236,6 +282,7 @@ void Sprite::updateClient(const UpdateParams &p) {
 }
 
 void Sprite::updateServer(const UpdateParams &p) {
+	DS_PROFILE_SPRITE_ZONE(typeid(*this));
 	mTouchProcess.update(p);
 
 	mIdleTimer.update();
@@ -245,6 +292,7 @@ void Sprite::updateServer(const UpdateParams &p) {
 	}
 
 	for(auto it = mChildren.begin(), it2 = mChildren.end(); it != it2; ++it) {
+		if((*it)->mUpdatedInParallel) continue;
 		(*it)->updateServer(p);
 	}
 
@@ -255,6 +303,7 @@ void Sprite::drawClient(const ci::mat4 &trans, const DrawParams &drawParams) {
 	if ((mSpriteFlags&VISIBLE_F) == 0) {
 		return;
 	}
+	DS_PROFILE_SPRITE_ZONE(typeid(*this));
 	DS_REPORT_GL_ERRORS();
 
 	buildTransform();
@@ -371,6 +420,7 @@ void Sprite::drawServer(const ci::mat4 &trans, const DrawParams &drawParams) {
 	if((mSpriteFlags&VISIBLE_F) == 0) {
 		return;
 	}
+	DS_PROFILE_SPRITE_ZONE(typeid(*this));
 
 	buildTransform();
 	ci::mat4 totalTransformation = trans*mTransformation;
@@ -1360,6 +1410,15 @@ void Sprite::writeTo(ds::DataBuffer& buf) {
 		return;
 	}
 
+	writeSelfTo(buf);
+
+	for (auto it=mChildren.begin(), end=mChildren.end(); it != end; ++it) {
+		(*it)->writeTo(buf);
+	}
+}
+
+void Sprite::writeSelfTo(ds::DataBuffer& buf) {
+	const unsigned		start = buf.size();
 	buf.add(mBlobType);
 	buf.add(SPRITE_ID_ATTRIBUTE);
 	buf.add(mId);
@@ -1370,8 +1429,33 @@ void Sprite::writeTo(ds::DataBuffer& buf) {
 	// If I wrote any attributes then make sure to terminate the block
 	mDirty.clear();
 
-	for (auto it=mChildren.begin(), end=mChildren.end(); it != end; ++it) {
-		(*it)->writeTo(buf);
+	ds::net::ReplicationStats&	stats = mEngine.getReplicationStats();
+	if(stats.isEnabled()) {
+		stats.addBlobBytes(mBlobType, buf.size() - start);
+	}
+}
+
+void Sprite::writeQueuedTo(ds::DataBuffer& buf) {
+	// Children that were dirtied while I was detached aren't queued anymore, but they
+	// can still be found through CHILD_DIRTY, same as a full walk.
+	if(mDirty.has(PARENT_DIRTY)) {
+		writeTo(buf);
+		return;
+	}
+
+	if(mDirty.isEmpty()) return;
+	if(mId == ds::EMPTY_SPRITE_ID) {
+		DS_LOG_WARNING_M("Sprite::writeQueuedTo() on empty sprite ID", SPRITE_LOG);
+		return;
+	}
+	writeSelfTo(buf);
+}
+
+void Sprite::clearAncestorsChildDirty() {
+	Sprite*		p = mParent;
+	while(p && p->mDirty.has(CHILD_DIRTY)) {
+		p->mDirty &= ~CHILD_DIRTY;
+		p = p->mParent;
 	}
 }
 
@@ -1392,7 +1476,13 @@ void Sprite::writeAttributesTo(ds::DataBuffer &buf) {
 		// Why would you send an empty sprite id?
 		//buf.add(ds::EMPTY_SPRITE_ID);
 	}
-	if (mDirty.has(SIZE_DIRTY)) {
+
+	const bool compact = mEngine.getAttributeEncoding().mEnabled;
+	if(compact) {
+		writeCompactAttributesTo(buf);
+	}
+
+	if (!compact && mDirty.has(SIZE_DIRTY)) {
 		buf.add(SIZE_ATT);
 		buf.add(mWidth);
 		buf.add(mHeight);
@@ -1406,7 +1496,7 @@ void Sprite::writeAttributesTo(ds::DataBuffer &buf) {
 		buf.add(mSpriteShader.getLocation());
 		buf.add(mSpriteShader.getName());
 	}
-	if (mDirty.has(POSITION_DIRTY)) {
+	if (!compact && mDirty.has(POSITION_DIRTY)) {
 		buf.add(POSITION_ATT);
 		buf.add(mPosition.x);
 		buf.add(mPosition.y);
@@ -1416,31 +1506,31 @@ void Sprite::writeAttributesTo(ds::DataBuffer &buf) {
 		buf.add(CHECKBOUNDS_ATT);
 		buf.add(mCheckBounds);
 	}
-	if (mDirty.has(CENTER_DIRTY)) {
+	if (!compact && mDirty.has(CENTER_DIRTY)) {
 		buf.add(CENTER_ATT);
 		buf.add(mCenter.x);
 		buf.add(mCenter.y);
 		buf.add(mCenter.z);
 	}
-	if (mDirty.has(ROTATION_DIRTY)) {
+	if (!compact && mDirty.has(ROTATION_DIRTY)) {
 		buf.add(ROTATION_ATT);
 		buf.add(mRotation.x);
 		buf.add(mRotation.y);
 		buf.add(mRotation.z);
 	}
-	if (mDirty.has(SCALE_DIRTY)) {
+	if (!compact && mDirty.has(SCALE_DIRTY)) {
 		buf.add(SCALE_ATT);
 		buf.add(mScale.x);
 		buf.add(mScale.y);
 		buf.add(mScale.z);
 	}
-	if (mDirty.has(COLOR_DIRTY)) {
+	if (!compact && mDirty.has(COLOR_DIRTY)) {
 		buf.add(COLOR_ATT);
 		buf.add(mColor.r);
 		buf.add(mColor.g);
 		buf.add(mColor.b);
 	}
-	if (mDirty.has(OPACITY_DIRTY)) {
+	if (!compact && mDirty.has(OPACITY_DIRTY)) {
 		buf.add(OPACITY_ATT);
 		buf.add(mOpacity);
 	}
@@ -1469,6 +1559,100 @@ void Sprite::writeAttributesTo(ds::DataBuffer &buf) {
 	}
 }
 
+void Sprite::writeCompactAttributesTo(ds::DataBuffer& buf) {
+	// Without a baseline the client can't apply differences, so send everything
+	const bool			absolute = mCompactBaseline.empty();
+	uint32_t			mask = 0;
+	if(absolute) {
+		mask = COMPACT_ALL_FIELDS | COMPACT_ABSOLUTE;
+		mCompactBaseline.assign(COMPACT_VALUE_COUNT, 0);
+	} else {
+		if(mDirty.has(SIZE_DIRTY)) mask |= (1 << COMPACT_SIZE_F);
+		if(mDirty.has(POSITION_DIRTY)) mask |= (1 << COMPACT_POSITION_F);
+		if(mDirty.has(CENTER_DIRTY)) mask |= (1 << COMPACT_CENTER_F);
+		if(mDirty.has(ROTATION_DIRTY)) mask |= (1 << COMPACT_ROTATION_F);
+		if(mDirty.has(SCALE_DIRTY)) mask |= (1 << COMPACT_SCALE_F);
+		if(mDirty.has(COLOR_DIRTY)) mask |= (1 << COMPACT_COLOR_F);
+		if(mDirty.has(OPACITY_DIRTY)) mask |= (1 << COMPACT_OPACITY_F);
+	}
+	if(mask == 0) return;
+
+	const float			values[COMPACT_VALUE_COUNT] = {	mWidth, mHeight, mDepth,
+														mPosition.x, mPosition.y, mPosition.z,
+														mCenter.x, mCenter.y, mCenter.z,
+														mRotation.x, mRotation.y, mRotation.z,
+														mScale.x, mScale.y, mScale.z,
+														mColor.r, mColor.g, mColor.b,
+														mOpacity };
+	const ds::CompactEncoding&	enc = mEngine.getAttributeEncoding();
+
+	buf.add(COMPACT_ATT);
+	ds::CompactEncoding::addVarint(buf, mask);
+	for(int field = 0; field < COMPACT_FIELD_COUNT; ++field) {
+		if((mask & (1 << field)) == 0) continue;
+		const float		precision = compactPrecision(enc, field);
+		const int		end = (field == COMPACT_OPACITY_F) ? COMPACT_VALUE_COUNT : field * 3 + 3;
+		for(int i = field * 3; i < end; ++i) {
+			const int32_t	q = ds::CompactEncoding::quantize(values[i], precision);
+			// Differences wrap the same way on both ends, so overflow can't desync anything
+			const int32_t	v = absolute ? q : static_cast<int32_t>(static_cast<uint32_t>(q) - static_cast<uint32_t>(mCompactBaseline[i]));
+			ds::CompactEncoding::addSignedVarint(buf, v);
+			mCompactBaseline[i] = q;
+		}
+	}
+}
+
+bool Sprite::readCompactAttributesFrom(ds::DataBuffer& buf) {
+	const uint32_t		mask = ds::CompactEncoding::readVarint(buf);
+	const bool			absolute = (mask & COMPACT_ABSOLUTE) != 0;
+	// Differences with nothing to apply them to still have to be read past
+	const bool			apply = absolute || !mCompactBaseline.empty();
+	if(!apply) {
+		DS_LOG_WARNING_M("Sprite::readCompactAttributesFrom() got differences before any absolute values, sprite=" << mId, SPRITE_LOG);
+	} else if(absolute) {
+		mCompactBaseline.assign(COMPACT_VALUE_COUNT, 0);
+	}
+
+	const ds::CompactEncoding&	enc = mEngine.getAttributeEncoding();
+	float				values[COMPACT_VALUE_COUNT];
+	for(int field = 0; field < COMPACT_FIELD_COUNT; ++field) {
+		if((mask & (1 << field)) == 0) continue;
+		const float		precision = compactPrecision(enc, field);
+		const int		end = (field == COMPACT_OPACITY_F) ? COMPACT_VALUE_COUNT : field * 3 + 3;
+		for(int i = field * 3; i < end; ++i) {
+			const int32_t	v = ds::CompactEncoding::readSignedVarint(buf);
+			if(!apply) continue;
+			const int32_t	q = absolute ? v : static_cast<int32_t>(static_cast<uint32_t>(mCompactBaseline[i]) + static_cast<uint32_t>(v));
+			mCompactBaseline[i] = q;
+			values[i] = ds::CompactEncoding::dequantize(q, precision);
+		}
+	}
+	if(!apply) return false;
+
+	if(mask & (1 << COMPACT_SIZE_F)) {
+		mWidth = values[0]; mHeight = values[1]; mDepth = values[2];
+	}
+	if(mask & (1 << COMPACT_POSITION_F)) {
+		mPosition = ci::vec3(values[3], values[4], values[5]);
+	}
+	if(mask & (1 << COMPACT_CENTER_F)) {
+		mCenter = ci::vec3(values[6], values[7], values[8]);
+	}
+	if(mask & (1 << COMPACT_ROTATION_F)) {
+		mRotation = ci::vec3(values[9], values[10], values[11]);
+	}
+	if(mask & (1 << COMPACT_SCALE_F)) {
+		mScale = ci::vec3(values[12], values[13], values[14]);
+	}
+	if(mask & (1 << COMPACT_COLOR_F)) {
+		mColor = ci::Color(values[15], values[16], values[17]);
+	}
+	if(mask & (1 << COMPACT_OPACITY_F)) {
+		mOpacity = values[18];
+	}
+	return (mask & COMPACT_TRANSFORM_FIELDS) != 0;
+}
+
 void Sprite::readFrom(ds::BlobReader& blob) {
 	ds::DataBuffer&       buf(blob.mDataBuffer);
 	readAttributesFrom(buf);
@@ -1539,6 +1723,8 @@ void Sprite::readAttributesFrom(ds::DataBuffer& buf) {
 		} else if(id == CORNERRADIUS_ATT){ 
 			float cornerRad = buf.read<float>();
 			mCornerRadius = cornerRad;
+		} else if(id == COMPACT_ATT) {
+			if(readCompactAttributesFrom(buf)) transformChanged = true;
 		} else if (id == SORTORDER_ATT) {
 			int32_t						size = buf.read<int32_t>();
 			// I'll assume anything beyond a certain size is a broken packet.
@@ -1589,6 +1775,9 @@ bool Sprite::getFlag(const int bit, const int flags) const {
 
 void Sprite::markAsDirty(const DirtyState& dirty){
 	mDirty |= dirty;
+	// During a parallel update, other threads can be marking the same ancestors
+	DirtySpriteList::ScopedLock	l(mEngine.getDirtySprites());
+	mEngine.getDirtySprites().add(*this);
 	Sprite*		      p = mParent;
 	while (p) {
 		if ((p->mDirty&CHILD_DIRTY) == true) break;
@@ -1607,6 +1796,10 @@ void Sprite::markAsDirty(const DirtyState& dirty){
 
 void Sprite::markChildrenAsDirty(const DirtyState& dirty){
 	mDirty |= dirty;
+	{
+		DirtySpriteList::ScopedLock	l(mEngine.getDirtySprites());
+		mEngine.getDirtySprites().add(*this);
+	}
 	for (auto it=mChildren.begin(), end=mChildren.end(); it != end; ++it) {
 		(*it)->markChildrenAsDirty(dirty);
 	}
@@ -1821,9 +2014,34 @@ void Sprite::setNoReplicationOptimization(const bool on) {
 	else mSpriteFlags &= ~NO_REPLICATION_F;
 }
 
+bool Sprite::getNoReplicationOptimization() const {
+	return (mSpriteFlags&NO_REPLICATION_F) != 0;
+}
+
+void Sprite::setUpdateParallel(const bool on) {
+	if(on == mUpdateParallel) return;
+
+	mUpdateParallel = on;
+	if(on) mEngine.getParallelUpdate().add(*this);
+	else mEngine.getParallelUpdate().remove(*this);
+}
+
+bool Sprite::getUpdateParallel() const {
+	return mUpdateParallel;
+}
+
 void Sprite::markTreeAsDirty() {
 	markAsDirty(ds::BitMask::newFilled());
 	markChildrenAsDirty(ds::BitMask::newFilled());
+	clearCompactBaselines();
+}
+
+void Sprite::clearCompactBaselines() {
+	// Whatever gets sent next is the whole tree, so send absolute values
+	mCompactBaseline.clear();
+	for(auto it : mChildren) {
+		it->clearCompactBaselines();
+	}
 }
 
 void Sprite::setRotateTouches(const bool on) {
@@ -62,6 +62,9 @@ namespace ui {
 
 		/** Generic sprite creation function.
 			The variadic args will be passed in the same order to your Sprite's constructor.
+			Like plain new, the sprite comes out of the SpritePool, so lists that make and release the same
+			kind of item over and over reuse memory; call SpritePool::get().reserve<T>(count) first to
+			have it all ready before a big batch.
 			\param engine The SpriteEngine for your app.
 			\param parent An optional parent for the new sprite to be added to as a child.
 			\param args Parameter arguments that are passed to your custom sprite type, in order, on construction		*/
@@ -86,6 +89,10 @@ namespace ui {
 		Sprite(SpriteEngine& engine, float width = 0.0f, float height = 0.0f);
 		virtual ~Sprite();
 
+		/// Every sprite, subclasses included, lives in the SpritePool. See sprite_pool.h
+		static void*			operator new(std::size_t size);
+		static void				operator delete(void* p, std::size_t size);
+
 		/** Update function for when this app is set to be a client.
 			Don't override this function, use onUpdateClient if you need it
 			\param updateParams UpdateParams containing some conveniences such as delta time.		*/
@@ -651,9 +658,16 @@ namespace ui {
 		/// Prevent this sprite (and all children) from replicating. NOTE: Should
 		/// only be done once on construction, if you change it, weird things could happen.
 		void					setNoReplicationOptimization(const bool = false);
+		bool					getNoReplicationOptimization() const;
 		/// Special function to mark every sprite from me down as dirty.
 		void					markTreeAsDirty();
 
+		/// Update me and everything below me on a worker thread, alongside any other subtrees
+		/// that do the same, before the rest of the tree is updated. Only for subtrees that keep to
+		/// themselves: see doc/basics/Parallel Update.md for what's allowed in there. Not replicated.
+		void					setUpdateParallel(const bool);
+		bool					getUpdateParallel() const;
+
 		/// When true, the touch input is automatically rotated to account for my rotation.
 		void					setRotateTouches(const bool = false);
 		bool					isRotateTouches() const;
@@ -780,6 +794,11 @@ namespace ui {
 		/// Special function that marks all children as dirty, without sending anything up the hierarchy.
 		virtual void		markChildrenAsDirty(const DirtyState&);
 		virtual void		writeAttributesTo(ds::DataBuffer&);
+		/// Size, position, center, rotation, scale, color and opacity, when the engine uses compact attribute encoding.
+		void				writeCompactAttributesTo(ds::DataBuffer&);
+		/// Answers true if any of the transform changed.
+		bool				readCompactAttributesFrom(ds::DataBuffer&);
+		void				clearCompactBaselines();
 		/// Used during client mode, to let clients get info back to the server. Use the
 		/// engine_io.defs::ScopedClientAtts at the top of the function to do all the boilerplate.
 		virtual void		writeClientAttributesTo(ds::DataBuffer&){};
@@ -848,6 +867,9 @@ namespace ui {
 		/// Class-unique key for this type.  Subclasses can replace.
 		char					mBlobType;
 		DirtyState				mDirty;
+		/// For compact attribute encoding: the quantized values last sent (on the server) or
+		/// received (on a client). Empty means the next send has to be absolute.
+		std::vector<int32_t>	mCompactBaseline;
 
 		std::function<void(Sprite *, const TouchInfo &)> mProcessTouchInfoCallback;
 		std::function<void(Sprite *, const ci::vec3 &)> mSwipeCallback;
@@ -882,6 +904,8 @@ namespace ui {
 
 		friend class ds::Engine;
 		friend class ds::EngineRoot;
+		friend class DirtySpriteList;
+		friend class ParallelSpriteUpdate;
 		/// Disable copy constructor; sprites are managed by their parent and
 		/// must be allocated
 		Sprite(const Sprite&);
@@ -903,6 +927,19 @@ namespace ui {
 		/// Use addChild() from outside sprite.cpp
 		void				setParent(Sprite *parent);
 
+		/// Write just me, unless I've just been added to a parent, in which case anything below me
+		/// that got dirty while I was detached has to go too. Used by the DirtySpriteList.
+		void				writeQueuedTo(ds::DataBuffer&);
+		/// Write my blob, without any children.
+		void				writeSelfTo(ds::DataBuffer&);
+		/// Once every queued sprite has been written, no ancestor has a dirty child anymore.
+		void				clearAncestorsChildDirty();
+		/// My slot in the engine's DirtySpriteList, -1 if I'm not queued.
+		int					mDirtyListIndex;
+		/// Opted in to parallel update, and updated that way this frame (so my parent skips me).
+		bool				mUpdateParallel;
+		bool				mUpdatedInParallel;
+
 		ci::gl::TextureRef	mRenderTarget;
 		BlendMode			mBlendMode;
 
@@ -12,6 +12,10 @@
 #include <cinder/app/Window.h>
 
 #include "ds/app/app_defs.h"
+#include "ds/data/compact_encoding.h"
+#include "ds/network/replication_stats.h"
+#include "ds/ui/sprite/dirty_sprite_list.h"
+#include "ds/ui/sprite/parallel_sprite_update.h"
 #include "ds/debug/logger.h"
 #include "ds/time/time_callback.h"
 #include "ds/thread/work_manager.h"
@@ -196,6 +200,21 @@ public:
 
 	virtual	int						getBytesRecieved() = 0;
 	virtual int						getBytesSent() = 0;
+	/// How big the most recent replicated frame was before compression. 0 if this engine doesn't replicate.
+	virtual int						getBytesPerFrame() = 0;
+
+	/// How sprites pack their common attributes when replicating. Clients get this from the server.
+	const ds::CompactEncoding&		getAttributeEncoding() const { return mAttributeEncoding; }
+	void							setAttributeEncoding(const ds::CompactEncoding& e) { mAttributeEncoding = e; }
+
+	/// Sprites marked dirty since the last frame was sent. Only filled in on engines that replicate.
+	ds::ui::DirtySpriteList&		getDirtySprites() { return mDirtySprites; }
+
+	/// Subtrees that opted in to being updated on worker threads.
+	ds::ui::ParallelSpriteUpdate&	getParallelUpdate() { return mParallelUpdate; }
+
+	/// What replication is costing, frame by frame. Only recorded on engines that replicate, and only if server:replication_stats is on.
+	ds::net::ReplicationStats&		getReplicationStats() { return mReplicationStats; }
 
 
 	static const int				CLIENT_MODE = 0;
@@ -303,6 +322,10 @@ protected:
 	ds::MetricsService*				mMetricsService;
 
 	bool							mRestartAfterUpdate;
+	ds::CompactEncoding				mAttributeEncoding;
+	ds::ui::DirtySpriteList			mDirtySprites;
+	ds::ui::ParallelSpriteUpdate	mParallelUpdate;
+	ds::net::ReplicationStats		mReplicationStats;
 
 	std::unordered_map<std::string, std::function<ds::ui::Sprite*(ds::ui::SpriteEngine&)>> mImporterMap;
 	std::unordered_map<std::string, std::function<void(ds::ui::Sprite& theSprite, const std::string& theValue, const std::string& fileRefferer)>> mPropertyMap;
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+
+#include "ds/ui/sprite/sprite_id_map.h"
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class SpriteIdMap
+ */
+SpriteIdMap::SpriteIdMap() {
+}
+
+void SpriteIdMap::set(const ds::sprite_id_t id, Sprite* s) {
+	if(id < 0) return;
+	if(!s) {
+		erase(id);
+		return;
+	}
+
+	const size_t			page = static_cast<size_t>(id) >> PAGE_BITS;
+	const size_t			slot = static_cast<size_t>(id) & PAGE_MASK;
+	if(page >= mPages.size()) mPages.resize(page + 1);
+	if(!mPages[page]) mPages[page].reset(new Page());
+
+	Page&					p = *mPages[page];
+	if(p.mSlots[slot]) {
+		mAll[p.mAllIndex[slot]] = s;
+	} else {
+		p.mAllIndex[slot] = static_cast<int>(mAll.size());
+		mAll.push_back(s);
+		mAllIds.push_back(id);
+		++p.mCount;
+	}
+	p.mSlots[slot] = s;
+}
+
+void SpriteIdMap::erase(const ds::sprite_id_t id) {
+	if(id < 0) return;
+	const size_t			page = static_cast<size_t>(id) >> PAGE_BITS;
+	const size_t			slot = static_cast<size_t>(id) & PAGE_MASK;
+	if(page >= mPages.size() || !mPages[page]) return;
+
+	Page&					p = *mPages[page];
+	if(!p.mSlots[slot]) return;
+
+	// Move the last entry into the hole, and tell its slot where it went
+	const int				index = p.mAllIndex[slot];
+	const ds::sprite_id_t	lastId = mAllIds.back();
+	mAll[index] = mAll.back();
+	mAllIds[index] = lastId;
+	mPages[static_cast<size_t>(lastId) >> PAGE_BITS]->mAllIndex[static_cast<size_t>(lastId) & PAGE_MASK] = index;
+	mAll.pop_back();
+	mAllIds.pop_back();
+
+	p.mSlots[slot] = nullptr;
+	if(--p.mCount < 1) {
+		mPages[page].reset();
+		while(!mPages.empty() && !mPages.back()) mPages.pop_back();
+	}
+}
+
+void SpriteIdMap::clear() {
+	mPages.clear();
+	mAll.clear();
+	mAllIds.clear();
+}
+
+/**
+ * \class SpriteIdMap::Page
+ */
+SpriteIdMap::Page::Page()
+	: mCount(0)
+{
+	for(size_t k = 0; k < PAGE_SIZE; ++k) {
+		mSlots[k] = nullptr;
+		mAllIndex[k] = -1;
+	}
+}
+
+} // namespace ui
+} // namespace ds
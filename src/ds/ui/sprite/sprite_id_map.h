@@ -0,0 +1,70 @@
+#pragma once
+#ifndef DS_UI_SPRITE_SPRITEIDMAP_H_
+#define DS_UI_SPRITE_SPRITEIDMAP_H_
+
+#include <memory>
+#include <vector>
+#include "ds/app/app_defs.h"
+
+namespace ds {
+namespace ui {
+class Sprite;
+
+/**
+ * \class SpriteIdMap
+ * \brief Every registered sprite, by ID. IDs are handed out in increasing order (and clients
+ * use the server's), so they're packed closely enough to index straight into an array:
+ * the ID picks a page and a slot, which makes find() a couple of loads instead of a hash.
+ * Pages are only allocated once an ID lands in them, and freed when they empty out.
+ * The live sprites are also kept packed together, for walking all of them.
+ */
+class SpriteIdMap {
+public:
+	SpriteIdMap();
+
+	/// Replaces whatever was registered with the ID
+	void						set(const ds::sprite_id_t, Sprite*);
+	void						erase(const ds::sprite_id_t);
+	void						clear();
+
+	inline Sprite*				find(const ds::sprite_id_t id) const {
+		if(id < 0) return nullptr;
+		const size_t			page = static_cast<size_t>(id) >> PAGE_BITS;
+		if(page >= mPages.size() || !mPages[page]) return nullptr;
+		return mPages[page]->mSlots[static_cast<size_t>(id) & PAGE_MASK];
+	}
+
+	size_t						size() const { return mAll.size(); }
+	bool						empty() const { return mAll.empty(); }
+	/// Every registered sprite, in no particular order. Changes whenever a sprite is set or erased.
+	const std::vector<Sprite*>&	getAll() const { return mAll; }
+
+private:
+	SpriteIdMap(const SpriteIdMap&);
+	SpriteIdMap&				operator=(const SpriteIdMap&);
+
+	static const size_t			PAGE_BITS = 12;
+	static const size_t			PAGE_SIZE = static_cast<size_t>(1) << PAGE_BITS;
+	static const size_t			PAGE_MASK = PAGE_SIZE - 1;
+
+	class Page {
+	public:
+		Page();
+		Sprite*					mSlots[PAGE_SIZE];
+		/// Where each slot's sprite is in mAll
+		int						mAllIndex[PAGE_SIZE];
+		size_t					mCount;
+	};
+
+	std::vector<std::unique_ptr<Page>>
+								mPages;
+	std::vector<Sprite*>		mAll;
+	/// The ID of each entry in mAll
+	std::vector<ds::sprite_id_t>
+								mAllIds;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_SPRITEIDMAP_H_
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+
+#include "ds/ui/sprite/sprite_pool.h"
+
+#include <algorithm>
+#include <new>
+#include "ds/debug/memory_accounting.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+// Chunks are at least this big, or hold at least MIN_SLOTS, whichever is more
+const size_t					CHUNK_BYTES = 64 * 1024;
+const size_t					MIN_SLOTS = 4;
+}
+
+/**
+ * \class SpritePool
+ */
+SpritePool& SpritePool::get() {
+	// Never deleted, since sprites held in statics can be released on the way out
+	static SpritePool*			POOL = new SpritePool();
+	return *POOL;
+}
+
+SpritePool::SpritePool()
+		: mMemory(ds::MemoryAccounting::get().getTag("Sprite pool")) {
+}
+
+void* SpritePool::allocate(const size_t size) {
+	if(size == 0 || size > MAX_SIZE) return ::operator new(size);
+
+	const size_t				index = (size - 1) / GRANULARITY;
+	Bucket&						b = mBuckets[index];
+	Poco::FastMutex::ScopedLock	l(b.mMutex);
+	if(!b.mFree) grow(b, (index + 1) * GRANULARITY, 1);
+	FreeSlot*					slot = b.mFree;
+	b.mFree = slot->mNext;
+	return slot;
+}
+
+void SpritePool::deallocate(void* p, const size_t size) {
+	if(!p) return;
+	if(size == 0 || size > MAX_SIZE) {
+		::operator delete(p);
+		return;
+	}
+
+	Bucket&						b = mBuckets[(size - 1) / GRANULARITY];
+	Poco::FastMutex::ScopedLock	l(b.mMutex);
+	FreeSlot*					slot = static_cast<FreeSlot*>(p);
+	slot->mNext = b.mFree;
+	b.mFree = slot;
+}
+
+void SpritePool::reserve(const size_t size, const size_t count) {
+	if(size == 0 || size > MAX_SIZE || count < 1) return;
+
+	const size_t				index = (size - 1) / GRANULARITY;
+	Bucket&						b = mBuckets[index];
+	Poco::FastMutex::ScopedLock	l(b.mMutex);
+	size_t						available = 0;
+	for(FreeSlot* s = b.mFree; s && available < count; s = s->mNext) ++available;
+	if(available < count) grow(b, (index + 1) * GRANULARITY, count - available);
+}
+
+void SpritePool::grow(Bucket& b, const size_t slotSize, const size_t count) {
+	const size_t				slots = std::max(count, std::max(MIN_SLOTS, CHUNK_BYTES / slotSize));
+	char*						chunk = static_cast<char*>(::operator new(slots * slotSize));
+	b.mChunks.push_back(chunk);
+	mMemory.add(1, static_cast<int64_t>(slots * slotSize));
+
+	// Thread the new slots onto the front of the free list, in address order
+	for(size_t k = slots; k > 0; --k) {
+		FreeSlot*				slot = reinterpret_cast<FreeSlot*>(chunk + (k - 1) * slotSize);
+		slot->mNext = b.mFree;
+		b.mFree = slot;
+	}
+}
+
+/**
+ * \class SpritePool::Bucket
+ */
+SpritePool::Bucket::Bucket()
+		: mFree(nullptr) {
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef DS_UI_SPRITE_SPRITEPOOL_H_
+#define DS_UI_SPRITE_SPRITEPOOL_H_
+
+#include <cstddef>
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace ds {
+class MemoryTag;
+namespace ui {
+
+/**
+ * \class SpritePool
+ * \brief The memory every sprite lives in. Sprite overrides operator new and delete to
+ * come through here, so plain new / release() and Sprite::make() both use it.
+ *
+ * Memory comes in chunks of same-sized slots, bucketed by object size rounded up to 16
+ * bytes. Classes of about the same size share a bucket. Released sprites hand their slot
+ * back to the bucket for the next object of that size instead of going back to the heap,
+ * so lists that create and release items as they scroll stop fragmenting the heap. The chunks are kept
+ * until the app exits; the stats view shows how much they hold under "Sprite pool".
+ *
+ * Anything bigger than MAX_SIZE goes straight to the heap.
+ */
+class SpritePool {
+public:
+	static const size_t			MAX_SIZE = 8192;
+
+	static SpritePool&			get();
+
+	void*						allocate(const size_t size);
+	void						deallocate(void* p, const size_t size);
+
+	/// Make sure count objects of this size can be made without going to the heap,
+	/// e.g. before building a long list. See reserve<T>().
+	void						reserve(const size_t size, const size_t count);
+	template <typename T>
+	void						reserve(const size_t count) { reserve(sizeof(T), count); }
+
+private:
+	SpritePool();
+	SpritePool(const SpritePool&);
+	SpritePool&					operator=(const SpritePool&);
+
+	// Slots are rounded up to this, which is also their alignment
+	static const size_t			GRANULARITY = 16;
+	static const size_t			BUCKET_COUNT = MAX_SIZE / GRANULARITY;
+
+	struct FreeSlot {
+		FreeSlot*				mNext;
+	};
+
+	class Bucket {
+	public:
+		Bucket();
+
+		Poco::FastMutex			mMutex;
+		FreeSlot*				mFree;
+		std::vector<void*>		mChunks;
+	};
+
+	/// Adds a chunk of at least count slots to the bucket. Call with the bucket locked.
+	void						grow(Bucket&, const size_t slotSize, const size_t count);
+
+	Bucket						mBuckets[BUCKET_COUNT];
+	ds::MemoryTag&				mMemory;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_SPRITEPOOL_H_
@@ -14,6 +14,8 @@
 #include "ds/app/blob_registry.h"
 #include "ds/data/data_buffer.h"
 #include "ds/debug/logger.h"
+#include "ds/debug/memory_accounting.h"
+#include "ds/debug/profiler.h"
 #include "ds/ui/sprite/sprite_engine.h"
 #include "ds/ui/service/pango_font_service.h"
 #include "ds/util/string_util.h"
@@ -87,12 +89,12 @@ const char			LAYOUT_ATT = 82;
 
 void Text::installAsServer(ds::BlobRegistry& registry)
 {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromClient(r); }, "Text");
 }
 
 void Text::installAsClient(ds::BlobRegistry& registry)
 {
-	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Text>(r); });
+	BLOB_TYPE = registry.add([](BlobReader& r) {Sprite::handleBlobFromServer<Text>(r); }, "Text");
 }
 
 Text::Text(ds::ui::SpriteEngine& eng)
@@ -515,6 +517,7 @@ void Text::onUpdateServer(const UpdateParams&){
 }
 
 bool Text::measurePangoText() {
+	DS_PROFILE_ZONE("Text::measurePangoText");
 	if(mNeedsFontUpdate || mNeedsMeasuring || mNeedsTextRender || mNeedsMarkupDetection) {
 
 		if(mText.empty() || mTextSize <= 0.0f){
@@ -785,6 +788,10 @@ void Text::renderPangoText(){
 			//format.setMagFilter(GL_NEAREST);
 			//format.setMinFilter(GL_NEAREST);
 			mTexture = ci::gl::Texture::create(pixels, GL_BGRA, mPixelWidth, mPixelHeight, format);
+			// Mipmapped, so a third again on top of the pixels
+			static ds::MemoryTag&	TEXTURE_MEMORY = ds::MemoryAccounting::get().getTag("Text textures");
+			const int64_t			textureBytes = static_cast<int64_t>(mPixelWidth) * static_cast<int64_t>(mPixelHeight) * 4;
+			mTexture = ds::trackMemory(mTexture, TEXTURE_MEMORY, textureBytes + textureBytes / 3);
 			mTexture->setTopDown(true);
 			mNeedsTextRender = false;
 
@@ -141,6 +141,7 @@ void TouchManager::inputBegin(const int fingerId, const ci::vec2& touchPos){
 	mRotationTranslator.down(touchInfo);
 
 	if(mSmoothEnabled){
+		mTouchHistoryPoint.erase(fingerId);
 		mTouchSmoothPoints[fingerId].clear();
 		mTouchSmoothPoints[fingerId].push_back(touchInfo.mCurrentGlobalPoint);
 	}
@@ -177,6 +178,50 @@ void TouchManager::touchesMoved(const ds::ui::TouchEvent &event) {
 	}
 }
 
+void TouchManager::touchesMovedHistory(const ds::ui::TouchEvent &event) {
+	if(!mSmoothEnabled || mInputMode != kInputNormal) return;
+
+	for (auto touchIt = event.getTouches().begin(); touchIt != event.getTouches().end(); ++touchIt) {
+		int fingerId = touchIt->getId() + MOUSE_RESERVED_IDS;
+
+		if(mDiscardTouchMap[fingerId]){
+			continue;
+		}
+
+		ci::vec2 touchPos = touchIt->getPos();
+		if(mOverrideTranslation && !event.getInWorldSpace()){
+			overrideTouchTranslation(touchPos);
+		}
+
+		// Smooth each folded sample like it had been sent on its own, but only remember where
+		// it ended up. The next real move carries on from there, and its delta covers them all.
+		auto found = mTouchHistoryPoint.find(fingerId);
+		const ci::vec3 previous = found != mTouchHistoryPoint.end() ? found->second : mTouchPreviousPoint[fingerId];
+		mTouchHistoryPoint[fingerId] = smoothPoint(fingerId, ci::vec3(touchPos, 0.0f), previous);
+	}
+}
+
+ci::vec3 TouchManager::smoothPoint(const int fingerId, const ci::vec3& point, const ci::vec3& previous){
+	auto& points = mTouchSmoothPoints[fingerId];
+	points.push_back(point);
+	if(points.size() > mFramesToSmooth){
+		points.erase(points.begin());
+	}
+	std::vector<ci::vec3> deltas;
+	for(int i = 1; i < points.size(); i++){
+		deltas.push_back(points[i] - points[i - 1]);
+	}
+	float xcomp(0.0f);
+	float ycomp(0.0f);
+	for(int i = 0; i < deltas.size(); i++){
+		xcomp += deltas[i].x;
+		ycomp += deltas[i].y;
+	}
+	xcomp /= deltas.size();
+	ycomp /= deltas.size();
+	return previous + ci::vec3(xcomp, ycomp, 0.0f);
+}
+
 void TouchManager::mouseTouchMoved(const ci::app::MouseEvent &event, int id){
 	ci::vec2 globalPos = translateMousePoint(event.getPos());
 
@@ -235,23 +280,13 @@ void TouchManager::inputMoved(const int fingerId, const ci::vec2& touchPos){
 	ci::vec3 globalPoint = ci::vec3(touchPos, 0.0f);
 
 	if(mSmoothEnabled){
-		mTouchSmoothPoints[fingerId].push_back(globalPoint);
-		if(mTouchSmoothPoints[fingerId].size() > mFramesToSmooth){
-			mTouchSmoothPoints[fingerId].erase(mTouchSmoothPoints[fingerId].begin());
-		}
-		std::vector<ci::vec3> deltas;
-		for(int i = 1; i < mTouchSmoothPoints[fingerId].size(); i++){
-			deltas.push_back(mTouchSmoothPoints[fingerId][i] - mTouchSmoothPoints[fingerId][i - 1]);
-		}
-		float xcomp(0.0f);
-		float ycomp(0.0f);
-		for(int i = 0; i < deltas.size(); i++){
-			xcomp += deltas[i].x;
-			ycomp += deltas[i].y;
+		auto found = mTouchHistoryPoint.find(fingerId);
+		if(found != mTouchHistoryPoint.end()){
+			globalPoint = smoothPoint(fingerId, globalPoint, found->second);
+			mTouchHistoryPoint.erase(found);
+		} else {
+			globalPoint = smoothPoint(fingerId, globalPoint, mTouchPreviousPoint[fingerId]);
 		}
-		xcomp /= deltas.size();
-		ycomp /= deltas.size();
-		globalPoint = mTouchPreviousPoint[fingerId] + ci::vec3(xcomp, ycomp, 0.0f);
 	}
 
 	TouchInfo touchInfo;
@@ -347,6 +382,7 @@ void TouchManager::inputEnded(const int fingerId, const ci::vec2& touchPos){
 
 	mTouchStartPoint.erase(touchInfo.mFingerId);
 	mTouchPreviousPoint.erase(touchInfo.mFingerId);
+	mTouchHistoryPoint.erase(touchInfo.mFingerId);
 	mFingerDispatcher.erase(touchInfo.mFingerId);
 
 	if(mCapture) mCapture->touchEnd(touchInfo);
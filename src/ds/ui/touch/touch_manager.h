@@ -49,6 +49,8 @@ public:
 	void									touchesBegin(const ds::ui::TouchEvent&);
 	void									touchesMoved(const ds::ui::TouchEvent&);
 	void									touchesEnded(const ds::ui::TouchEvent&);
+	/// Moves that were folded into a later one before reaching touchesMoved(). Only feeds smoothing.
+	void									touchesMovedHistory(const ds::ui::TouchEvent&);
 
 	void									clearFingers(const std::vector<int> &fingers);
 
@@ -88,8 +90,12 @@ private:
 	void									inputBegin(const int fingerId, const ci::vec2& globalPos);
 	void									inputMoved(const int fingerId, const ci::vec2& globalPos);
 	void									inputEnded(const int fingerId, const ci::vec2& globalPos);
+	/// Adds the point to the finger's smoothing window and answers where it lands, starting from previous
+	ci::vec3								smoothPoint(const int fingerId, const ci::vec3& point, const ci::vec3& previous);
 
 	std::map<int, std::vector<ci::vec3>>	mTouchSmoothPoints;
+	/// Where the smoothed point got to from folded moves, since the last move was sent
+	std::map<int, ci::vec3>					mTouchHistoryPoint;
 	bool									mSmoothEnabled;
 	int										mFramesToSmooth;
 
@@ -63,6 +63,19 @@ std::wstring		wstr_from_utf8(const std::string& str)
 	return wstr_from_str(str, CP_UTF8);
 }
 
+void				wstr_from_utf8(const std::string& str, std::wstring& out)
+{
+	out.clear();
+	if (str.empty()) return;
+
+	const int len = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.length()), 0, 0);
+	if(!len) return;
+	out.resize(len);
+	if(!MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.length()), &out[0], len)){
+		out.clear();
+	}
+}
+
 std::string			utf8_from_wstr(const std::wstring& wstr)
 {
 	return str_from_wstr(wstr, CP_UTF8);
@@ -99,6 +112,12 @@ namespace ds{
 
 std::wstring		wstr_from_utf8(const std::string& src) {
 	std::wstring dest;
+	wstr_from_utf8(src, dest);
+	return dest;
+}
+
+void				wstr_from_utf8(const std::string& src, std::wstring& dest) {
+	dest.clear();
 
 	wchar_t w = 0;
 	int bytes = 0;
@@ -141,9 +160,6 @@ std::wstring		wstr_from_utf8(const std::string& src) {
 	}
 	if ( bytes )
 		dest.push_back( err );
-
-
-	return dest;
 }
 
 
@@ -13,6 +13,8 @@
 namespace ds {
 // Format conversions
 std::wstring		wstr_from_utf8(const std::string&);		
+/// Into an existing string, reusing its storage
+void				wstr_from_utf8(const std::string&, std::wstring& out);
 std::string			utf8_from_wstr(const std::wstring&);	
 
 // If you have some ANSI text, iso 8859-1
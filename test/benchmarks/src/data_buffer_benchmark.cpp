@@ -0,0 +1,179 @@
+/**
+ * Encodes and decodes a single 50,000 sprite world frame, the way the server and
+ * clients do: every sprite fully dirty, written attribute by attribute into a
+ * DataBuffer, then read back out of a wrapped span.
+ *
+ * The attribute layout mirrors Sprite::writeTo() / Sprite::readAttributesFrom().
+ * Usage: data_buffer_benchmark [sprite count] [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "ds/data/data_buffer.h"
+#include "ds/network/net_codec.h"
+
+namespace {
+
+typedef int					sprite_id_t;
+
+const char					TERMINATOR_CHAR		= 0;
+const char					BLOB_TYPE			= 3;
+const char					SPRITE_ID_ATTRIBUTE	= 1;
+const char					PARENT_ATT			= 2;
+const char					SIZE_ATT			= 3;
+const char					FLAGS_ATT			= 4;
+const char					POSITION_ATT		= 5;
+const char					CENTER_ATT			= 6;
+const char					SCALE_ATT			= 7;
+const char					COLOR_ATT			= 8;
+const char					OPACITY_ATT			= 9;
+const char					ROTATION_ATT		= 13;
+
+struct FakeSprite {
+	sprite_id_t				mId;
+	sprite_id_t				mParent;
+	float					mWidth, mHeight, mDepth;
+	int						mFlags;
+	std::string				mShaderLocation, mShaderName;
+	float					mPosition[3], mCenter[3], mScale[3], mRotation[3], mColor[3];
+	float					mOpacity;
+};
+
+void writeSprite(const FakeSprite& s, ds::DataBuffer& buf) {
+	buf.add(BLOB_TYPE);
+	buf.add(SPRITE_ID_ATTRIBUTE);
+	buf.add(s.mId);
+
+	buf.add(PARENT_ATT);
+	buf.add(s.mParent);
+	buf.add(SIZE_ATT);
+	buf.add(s.mWidth);
+	buf.add(s.mHeight);
+	buf.add(s.mDepth);
+	buf.add(FLAGS_ATT);
+	buf.add(s.mFlags);
+	buf.add(s.mShaderLocation);
+	buf.add(s.mShaderName);
+	const char vecAtts[] = { POSITION_ATT, CENTER_ATT, ROTATION_ATT, SCALE_ATT, COLOR_ATT };
+	const float* vecs[] = { s.mPosition, s.mCenter, s.mRotation, s.mScale, s.mColor };
+	for(int i = 0; i < 5; ++i) {
+		buf.add(vecAtts[i]);
+		buf.add(vecs[i][0]);
+		buf.add(vecs[i][1]);
+		buf.add(vecs[i][2]);
+	}
+	buf.add(OPACITY_ATT);
+	buf.add(s.mOpacity);
+
+	buf.add(TERMINATOR_CHAR);
+}
+
+/// Answers the number of sprites read, or -1 if the frame is malformed.
+int readFrame(ds::DataBuffer& buf, FakeSprite& s) {
+	int count = 0;
+	while(buf.canRead<char>()) {
+		if(buf.read<char>() != BLOB_TYPE) return -1;
+		if(buf.read<char>() != SPRITE_ID_ATTRIBUTE) return -1;
+		s.mId = buf.read<sprite_id_t>();
+
+		char id;
+		while(buf.canRead<char>() && (id = buf.read<char>()) != TERMINATOR_CHAR) {
+			if(id == PARENT_ATT) {
+				s.mParent = buf.read<sprite_id_t>();
+			} else if(id == SIZE_ATT) {
+				s.mWidth = buf.read<float>();
+				s.mHeight = buf.read<float>();
+				s.mDepth = buf.read<float>();
+			} else if(id == FLAGS_ATT) {
+				s.mFlags = buf.read<int>();
+				s.mShaderLocation = buf.read<std::string>();
+				s.mShaderName = buf.read<std::string>();
+			} else if(id == OPACITY_ATT) {
+				s.mOpacity = buf.read<float>();
+			} else {
+				float* v = id == POSITION_ATT ? s.mPosition : id == CENTER_ATT ? s.mCenter
+					: id == ROTATION_ATT ? s.mRotation : id == SCALE_ATT ? s.mScale : s.mColor;
+				v[0] = buf.read<float>();
+				v[1] = buf.read<float>();
+				v[2] = buf.read<float>();
+			}
+		}
+		++count;
+	}
+	return count;
+}
+
+double millisSince(const std::chrono::high_resolution_clock::time_point& start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+	const int numSprites = argc > 1 ? std::atoi(argv[1]) : 50000;
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+
+	std::vector<FakeSprite> sprites(numSprites);
+	for(int i = 0; i < numSprites; ++i) {
+		FakeSprite& s = sprites[i];
+		s.mId = i + 1;
+		s.mParent = i / 8;
+		s.mWidth = 100.0f + i; s.mHeight = 50.0f; s.mDepth = 1.0f;
+		s.mFlags = i & 0xff;
+		s.mShaderLocation = "";
+		s.mShaderName = "base";
+		for(int k = 0; k < 3; ++k) {
+			s.mPosition[k] = static_cast<float>(i * k);
+			s.mCenter[k] = 0.0f;
+			s.mRotation[k] = 0.0f;
+			s.mScale[k] = 1.0f;
+			s.mColor[k] = 1.0f;
+		}
+		s.mOpacity = 1.0f;
+	}
+
+	// One long-lived buffer, like EngineSender's, so the arena is only sized once
+	ds::DataBuffer sendBuffer;
+	ds::DataBuffer receiveBuffer;
+	std::string compressed, decompressed;
+	FakeSprite readInto;
+
+	double bestWrite = 1e9, bestRead = 1e9, bestEncode = 1e9, bestDecode = 1e9;
+	for(int it = 0; it < iterations; ++it) {
+		auto start = std::chrono::high_resolution_clock::now();
+		sendBuffer.clear();
+		for(auto& s : sprites) writeSprite(s, sendBuffer);
+		bestWrite = std::min(bestWrite, millisSince(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		ds::net::encode(ds::net::CODEC_SNAPPY, sendBuffer.data(), sendBuffer.size(), compressed);
+		bestEncode = std::min(bestEncode, millisSince(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		ds::net::decode(ds::net::CODEC_SNAPPY, compressed.data(), compressed.size(), decompressed);
+		bestDecode = std::min(bestDecode, millisSince(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		receiveBuffer.wrap(decompressed.data(), static_cast<unsigned>(decompressed.size()));
+		const int numRead = readFrame(receiveBuffer, readInto);
+		bestRead = std::min(bestRead, millisSince(start));
+
+		if(numRead != numSprites) {
+			std::cerr << "Read back " << numRead << " sprites, expected " << numSprites << std::endl;
+			return 1;
+		}
+	}
+
+	const double mb = sendBuffer.size() / (1024.0 * 1024.0);
+	std::cout << numSprites << " sprites, " << sendBuffer.size() << " bytes raw, " << compressed.size() << " bytes snappy" << std::endl;
+	std::cout << "best of " << iterations << ":" << std::endl;
+	std::cout << "  serialize    " << bestWrite << " ms (" << mb / (bestWrite / 1000.0) << " MB/s)" << std::endl;
+	std::cout << "  compress     " << bestEncode << " ms" << std::endl;
+	std::cout << "  decompress   " << bestDecode << " ms" << std::endl;
+	std::cout << "  deserialize  " << bestRead << " ms (" << mb / (bestRead / 1000.0) << " MB/s)" << std::endl;
+	return 0;
+}
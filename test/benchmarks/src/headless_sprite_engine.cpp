@@ -0,0 +1,198 @@
+#include "headless_sprite_engine.h"
+
+#include <stdexcept>
+#include "ds/params/camera_params.h"
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+namespace bench {
+
+/**
+ * \class HeadlessEngineData
+ */
+HeadlessEngineData::HeadlessEngineData()
+		: mEngineData(mEngineSettings) {
+	mEngineData.mWorldSize = ci::vec2(1920.0f, 1080.0f);
+	mEngineData.mSrcRect = ci::Rectf(0.0f, 0.0f, 1920.0f, 1080.0f);
+	mEngineData.mDstRect = mEngineData.mSrcRect;
+	mEngineData.mOriginalSrcRect = mEngineData.mSrcRect;
+}
+
+/**
+ * \class HeadlessSpriteEngine
+ */
+HeadlessSpriteEngine::HeadlessSpriteEngine(const int appMode)
+		: ds::ui::SpriteEngine(mEngineData, appMode)
+		, mTimeline(ci::Timeline::create())
+		, mTweenline(*mTimeline)
+		, mFonts(*this)
+		, mNextId(ds::EMPTY_SPRITE_ID)
+		, mElapsed(0.0f) {
+	mDirtySprites.setEnabled(appMode == SERVER_MODE || appMode == CLIENTSERVER_MODE);
+}
+
+HeadlessSpriteEngine::~HeadlessSpriteEngine() {
+	mRootPtrs.clear();
+	mRoots.clear();
+	mDirtySprites.clear();
+}
+
+ds::ui::Sprite& HeadlessSpriteEngine::addRoot(const ds::sprite_id_t id) {
+	ds::ui::Sprite*			root = new ds::ui::Sprite(*this, id == ds::EMPTY_SPRITE_ID ? nextSpriteId() : id, false);
+	root->setSize(mEngineData.mWorldSize.x, mEngineData.mWorldSize.y);
+	mRoots.push_back(std::unique_ptr<ds::ui::Sprite>(root));
+	mRootPtrs.push_back(root);
+	return *root;
+}
+
+void HeadlessSpriteEngine::step(const float dt) {
+	mElapsed += dt;
+	mUpdateParams.setDeltaTime(dt);
+	mUpdateParams.setElapsedTime(mElapsed);
+	mTimeline->step(dt);
+}
+
+ds::EventNotifier& HeadlessSpriteEngine::getChannel(const std::string&) {
+	return mEngineData.mNotifier;
+}
+
+ds::ResourceList& HeadlessSpriteEngine::getResources() {
+	return mResources;
+}
+
+const ds::ColorList& HeadlessSpriteEngine::getColors() const {
+	return mColors;
+}
+
+const ds::FontList& HeadlessSpriteEngine::getFonts() const {
+	return mFonts;
+}
+
+ds::AutoUpdateList& HeadlessSpriteEngine::getAutoUpdateList(const int) {
+	return mAutoUpdate;
+}
+
+ds::ui::LoadImageService& HeadlessSpriteEngine::getLoadImageService() {
+	throw std::runtime_error("HeadlessSpriteEngine can't load images");
+}
+
+ds::ui::PangoFontService& HeadlessSpriteEngine::getPangoFontService() {
+	throw std::runtime_error("HeadlessSpriteEngine can't render text");
+}
+
+ds::ui::Tweenline& HeadlessSpriteEngine::getTweenline() {
+	return mTweenline;
+}
+
+ci::app::WindowRef HeadlessSpriteEngine::getWindow() {
+	return ci::app::WindowRef();
+}
+
+ds::sprite_id_t HeadlessSpriteEngine::nextSpriteId() {
+	// Same as EngineClient, clients only use the IDs the server sends
+	if(getMode() == CLIENT_MODE) return ds::EMPTY_SPRITE_ID;
+	++mNextId;
+	if(mNextId <= ds::EMPTY_SPRITE_ID) mNextId = ds::EMPTY_SPRITE_ID + 1;
+	return mNextId;
+}
+
+void HeadlessSpriteEngine::registerSprite(ds::ui::Sprite& s) {
+	mSprites.set(s.getId(), &s);
+}
+
+void HeadlessSpriteEngine::unregisterSprite(ds::ui::Sprite& s) {
+	mSprites.erase(s.getId());
+}
+
+ds::ui::Sprite* HeadlessSpriteEngine::findSprite(const ds::sprite_id_t id) {
+	return mSprites.find(id);
+}
+
+void HeadlessSpriteEngine::spriteDeleted(const ds::sprite_id_t&) {
+}
+
+ci::Color8u HeadlessSpriteEngine::getUniqueColor() {
+	return ci::Color8u(0, 0, 0);
+}
+
+ds::PerspCameraParams HeadlessSpriteEngine::getPerspectiveCamera(const size_t) const {
+	return ds::PerspCameraParams();
+}
+
+const ci::CameraPersp& HeadlessSpriteEngine::getPerspectiveCameraRef(const size_t) const {
+	static ci::CameraPersp	CAMERA;
+	return CAMERA;
+}
+
+void HeadlessSpriteEngine::setPerspectiveCamera(const size_t, const ds::PerspCameraParams&) {
+}
+
+void HeadlessSpriteEngine::setPerspectiveCameraRef(const size_t, const ci::CameraPersp&) {
+}
+
+float HeadlessSpriteEngine::getOrthoFarPlane(const size_t) const {
+	return 1000.0f;
+}
+
+float HeadlessSpriteEngine::getOrthoNearPlane(const size_t) const {
+	return -1000.0f;
+}
+
+void HeadlessSpriteEngine::setOrthoViewPlanes(const size_t, const float, const float) {
+}
+
+bool HeadlessSpriteEngine::isIdling() {
+	return false;
+}
+
+void HeadlessSpriteEngine::setSpriteForFinger(const int, ds::ui::Sprite*) {
+}
+
+ds::ui::Sprite* HeadlessSpriteEngine::getSpriteForFinger(const int) {
+	return nullptr;
+}
+
+void HeadlessSpriteEngine::injectTouchesBegin(const ds::ui::TouchEvent&) {
+}
+
+void HeadlessSpriteEngine::injectTouchesMoved(const ds::ui::TouchEvent&) {
+}
+
+void HeadlessSpriteEngine::injectTouchesEnded(const ds::ui::TouchEvent&) {
+}
+
+void HeadlessSpriteEngine::injectObjectsBegin(const ds::TuioObject&) {
+}
+
+void HeadlessSpriteEngine::injectObjectsMoved(const ds::TuioObject&) {
+}
+
+void HeadlessSpriteEngine::injectObjectsEnded(const ds::TuioObject&) {
+}
+
+bool HeadlessSpriteEngine::getRotateTouchesDefault() {
+	return false;
+}
+
+ds::ui::Sprite* HeadlessSpriteEngine::getHit(const ci::vec3& point) {
+	for(auto it = mRootPtrs.rbegin(), end = mRootPtrs.rend(); it != end; ++it) {
+		ds::ui::Sprite*		s = (*it)->getHit(point);
+		if(s) return s;
+	}
+	return nullptr;
+}
+
+int HeadlessSpriteEngine::getBytesRecieved() {
+	return 0;
+}
+
+int HeadlessSpriteEngine::getBytesSent() {
+	return 0;
+}
+
+int HeadlessSpriteEngine::getBytesPerFrame() {
+	return 0;
+}
+
+} // namespace bench
+} // namespace ds
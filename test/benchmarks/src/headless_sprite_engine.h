@@ -0,0 +1,126 @@
+#pragma once
+#ifndef DS_TEST_BENCHMARKS_HEADLESSSPRITEENGINE_H_
+#define DS_TEST_BENCHMARKS_HEADLESSSPRITEENGINE_H_
+
+#include <memory>
+#include <vector>
+#include <cinder/Timeline.h>
+#include "ds/app/auto_update_list.h"
+#include "ds/app/engine/engine_data.h"
+#include "ds/cfg/settings.h"
+#include "ds/data/color_list.h"
+#include "ds/data/font_list.h"
+#include "ds/data/resource_list.h"
+#include "ds/params/update_params.h"
+#include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/sprite/sprite_id_map.h"
+#include "ds/ui/tween/tweenline.h"
+
+namespace ds {
+namespace bench {
+
+/**
+ * \class HeadlessEngineData
+ * \brief The settings and data behind a HeadlessSpriteEngine. A base class so it's
+ * built before the SpriteEngine, which holds on to the data.
+ */
+class HeadlessEngineData {
+protected:
+	HeadlessEngineData();
+
+	ds::cfg::Settings				mEngineSettings;
+	ds::EngineData					mEngineData;
+};
+
+/**
+ * \class HeadlessSpriteEngine
+ * \brief Just enough of a sprite engine to build, update, replicate and hit test
+ * plain sprites with no app, window or GL context, so the engine core can be
+ * benchmarked on a machine without a GPU. Time only moves when step() is called.
+ *
+ * Anything that needs a window or GL (image loading, text, cameras, touch input)
+ * isn't there: the services throw, and the rest do nothing.
+ */
+class HeadlessSpriteEngine : private HeadlessEngineData, public ds::ui::SpriteEngine {
+public:
+	/// SERVER_MODE turns on the dirty sprite list, so the trees can be replicated.
+	HeadlessSpriteEngine(const int appMode);
+	~HeadlessSpriteEngine();
+
+	/// A root, owned by the engine. Clients replicate into their roots, so they need
+	/// to use the server's root IDs.
+	ds::ui::Sprite&					addRoot(const ds::sprite_id_t id = ds::EMPTY_SPRITE_ID);
+	const std::vector<ds::ui::Sprite*>&
+									getRoots() const { return mRootPtrs; }
+
+	/// Advance the clock and the tweens by dt seconds.
+	void							step(const float dt);
+	const ds::UpdateParams&			getUpdateParams() const { return mUpdateParams; }
+	ds::ui::SpriteIdMap&			getSprites() { return mSprites; }
+
+	virtual ds::EventNotifier&		getChannel(const std::string&);
+	virtual ds::ResourceList&		getResources();
+	virtual const ds::ColorList&	getColors() const;
+	virtual const ds::FontList&		getFonts() const;
+	virtual ds::AutoUpdateList&		getAutoUpdateList(const int = ds::AutoUpdateType::SERVER);
+	virtual ds::ui::LoadImageService&
+									getLoadImageService();
+	virtual ds::ui::PangoFontService&
+									getPangoFontService();
+	virtual ds::ui::Tweenline&		getTweenline();
+	virtual ci::app::WindowRef		getWindow();
+
+	virtual ds::sprite_id_t			nextSpriteId();
+	virtual void					registerSprite(ds::ui::Sprite&);
+	virtual void					unregisterSprite(ds::ui::Sprite&);
+	virtual ds::ui::Sprite*			findSprite(const ds::sprite_id_t);
+	virtual void					spriteDeleted(const ds::sprite_id_t&);
+	virtual ci::Color8u				getUniqueColor();
+
+	virtual ds::PerspCameraParams	getPerspectiveCamera(const size_t index) const;
+	virtual const ci::CameraPersp&	getPerspectiveCameraRef(const size_t index) const;
+	virtual void					setPerspectiveCamera(const size_t index, const ds::PerspCameraParams&);
+	virtual void					setPerspectiveCameraRef(const size_t index, const ci::CameraPersp&);
+	virtual float					getOrthoFarPlane(const size_t index) const;
+	virtual float					getOrthoNearPlane(const size_t index) const;
+	virtual void					setOrthoViewPlanes(const size_t index, const float nearPlane, const float farPlane);
+
+	virtual bool					isIdling();
+	virtual void					setSpriteForFinger(const int fingerId, ds::ui::Sprite*);
+	virtual ds::ui::Sprite*			getSpriteForFinger(const int fingerId);
+	virtual void					injectTouchesBegin(const ds::ui::TouchEvent&);
+	virtual void					injectTouchesMoved(const ds::ui::TouchEvent&);
+	virtual void					injectTouchesEnded(const ds::ui::TouchEvent&);
+	virtual void					injectObjectsBegin(const ds::TuioObject&);
+	virtual void					injectObjectsMoved(const ds::TuioObject&);
+	virtual void					injectObjectsEnded(const ds::TuioObject&);
+	virtual bool					getRotateTouchesDefault();
+	virtual ds::ui::Sprite*			getHit(const ci::vec3& point);
+
+	virtual int						getBytesRecieved();
+	virtual int						getBytesSent();
+	virtual int						getBytesPerFrame();
+
+private:
+	HeadlessSpriteEngine(const HeadlessSpriteEngine&);
+	HeadlessSpriteEngine&			operator=(const HeadlessSpriteEngine&);
+
+	ci::TimelineRef					mTimeline;
+	ds::ui::Tweenline				mTweenline;
+	ds::ResourceList				mResources;
+	ds::ColorList					mColors;
+	ds::FontList					mFonts;
+	ds::AutoUpdateList				mAutoUpdate;
+	ds::ui::SpriteIdMap				mSprites;
+	ds::sprite_id_t					mNextId;
+	std::vector<std::unique_ptr<ds::ui::Sprite>>
+									mRoots;
+	std::vector<ds::ui::Sprite*>	mRootPtrs;
+	ds::UpdateParams				mUpdateParams;
+	float							mElapsed;
+};
+
+} // namespace bench
+} // namespace ds
+
+#endif // DS_TEST_BENCHMARKS_HEADLESSSPRITEENGINE_H_
@@ -0,0 +1,306 @@
+/**
+ * Builds a query::Result from an in-memory SQLite table the way query::Client does,
+ * and the same rows into a copy of the row-at-a-time layout Result used to have (a
+ * heap row per row, each with a vector of numbers, strings and wide strings), so the
+ * two can be compared: build time, allocations, the memory each holds on to, reading
+ * every row back, and copying the whole result.
+ *
+ * The table has an id, a title, a body, a score and a resource id that's NULL for
+ * every tenth row. Allocations are counted by replacing the global operator new.
+ * Usage: query_result_benchmark [rows] [iterations]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "ds/query/query_result.h"
+#include "ds/query/sql_query_result_builder.h"
+#include "ds/query/sqlite/sqlite3.h"
+#include "ds/util/string_util.h"
+
+namespace {
+std::atomic<size_t>			ALLOCATIONS(0);
+std::atomic<int64_t>		LIVE_BYTES(0);
+// Every block carries its size in front, so deletes can take it off the live count
+const size_t				HEADER = 16;
+}
+
+void* operator new(std::size_t size) {
+	ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+	LIVE_BYTES.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+	char*					p = static_cast<char*>(std::malloc(size + HEADER));
+	if(!p) throw std::bad_alloc();
+	*reinterpret_cast<std::size_t*>(p) = size;
+	return p + HEADER;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	if(!p) return;
+	char*					block = static_cast<char*>(p) - HEADER;
+	LIVE_BYTES.fetch_sub(static_cast<int64_t>(*reinterpret_cast<std::size_t*>(block)), std::memory_order_relaxed);
+	std::free(block);
+}
+
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+namespace {
+
+/// The layout query::Result had before it went columnar, built the way ResultBuilder built it
+class RowResult {
+public:
+	class Row {
+	public:
+		std::string					mName;
+		std::vector<double>			mNumeric;
+		std::vector<std::string>	mString;
+		std::vector<std::wstring>	mWString;
+	};
+
+	std::vector<int>				mCol;
+	std::vector<std::unique_ptr<Row>>	mRow;
+
+	void build(sqlite3_stmt* statement) {
+		mCol.clear();
+		mRow.clear();
+		std::string					buffer;
+		int							step = sqlite3_step(statement);
+		if(step != SQLITE_ROW) return;
+		for(int k = 0; k < sqlite3_data_count(statement); ++k) {
+			const int				t = sqlite3_column_type(statement, k);
+			mCol.push_back(t == SQLITE_INTEGER || t == SQLITE_FLOAT ? ds::query::QUERY_NUMERIC : t == SQLITE_TEXT ? ds::query::QUERY_STRING : ds::query::QUERY_NULL);
+		}
+		while(step == SQLITE_ROW) {
+			mRow.push_back(std::unique_ptr<Row>(new Row()));
+			Row&					row = *mRow.back();
+			for(int k = 0; k < static_cast<int>(mCol.size()); ++k) {
+				if(mCol[k] != ds::query::QUERY_STRING) {
+					row.mNumeric.resize(k + 1);
+					row.mNumeric[k] = sqlite3_column_double(statement, k);
+				}
+				if(mCol[k] != ds::query::QUERY_NUMERIC) {
+					const unsigned char*	text = sqlite3_column_text(statement, k);
+					buffer.clear();
+					if(text) buffer.assign(reinterpret_cast<const char*>(text));
+					row.mString.resize(k + 1);
+					row.mString[k] = buffer;
+					row.mWString.resize(k + 1);
+					ds::wstr_from_utf8(buffer, row.mWString[k]);
+				}
+			}
+			step = sqlite3_step(statement);
+		}
+	}
+
+	/// What RowIterator::getInt64() did: NULL columns can hold numbers as text
+	static int64_t getInt64(const Row& row, const size_t column) {
+		if(column < row.mWString.size() && !row.mWString[column].empty()) {
+			int64_t					ans = 0;
+			if(ds::wstring_to_value(row.mWString[column], ans)) return ans;
+		}
+		if(column >= row.mNumeric.size()) return 0;
+		const double				d = row.mNumeric[column];
+		return static_cast<int64_t>(d > 0.0 ? d + 0.5 : d - 0.5);
+	}
+
+	RowResult& operator=(const RowResult& o) {
+		mCol = o.mCol;
+		mRow.clear();
+		for(auto& r : o.mRow) mRow.push_back(std::unique_ptr<Row>(new Row(*r)));
+		return *this;
+	}
+};
+
+/// Time, allocations and retained bytes for one thing, one entry per iteration
+class Log {
+public:
+	std::vector<double>		mMillis;
+	std::vector<size_t>		mAllocations;
+	std::vector<int64_t>	mBytes;
+
+	double median() const {
+		if(mMillis.empty()) return 0.0;
+		std::vector<double>	sorted(mMillis);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[sorted.size() / 2];
+	}
+	template <typename T>
+	static double average(const std::vector<T>& v) {
+		if(v.empty()) return 0.0;
+		double				sum = 0.0;
+		for(auto n : v) sum += static_cast<double>(n);
+		return sum / static_cast<double>(v.size());
+	}
+};
+
+/// Times whatever happens between construction and stop(), counting allocations and
+/// how many more bytes are held at the end than at the start
+class Measure {
+public:
+	Measure(Log& log)
+			: mLog(log)
+			, mAllocations(ALLOCATIONS.load(std::memory_order_relaxed))
+			, mBytes(LIVE_BYTES.load(std::memory_order_relaxed))
+			, mStart(std::chrono::high_resolution_clock::now()) {
+	}
+	void stop() {
+		const auto			end = std::chrono::high_resolution_clock::now();
+		mLog.mMillis.push_back(std::chrono::duration<double, std::milli>(end - mStart).count());
+		mLog.mAllocations.push_back(ALLOCATIONS.load(std::memory_order_relaxed) - mAllocations);
+		mLog.mBytes.push_back(LIVE_BYTES.load(std::memory_order_relaxed) - mBytes);
+	}
+
+private:
+	Log&					mLog;
+	const size_t			mAllocations;
+	const int64_t			mBytes;
+	const std::chrono::high_resolution_clock::time_point
+							mStart;
+};
+
+bool exec(sqlite3* db, const char* sql) {
+	char*					err = nullptr;
+	if(sqlite3_exec(db, sql, nullptr, nullptr, &err) == SQLITE_OK) return true;
+	std::cerr << "SQL error: " << (err ? err : "?") << " on " << sql << std::endl;
+	sqlite3_free(err);
+	return false;
+}
+
+bool fillTable(sqlite3* db, const int rows) {
+	if(!exec(db, "CREATE TABLE items (id INTEGER PRIMARY KEY, title TEXT, body TEXT, score REAL, resource INTEGER)")) return false;
+	if(!exec(db, "BEGIN")) return false;
+	sqlite3_stmt*			insert = nullptr;
+	sqlite3_prepare_v2(db, "INSERT INTO items VALUES (?, ?, ?, ?, ?)", -1, &insert, nullptr);
+	const std::string		body = "A body of text long enough that it won't fit in a short string, about a hundred chars or so long.";
+	for(int k = 0; k < rows; ++k) {
+		const std::string	title = "Item number " + std::to_string(k);
+		sqlite3_bind_int(insert, 1, k + 1);
+		sqlite3_bind_text(insert, 2, title.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(insert, 3, body.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_double(insert, 4, k * 0.5);
+		if(k % 10 == 0) sqlite3_bind_null(insert, 5);
+		else sqlite3_bind_int(insert, 5, k * 3);
+		if(sqlite3_step(insert) != SQLITE_DONE) return false;
+		sqlite3_reset(insert);
+	}
+	sqlite3_finalize(insert);
+	return exec(db, "COMMIT");
+}
+
+sqlite3_stmt* selectAll(sqlite3* db) {
+	sqlite3_stmt*			statement = nullptr;
+	sqlite3_prepare_v2(db, "SELECT id, title, body, score, resource FROM items ORDER BY id", -1, &statement, nullptr);
+	return statement;
+}
+
+void print(const char* name, const Log& log) {
+	std::cout << "  " << std::left << std::setw(24) << name << std::right << std::setprecision(3)
+		<< std::setw(10) << log.median() << std::setprecision(0)
+		<< std::setw(14) << Log::average(log.mAllocations) << std::setw(16) << Log::average(log.mBytes) << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+	const int				rows = argc > 1 ? std::atoi(argv[1]) : 100000;
+	const int				iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+	sqlite3*				db = nullptr;
+	if(sqlite3_open(":memory:", &db) != SQLITE_OK || !fillTable(db, rows)) {
+		std::cerr << "Couldn't make the table" << std::endl;
+		return 1;
+	}
+
+	Log						rowBuild, rowRead, rowCopy;
+	Log						colBuild, colRead, colChars, colCopy;
+	int64_t					rowSum = 0, colSum = 0, charSum = 0;
+	for(int i = 0; i < iterations; ++i) {
+		{
+			RowResult		result;
+			Measure			build(rowBuild);
+			result.build(selectAll(db));
+			build.stop();
+
+			Measure			read(rowRead);
+			for(auto& r : result.mRow) {
+				rowSum += RowResult::getInt64(*r, 0) + static_cast<int64_t>(r->mString[1].size())
+					+ static_cast<int64_t>(r->mString[2].size()) + RowResult::getInt64(*r, 4);
+			}
+			read.stop();
+
+			RowResult		copy;
+			Measure			copying(rowCopy);
+			copy = result;
+			copying.stop();
+		}
+		{
+			ds::query::Result	result;
+			Measure			build(colBuild);
+			{
+				ds::query::SqlResultBuilder	builder(result, selectAll(db));
+				builder.build();
+			}
+			build.stop();
+
+			Measure			read(colRead);
+			for(auto it = result.getRows(); it.hasValue(); ++it) {
+				colSum += it.getInt64(0) + static_cast<int64_t>(it.getString(1).size())
+					+ static_cast<int64_t>(it.getString(2).size()) + it.getInt64(4);
+			}
+			read.stop();
+
+			Measure			chars(colChars);
+			size_t			title = 0, body = 0;
+			for(auto it = result.getRows(); it.hasValue(); ++it) {
+				it.getChars(1, &title);
+				it.getChars(2, &body);
+				charSum += it.getInt64(0) + static_cast<int64_t>(title + body) + it.getInt64(4);
+			}
+			chars.stop();
+
+			ds::query::Result	copy;
+			Measure			copying(colCopy);
+			copy = result;
+			copying.stop();
+		}
+	}
+	sqlite3_close(db);
+
+	if(rowSum != colSum || rowSum != charSum) {
+		std::cerr << "Layouts disagree: rows " << rowSum << " columns " << colSum << " chars " << charSum << std::endl;
+		return 1;
+	}
+
+	std::cout << rows << " rows, " << iterations << " iterations" << std::endl;
+	std::cout << "  phase                   median ms   allocations   bytes retained" << std::endl;
+	std::cout << std::fixed;
+	print("row layout build", rowBuild);
+	print("row layout read", rowRead);
+	print("row layout copy", rowCopy);
+	print("columns build", colBuild);
+	print("columns read (strings)", colRead);
+	print("columns read (chars)", colChars);
+	print("columns copy", colCopy);
+	return 0;
+}
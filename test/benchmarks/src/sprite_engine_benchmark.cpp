@@ -0,0 +1,293 @@
+/**
+ * Runs a sprite tree through the engine's per-frame work with no app, window or GL
+ * context, so it can run on a build machine: tweens, updateServer(), property changes,
+ * transforms, hit testing, and replication from a server engine into a client engine
+ * through the dirty sprite list and Sprite::readAttributesFrom().
+ *
+ * The tree is [depth] levels deep with [children] children per sprite. Every phase is
+ * timed separately each frame, and every allocation made during it is counted by
+ * replacing the global operator new.
+ *
+ * Given a baseline file that doesn't exist yet, the median of each phase is written to
+ * it. Given one that does, the run fails if any phase's median is more than [tolerance]
+ * slower (0.25 is 25%), so a CI job can keep a baseline per machine and gate on it.
+ * Usage: sprite_engine_benchmark [depth] [children] [frames] [baseline file] [tolerance]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ds/app/blob_reader.h"
+#include "ds/data/data_buffer.h"
+#include "ds/ui/sprite/sprite.h"
+#include "headless_sprite_engine.h"
+
+namespace {
+std::atomic<size_t>			ALLOCATIONS(0);
+std::atomic<size_t>			ALLOCATED_BYTES(0);
+}
+
+void* operator new(std::size_t size) {
+	ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+	ALLOCATED_BYTES.fetch_add(size, std::memory_order_relaxed);
+	void*					p = std::malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+enum Phase {
+	PHASE_TWEEN,
+	PHASE_UPDATE,
+	PHASE_SET_PROPERTIES,
+	PHASE_TRANSFORM,
+	PHASE_HIT_TEST,
+	PHASE_WRITE,
+	PHASE_READ,
+	PHASE_COUNT
+};
+
+const char*					PHASE_NAMES[PHASE_COUNT] = { "tween", "update", "set_properties", "transform", "hit_test", "write", "read" };
+
+/// Times and allocation counts for one phase, one entry per frame
+class PhaseLog {
+public:
+	std::vector<double>		mMillis;
+	std::vector<size_t>		mAllocations;
+	std::vector<size_t>		mBytes;
+
+	double median() const { return percentile(0.5); }
+	double percentile(const double p) const {
+		if(mMillis.empty()) return 0.0;
+		std::vector<double>	sorted(mMillis);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5)];
+	}
+	double average(const std::vector<size_t>& v) const {
+		if(v.empty()) return 0.0;
+		double				sum = 0.0;
+		for(auto n : v) sum += static_cast<double>(n);
+		return sum / static_cast<double>(v.size());
+	}
+};
+
+/// Times whatever happens between construction and stop(), and counts its allocations
+class Measure {
+public:
+	Measure(PhaseLog& log, const bool record)
+			: mLog(log)
+			, mRecord(record)
+			, mAllocations(ALLOCATIONS.load(std::memory_order_relaxed))
+			, mBytes(ALLOCATED_BYTES.load(std::memory_order_relaxed))
+			, mStart(std::chrono::high_resolution_clock::now()) {
+	}
+	void stop() {
+		const auto			end = std::chrono::high_resolution_clock::now();
+		if(!mRecord) return;
+		mLog.mMillis.push_back(std::chrono::duration<double, std::milli>(end - mStart).count());
+		mLog.mAllocations.push_back(ALLOCATIONS.load(std::memory_order_relaxed) - mAllocations);
+		mLog.mBytes.push_back(ALLOCATED_BYTES.load(std::memory_order_relaxed) - mBytes);
+	}
+
+private:
+	PhaseLog&				mLog;
+	const bool				mRecord;
+	const size_t			mAllocations;
+	const size_t			mBytes;
+	const std::chrono::high_resolution_clock::time_point
+							mStart;
+};
+
+void buildTree(ds::ui::SpriteEngine& engine, ds::ui::Sprite& parent, const int depth, const int children,
+			   std::mt19937& rand, std::vector<ds::ui::Sprite*>& all, std::vector<ds::ui::Sprite*>& leaves) {
+	if(depth < 1) {
+		leaves.push_back(&parent);
+		return;
+	}
+	std::uniform_real_distribution<float>	unit(0.0f, 1.0f);
+	const float								w = parent.getWidth() * 0.5f, h = parent.getHeight() * 0.5f;
+	for(int k = 0; k < children; ++k) {
+		ds::ui::Sprite*		s = new ds::ui::Sprite(engine, w, h);
+		s->setPosition(unit(rand) * w, unit(rand) * h);
+		s->setRotation(unit(rand) * 10.0f);
+		parent.addChild(*s);
+		all.push_back(s);
+		buildTree(engine, *s, depth - 1, children, rand, all, leaves);
+	}
+}
+
+/// Every blob in the buffer is a plain sprite, so they can skip the blob registry
+void readFrame(ds::DataBuffer& buf, ds::bench::HeadlessSpriteEngine& client) {
+	ds::BlobReader			reader(buf, client);
+	buf.rewindRead();
+	while(buf.canRead<char>()) {
+		buf.read<char>();
+		ds::ui::Sprite::handleBlobFromServer<ds::ui::Sprite>(reader);
+	}
+}
+
+bool matches(ds::bench::HeadlessSpriteEngine& server, ds::bench::HeadlessSpriteEngine& client) {
+	if(server.getSprites().size() != client.getSprites().size()) {
+		std::cerr << "Client has " << client.getSprites().size() << " sprites, server has " << server.getSprites().size() << std::endl;
+		return false;
+	}
+	for(auto s : server.getSprites().getAll()) {
+		ds::ui::Sprite*		c = client.findSprite(s->getId());
+		if(!c || c->getPosition() != s->getPosition() || c->getRotation() != s->getRotation()) {
+			std::cerr << "Sprite " << s->getId() << " didn't replicate" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readBaseline(const std::string& path, std::map<std::string, double>& out) {
+	std::ifstream			in(path.c_str());
+	if(!in.is_open()) return false;
+	std::string				name;
+	double					millis;
+	while(in >> name >> millis) out[name] = millis;
+	return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+	const int				depth = argc > 1 ? std::atoi(argv[1]) : 4;
+	const int				children = argc > 2 ? std::atoi(argv[2]) : 8;
+	const int				frames = argc > 3 ? std::atoi(argv[3]) : 300;
+	const std::string		baselinePath = argc > 4 ? argv[4] : "";
+	const double			tolerance = argc > 5 ? std::atof(argv[5]) : 0.25;
+	const float				dt = 1.0f / 60.0f;
+
+	ds::bench::HeadlessSpriteEngine	server(ds::ui::SpriteEngine::SERVER_MODE);
+	ds::bench::HeadlessSpriteEngine	client(ds::ui::SpriteEngine::CLIENT_MODE);
+	ds::ui::Sprite&			root = server.addRoot();
+	client.addRoot(root.getId());
+
+	std::mt19937			rand(1234);
+	std::vector<ds::ui::Sprite*>	all, leaves;
+	buildTree(server, root, depth, children, rand, all, leaves);
+	for(auto s : leaves) s->enable(true);
+
+	// An eighth of the sprites drift the whole run, another eighth get moved by hand each frame
+	std::uniform_real_distribution<float>	unit(0.0f, 1.0f);
+	for(size_t k = 0; k < all.size(); k += 8) {
+		all[k]->tweenPosition(ci::vec3(unit(rand) * 500.0f, unit(rand) * 500.0f, 0.0f), static_cast<float>(frames + 1) * dt);
+	}
+	std::vector<ci::vec3>	hits;
+	for(int k = 0; k < 64; ++k) hits.push_back(ci::vec3(unit(rand) * server.getWorldWidth(), unit(rand) * server.getWorldHeight(), 0.0f));
+
+	PhaseLog				log[PHASE_COUNT];
+	ds::DataBuffer			buf;
+	size_t					hitCount = 0, frameBytes = 0;
+	// Frame 0 sends the whole world and warms everything up, so it isn't counted
+	for(int frame = 0; frame <= frames; ++frame) {
+		const bool			record = frame > 0;
+
+		Measure				tween(log[PHASE_TWEEN], record);
+		server.step(dt);
+		tween.stop();
+
+		Measure				update(log[PHASE_UPDATE], record);
+		for(auto r : server.getRoots()) r->updateServer(server.getUpdateParams());
+		update.stop();
+
+		Measure				props(log[PHASE_SET_PROPERTIES], record);
+		for(size_t k = 4 + static_cast<size_t>(frame % 8); k < all.size(); k += 8) {
+			all[k]->move(1.0f, 0.5f);
+			all[k]->setRotation(all[k]->getRotation().z + 1.0f);
+		}
+		props.stop();
+
+		Measure				transform(log[PHASE_TRANSFORM], record);
+		float				sum = 0.0f;
+		for(auto s : leaves) sum += s->getGlobalTransform()[3].x;
+		transform.stop();
+
+		Measure				hit(log[PHASE_HIT_TEST], record);
+		for(auto& p : hits) {
+			if(server.getHit(p)) ++hitCount;
+		}
+		hit.stop();
+
+		Measure				write(log[PHASE_WRITE], record);
+		buf.clear();
+		server.getDirtySprites().writeTo(buf, server.getRoots());
+		write.stop();
+		if(record) frameBytes += buf.size();
+
+		Measure				read(log[PHASE_READ], record);
+		readFrame(buf, client);
+		read.stop();
+
+		// Keeps the transforms from being optimized away
+		if(sum != sum) std::cerr << "NaN transform" << std::endl;
+	}
+	if(!matches(server, client)) return 1;
+
+	std::cout << all.size() + 1 << " sprites (" << depth << " deep, " << children << " per sprite), " << frames << " frames, "
+		<< (frames > 0 ? frameBytes / frames : 0) << " bytes replicated per frame, " << hitCount << " hits" << std::endl;
+	std::cout << "  phase            median ms   p95 ms     allocs/frame  bytes/frame" << std::endl;
+	std::cout << std::fixed;
+	for(int p = 0; p < PHASE_COUNT; ++p) {
+		std::cout << "  " << std::left << std::setw(16) << PHASE_NAMES[p] << std::right << std::setprecision(4)
+			<< std::setw(10) << log[p].median() << std::setw(10) << log[p].percentile(0.95)
+			<< std::setprecision(1) << std::setw(16) << log[p].average(log[p].mAllocations)
+			<< std::setw(13) << log[p].average(log[p].mBytes) << std::endl;
+	}
+
+	if(baselinePath.empty()) return 0;
+	std::map<std::string, double>	baseline;
+	if(!readBaseline(baselinePath, baseline)) {
+		std::ofstream		out(baselinePath.c_str());
+		out << std::setprecision(6);
+		for(int p = 0; p < PHASE_COUNT; ++p) out << PHASE_NAMES[p] << " " << log[p].median() << std::endl;
+		std::cout << "Wrote baseline " << baselinePath << std::endl;
+		return out.good() ? 0 : 1;
+	}
+
+	int						ans = 0;
+	for(int p = 0; p < PHASE_COUNT; ++p) {
+		auto				found = baseline.find(PHASE_NAMES[p]);
+		if(found == baseline.end()) continue;
+		const double		limit = found->second * (1.0 + tolerance);
+		if(log[p].median() > limit) {
+			std::cerr << PHASE_NAMES[p] << " regressed: " << log[p].median() << " ms, baseline " << found->second << " ms" << std::endl;
+			ans = 1;
+		}
+	}
+	if(ans == 0) std::cout << "Within " << (tolerance * 100.0) << "% of baseline " << baselinePath << std::endl;
+	return ans;
+}
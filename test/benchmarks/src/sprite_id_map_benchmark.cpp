@@ -0,0 +1,106 @@
+/**
+ * Looks sprites up by ID the way clients do when applying a frame, comparing the
+ * std::unordered_map the engine used to keep against ds::ui::SpriteIdMap.
+ *
+ * IDs are registered in increasing order like Engine::nextSpriteId() hands them out,
+ * then looked up in a shuffled order, then a slice is deleted and recreated with new IDs
+ * to mimic churn. The sprites are never dereferenced, so they're just fake addresses.
+ * Usage: sprite_id_map_benchmark [sprite count] [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "ds/ui/sprite/sprite_id_map.h"
+
+namespace {
+
+typedef std::unordered_map<ds::sprite_id_t, ds::ui::Sprite*> HashMap;
+
+ds::ui::Sprite* fakeSprite(const ds::sprite_id_t id) {
+	return reinterpret_cast<ds::ui::Sprite*>(static_cast<uintptr_t>(id) * 64);
+}
+
+double millisSince(const std::chrono::high_resolution_clock::time_point& start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void set(HashMap& m, const ds::sprite_id_t id) { m[id] = fakeSprite(id); }
+void set(ds::ui::SpriteIdMap& m, const ds::sprite_id_t id) { m.set(id, fakeSprite(id)); }
+void erase(HashMap& m, const ds::sprite_id_t id) { m.erase(id); }
+void erase(ds::ui::SpriteIdMap& m, const ds::sprite_id_t id) { m.erase(id); }
+
+ds::ui::Sprite* find(const HashMap& m, const ds::sprite_id_t id) {
+	auto it = m.find(id);
+	return it == m.end() ? nullptr : it->second;
+}
+ds::ui::Sprite* find(const ds::ui::SpriteIdMap& m, const ds::sprite_id_t id) { return m.find(id); }
+
+class Result {
+public:
+	Result() : mInsert(1e9), mFind(1e9), mChurn(1e9), mChecksum(0) {}
+	double					mInsert, mFind, mChurn;
+	uintptr_t				mChecksum;
+};
+
+template <typename MAP>
+Result run(const int numSprites, const int iterations, const std::vector<ds::sprite_id_t>& lookups) {
+	Result					ans;
+	for(int it = 0; it < iterations; ++it) {
+		MAP					map;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for(int i = 1; i <= numSprites; ++i) set(map, i);
+		ans.mInsert = std::min(ans.mInsert, millisSince(start));
+
+		uintptr_t			sum = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for(auto id : lookups) sum += reinterpret_cast<uintptr_t>(find(map, id));
+		ans.mFind = std::min(ans.mFind, millisSince(start));
+		ans.mChecksum = sum;
+
+		// Replace the oldest tenth with new sprites, like a view being torn down and rebuilt
+		const int			slice = numSprites / 10;
+		start = std::chrono::high_resolution_clock::now();
+		for(int i = 1; i <= slice; ++i) erase(map, i);
+		for(int i = 1; i <= slice; ++i) set(map, numSprites + i);
+		ans.mChurn = std::min(ans.mChurn, millisSince(start));
+	}
+	return ans;
+}
+
+}
+
+int main(int argc, char** argv) {
+	const int numSprites = argc > 1 ? std::atoi(argv[1]) : 100000;
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+
+	// Ten lookups per sprite, in no particular order, plus some that miss
+	std::vector<ds::sprite_id_t> lookups;
+	for(int k = 0; k < 10; ++k) {
+		for(int i = 1; i <= numSprites; ++i) lookups.push_back(i);
+	}
+	for(int i = 0; i < numSprites / 10; ++i) lookups.push_back(numSprites * 2 + i);
+	std::shuffle(lookups.begin(), lookups.end(), std::mt19937(1234));
+
+	const Result hash = run<HashMap>(numSprites, iterations, lookups);
+	const Result flat = run<ds::ui::SpriteIdMap>(numSprites, iterations, lookups);
+	if(hash.mChecksum != flat.mChecksum) {
+		std::cerr << "Lookups disagree, " << hash.mChecksum << " vs " << flat.mChecksum << std::endl;
+		return 1;
+	}
+
+	std::cout << numSprites << " sprites, " << lookups.size() << " lookups, best of " << iterations << ":" << std::endl;
+	std::cout << "                 unordered_map   SpriteIdMap" << std::endl;
+	std::cout << "  insert         " << hash.mInsert << " ms\t" << flat.mInsert << " ms" << std::endl;
+	std::cout << "  find           " << hash.mFind << " ms\t" << flat.mFind << " ms ("
+		<< (hash.mFind * 1000000.0 / lookups.size()) << " vs " << (flat.mFind * 1000000.0 / lookups.size()) << " ns each)" << std::endl;
+	std::cout << "  churn          " << hash.mChurn << " ms\t" << flat.mChurn << " ms" << std::endl;
+	return 0;
+}